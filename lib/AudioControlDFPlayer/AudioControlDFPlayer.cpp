@@ -1,106 +1,548 @@
 #include "AudioControlDFPlayer.h"
+#include "AudioSequencer.h"
+#include "TrackManifest.h"
 #include <DebugConfig.h>
+#include <Instrumentation.h>
+
+static constexpr char TAG[] = "DFPLAYER";  // Log tag
+
+// The manifest is generated from the SD card files - catch the enum drifting from it
+static_assert(TRACK_MANIFEST_ADDAMS_FAMILY == SOUND_ADDAMS_FAMILY && TRACK_MANIFEST_CHIME == SOUND_CHIME &&
+              TRACK_MANIFEST_ERROR == SOUND_ERROR && TRACK_MANIFEST_EXCELLENT == SOUND_EXCELLENT &&
+              TRACK_MANIFEST_FOOLISH == SOUND_FOOLISH && TRACK_MANIFEST_HELLO == SOUND_HELLO &&
+              TRACK_MANIFEST_IMPERIAL_MARCH == SOUND_IMPERIAL_MARCH && TRACK_MANIFEST_OPERATIONAL == SOUND_OPERATIONAL &&
+              TRACK_MANIFEST_PIRATE_CLIP == SOUND_PIRATE_CLIP && TRACK_MANIFEST_STARTOURS == SOUND_STARTOURS &&
+              TRACK_MANIFEST_TAP_START == SOUND_TAP_START && TRACK_MANIFEST_VADER_BREATHING == SOUND_VADER_BREATHING &&
+              TRACK_MANIFEST_WIZARD_HARRY == SOUND_WIZARD_HARRY,
+              "SoundFile enum doesn't match TrackManifest.h - regenerate it with tools/generate_track_manifest.py");
 
 // Create Serial port for DFPlayer communication
 HardwareSerial DFPlayerSerial(2); // Use UART2
 
-// DFPlayer Mini object
-DFRobotDFPlayerMini myDFPlayer;
+// DFPlayer serial protocol
+// Every frame is 10 bytes: 7E FF 06 CMD ACK PARAM_H PARAM_L CHECK_H CHECK_L EF
+#define DFPLAYER_FRAME_SIZE 10
+#define DFPLAYER_START_BYTE 0x7E
+#define DFPLAYER_VERSION 0xFF
+#define DFPLAYER_LENGTH 0x06
+#define DFPLAYER_END_BYTE 0xEF
+
+// Commands sent to the module
+#define DFPLAYER_CMD_PLAY_TRACK 0x03
+#define DFPLAYER_CMD_VOLUME 0x06
+#define DFPLAYER_CMD_EQ 0x07
+#define DFPLAYER_CMD_OUTPUT_DEVICE 0x09
+#define DFPLAYER_CMD_RESET 0x0C
+#define DFPLAYER_CMD_PLAY_FOLDER 0x0F
+#define DFPLAYER_CMD_STOP 0x16
+#define DFPLAYER_CMD_QUERY_STATUS 0x42
+#define DFPLAYER_CMD_QUERY_SD_FILES 0x48
+
+// Messages received from the module
+#define DFPLAYER_MSG_CARD_INSERTED 0x3A
+#define DFPLAYER_MSG_CARD_REMOVED 0x3B
+#define DFPLAYER_MSG_USB_FINISHED 0x3C
+#define DFPLAYER_MSG_SD_FINISHED 0x3D
+#define DFPLAYER_MSG_ONLINE 0x3F
+#define DFPLAYER_MSG_ERROR 0x40
+#define DFPLAYER_MSG_ACK 0x41
+#define DFPLAYER_MSG_STATUS 0x42
+#define DFPLAYER_MSG_SD_FILES 0x48
+
+#define DFPLAYER_DEVICE_SD 2
+#define DFPLAYER_STATUS_STOPPED 0  // Low byte of the status word (1 = playing, 2 = paused)
+
+// Driver state
+enum DFPlayerState {
+  DFPLAYER_OFF,       // setup not called
+  DFPLAYER_STARTING,  // Reset sent, waiting for the module to come online
+  DFPLAYER_READY,
+  DFPLAYER_FAILED     // Module never answered
+};
+
+struct DFPlayerCommand {
+  uint8_t command;
+  uint16_t param;
+};
+
+static Stream* dfplayer_port = nullptr;
+static DFPlayerState dfplayer_state = DFPLAYER_OFF;
+static unsigned long dfplayer_reset_time = 0;
+static bool dfplayer_heard = false;  // Any valid frame received since the reset
+
+// Command ring buffer
+static DFPlayerCommand command_queue[DFPLAYER_QUEUE_SIZE];
+static uint8_t command_head = 0;  // Next command to send
+static uint8_t command_tail = 0;  // Next free slot
+static bool awaiting_ack = false;
+static uint8_t awaiting_command = 0;
+static unsigned long command_sent_time = 0;
+static unsigned long command_sent_us = 0;  // micros() of the same send - ACK latency
+static unsigned long next_send_time = 0;
+
+// Receive parser
+static uint8_t rx_frame[DFPLAYER_FRAME_SIZE];
+static uint8_t rx_length = 0;
+
+// Tracked player state
+static audio_event_callback event_callback = nullptr;
+static bool audio_playing = false;
+static uint16_t current_track = 0;
+static uint16_t file_count = 0;
+
+// Playback timing and learned durations
+static unsigned long play_sent_time = 0;   // millis() when the current play command went out
+static unsigned long play_start_time = 0;
+static unsigned long play_end_time = 0;
+static bool play_learnable = false;        // Current track is a root track whose length can be recorded
+static uint32_t track_duration[DFPLAYER_DURATION_TABLE_SIZE];
+static unsigned long status_query_time = 0; // millis() of the last status query sent while playing
+
+#if DFPLAYER_BUSY_PIN >= 0
+// BUSY pin monitoring
+// The module holds BUSY low while a track plays. The edge interrupt keeps the level and
+// timestamps both edges, so playback state never needs a serial query.
+// The pull-up reads idle whether or not BUSY is wired, so the level is only trusted once it
+// has gone low for a play command - if it never does, the pin is dropped (see verify_busy_pin()).
+static bool busy_pin_enabled = false;
+static bool busy_pin_verified = false;  // BUSY went low after a play command at least once
+static volatile bool busy_playing = false;
+static volatile unsigned long busy_start_time = 0;  // millis() of the last falling edge
+static volatile unsigned long busy_end_time = 0;    // millis() of the last rising edge
+static volatile bool busy_edge = false;
+static bool busy_start_seen = false;  // BUSY went low since the current play command was sent
+
+static void IRAM_ATTR busy_pin_handler() {
+  bool playing = digitalRead(DFPLAYER_BUSY_PIN) == LOW;
+  if (playing == busy_playing) return;
+
+  if (playing) {
+    busy_start_time = millis();
+  } else {
+    busy_end_time = millis();
+  }
+  busy_playing = playing;
+  busy_edge = true;
+}
+#else
+static const bool busy_pin_enabled = false;
+static const bool busy_pin_verified = false;
+#endif
 
 // Current volume setting
 uint8_t current_volume = DEFAULT_VOLUME;
 
-// Status flags
-bool dfplayer_initialized = false;
+/**
+ * Checksum over version..param bytes (frame bytes 1-6), two's complement
+ */
+static uint16_t dfplayer_checksum(const uint8_t* frame) {
+  uint16_t sum = 0;
+  for (int i = 1; i < 7; i++) {
+    sum += frame[i];
+  }
+  return -sum;
+}
 
 /**
- * Initialize the DFPlayer Mini module
- * Sets up serial communication and configures the player
+ * Write one command frame - 10 bytes fit in the UART TX FIFO, so this never blocks
  */
-bool setup_audio_dfplayer() {
-  DEBUG_PRINTLN("Initializing DFPlayer Mini...");
-  
-  // Initialize serial communication with DFPlayer
-  DFPlayerSerial.begin(9600, SERIAL_8N1, DFPLAYER_RX_PIN, DFPLAYER_TX_PIN);
-  
-  // Reduced delay - DFPlayer should respond in ~500ms if working
-  // If it's not connected, no point waiting longer
-  delay(500);
-  
-  // Connect to DFPlayer with timeout behavior
-  if (!myDFPlayer.begin(DFPlayerSerial, true, true)) {
-    DEBUG_PRINTLN("DFPlayer Mini initialization FAILED!");
-    DEBUG_PRINTLN("Check connections:");
-    DEBUG_PRINT("  RX Pin: "); DEBUG_PRINTLN(DFPLAYER_RX_PIN);
-    DEBUG_PRINT("  TX Pin: "); DEBUG_PRINTLN(DFPLAYER_TX_PIN);
-    DEBUG_PRINTLN("  VCC: 3.3-5V");
-    DEBUG_PRINTLN("  GND: GND");
-    DEBUG_PRINTLN("Verify SD card is inserted and formatted as FAT32");
-    DEBUG_PRINTLN("System will continue without audio");
+static void send_frame(uint8_t command, uint16_t param) {
+  uint8_t frame[DFPLAYER_FRAME_SIZE] = {
+    DFPLAYER_START_BYTE, DFPLAYER_VERSION, DFPLAYER_LENGTH, command,
+    0x01,  // Request an ACK so commands can be paced by the module
+    (uint8_t)(param >> 8), (uint8_t)(param & 0xFF), 0, 0, DFPLAYER_END_BYTE
+  };
+  uint16_t checksum = dfplayer_checksum(frame);
+  frame[7] = checksum >> 8;
+  frame[8] = checksum & 0xFF;
+  dfplayer_port->write(frame, DFPLAYER_FRAME_SIZE);
+}
+
+static void emit_event(AudioEvent event, uint16_t value) {
+  print_dfplayer_detail(event, value);
+  audio_sequence_handle_event(event, value);
+  if (event_callback != nullptr) {
+    event_callback(event, value);
+  }
+}
+
+static bool enqueue_command(uint8_t command, uint16_t param) {
+  if (dfplayer_state == DFPLAYER_OFF || dfplayer_state == DFPLAYER_FAILED) {
+    return false;
+  }
+  if ((uint8_t)(command_tail - command_head) >= DFPLAYER_QUEUE_SIZE) {
+    LOGW(TAG, "Command queue full - dropping command 0x%02X", command);
     return false;
   }
-  
-  DEBUG_PRINTLN("DFPlayer Mini initialized successfully!");
-  
-  // Reduced configuration delays - commands are queued anyway
-  delay(100);
-  
-  // Set default volume
-  myDFPlayer.volume(current_volume);
-  delay(30);  // Reduced from 50ms
-  DEBUG_PRINT("Volume set to: ");
-  DEBUG_PRINTLN(current_volume);
-  
-  // Set equalizer (0=Normal, 1=Pop, 2=Rock, 3=Jazz, 4=Classic, 5=Bass)
-  myDFPlayer.EQ(0);  // Normal EQ
-  delay(30);  // Reduced from 50ms
-  
-  // Set output device to SD card
-  myDFPlayer.outputDevice(DFPLAYER_DEVICE_SD);
-  
-  // Reduced stabilization delay
-  delay(200);
-  
-  // Get file count - don't block if this fails
-  int file_count = myDFPlayer.readFileCounts();
-  DEBUG_PRINT("Files on SD card: ");
-  DEBUG_PRINTLN(file_count);
-  
-  if (file_count <= 0 || file_count == -1) {
-    DEBUG_PRINTLN("WARNING: SD card read error or no files found!");
-    DEBUG_PRINTLN("Possible causes:");
-    DEBUG_PRINTLN("  - SD card not inserted");
-    DEBUG_PRINTLN("  - SD card not formatted as FAT32");
-    DEBUG_PRINTLN("  - No audio files on SD card");
-    DEBUG_PRINTLN("  - DFPlayer communication error");
-    DEBUG_PRINTLN("Audio playback may not work!");
-    // Don't return false - let system continue
+  command_queue[command_tail % DFPLAYER_QUEUE_SIZE] = {command, param};
+  command_tail++;
+  return true;
+}
+
+static void clear_command_queue() {
+  command_head = command_tail;
+}
+
+/**
+ * Current track played to the end - record its length and report it
+ */
+static void track_finished(unsigned long end_time, uint16_t track) {
+  audio_playing = false;
+  play_end_time = end_time;
+  // Only if the start was seen for this play command - otherwise play_start_time is stale
+  if (play_learnable && (long)(play_start_time - play_sent_time) >= 0 &&
+      current_track < DFPLAYER_DURATION_TABLE_SIZE) {
+    track_duration[current_track] = end_time - play_start_time;
+  }
+  play_learnable = false;
+  emit_event(AUDIO_EVENT_PLAY_FINISHED, track);
+}
+
+/**
+ * Handle one complete, checksum-verified frame from the module
+ */
+static void handle_frame(uint8_t command, uint16_t param) {
+  dfplayer_heard = true;
+
+  switch (command) {
+    case DFPLAYER_MSG_ACK:
+      if (awaiting_ack) {
+        instrument_since(INSTRUMENT_DFPLAYER_COMMAND, command_sent_us);
+      }
+      if (awaiting_ack && (awaiting_command == DFPLAYER_CMD_PLAY_TRACK || awaiting_command == DFPLAYER_CMD_PLAY_FOLDER)) {
+        if (!busy_pin_verified) {
+          play_start_time = millis();  // Best estimate without BUSY - the BUSY edge is exact
+        }
+        emit_event(AUDIO_EVENT_PLAY_STARTED, current_track);
+      }
+      awaiting_ack = false;
+      break;
+
+    case DFPLAYER_MSG_ONLINE:
+      if (dfplayer_state == DFPLAYER_STARTING) {
+        dfplayer_state = DFPLAYER_READY;
+        emit_event(AUDIO_EVENT_READY, param);
+      }
+      break;
+
+    case DFPLAYER_MSG_SD_FINISHED:
+    case DFPLAYER_MSG_USB_FINISHED:
+      // Many modules send the finished notification twice - report it once
+      // With BUSY wired the rising edge usually reported it already
+      if (audio_playing) {
+        unsigned long end_time = millis();
+#if DFPLAYER_BUSY_PIN >= 0
+        if (busy_pin_enabled && busy_start_seen && !busy_playing) {
+          end_time = busy_end_time;  // The edge is the exact end, the message trails it
+        }
+#endif
+        track_finished(end_time, param);
+      }
+      break;
+
+    case DFPLAYER_MSG_ERROR:
+      if (awaiting_ack) {
+        instrument_since(INSTRUMENT_DFPLAYER_COMMAND, command_sent_us);
+      }
+      awaiting_ack = false;  // An error replaces the ACK
+      audio_playing = false;
+      play_learnable = false;
+      emit_event(AUDIO_EVENT_ERROR, param);
+      break;
+
+    case DFPLAYER_MSG_CARD_INSERTED:
+      emit_event(AUDIO_EVENT_CARD_INSERTED, param);
+      break;
+
+    case DFPLAYER_MSG_CARD_REMOVED:
+      audio_playing = false;
+      play_learnable = false;
+      emit_event(AUDIO_EVENT_CARD_REMOVED, param);
+      break;
+
+    case DFPLAYER_MSG_SD_FILES:
+      file_count = param;
+      emit_event(AUDIO_EVENT_FILE_COUNT, param);
+      break;
+
+    case DFPLAYER_MSG_STATUS:
+      emit_event(AUDIO_EVENT_STATUS, param);
+      // Polled without BUSY (see service_command_queue()) - low byte 0 = stopped. Only an answer
+      // to a query sent after the current play command says anything about that track.
+      if (audio_playing && !busy_pin_enabled && (param & 0xFF) == DFPLAYER_STATUS_STOPPED &&
+          (long)(status_query_time - play_sent_time) > 0) {
+        play_learnable = false;  // Ended somewhere in the last poll interval - too coarse to record
+        track_finished(millis(), current_track);
+      }
+      break;
+
+    default:
+      // Many DFPlayer clones send undocumented status messages (like type 11, 12, 13, etc.)
+      // These are typically benign status updates, not errors
+      #ifdef DEBUG_DFPLAYER_MESSAGES
+      LOGV(TAG, "Undocumented message type %u value: %u", command, param);
+      #endif
+      break;
+  }
+}
+
+/**
+ * Feed one received byte to the frame parser
+ * Resynchronizes on the start byte after line noise or a dropped byte
+ */
+static void receive_byte(uint8_t b) {
+  if (rx_length == 0 && b != DFPLAYER_START_BYTE) {
+    return;
+  }
+  rx_frame[rx_length++] = b;
+
+  // Reject a bad header early so a stray 0x7E inside a frame doesn't swallow the next one
+  if ((rx_length == 2 && b != DFPLAYER_VERSION) || (rx_length == 3 && b != DFPLAYER_LENGTH)) {
+    rx_length = (b == DFPLAYER_START_BYTE) ? 1 : 0;
+    if (rx_length == 1) {
+      rx_frame[0] = b;
+    }
+    return;
+  }
+
+  if (rx_length < DFPLAYER_FRAME_SIZE) {
+    return;
+  }
+  rx_length = 0;
+
+  uint16_t checksum = ((uint16_t)rx_frame[7] << 8) | rx_frame[8];
+  if (rx_frame[9] != DFPLAYER_END_BYTE || checksum != dfplayer_checksum(rx_frame)) {
+    LOGW(TAG, "Dropped corrupt frame");
+    return;
+  }
+  handle_frame(rx_frame[3], ((uint16_t)rx_frame[5] << 8) | rx_frame[6]);
+}
+
+/**
+ * Send the next queued command if the link is free
+ */
+static void service_command_queue(unsigned long now) {
+  if (awaiting_ack) {
+    if (now - command_sent_time < DFPLAYER_ACK_TIMEOUT_MS) {
+      return;
+    }
+    awaiting_ack = false;
+    if (awaiting_command != DFPLAYER_CMD_RESET) {
+      instrument_count(INSTRUMENT_DFPLAYER_TIMEOUTS);  // Many modules never ACK the reset
+    }
+    emit_event(AUDIO_EVENT_ACK_TIMEOUT, awaiting_command);
+  }
+
+  if ((long)(now - next_send_time) < 0) {
+    return;
+  }
+  if (command_head == command_tail) {
+    // Without BUSY the finished message is the only end of a track - if it's lost, the status
+    // query catches it. Only on an idle link, so it never delays a real command.
+    if (audio_playing && !busy_pin_enabled && now - play_sent_time >= DFPLAYER_STATUS_POLL_MS &&
+        now - status_query_time >= DFPLAYER_STATUS_POLL_MS) {
+      send_frame(DFPLAYER_CMD_QUERY_STATUS, 0);
+      awaiting_ack = true;
+      awaiting_command = DFPLAYER_CMD_QUERY_STATUS;
+      command_sent_time = now;
+      command_sent_us = micros();
+      status_query_time = now;
+      next_send_time = now + DFPLAYER_COMMAND_GAP_MS;
+    }
+    return;
+  }
+
+  DFPlayerCommand cmd = command_queue[command_head % DFPLAYER_QUEUE_SIZE];
+  command_head++;
+
+  send_frame(cmd.command, cmd.param);
+  awaiting_ack = true;
+  awaiting_command = cmd.command;
+  command_sent_time = now;
+  command_sent_us = micros();
+
+  if (cmd.command == DFPLAYER_CMD_PLAY_TRACK || cmd.command == DFPLAYER_CMD_PLAY_FOLDER) {
+    // Give the module time to read from the SD card and fill its buffer -
+    // commands sent during that time make playback stutter at the start
+    audio_playing = true;
+    current_track = cmd.param;
+    play_sent_time = now;
+    play_learnable = (cmd.command == DFPLAYER_CMD_PLAY_TRACK);  // Folder tracks aren't in the table
+#if DFPLAYER_BUSY_PIN >= 0
+    busy_start_seen = false;
+#endif
+    next_send_time = now + DFPLAYER_PLAY_SETTLE_MS;
+  } else {
+    if (cmd.command == DFPLAYER_CMD_STOP) {
+      audio_playing = false;
+      play_learnable = false;
+      play_end_time = now;
+    }
+    next_send_time = now + DFPLAYER_COMMAND_GAP_MS;
+  }
+}
+
+#if DFPLAYER_BUSY_PIN >= 0
+/**
+ * Turn BUSY edges into playback timing
+ * The end of a track counts only after BUSY went low for the current play command -
+ * the blip when one track replaces another must not finish the new one.
+ */
+static void service_busy_pin() {
+  if (!busy_edge) return;
+  busy_edge = false;
+
+  unsigned long start = busy_start_time;
+  unsigned long end = busy_end_time;
+
+  if (audio_playing && !busy_start_seen && (long)(start - play_sent_time) >= 0) {
+    busy_start_seen = true;
+    busy_pin_verified = true;
+    play_start_time = start;
+  }
+  if (audio_playing && busy_start_seen && !busy_playing && (long)(end - start) >= 0) {
+    track_finished(end, current_track);
   }
-  
-  dfplayer_initialized = true;
-  DEBUG_PRINTLN("DFPlayer setup complete");
+}
+
+/**
+ * Drop a BUSY pin that never goes low
+ * A track still playing DFPLAYER_BUSY_VERIFY_MS after its play command should have pulled
+ * BUSY low long ago - if it hasn't, BUSY isn't wired and the pull-up reads "idle" forever.
+ * Playback state then comes from commands, events and the status query instead.
+ */
+static void verify_busy_pin(unsigned long now) {
+  if (busy_pin_verified || !audio_playing || busy_start_seen ||
+      now - play_sent_time < DFPLAYER_BUSY_VERIFY_MS) {
+    return;
+  }
+  detachInterrupt(digitalPinToInterrupt(DFPLAYER_BUSY_PIN));
+  busy_pin_enabled = false;
+  LOGW(TAG, "BUSY on GPIO%d never went low for track %u - not wired? Tracking playback over serial",
+       DFPLAYER_BUSY_PIN, current_track);
+}
+#endif
+
+/**
+ * Initialize the DFPlayer Mini module on UART2
+ * Non-blocking: sends a reset and returns. The module comes online in the background
+ * (AUDIO_EVENT_READY) - commands issued meanwhile are queued.
+ */
+bool setup_audio_dfplayer() {
+  DFPlayerSerial.begin(9600, SERIAL_8N1, DFPLAYER_RX_PIN, DFPLAYER_TX_PIN);
+
+#if DFPLAYER_BUSY_PIN >= 0
+  pinMode(DFPLAYER_BUSY_PIN, INPUT_PULLUP);  // Reads idle if the pin isn't connected
+  busy_playing = digitalRead(DFPLAYER_BUSY_PIN) == LOW;
+  attachInterrupt(digitalPinToInterrupt(DFPLAYER_BUSY_PIN), busy_pin_handler, CHANGE);
+  busy_pin_enabled = true;
+  busy_pin_verified = false;
+  LOGI(TAG, "Monitoring BUSY on GPIO%d - trusted once it goes low for a track", DFPLAYER_BUSY_PIN);
+#endif
+
+  return setup_audio_dfplayer_stream(DFPlayerSerial);
+}
+
+/**
+ * Initialize the DFPlayer Mini on an already-open Stream
+ */
+bool setup_audio_dfplayer_stream(Stream& port) {
+  LOGI(TAG, "Initializing DFPlayer Mini...");
+
+  dfplayer_port = &port;
+  dfplayer_state = DFPLAYER_STARTING;
+  dfplayer_heard = false;
+  rx_length = 0;
+  awaiting_ack = false;
+  audio_playing = false;
+  command_head = command_tail = 0;
+
+  unsigned long now = millis();
+  send_frame(DFPLAYER_CMD_RESET, 0);
+  awaiting_ack = true;
+  awaiting_command = DFPLAYER_CMD_RESET;
+  command_sent_time = now;
+  command_sent_us = micros();
+  dfplayer_reset_time = now;
+  next_send_time = now + DFPLAYER_RESET_TIME_MS;
+
+  // Configuration is sent as soon as the module is online
+  enqueue_command(DFPLAYER_CMD_VOLUME, current_volume);
+  enqueue_command(DFPLAYER_CMD_EQ, 0);  // 0=Normal, 1=Pop, 2=Rock, 3=Jazz, 4=Classic, 5=Bass
+  enqueue_command(DFPLAYER_CMD_OUTPUT_DEVICE, DFPLAYER_DEVICE_SD);
+  enqueue_command(DFPLAYER_CMD_QUERY_SD_FILES, 0);
+
   return true;
 }
 
+/**
+ * Process DFPlayer I/O - call every loop iteration
+ * Parses whatever bytes have arrived and sends at most one queued command
+ */
+void loop_audio_dfplayer() {
+  if (dfplayer_state == DFPLAYER_OFF || dfplayer_state == DFPLAYER_FAILED) {
+    return;
+  }
+
+  while (dfplayer_port->available() > 0) {
+    receive_byte(dfplayer_port->read());
+  }
+  unsigned long now = millis();
+#if DFPLAYER_BUSY_PIN >= 0
+  if (busy_pin_enabled) {
+    service_busy_pin();
+    verify_busy_pin(now);
+  }
+#endif
+
+  loop_audio_sequence(now);
+
+  if (dfplayer_state == DFPLAYER_STARTING) {
+    unsigned long elapsed = now - dfplayer_reset_time;
+    // Some clones never send the "online" message - an ACK after the reset time will do
+    if (dfplayer_heard && elapsed >= DFPLAYER_RESET_TIME_MS) {
+      dfplayer_state = DFPLAYER_READY;
+      emit_event(AUDIO_EVENT_READY, 0);
+    } else if (!dfplayer_heard && elapsed >= DFPLAYER_INIT_TIMEOUT_MS) {
+      dfplayer_state = DFPLAYER_FAILED;
+      clear_command_queue();
+      emit_event(AUDIO_EVENT_INIT_FAILED, 0);
+      return;
+    } else {
+      // Let the reset ACK arrive, but hold queued commands until the module is up
+      if (awaiting_ack && now - command_sent_time >= DFPLAYER_ACK_TIMEOUT_MS) {
+        awaiting_ack = false;
+      }
+      return;
+    }
+  }
+
+  service_command_queue(now);
+}
+
+/**
+ * Register a function to receive driver events (called from loop_audio_dfplayer)
+ */
+void set_audio_event_callback(audio_event_callback callback) {
+  event_callback = callback;
+}
+
 /**
  * Set playback volume
  * @param volume Volume level (0-30)
  */
 void set_volume(uint8_t volume) {
-  if (!dfplayer_initialized) {
-    DEBUG_PRINTLN("DFPlayer not initialized!");
-    return;
-  }
-  
   if (volume > MAX_VOLUME) {
     volume = MAX_VOLUME;
   }
-  
+
   current_volume = volume;
-  myDFPlayer.volume(current_volume);
-  
-  DEBUG_PRINT("Volume set to: ");
-  DEBUG_PRINTLN(current_volume);
+  if (!enqueue_command(DFPLAYER_CMD_VOLUME, current_volume)) {
+    LOGW(TAG, "Not initialized!");
+    return;
+  }
+
+  LOGD(TAG, "Volume set to: %u", current_volume);
 }
 
 /**
@@ -113,54 +555,45 @@ uint8_t get_volume() {
 
 /**
  * Check if audio is currently playing
+ * Reads the BUSY level kept by the edge interrupt once BUSY has been seen going low for a
+ * track, otherwise the state tracked from play/stop commands, finished/error events and the
+ * background status query - no serial round trip
+ * Note: BUSY only drops once the module has loaded the file, ~100ms after the play command
  * @return true if playing, false if idle
  */
 bool is_audio_playing() {
-  if (!dfplayer_initialized) return false;
-  
-  // DFPlayer Mini doesn't have a direct "is playing" status
-  // We can check by reading the state
-  int state = myDFPlayer.readState();
-  // State: 1=playing, 2=paused, 512=stopped
-  return (state == 1);
+#if DFPLAYER_BUSY_PIN >= 0
+  if (busy_pin_enabled && busy_pin_verified) {
+    return busy_playing;
+  }
+#endif
+  return audio_playing;
 }
 
 /**
  * Stop current playback
+ * Drops anything still queued so a stop is never followed by a stale play
  */
 void stop_audio() {
-  if (!dfplayer_initialized) return;
-  
-  myDFPlayer.stop();
-  DEBUG_PRINTLN("Audio playback stopped");
+  if (dfplayer_state != DFPLAYER_READY && dfplayer_state != DFPLAYER_STARTING) return;
+
+  clear_command_queue();
+  enqueue_command(DFPLAYER_CMD_STOP, 0);
+  LOGD(TAG, "Playback stopped");
 }
 
 /**
  * Play a specific audio file from SD card
  * @param file_number File number (1-based, e.g., 0001.mp3, 0002.mp3)
- * @return true if successful, false otherwise
+ * @return true if queued, false otherwise
  */
 bool play_sound_file(uint8_t file_number) {
-  if (!dfplayer_initialized) {
-    DEBUG_PRINTLN("DFPlayer not initialized!");
+  if (!enqueue_command(DFPLAYER_CMD_PLAY_TRACK, file_number)) {
+    LOGW(TAG, "Not initialized!");
     return false;
   }
-  
-  DEBUG_PRINT("Playing file: ");
-  DEBUG_PRINTLN(file_number);
-  
-  // Send play command
-  myDFPlayer.play(file_number);
-  
-  // CRITICAL: Add delay to allow DFPlayer to buffer audio data
-  // Without this delay, playback can stutter at the start
-  // 100-150ms allows the DFPlayer to read from SD card and fill its buffer
-  delay(100);
-  
-  // Note: DFPlayer often sends status messages (like type 11) after play commands
-  // These are not errors - they're informational. We'll let the main error handler
-  // catch any real issues. Checking immediately after play() often gives false positives.
-  
+
+  LOGD(TAG, "Playing file: %u", file_number);
   return true;
 }
 
@@ -169,107 +602,150 @@ bool play_sound_file(uint8_t file_number) {
  * Allows better organization of audio files
  * @param folder_number Folder number (01-99)
  * @param file_number File number within folder (001-255)
- * @return true if successful, false otherwise
+ * @return true if queued, false otherwise
  */
 bool play_sound_from_folder(uint8_t folder_number, uint8_t file_number) {
-  if (!dfplayer_initialized) {
-    DEBUG_PRINTLN("DFPlayer not initialized!");
+  if (!enqueue_command(DFPLAYER_CMD_PLAY_FOLDER, ((uint16_t)folder_number << 8) | file_number)) {
+    LOGW(TAG, "Not initialized!");
     return false;
   }
-  
-  DEBUG_PRINT("Playing folder ");
-  DEBUG_PRINT(folder_number);
-  DEBUG_PRINT(" file ");
-  DEBUG_PRINTLN(file_number);
-  
-  myDFPlayer.playFolder(folder_number, file_number);
-  
-  // Note: Same as play_sound_file - don't check for "errors" immediately after playback
-  
+
+  LOGD(TAG, "Playing folder %u file %u", folder_number, file_number);
   return true;
 }
 
 /**
  * Check if DFPlayer is ready
- * @return true if initialized, false otherwise
+ * @return true once the module has answered and finished its reset
  */
 bool dfplayer_is_ready() {
-  return dfplayer_initialized;
+  return dfplayer_state == DFPLAYER_READY;
+}
+
+/**
+ * Check if DFPlayer is still coming online
+ * @return true while the reset is in progress
+ */
+bool dfplayer_is_starting() {
+  return dfplayer_state == DFPLAYER_STARTING;
 }
 
 /**
  * Get number of files on SD card
- * @return File count
+ * @return File count reported at startup (0 until the reply arrives)
  */
 uint16_t get_file_count() {
-  if (!dfplayer_initialized) return 0;
-  return myDFPlayer.readFileCounts();
+  return file_count;
+}
+
+/**
+ * Get number of commands waiting to be sent
+ */
+int get_audio_queue_depth() {
+  return (uint8_t)(command_tail - command_head);
+}
+
+/**
+ * Check where playback state comes from
+ * @return true while the BUSY pin interrupt is active (false once an unwired pin was dropped)
+ */
+bool is_audio_busy_pin_mode() {
+  return busy_pin_enabled;
+}
+
+/**
+ * Get when the last track started playing
+ * @return millis() of the BUSY falling edge (or the play ACK without BUSY), 0 if nothing played yet
+ */
+unsigned long get_audio_play_start_time() {
+  return play_start_time;
+}
+
+/**
+ * Get when the last track stopped playing
+ * @return millis() of the BUSY rising edge, finished message or stop command, 0 if nothing played yet
+ */
+unsigned long get_audio_play_end_time() {
+  return play_end_time;
+}
+
+/**
+ * Get the length of a root track
+ * Measured each time the track plays through to the end (not when it is stopped or replaced);
+ * until then the length from the generated manifest
+ * @param file_number File number (1-based, e.g., 0001.mp3)
+ * @return Length in ms, 0 if unknown
+ */
+uint32_t get_track_duration(uint8_t file_number) {
+  if (track_duration[file_number] > 0) {
+    return track_duration[file_number];
+  }
+  return file_number <= TRACK_MANIFEST_COUNT ? TRACK_MANIFEST[file_number].duration_ms : 0;
 }
 
 /**
- * Print DFPlayer error/status messages
+ * Print DFPlayer events
  */
-void print_dfplayer_detail(uint8_t type, int value) {
-  switch (type) {
-    case TimeOut:
-      DEBUG_PRINTLN("DFPlayer: Time Out!");
+void print_dfplayer_detail(AudioEvent event, uint16_t value) {
+  switch (event) {
+    case AUDIO_EVENT_READY:
+      LOGI(TAG, "DFPlayer Mini initialized successfully!");
       break;
-    case WrongStack:
-      DEBUG_PRINTLN("DFPlayer: Wrong Stack!");
+    case AUDIO_EVENT_INIT_FAILED:
+      LOGE(TAG, "DFPlayer Mini initialization FAILED! Check connections: RX pin %d, TX pin %d, "
+                "VCC 3.3-5V, GND", DFPLAYER_RX_PIN, DFPLAYER_TX_PIN);
+      LOGE(TAG, "Verify SD card is inserted and formatted as FAT32 - continuing without audio");
       break;
-    case DFPlayerCardInserted:
-      DEBUG_PRINTLN("DFPlayer: Card Inserted!");
+    case AUDIO_EVENT_PLAY_STARTED:
+      break;  // Already logged when queued
+    case AUDIO_EVENT_ACK_TIMEOUT:
+      LOGW(TAG, "Time Out! (command 0x%X)", value);
       break;
-    case DFPlayerCardRemoved:
-      DEBUG_PRINTLN("DFPlayer: Card Removed!");
+    case AUDIO_EVENT_CARD_INSERTED:
+      LOGI(TAG, "Card Inserted!");
       break;
-    case DFPlayerCardOnline:
-      DEBUG_PRINTLN("DFPlayer: Card Online!");
+    case AUDIO_EVENT_CARD_REMOVED:
+      LOGW(TAG, "Card Removed!");
+      break;
+    case AUDIO_EVENT_PLAY_FINISHED:
+      LOGD(TAG, "Finished playing file %u", value);
+      break;
+    case AUDIO_EVENT_FILE_COUNT:
+      LOGI(TAG, "Files on SD card: %u", value);
+      if (value == 0) {
+        LOGW(TAG, "SD card read error or no files found! Card missing, not FAT32, or no audio files - "
+                  "playback may not work");
+      }
       break;
-    case DFPlayerPlayFinished:
-      DEBUG_PRINT("DFPlayer: Finished playing file ");
-      DEBUG_PRINTLN(value);
+    case AUDIO_EVENT_STATUS:
       break;
-    case DFPlayerError:
-      DEBUG_PRINT("DFPlayer Error: ");
+    case AUDIO_EVENT_ERROR:
       switch (value) {
-        case Busy:
-          DEBUG_PRINTLN("Card not found");
+        case DFPLAYER_ERROR_BUSY:
+          LOGE(TAG, "Error: Card not found");
           break;
-        case Sleeping:
-          DEBUG_PRINTLN("Sleeping");
+        case DFPLAYER_ERROR_SLEEPING:
+          LOGE(TAG, "Error: Sleeping");
           break;
-        case SerialWrongStack:
-          DEBUG_PRINTLN("Serial wrong stack");
+        case DFPLAYER_ERROR_WRONG_STACK:
+          LOGE(TAG, "Error: Serial wrong stack");
           break;
-        case CheckSumNotMatch:
-          DEBUG_PRINTLN("Checksum not match");
+        case DFPLAYER_ERROR_CHECKSUM:
+          LOGE(TAG, "Error: Checksum not match");
           break;
-        case FileIndexOut:
-          DEBUG_PRINTLN("File index out of bounds");
+        case DFPLAYER_ERROR_FILE_INDEX:
+          LOGE(TAG, "Error: File index out of bounds");
           break;
-        case FileMismatch:
-          DEBUG_PRINTLN("File mismatch");
+        case DFPLAYER_ERROR_FILE_MISMATCH:
+          LOGE(TAG, "Error: File mismatch");
           break;
-        case Advertise:
-          DEBUG_PRINTLN("Advertise");
+        case DFPLAYER_ERROR_ADVERTISE:
+          LOGE(TAG, "Error: Advertise");
           break;
         default:
-          DEBUG_PRINT("Unknown error: ");
-          DEBUG_PRINTLN(value);
+          LOGE(TAG, "Unknown error: %u", value);
           break;
       }
       break;
-    default:
-      // Many DFPlayer clones send undocumented status messages (like type 11, 12, 13, etc.)
-      // These are typically benign status updates, not errors
-      // Only log them if debugging is needed
-      #ifdef DEBUG_DFPLAYER_MESSAGES
-      DEBUG_PRINT("DFPlayer: Undocumented message type ");
-      DEBUG_PRINT(type);
-      DEBUG_PRINT(" value: ");
-      DEBUG_PRINTLN(value);
-      #endif
-      break;
   }
 }
@@ -2,13 +2,15 @@
 #define AUDIO_CONTROL_DFPLAYER_H
 
 #include <Arduino.h>
-#include <DFRobotDFPlayerMini.h>
 
 // Pin definitions for DFPlayer Mini
 #define DFPLAYER_RX_PIN 16  // Connect to DFPlayer TX
 #define DFPLAYER_TX_PIN 17  // Connect to DFPlayer RX
+#define DFPLAYER_BUSY_PIN 27  // Connect to DFPlayer BUSY (low while playing) - set to -1 if not wired
+                              // (an unwired pin is also detected on the first track and dropped)
 
 // Audio file mapping
+// Must match tools/generate_track_manifest.py's numbering - TrackManifest.h is checked against it at compile time
 // NOTE: DFPlayer Mini requires files to be numbered (0001.mp3, 0002.mp3, etc.)
 // Files are sorted alphabetically by the prepare_sd_card.ps1 script
 // Currently using root directory (no folders)
@@ -51,20 +53,75 @@ enum SoundFile {
 #define MAX_VOLUME 30
 #define MIN_VOLUME 0
 
+// Non-blocking driver
+// Commands go into a ring buffer and are sent one at a time from loop_audio_dfplayer(),
+// paced by the module's ACKs. Replies and notifications are parsed from the UART as the
+// bytes arrive and reported as events - nothing here waits on the 9600 baud link.
+#define DFPLAYER_QUEUE_SIZE 16          // Pending commands (must be a power of two)
+#define DFPLAYER_COMMAND_GAP_MS 30      // Minimum spacing between commands
+#define DFPLAYER_PLAY_SETTLE_MS 100     // Quiet time after a play command while the module buffers the file
+#define DFPLAYER_ACK_TIMEOUT_MS 200     // Stop waiting for an ACK and send the next command
+#define DFPLAYER_RESET_TIME_MS 1500     // Module ignores commands for this long after a reset
+#define DFPLAYER_INIT_TIMEOUT_MS 3000   // No reply at all within this time = module missing
+#define DFPLAYER_BUSY_VERIFY_MS 500     // BUSY still high this long after a play command = not wired
+#define DFPLAYER_STATUS_POLL_MS 500     // Status query interval while playing without BUSY
+
+// Learned track durations - one slot per root track number (0001.mp3 - 0255.mp3)
+// Measured each time a track plays to the end, from the BUSY edges when the pin is wired
+#define DFPLAYER_DURATION_TABLE_SIZE 256
+
+// Events reported by the driver
+enum AudioEvent {
+  AUDIO_EVENT_READY = 0,        // Module online after reset (value: online storage bitmask)
+  AUDIO_EVENT_INIT_FAILED,      // Module never answered (value: 0)
+  AUDIO_EVENT_PLAY_STARTED,     // Play command accepted (value: track)
+  AUDIO_EVENT_PLAY_FINISHED,    // Track played to the end (value: track)
+  AUDIO_EVENT_ERROR,            // Module reported an error (value: DFPlayerErrorCode)
+  AUDIO_EVENT_ACK_TIMEOUT,      // A command was never acknowledged (value: command byte)
+  AUDIO_EVENT_CARD_INSERTED,
+  AUDIO_EVENT_CARD_REMOVED,
+  AUDIO_EVENT_FILE_COUNT,       // Reply to the file count query (value: files on the SD card)
+  AUDIO_EVENT_STATUS            // Reply to a status query (value: module status word)
+};
+
+// Error codes carried by AUDIO_EVENT_ERROR
+enum DFPlayerErrorCode {
+  DFPLAYER_ERROR_BUSY = 1,          // Card not found / module initializing
+  DFPLAYER_ERROR_SLEEPING = 2,
+  DFPLAYER_ERROR_WRONG_STACK = 3,   // Frame not fully received
+  DFPLAYER_ERROR_CHECKSUM = 4,
+  DFPLAYER_ERROR_FILE_INDEX = 5,    // Track number out of range
+  DFPLAYER_ERROR_FILE_MISMATCH = 6, // Track not found
+  DFPLAYER_ERROR_ADVERTISE = 7
+};
+
+typedef void (*audio_event_callback)(AudioEvent event, uint16_t value);
+
 // Setup and control functions
-bool setup_audio_dfplayer();
+bool setup_audio_dfplayer();               // Start UART2 and reset the module - returns immediately
+bool setup_audio_dfplayer_stream(Stream& port);  // Same on any Stream (e.g. a scripted fake port)
+void loop_audio_dfplayer();                // Parse received bytes, send the next queued command
+void set_audio_event_callback(audio_event_callback callback);
 void set_volume(uint8_t volume);
 uint8_t get_volume();
-bool is_audio_playing();
+bool is_audio_playing();                   // BUSY pin level (or tracked from commands and events) - no serial round trip
 void stop_audio();
 
-// Sound playback functions - simplified!
+// Sound playback functions - queued, return false only if the queue is full or the module failed
 bool play_sound_file(uint8_t file_number);
 bool play_sound_from_folder(uint8_t folder_number, uint8_t file_number);
 
 // DFPlayer status functions
-bool dfplayer_is_ready();
-uint16_t get_file_count();
-void print_dfplayer_detail(uint8_t type, int value);
+bool dfplayer_is_ready();                  // Module answered and finished its reset
+bool dfplayer_is_starting();               // Reset in progress - commands are queued until ready
+uint16_t get_file_count();                 // Cached from the query sent at startup
+int get_audio_queue_depth();               // Commands waiting to be sent
+bool is_audio_busy_pin_mode();             // True while the BUSY pin is monitored (false once found unwired)
+
+// Playback timing
+unsigned long get_audio_play_start_time(); // millis() when the last track started playing (0 = never)
+unsigned long get_audio_play_end_time();   // millis() when the last track stopped playing (0 = never)
+uint32_t get_track_duration(uint8_t file_number);  // Length in ms - measured once played through, else from TrackManifest.h (0 = unknown)
+void print_dfplayer_detail(AudioEvent event, uint16_t value);
 
 #endif
@@ -0,0 +1,151 @@
+#include "AudioSequencer.h"
+#include <DebugConfig.h>
+
+static constexpr char TAG[] = "AUDIO";  // Log tag
+
+enum AudioSequenceState {
+  SEQUENCE_IDLE,
+  SEQUENCE_PLAYING,  // Current step's track queued or playing
+  SEQUENCE_GAP       // Current step done, waiting out its gap
+};
+
+static AudioSequenceStep sequence_steps[AUDIO_SEQUENCE_MAX_STEPS];
+static uint8_t sequence_count = 0;
+static uint8_t sequence_index = 0;
+static AudioSequenceState sequence_state = SEQUENCE_IDLE;
+static unsigned long step_started = 0;    // millis() when the step was queued or its gap began
+static bool step_acknowledged = false;    // Module accepted this step's play command
+static uint32_t step_timeout = 0;         // Effective timeout for the current step
+
+/**
+ * Queue the current step's track
+ */
+static bool start_step(unsigned long now) {
+  const AudioSequenceStep& step = sequence_steps[sequence_index];
+  step_started = now;
+  step_acknowledged = false;
+  step_timeout = step.timeout_ms;
+
+  // A track that has played through before won't need the worst-case timeout
+  uint32_t learned = get_track_duration(step.track);
+  if (learned > 0 && learned + AUDIO_SEQUENCE_TIMEOUT_MARGIN_MS < step_timeout) {
+    step_timeout = learned + AUDIO_SEQUENCE_TIMEOUT_MARGIN_MS;
+  }
+
+  sequence_state = SEQUENCE_PLAYING;
+  return play_sound_file(step.track);
+}
+
+/**
+ * Current step is over - wait out its gap, or end the sequence after the last step
+ */
+static void finish_step(unsigned long now) {
+  if (sequence_index + 1 >= sequence_count) {
+    sequence_state = SEQUENCE_IDLE;
+    return;
+  }
+  sequence_state = SEQUENCE_GAP;
+  step_started = now;
+}
+
+/**
+ * Start a playlist
+ * @param steps Tracks to play in order (copied - the caller's array may go away)
+ * @param count Number of steps (1-AUDIO_SEQUENCE_MAX_STEPS)
+ * @return true if the first track was queued
+ */
+bool audio_sequence_start(const AudioSequenceStep* steps, uint8_t count) {
+  sequence_state = SEQUENCE_IDLE;
+  if (count == 0 || count > AUDIO_SEQUENCE_MAX_STEPS) {
+    return false;
+  }
+
+  memcpy(sequence_steps, steps, count * sizeof(AudioSequenceStep));
+  sequence_count = count;
+  sequence_index = 0;
+
+  if (!start_step(millis())) {
+    sequence_state = SEQUENCE_IDLE;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Abandon the sequence and silence the player
+ */
+void audio_sequence_stop() {
+  if (sequence_state == SEQUENCE_IDLE) return;
+
+  sequence_state = SEQUENCE_IDLE;
+  stop_audio();
+}
+
+bool audio_sequence_running() {
+  return sequence_state != SEQUENCE_IDLE;
+}
+
+int audio_sequence_step() {
+  return sequence_state == SEQUENCE_IDLE ? -1 : sequence_index;
+}
+
+/**
+ * Advance on DFPlayer events
+ * A finished event only counts once this step's play was acknowledged, so the tail end of
+ * an earlier sound (like the tap beep) can't skip the step. Errors end the step right away -
+ * the module reports a missing file instead of acknowledging the play.
+ */
+void audio_sequence_handle_event(AudioEvent event, uint16_t value) {
+  if (event == AUDIO_EVENT_INIT_FAILED) {
+    sequence_state = SEQUENCE_IDLE;  // Driver stops running - nothing will advance the sequence
+    return;
+  }
+  if (sequence_state != SEQUENCE_PLAYING) return;
+
+  switch (event) {
+    case AUDIO_EVENT_PLAY_STARTED:
+      step_acknowledged = true;
+      break;
+
+    case AUDIO_EVENT_PLAY_FINISHED:
+      if (step_acknowledged) {
+        finish_step(millis());
+      }
+      break;
+
+    case AUDIO_EVENT_ERROR:
+    case AUDIO_EVENT_CARD_REMOVED:
+      LOGW(TAG, "Sequence step %u failed - skipping", sequence_index);
+      finish_step(millis());
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**
+ * Timeout fallback and gaps between steps
+ */
+void loop_audio_sequence(unsigned long now) {
+  switch (sequence_state) {
+    case SEQUENCE_IDLE:
+      break;
+
+    case SEQUENCE_PLAYING:
+      if (now - step_started >= step_timeout) {
+        LOGW(TAG, "Sequence: no finished event for track %u - timed out", sequence_steps[sequence_index].track);
+        finish_step(now);
+      }
+      break;
+
+    case SEQUENCE_GAP:
+      if (now - step_started >= sequence_steps[sequence_index].gap_after_ms) {
+        sequence_index++;
+        if (!start_step(now)) {
+          sequence_state = SEQUENCE_IDLE;
+        }
+      }
+      break;
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef AUDIO_SEQUENCER_H
+#define AUDIO_SEQUENCER_H
+
+#include <Arduino.h>
+#include "AudioControlDFPlayer.h"
+
+// Audio sequencer - plays a short playlist of tracks back to back
+//
+// Each step advances when the DFPlayer reports the track finished (AUDIO_EVENT_PLAY_FINISHED)
+// or reports an error for it, so a greeting lasts exactly as long as its sounds do. The
+// per-step timeout is only a fallback for modules that drop the finished notification.
+// Driven from loop_audio_dfplayer() - no extra loop call needed.
+
+#define AUDIO_SEQUENCE_MAX_STEPS 4
+
+// Once a track's length has been learned (get_track_duration), its timeout is tightened to
+// that length plus this margin, which covers the queue and the module's load time
+#define AUDIO_SEQUENCE_TIMEOUT_MARGIN_MS 1000
+
+struct AudioSequenceStep {
+  uint8_t track;          // File number to play (0001.mp3 = 1)
+  uint16_t timeout_ms;    // Give up waiting for the finished event after this long
+  uint16_t gap_after_ms;  // Silence before the next step starts
+};
+
+// Start playing steps in order, replacing any sequence already running
+// Returns false if the DFPlayer can't take the first track (not ready, queue full)
+bool audio_sequence_start(const AudioSequenceStep* steps, uint8_t count);
+
+// Abandon the running sequence and stop playback
+void audio_sequence_stop();
+
+// True until the last step has finished
+bool audio_sequence_running();
+
+// Index of the step currently playing or waiting out its gap, -1 when idle
+int audio_sequence_step();
+
+// Hooks called by the DFPlayer driver
+void audio_sequence_handle_event(AudioEvent event, uint16_t value);
+void loop_audio_sequence(unsigned long now);
+
+#endif // AUDIO_SEQUENCER_H
@@ -0,0 +1,50 @@
+#ifndef TRACK_MANIFEST_H
+#define TRACK_MANIFEST_H
+
+// Generated by tools/generate_track_manifest.py from assets/mp3_for_sd - do not edit
+// Regenerate whenever the SD card files change
+
+#include <stdint.h>
+
+#define TRACK_MANIFEST_COUNT 13
+#define TRACK_LOUDNESS_UNKNOWN INT16_MIN
+
+struct TrackManifestEntry {
+  uint32_t duration_ms;   // Decoded length
+  int16_t loudness_x10;   // Integrated loudness in 0.1 LUFS (TRACK_LOUDNESS_UNKNOWN if not measured) -
+                          // for leveling the files, not used by the firmware
+};
+
+// Indexed by track number - entry 0 is unused (tracks start at 0001.mp3)
+static const TrackManifestEntry TRACK_MANIFEST[TRACK_MANIFEST_COUNT + 1] = {
+  { 0, TRACK_LOUDNESS_UNKNOWN },
+  { 7863, TRACK_LOUDNESS_UNKNOWN },  // 0001_addams-family.mp3
+  { 3030, TRACK_LOUDNESS_UNKNOWN },  // 0002_chime.mp3
+  { 1045, TRACK_LOUDNESS_UNKNOWN },  // 0003_error.mp3
+  { 1045, TRACK_LOUDNESS_UNKNOWN },  // 0004_excellent.mp3
+  { 3109, TRACK_LOUDNESS_UNKNOWN },  // 0005_foolish.mp3
+  { 993, TRACK_LOUDNESS_UNKNOWN },  // 0006_hello.mp3
+  { 19357, TRACK_LOUDNESS_UNKNOWN },  // 0007_imperial_march.mp3
+  { 2116, TRACK_LOUDNESS_UNKNOWN },  // 0008_operational.mp3
+  { 12800, TRACK_LOUDNESS_UNKNOWN },  // 0009_pirate-clip.mp3
+  { 1750, TRACK_LOUDNESS_UNKNOWN },  // 0010_startours.mp3
+  { 183, TRACK_LOUDNESS_UNKNOWN },  // 0011_tap-start.mp3
+  { 16065, TRACK_LOUDNESS_UNKNOWN },  // 0012_vader_breathing.mp3
+  { 2351, TRACK_LOUDNESS_UNKNOWN },  // 0013_wizard_harry.mp3
+};
+
+#define TRACK_MANIFEST_ADDAMS_FAMILY 1
+#define TRACK_MANIFEST_CHIME 2
+#define TRACK_MANIFEST_ERROR 3
+#define TRACK_MANIFEST_EXCELLENT 4
+#define TRACK_MANIFEST_FOOLISH 5
+#define TRACK_MANIFEST_HELLO 6
+#define TRACK_MANIFEST_IMPERIAL_MARCH 7
+#define TRACK_MANIFEST_OPERATIONAL 8
+#define TRACK_MANIFEST_PIRATE_CLIP 9
+#define TRACK_MANIFEST_STARTOURS 10
+#define TRACK_MANIFEST_TAP_START 11
+#define TRACK_MANIFEST_VADER_BREATHING 12
+#define TRACK_MANIFEST_WIZARD_HARRY 13
+
+#endif // TRACK_MANIFEST_H
@@ -5,10 +5,14 @@
 #include <FastLED.h>
 #include <AudioControlDFPlayer.h>
 
+// Maximum band name length including the terminator
+// Names are stored inline so a band can be copied into the registry and band store as-is
+#define BAND_NAME_LENGTH 24
+
 // Band configuration structure with sound variation support
 struct BandConfig {
   uint64_t band_id;              // RFID UID (unique identifier) - supports both 32-bit and 64-bit UIDs
-  const char* name;              // Human-readable name for Home Assistant
+  char name[BAND_NAME_LENGTH];   // Human-readable name for Home Assistant
   CRGB led_color;                // LED color to display
   uint8_t sound_files[3];        // Array of up to 3 sound file numbers
   uint8_t num_sounds;            // Number of sounds available for this band
@@ -16,10 +20,8 @@ struct BandConfig {
 };
 
 // External declarations - defined in main.cpp
+// Compiled-in defaults; loaded into the band registry (BandRegistry.h) at boot
 extern BandConfig BAND_CONFIGS[];
 extern const int NUM_BANDS;
 
-// Helper function to find band configuration by ID (accepts both 32-bit and 64-bit)
-BandConfig* find_band_config(uint64_t band_id);
-
 #endif // BAND_CONFIG_H
@@ -0,0 +1,255 @@
+#include "BandRegistry.h"
+#include <DebugConfig.h>
+#include <atomic>
+
+#if (BAND_REGISTRY_CAPACITY & (BAND_REGISTRY_CAPACITY - 1)) != 0
+#error "BAND_REGISTRY_CAPACITY must be a power of two"
+#endif
+
+#if BAND_REGISTRY_CAPACITY > 0x8000
+#error "BAND_REGISTRY_CAPACITY must fit the 16-bit index"
+#endif
+
+#define BAND_REGISTRY_MASK (BAND_REGISTRY_CAPACITY - 1)
+
+// Index slots hold the entry number, or one of these
+// Removed entries leave a tombstone so later probe chains stay intact
+#define INDEX_EMPTY 0xFFFF
+#define INDEX_DELETED 0xFFFE
+
+// Past this many bands plus tombstones the index is rebuilt - provisioning churn would
+// otherwise use up the empty slots and an unknown UID would probe the whole table
+#define BAND_REGISTRY_MAX_OCCUPIED (BAND_REGISTRY_CAPACITY / 8 * 7)
+
+// Flat storage - one allocation each for the entries and the index, none per band
+// Entries stay put; only the index is rebuilt, so an entry's slot number never changes
+static BandConfig* band_slots = nullptr;
+static uint8_t* band_slot_used = nullptr;
+static uint16_t* band_index = nullptr;
+static int band_count = 0;
+static int band_tombstones = 0;
+
+// Sequence lock for band_registry_lookup() - odd while the owning task is changing a slot
+static std::atomic<uint32_t> band_sequence(0);
+
+static void begin_change() {
+  band_sequence.store(band_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+static void end_change() {
+  band_sequence.store(band_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// 64-bit mix (MurmurHash3 finalizer) - spreads sequential UIDs across the table
+static uint32_t band_hash(uint64_t band_id) {
+  band_id ^= band_id >> 33;
+  band_id *= 0xff51afd7ed558ccdULL;
+  band_id ^= band_id >> 33;
+  band_id *= 0xc4ceb9fe1a85ec53ULL;
+  band_id ^= band_id >> 33;
+  return (uint32_t)band_id;
+}
+
+// Find the index position pointing at band_id, or -1
+static int find_index(uint64_t band_id) {
+  if (band_slots == nullptr) {
+    return -1;
+  }
+  
+  uint32_t index = band_hash(band_id) & BAND_REGISTRY_MASK;
+  
+  for (int probe = 0; probe < BAND_REGISTRY_CAPACITY; probe++) {
+    uint16_t slot = band_index[index];
+    if (slot == INDEX_EMPTY) {
+      return -1;  // End of probe chain - not registered
+    }
+    if (slot != INDEX_DELETED && band_slots[slot].band_id == band_id) {
+      return index;
+    }
+    index = (index + 1) & BAND_REGISTRY_MASK;
+  }
+  return -1;
+}
+
+// Find the slot holding band_id, or -1
+static int find_slot(uint64_t band_id) {
+  int index = find_index(band_id);
+  return (index < 0) ? -1 : band_index[index];
+}
+
+// Point the first empty index slot on band_id's probe chain at slot (no tombstones left)
+static void index_slot(uint64_t band_id, int slot) {
+  uint32_t index = band_hash(band_id) & BAND_REGISTRY_MASK;
+  while (band_index[index] != INDEX_EMPTY) {
+    index = (index + 1) & BAND_REGISTRY_MASK;
+  }
+  band_index[index] = slot;
+}
+
+// Drop every tombstone by indexing the registered entries afresh - O(capacity), and rare:
+// even at full load the next one is BAND_REGISTRY_CAPACITY / 8 removals away
+static void rebuild_index() {
+  begin_change();
+  memset(band_index, 0xFF, BAND_REGISTRY_CAPACITY * sizeof(uint16_t));
+  for (int slot = 0; slot < BAND_REGISTRY_CAPACITY; slot++) {
+    if (band_slot_used[slot]) {
+      index_slot(band_slots[slot].band_id, slot);
+    }
+  }
+  band_tombstones = 0;
+  end_change();
+}
+
+void setup_band_registry(const BandConfig* configs, int count) {
+  if (band_slots == nullptr) {
+    band_slots = (BandConfig*)calloc(BAND_REGISTRY_CAPACITY, sizeof(BandConfig));
+    band_slot_used = (uint8_t*)calloc(BAND_REGISTRY_CAPACITY, sizeof(uint8_t));
+    band_index = (uint16_t*)calloc(BAND_REGISTRY_CAPACITY, sizeof(uint16_t));
+    if (band_slots == nullptr || band_slot_used == nullptr || band_index == nullptr) {
+      DEBUG_PRINTLN("ERROR: Not enough memory for the band registry!");
+      free(band_slots);
+      free(band_slot_used);
+      free(band_index);
+      band_slots = nullptr;
+      band_slot_used = nullptr;
+      band_index = nullptr;
+      return;
+    }
+  }
+  memset(band_slot_used, 0, BAND_REGISTRY_CAPACITY);
+  memset(band_index, 0xFF, BAND_REGISTRY_CAPACITY * sizeof(uint16_t));
+  band_count = 0;
+  band_tombstones = 0;
+  
+  for (int i = 0; i < count; i++) {
+    if (band_registry_insert(configs[i]) == nullptr) {
+      DEBUG_PRINTLN("WARNING: Band registry full - remaining bands not loaded");
+      break;
+    }
+  }
+  
+  DEBUG_PRINT("Band registry ready: ");
+  DEBUG_PRINT(band_count);
+  DEBUG_PRINTLN(" bands");
+}
+
+BandConfig* band_registry_insert(const BandConfig& config) {
+  if (band_slots == nullptr) {
+    return nullptr;
+  }
+  
+  uint32_t home = band_hash(config.band_id) & BAND_REGISTRY_MASK;
+  uint32_t index = home;
+  int first_free = -1;
+  
+  // Walk the probe chain: replace an existing entry, otherwise take the first free index slot
+  for (int probe = 0; probe < BAND_REGISTRY_CAPACITY; probe++) {
+    uint16_t slot = band_index[index];
+    if (slot == INDEX_EMPTY || slot == INDEX_DELETED) {
+      if (first_free < 0) {
+        first_free = index;
+      }
+      if (slot == INDEX_EMPTY) {
+        break;  // Band can't be further along the chain
+      }
+    } else if (band_slots[slot].band_id == config.band_id) {
+      begin_change();
+      band_slots[slot] = config;
+      end_change();
+      return &band_slots[slot];
+    }
+    index = (index + 1) & BAND_REGISTRY_MASK;
+  }
+  
+  if (first_free < 0 || band_count >= BAND_REGISTRY_MAX_BANDS) {
+    return nullptr;
+  }
+  
+  // Entries are at most 75% used, so a free one is a few steps from the band's home slot
+  int slot = home;
+  while (band_slot_used[slot]) {
+    slot = (slot + 1) & BAND_REGISTRY_MASK;
+  }
+  
+  begin_change();
+  band_slots[slot] = config;
+  band_slot_used[slot] = 1;
+  if (band_index[first_free] == INDEX_DELETED) {
+    band_tombstones--;
+  }
+  band_index[first_free] = slot;
+  end_change();
+  band_count++;
+  return &band_slots[slot];
+}
+
+bool band_registry_remove(uint64_t band_id) {
+  int index = find_index(band_id);
+  if (index < 0) {
+    return false;
+  }
+  
+  begin_change();
+  band_slot_used[band_index[index]] = 0;
+  if (band_index[(index + 1) & BAND_REGISTRY_MASK] == INDEX_EMPTY) {
+    // End of the chain - no probe needs this position, nor the tombstones right before it
+    band_index[index] = INDEX_EMPTY;
+    index = (index - 1) & BAND_REGISTRY_MASK;
+    while (band_index[index] == INDEX_DELETED) {
+      band_index[index] = INDEX_EMPTY;
+      band_tombstones--;
+      index = (index - 1) & BAND_REGISTRY_MASK;
+    }
+  } else {
+    band_index[index] = INDEX_DELETED;
+    band_tombstones++;
+  }
+  end_change();
+  band_count--;
+  
+  if (band_count + band_tombstones > BAND_REGISTRY_MAX_OCCUPIED) {
+    rebuild_index();
+  }
+  return true;
+}
+
+BandConfig* find_band_config(uint64_t band_id) {
+  int slot = find_slot(band_id);
+  return (slot < 0) ? nullptr : &band_slots[slot];
+}
+
+bool band_registry_lookup(uint64_t band_id, BandConfig* band) {
+  for (;;) {
+    uint32_t sequence = band_sequence.load(std::memory_order_acquire);
+    if (sequence & 1) {
+      continue;  // Change in progress on the other core - a handful of stores, or an index rebuild
+    }
+    int slot = find_slot(band_id);
+    if (slot >= 0) {
+      *band = band_slots[slot];
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (band_sequence.load(std::memory_order_relaxed) == sequence) {
+      return slot >= 0;
+    }
+  }
+}
+
+int band_registry_count() {
+  return band_count;
+}
+
+int band_registry_slot(const BandConfig* band) {
+  if (band_slots == nullptr || band < band_slots || band >= band_slots + BAND_REGISTRY_CAPACITY) {
+    return -1;
+  }
+  return band - band_slots;
+}
+
+BandConfig* band_registry_at(int slot) {
+  if (band_slots == nullptr || slot < 0 || slot >= BAND_REGISTRY_CAPACITY || !band_slot_used[slot]) {
+    return nullptr;
+  }
+  return &band_slots[slot];
+}
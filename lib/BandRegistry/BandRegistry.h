@@ -0,0 +1,51 @@
+#ifndef BAND_REGISTRY_H
+#define BAND_REGISTRY_H
+
+#include <Arduino.h>
+#include <BandConfig.h>
+
+// Band registry - hash table of BandConfig keyed by the 64-bit band UID
+// Open addressing with linear probing over a 16-bit index into one flat entry array:
+// O(1) expected lookup, no per-entry heap allocation. Entries never move once inserted -
+// removals only rebuild the index - so a slot index stays valid for the lifetime of the
+// band (useful for per-band counters).
+//
+// One task owns the registry (the network task - provisioning and sound rotation) and is the
+// only one that inserts, removes or reads entries through pointers. Any other task copies an
+// entry with band_registry_lookup(), which never waits: a copy that overlapped a change is
+// simply taken again.
+
+// Number of slots - must be a power of two, at most 32768 (16-bit index)
+// 2048 slots hold 1536 bands (~84KB with the index), allocated once from the heap at boot
+// so the table doesn't eat into the static DRAM segment
+#ifndef BAND_REGISTRY_CAPACITY
+#define BAND_REGISTRY_CAPACITY 2048
+#endif
+
+// Inserts are refused beyond this many bands to keep probe sequences short (75% load)
+#define BAND_REGISTRY_MAX_BANDS (BAND_REGISTRY_CAPACITY / 4 * 3)
+
+// Build the registry from a config source (call once in setup())
+void setup_band_registry(const BandConfig* configs, int count);
+
+// Add a band, or replace the existing entry with the same band_id
+// Returns the stored entry, or nullptr if the registry is full
+BandConfig* band_registry_insert(const BandConfig& config);
+
+// Remove a band - returns false if it was not registered
+bool band_registry_remove(uint64_t band_id);
+
+// Find band configuration by ID (accepts both 32-bit and 64-bit)
+// Returns pointer to BandConfig or nullptr if not found - owning task only
+BandConfig* find_band_config(uint64_t band_id);
+
+// Copy a band's configuration - safe from any task while the owner changes the registry
+// Returns false if the band is not registered
+bool band_registry_lookup(uint64_t band_id, BandConfig* band);
+
+// Registry status and iteration
+int band_registry_count();                        // Number of registered bands
+int band_registry_slot(const BandConfig* band);   // Slot index of a registered entry (-1 if not an entry)
+BandConfig* band_registry_at(int slot);           // Entry in a slot, or nullptr if the slot is free
+
+#endif // BAND_REGISTRY_H
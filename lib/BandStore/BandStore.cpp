@@ -0,0 +1,369 @@
+#include "BandStore.h"
+#include <BandRegistry.h>
+#include <DebugConfig.h>
+#include <esp_partition.h>
+
+#define BAND_STORE_HEADER_MAGIC 0x42414E44  // "BAND"
+#define BAND_RECORD_MAGIC       0x42524543  // "BREC"
+#define BAND_STORE_ERASED       0xFFFFFFFF  // Magic of a never-written slot
+#define BAND_STORE_SECTOR_SIZE  4096
+
+enum BandRecordOp : uint8_t {
+  BAND_RECORD_PUT = 1,
+  BAND_RECORD_DELETE = 2,
+  BAND_RECORD_ROTATION = 3        // A band as compiled in - only its sound rotation is replayed
+};
+
+// On-flash band record (one log entry)
+struct BandRecord {
+  uint32_t magic;                 // BAND_RECORD_MAGIC, or BAND_STORE_ERASED for a free slot
+  uint8_t op;                     // BandRecordOp
+  uint8_t num_sounds;
+  uint8_t current_sound_index;
+  uint8_t sound_files[3];
+  uint8_t color[3];               // R, G, B
+  uint8_t reserved1[3];
+  uint64_t band_id;
+  char name[BAND_NAME_LENGTH];
+  uint32_t generation;            // Bank generation this record was written in
+  uint8_t reserved2[BAND_STORE_RECORD_SIZE - 28 - BAND_NAME_LENGTH - 4];
+  uint32_t crc;                   // CRC32 of all preceding bytes
+};
+
+// Bank header - occupies the first record slot of each bank
+struct BandStoreHeader {
+  uint32_t magic;                 // BAND_STORE_HEADER_MAGIC
+  uint32_t generation;            // Incremented on every compaction - highest valid bank wins
+  uint32_t record_size;           // BAND_STORE_RECORD_SIZE when the bank was written
+  uint8_t reserved[BAND_STORE_RECORD_SIZE - 16];
+  uint32_t crc;                   // CRC32 of all preceding bytes
+};
+
+static_assert(sizeof(BandRecord) == BAND_STORE_RECORD_SIZE, "BandRecord must match BAND_STORE_RECORD_SIZE");
+static_assert(sizeof(BandStoreHeader) == BAND_STORE_RECORD_SIZE, "BandStoreHeader must match BAND_STORE_RECORD_SIZE");
+
+static const esp_partition_t* store_partition = nullptr;
+static uint32_t bank_size = 0;           // Bytes per bank (sector multiple)
+static int records_per_bank = 0;         // Record slots per bank, including the header slot
+static uint8_t active_bank = 0;
+static uint32_t active_generation = 0;
+static int next_record = 1;              // Next free record slot in the active bank (slot 0 = header)
+static bool store_ready = false;
+static const BandConfig* default_bands = nullptr;  // Compiled-in bands (BAND_CONFIGS)
+static int default_band_count = 0;
+
+// CRC32 (IEEE, reflected) with a 16-entry nibble table - small and fast enough for boot
+static uint32_t band_store_crc32(const void* data, size_t length) {
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+  const uint8_t* bytes = (const uint8_t*)data;
+  uint32_t crc = 0xFFFFFFFF;
+  while (length--) {
+    crc ^= *bytes++;
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+static uint32_t slot_offset(uint8_t bank, int slot) {
+  return bank * bank_size + slot * BAND_STORE_RECORD_SIZE;
+}
+
+// Write one record slot, erasing its sector first if this is the first slot in it
+// (sector 0 holds the header and is erased when the bank is started)
+static bool write_slot(uint8_t bank, int slot, const void* data) {
+  uint32_t offset = slot_offset(bank, slot);
+  if (offset % BAND_STORE_SECTOR_SIZE == 0) {
+    if (esp_partition_erase_range(store_partition, offset, BAND_STORE_SECTOR_SIZE) != ESP_OK) {
+      return false;
+    }
+  }
+  return esp_partition_write(store_partition, offset, data, BAND_STORE_RECORD_SIZE) == ESP_OK;
+}
+
+static bool read_header(uint8_t bank, BandStoreHeader* header) {
+  if (esp_partition_read(store_partition, slot_offset(bank, 0), header, sizeof(*header)) != ESP_OK) {
+    return false;
+  }
+  return header->magic == BAND_STORE_HEADER_MAGIC &&
+         header->record_size == BAND_STORE_RECORD_SIZE &&
+         header->crc == band_store_crc32(header, offsetof(BandStoreHeader, crc));
+}
+
+// Commit a bank by writing its header - always the last write of a format/compaction
+static bool write_header(uint8_t bank, uint32_t generation) {
+  BandStoreHeader header;
+  memset(&header, 0xFF, sizeof(header));
+  header.magic = BAND_STORE_HEADER_MAGIC;
+  header.generation = generation;
+  header.record_size = BAND_STORE_RECORD_SIZE;
+  header.crc = band_store_crc32(&header, offsetof(BandStoreHeader, crc));
+  return esp_partition_write(store_partition, slot_offset(bank, 0), &header, sizeof(header)) == ESP_OK;
+}
+
+// Start a fresh generation in a bank: erase the header sector so the old header is gone
+static bool start_bank(uint8_t bank) {
+  return esp_partition_erase_range(store_partition, slot_offset(bank, 0), BAND_STORE_SECTOR_SIZE) == ESP_OK;
+}
+
+static const BandConfig* find_default_band(uint64_t band_id) {
+  for (int i = 0; i < default_band_count; i++) {
+    if (default_bands[i].band_id == band_id) {
+      return &default_bands[i];
+    }
+  }
+  return nullptr;
+}
+
+// Record type for saving a band - a band that still matches its compiled-in default only
+// needs its rotation stored, so later edits to BAND_CONFIGS still reach it
+static uint8_t put_op(const BandConfig& band) {
+  const BandConfig* compiled = find_default_band(band.band_id);
+  if (compiled != nullptr && strcmp(compiled->name, band.name) == 0 && compiled->led_color == band.led_color &&
+      memcmp(compiled->sound_files, band.sound_files, sizeof(band.sound_files)) == 0 &&
+      compiled->num_sounds == band.num_sounds) {
+    return BAND_RECORD_ROTATION;
+  }
+  return BAND_RECORD_PUT;
+}
+
+static void encode_record(BandRecord* record, uint8_t op, const BandConfig& band) {
+  memset(record, 0xFF, sizeof(*record));
+  record->magic = BAND_RECORD_MAGIC;
+  record->op = op;
+  record->num_sounds = band.num_sounds;
+  record->current_sound_index = band.current_sound_index;
+  memcpy(record->sound_files, band.sound_files, sizeof(record->sound_files));
+  record->color[0] = band.led_color.r;
+  record->color[1] = band.led_color.g;
+  record->color[2] = band.led_color.b;
+  record->band_id = band.band_id;
+  memset(record->name, 0, sizeof(record->name));
+  snprintf(record->name, sizeof(record->name), "%s", band.name);
+  record->generation = active_generation;
+  record->crc = band_store_crc32(record, offsetof(BandRecord, crc));
+}
+
+static void decode_record(const BandRecord* record, BandConfig* band) {
+  band->band_id = record->band_id;
+  memcpy(band->name, record->name, sizeof(band->name));
+  band->name[sizeof(band->name) - 1] = '\0';
+  band->led_color = CRGB(record->color[0], record->color[1], record->color[2]);
+  memcpy(band->sound_files, record->sound_files, sizeof(band->sound_files));
+  band->num_sounds = (record->num_sounds >= 1 && record->num_sounds <= 3) ? record->num_sounds : 1;
+  band->current_sound_index = (record->current_sound_index < band->num_sounds) ? record->current_sound_index : 0;
+}
+
+// A record written in the active generation that survived intact
+static bool is_live_record(const BandRecord* record) {
+  return record->magic == BAND_RECORD_MAGIC &&
+         record->crc == band_store_crc32(record, offsetof(BandRecord, crc)) &&
+         record->generation == active_generation;
+}
+
+// Replay the active bank's log into the registry
+// The bank is memory-mapped so the whole log is read in a single pass through the flash cache
+static bool load_active_bank() {
+  const void* map_ptr = nullptr;
+  spi_flash_mmap_handle_t map_handle;
+  if (esp_partition_mmap(store_partition, slot_offset(active_bank, 0), bank_size,
+                         SPI_FLASH_MMAP_DATA, &map_ptr, &map_handle) != ESP_OK) {
+    return false;
+  }
+  
+  const BandRecord* records = (const BandRecord*)map_ptr;
+  const int slots_per_sector = BAND_STORE_SECTOR_SIZE / BAND_STORE_RECORD_SIZE;
+  int loaded = 0;
+  int slot = 1;
+  for (; slot < records_per_bank; slot++) {
+    const BandRecord* record = &records[slot];
+    if (record->magic == BAND_STORE_ERASED) {
+      break;  // End of log
+    }
+    if (!is_live_record(record)) {
+      // Torn write or leftover from an older generation. Appends after a torn write resumed on
+      // the next fresh sector, so the log carries on there if that sector starts with a live record
+      int resume = (slot + slots_per_sector - 1) / slots_per_sector * slots_per_sector;
+      if (resume != slot && resume < records_per_bank && is_live_record(&records[resume])) {
+        DEBUG_PRINTLN("Band store: skipped a torn record");
+        slot = resume - 1;
+        continue;
+      }
+      // Otherwise the log ends here - resume on a fresh sector so the next append never lands
+      // on unerased flash
+      DEBUG_PRINTLN("Band store: log ends at an invalid record");
+      slot = resume;
+      break;
+    }
+    
+    if (record->op == BAND_RECORD_DELETE) {
+      band_registry_remove(record->band_id);
+    } else if (record->op == BAND_RECORD_ROTATION) {
+      // The band as compiled in now, at the stored rotation - gone if BAND_CONFIGS dropped it
+      const BandConfig* compiled = find_default_band(record->band_id);
+      if (compiled == nullptr) {
+        band_registry_remove(record->band_id);
+      } else {
+        BandConfig band = *compiled;
+        band.current_sound_index = (record->current_sound_index < band.num_sounds) ? record->current_sound_index : 0;
+        band_registry_insert(band);
+      }
+    } else {
+      BandConfig band;
+      decode_record(record, &band);
+      if (band_registry_insert(band) == nullptr) {
+        DEBUG_PRINTLN("WARNING: Band registry full - persisted band not loaded");
+      }
+    }
+    loaded++;
+  }
+  next_record = slot;
+  
+  spi_flash_munmap(map_handle);
+  
+  DEBUG_PRINT("Band store: replayed ");
+  DEBUG_PRINT(loaded);
+  DEBUG_PRINTLN(" records");
+  return true;
+}
+
+// Rewrite the live bands into the spare bank and switch to it
+static bool compact_band_store() {
+  uint8_t spare = 1 - active_bank;
+  uint32_t generation = active_generation + 1;
+  DEBUG_PRINTLN("Band store: compacting...");
+  
+  if (!start_bank(spare)) {
+    return false;
+  }
+  
+  // Records are tagged with the new generation while the old bank stays active until the header lands
+  uint32_t previous_generation = active_generation;
+  active_generation = generation;
+  
+  BandRecord record;
+  int slot = 1;
+  for (int i = 0; i < BAND_REGISTRY_CAPACITY; i++) {
+    BandConfig* band = band_registry_at(i);
+    if (band == nullptr) {
+      continue;
+    }
+    encode_record(&record, put_op(*band), *band);
+    if (slot >= records_per_bank || !write_slot(spare, slot, &record)) {
+      active_generation = previous_generation;
+      DEBUG_PRINTLN("Band store: compaction failed - keeping previous bank");
+      return false;
+    }
+    slot++;
+  }
+  
+  if (!write_header(spare, generation)) {
+    active_generation = previous_generation;
+    return false;
+  }
+  
+  active_bank = spare;
+  next_record = slot;
+  DEBUG_PRINT("Band store: compacted to ");
+  DEBUG_PRINT(slot - 1);
+  DEBUG_PRINTLN(" records");
+  return true;
+}
+
+// Append one log record, compacting first if the active bank is full
+static bool append_record(uint8_t op, const BandConfig& band) {
+  if (!store_ready) {
+    return false;
+  }
+  
+  if (next_record >= records_per_bank) {
+    // The registry already holds this change, so compaction persists it
+    return compact_band_store();
+  }
+  
+  BandRecord record;
+  encode_record(&record, op, band);
+  if (!write_slot(active_bank, next_record, &record)) {
+    return false;
+  }
+  next_record++;
+  return true;
+}
+
+bool setup_band_store(const BandConfig* defaults, int count) {
+  default_bands = defaults;
+  default_band_count = count;
+  store_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                             BAND_STORE_PARTITION_LABEL);
+  if (store_partition == nullptr) {
+    DEBUG_PRINTLN("Band store: partition '" BAND_STORE_PARTITION_LABEL "' not found");
+    return false;
+  }
+  
+  // Two banks, each a whole number of sectors
+  bank_size = (store_partition->size / 2) / BAND_STORE_SECTOR_SIZE * BAND_STORE_SECTOR_SIZE;
+  if (bank_size > BAND_STORE_MAX_BANK_SIZE) {
+    bank_size = BAND_STORE_MAX_BANK_SIZE;
+  }
+  records_per_bank = bank_size / BAND_STORE_RECORD_SIZE;
+  
+  // Pick the valid bank with the highest generation
+  BandStoreHeader headers[2];
+  bool valid[2] = { read_header(0, &headers[0]), read_header(1, &headers[1]) };
+  
+  if (!valid[0] && !valid[1]) {
+    DEBUG_PRINTLN("Band store: no valid bank - formatting");
+    active_bank = 0;
+    active_generation = 1;
+    if (!start_bank(0) || !write_header(0, active_generation)) {
+      DEBUG_PRINTLN("Band store: format failed");
+      return false;
+    }
+    next_record = 1;
+    store_ready = true;
+    return true;
+  }
+  
+  if (valid[0] && valid[1]) {
+    active_bank = (headers[1].generation > headers[0].generation) ? 1 : 0;
+  } else {
+    active_bank = valid[1] ? 1 : 0;
+  }
+  active_generation = headers[active_bank].generation;
+  
+  if (!load_active_bank()) {
+    DEBUG_PRINTLN("Band store: failed to map partition");
+    return false;
+  }
+  
+  store_ready = true;
+  DEBUG_PRINT("Band store ready: ");
+  DEBUG_PRINT(band_registry_count());
+  DEBUG_PRINTLN(" bands");
+  return true;
+}
+
+bool band_store_save(const BandConfig& band) {
+  return append_record(put_op(band), band);
+}
+
+bool band_store_delete(uint64_t band_id) {
+  BandConfig band = {};
+  band.band_id = band_id;
+  return append_record(BAND_RECORD_DELETE, band);
+}
+
+bool band_store_is_ready() {
+  return store_ready;
+}
+
+int band_store_record_count() {
+  return store_ready ? next_record - 1 : 0;
+}
+
+int band_store_capacity() {
+  return records_per_bank - 1;
+}
@@ -0,0 +1,44 @@
+#ifndef BAND_STORE_H
+#define BAND_STORE_H
+
+#include <Arduino.h>
+#include <BandConfig.h>
+
+// Persistent band database in a raw flash partition
+//
+// Bands are stored as fixed-size records in an append-only log, so updating one band
+// (e.g. its sound rotation) writes a single 64-byte record instead of the whole table.
+// The partition is split into two banks; when the active bank fills up, the live bands
+// are compacted into the spare bank and its header is written last. A crash at any point
+// leaves either the old or the new bank valid, and a torn record fails its CRC.
+// Flash sectors are erased on demand as the log first enters them, and every record
+// carries its bank generation so leftovers from an older generation are never replayed.
+//
+// Uses the "spiffs" data partition of the default partition table (SPIFFS is unused),
+// so existing units can be updated over OTA without a new partition table. The end of the
+// partition holds the flash event log (EventLog.h) - keep 2 x BAND_STORE_MAX_BANK_SIZE
+// within EVENT_FLASH_RESERVED.
+
+#define BAND_STORE_PARTITION_LABEL "spiffs"
+#define BAND_STORE_RECORD_SIZE 64
+#define BAND_STORE_MAX_BANK_SIZE (256 * 1024)        // Up to 4095 records per bank
+
+// Mount the store and load every persisted band into the band registry in one pass
+// Call after setup_band_registry() with the same compiled-in defaults - persisted bands
+// override them, except that a band saved as compiled in keeps only its sound rotation and
+// otherwise follows the defaults (edited there, it changes; dropped there, it is gone)
+// Returns false if the partition is missing (system continues with compiled-in bands)
+bool setup_band_store(const BandConfig* defaults, int count);
+
+// Persist one band (insert or update) / record its removal
+// Update the band registry first - a compaction writes the registry's current contents
+// A band that matches its compiled-in default is stored as its sound rotation only
+bool band_store_save(const BandConfig& band);
+bool band_store_delete(uint64_t band_id);
+
+// Status
+bool band_store_is_ready();
+int band_store_record_count();   // Records in the active bank's log
+int band_store_capacity();       // Records that fit in one bank
+
+#endif // BAND_STORE_H
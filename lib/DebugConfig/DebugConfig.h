@@ -2,16 +2,22 @@
 #define DEBUG_CONFIG_H
 
 #include <Arduino.h>
+#include "DebugLog.h"
 
 // Set to 1 to enable debug output, 0 to disable
 #define DEBUG_ENABLED 1
 
 #if DEBUG_ENABLED
-  // Safe debug macros that check if Serial is available
-  // This prevents blocking when running on DC power without USB
-  #define DEBUG_PRINT(...) if (Serial) Serial.print(__VA_ARGS__)
-  #define DEBUG_PRINTLN(...) if (Serial) Serial.println(__VA_ARGS__)
-  #define DEBUG_PRINTF(...) if (Serial) Serial.printf(__VA_ARGS__)
+  // Print-style debug output - queued in the debug log (DebugLog.h) as DEBUG-level lines,
+  // so a print never waits on the UART. Serial is checked when the log task writes them out,
+  // which keeps a board on DC power without USB from blocking.
+  // New code should use the LOGx(tag, format, ...) macros, which carry a level and module tag.
+  #define DEBUG_PRINT(...) \
+    do { if (LOG_LEVEL_DEBUG <= LOG_COMPILE_LEVEL && LOG_LEVEL_DEBUG <= log_runtime_level) debug_log.print(__VA_ARGS__); } while (0)
+  #define DEBUG_PRINTLN(...) \
+    do { if (LOG_LEVEL_DEBUG <= LOG_COMPILE_LEVEL && LOG_LEVEL_DEBUG <= log_runtime_level) debug_log.println(__VA_ARGS__); } while (0)
+  #define DEBUG_PRINTF(...) \
+    do { if (LOG_LEVEL_DEBUG <= LOG_COMPILE_LEVEL && LOG_LEVEL_DEBUG <= log_runtime_level) debug_log.printf(__VA_ARGS__); } while (0)
 #else
   #define DEBUG_PRINT(...)
   #define DEBUG_PRINTLN(...)
@@ -0,0 +1,219 @@
+#include "DebugLog.h"
+#include <atomic>
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+// Ring slot - stamp says who may touch it next (Vyukov's bounded queue, offset by the slot
+// index so a zero-initialized ring is already valid - logging works before setup runs):
+//   stamp + index == position      free for the producer claiming that position
+//   stamp + index == position + 1  filled, waiting for the log task
+struct LogRecord {
+  std::atomic<uint32_t> stamp;
+  uint32_t timestamp_ms;
+  uint8_t level;
+  uint8_t length;
+  bool binary;      // Event record: id + encoded args in data (EventLog.h)
+  uint32_t id;
+  const char* tag;  // Text records - nullptr for DEBUG_PRINT lines, written as they are
+  char text[LOG_MESSAGE_MAX];
+};
+
+static LogRecord ring[LOG_RING_SIZE];
+static std::atomic<uint32_t> ring_head(0);  // Next position to claim - producers
+static uint32_t ring_tail = 0;              // Next position to write out - log task only
+static std::atomic<uint32_t> dropped(0);
+static uint32_t dropped_reported = 0;
+static std::atomic<bool> draining(false);   // log_flush() from another task waits for the log task
+
+volatile uint8_t log_runtime_level = LOG_COMPILE_LEVEL;
+
+DebugLogPrint debug_log;
+
+void log_set_level(uint8_t level) {
+  log_runtime_level = level;
+}
+
+uint32_t log_dropped() {
+  return dropped.load(std::memory_order_relaxed);
+}
+
+// Claim the slot for the next position - nullptr when the ring is full
+static LogRecord* claim_record(uint32_t* position) {
+  uint32_t pos = ring_head.load(std::memory_order_relaxed);
+  for (;;) {
+    uint32_t index = pos & (LOG_RING_SIZE - 1);
+    uint32_t stamp = ring[index].stamp.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(stamp + index - pos);
+    if (diff == 0) {
+      if (ring_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        *position = pos;
+        return &ring[index];
+      }
+    } else if (diff < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;  // Log task hasn't freed this slot yet
+    } else {
+      pos = ring_head.load(std::memory_order_relaxed);  // Another task took it
+    }
+  }
+}
+
+static void publish_record(LogRecord* record, uint32_t position) {
+  uint32_t index = position & (LOG_RING_SIZE - 1);
+  record->stamp.store(position + 1 - index, std::memory_order_release);
+}
+
+static void queue_text(uint8_t level, const char* tag, const char* text, size_t length) {
+  uint32_t position;
+  LogRecord* record = claim_record(&position);
+  if (record == nullptr) return;
+  if (length > LOG_MESSAGE_MAX) length = LOG_MESSAGE_MAX;
+  record->timestamp_ms = millis();
+  record->level = level;
+  record->binary = false;
+  record->tag = tag;
+  record->length = length;
+  memcpy(record->text, text, length);
+  publish_record(record, position);
+}
+
+void log_write_v(uint8_t level, const char* tag, const char* format, va_list args) {
+  uint32_t position;
+  LogRecord* record = claim_record(&position);
+  if (record == nullptr) return;
+  record->timestamp_ms = millis();
+  record->level = level;
+  record->binary = false;
+  record->tag = tag;
+  int length = vsnprintf(record->text, LOG_MESSAGE_MAX, format, args);
+  record->length = length < 0 ? 0 : (length >= LOG_MESSAGE_MAX ? LOG_MESSAGE_MAX - 1 : length);
+  publish_record(record, position);
+}
+
+void log_write(uint8_t level, const char* tag, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  log_write_v(level, tag, format, args);
+  va_end(args);
+}
+
+uint8_t* log_event_begin(uint8_t level, uint32_t id, uint32_t* position) {
+  LogRecord* record = claim_record(position);
+  if (record == nullptr) return nullptr;
+  record->timestamp_ms = millis();
+  record->level = level;
+  record->binary = true;
+  record->id = id;
+  return (uint8_t*)record->text;
+}
+
+void log_event_end(uint32_t position, size_t length) {
+  LogRecord* record = &ring[position & (LOG_RING_SIZE - 1)];
+  record->length = length;
+  publish_record(record, position);
+}
+
+// Frame one event record for the UART (and the flash log at EVENT_FLASH_LEVEL and above)
+static void write_event(const LogRecord& record) {
+  uint8_t frame[2 + EVENT_HEADER_SIZE + LOG_MESSAGE_MAX + 1];
+  uint8_t* payload = frame + 2;
+  size_t length = EVENT_HEADER_SIZE + record.length;
+  memcpy(payload, &record.id, 4);
+  memcpy(payload + 4, &record.timestamp_ms, 4);
+  payload[8] = record.level;
+  memcpy(payload + EVENT_HEADER_SIZE, record.text, record.length);
+  frame[0] = EVENT_FRAME_START;
+  frame[1] = length;
+  payload[length] = event_checksum(payload, length);
+
+  if (Serial) {
+    Serial.write(frame, length + 3);
+  }
+  if (record.level <= EVENT_FLASH_LEVEL) {
+    event_flash_append(payload, length);
+  }
+}
+
+// Log task side - write out one record, false if the ring is empty
+static bool drain_one() {
+  uint32_t index = ring_tail & (LOG_RING_SIZE - 1);
+  LogRecord& record = ring[index];
+  if (record.stamp.load(std::memory_order_acquire) + index != ring_tail + 1) {
+    return false;
+  }
+
+  if (record.binary) {
+    write_event(record);
+  } else if (Serial) {
+    if (record.tag != nullptr) {
+      static const char LEVEL_LETTERS[] = "-EWIDV";
+      char prefix[40];
+      int n = snprintf(prefix, sizeof(prefix), "[%lu] %c %s: ", (unsigned long)record.timestamp_ms,
+                       LEVEL_LETTERS[record.level <= LOG_LEVEL_VERBOSE ? record.level : 0], record.tag);
+      Serial.write((const uint8_t*)prefix, n < (int)sizeof(prefix) ? n : sizeof(prefix) - 1);
+    }
+    Serial.write((const uint8_t*)record.text, record.length);
+    Serial.write((const uint8_t*)"\r\n", 2);
+  }
+
+  record.stamp.store(ring_tail + LOG_RING_SIZE - index, std::memory_order_release);
+  ring_tail++;
+  return true;
+}
+
+void log_flush() {
+  while (draining.exchange(true, std::memory_order_acquire)) {
+    yield();
+  }
+  while (drain_one()) {
+  }
+  uint32_t lost = log_dropped();
+  if (lost != dropped_reported && Serial) {
+    Serial.printf("[log] %lu messages dropped - ring full\r\n", (unsigned long)(lost - dropped_reported));
+    dropped_reported = lost;
+  }
+  draining.store(false, std::memory_order_release);
+}
+
+static void log_task(void* parameter) {
+  for (;;) {
+    log_flush();
+    vTaskDelay(pdMS_TO_TICKS(LOG_TASK_INTERVAL_MS));
+  }
+}
+
+void setup_debug_log() {
+  setup_event_flash_log();
+  // Core 0 with the network tasks - the loop on core 1 only ever pays for filling a slot
+  xTaskCreatePinnedToCore(log_task, "log", LOG_TASK_STACK_SIZE, nullptr, LOG_TASK_PRIORITY, nullptr, 0);
+}
+
+// DEBUG_PRINT lines - each task builds its own line, queued at the newline
+struct PendingLine {
+  char text[LOG_MESSAGE_MAX];
+  size_t length;
+};
+
+static thread_local PendingLine pending_line;
+
+size_t DebugLogPrint::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t DebugLogPrint::write(const uint8_t* buffer, size_t size) {
+  PendingLine& line = pending_line;
+  for (size_t i = 0; i < size; i++) {
+    char c = (char)buffer[i];
+    if (c == '\n') {
+      queue_text(LOG_LEVEL_DEBUG, nullptr, line.text, line.length);
+      line.length = 0;
+    } else if (c != '\r') {
+      if (line.length == LOG_MESSAGE_MAX) {
+        queue_text(LOG_LEVEL_DEBUG, nullptr, line.text, line.length);  // Too long - split it
+        line.length = 0;
+      }
+      line.text[line.length++] = c;
+    }
+  }
+  return size;
+}
@@ -0,0 +1,119 @@
+#ifndef DEBUG_LOG_H
+#define DEBUG_LOG_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include "EventLog.h"
+
+// Debug log - queues messages in a lock-free ring, a low-priority task writes them out
+//
+// A log call never waits on the UART: at 115200 baud a 60-character line takes ~5ms to send,
+// which used to land on the tap path. The caller fills a ring slot and returns; the
+// log task drains the ring to Serial in the background. When the ring is full new messages
+// are dropped and counted (the log task reports how many), the caller never blocks.
+//
+// Any task may log - slots are claimed with a compare-and-swap (bounded MPSC ring).
+//
+// With LOG_BINARY (the default) a LOGx call doesn't format at all - it queues a compact binary
+// record (EventLog.h) and tools/decode_event_log.py renders it on the host. LOG_BINARY 0
+// formats text on the device, as a terminal expects.
+//
+// Levels are filtered twice:
+//   LOG_COMPILE_LEVEL  Calls above it compile to nothing - arguments aren't even evaluated
+//   log_set_level()    Runtime threshold at or below it - a filtered call costs one compare
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_VERBOSE 5
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG   // LOG_LEVEL_INFO or lower for production builds
+#endif
+
+#ifndef LOG_BINARY
+#define LOG_BINARY 1                 // 0 = LOGx formats text on the device (readable without the decoder)
+#endif
+
+#define LOG_RING_SIZE 64          // Messages waiting for the log task (power of two)
+#define LOG_MESSAGE_MAX 120       // Longer messages are truncated
+#define LOG_TASK_STACK_SIZE 3072
+#define LOG_TASK_PRIORITY 0       // Idle priority - runs whenever nothing else wants the core
+#define LOG_TASK_INTERVAL_MS 20   // Pause between drains of the ring
+
+// Start the log task (call once, right after Serial.begin()) - messages logged earlier wait in the ring
+void setup_debug_log();
+
+// Runtime threshold - messages above it are skipped (default LOG_COMPILE_LEVEL)
+void log_set_level(uint8_t level);
+extern volatile uint8_t log_runtime_level;
+
+// Queue one message - use the LOG* macros below so filtered levels compile out
+// tag names the module ("PN532", "MQTT") and must be a string literal or otherwise outlive the message
+void log_write(uint8_t level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+void log_write_v(uint8_t level, const char* tag, const char* format, va_list args);
+
+// Write everything queued now, from the calling task - before a restart
+void log_flush();
+
+uint32_t log_dropped();  // Messages lost to a full ring since boot
+
+// Binary records - claim a ring slot for event id, the args go in the returned buffer
+// (LOG_MESSAGE_MAX bytes), nullptr when the ring is full
+uint8_t* log_event_begin(uint8_t level, uint32_t id, uint32_t* position);
+void log_event_end(uint32_t position, size_t length);
+
+template <typename... Args>
+inline void log_event(uint8_t level, uint32_t id, Args... args) {
+  uint32_t position;
+  uint8_t* data = log_event_begin(level, id, &position);
+  if (data == nullptr) return;
+  EventArgs out = {data, 0, LOG_MESSAGE_MAX};
+  event_put_all(out, args...);
+  log_event_end(position, out.length);
+}
+
+// Never called - keeps the compiler's printf checks on binary call sites
+inline void log_format_check(const char* format, ...) __attribute__((format(printf, 1, 2)));
+inline void log_format_check(const char* format, ...) {}
+
+#if LOG_BINARY
+// tag and format must be constants (a string literal, or a static constexpr char TAG[]) -
+// the format ID is computed at compile time and the generator reads both from the source
+#define LOG_WRITE(level, tag, format, ...)                                                     \
+  do {                                                                                         \
+    if (0) log_format_check(format, ##__VA_ARGS__);                                            \
+    log_event((level), std::integral_constant<uint32_t, event_log_id(tag, format)>::value,     \
+              ##__VA_ARGS__);                                                                  \
+  } while (0)
+#else
+#define LOG_WRITE(level, tag, ...) log_write((level), (tag), __VA_ARGS__)
+#endif
+
+#define LOG_AT(level, tag, ...)                                                   \
+  do {                                                                            \
+    if ((level) <= LOG_COMPILE_LEVEL && (level) <= log_runtime_level) {           \
+      LOG_WRITE((level), tag, __VA_ARGS__);                                       \
+    }                                                                             \
+  } while (0)
+
+#define LOGE(tag, ...) LOG_AT(LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#define LOGW(tag, ...) LOG_AT(LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define LOGI(tag, ...) LOG_AT(LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define LOGD(tag, ...) LOG_AT(LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#define LOGV(tag, ...) LOG_AT(LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
+
+// Print-style sink behind the DEBUG_PRINT macros (DebugConfig.h)
+// Pieces are collected per task until the newline, then queued as one DEBUG-level message
+class DebugLogPrint : public Print {
+ public:
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+};
+
+extern DebugLogPrint debug_log;
+
+#endif // DEBUG_LOG_H
@@ -0,0 +1,121 @@
+#include "DebugLog.h"
+
+#if LOG_BINARY && EVENT_FLASH_LOG
+
+#include <esp_partition.h>
+#include <esp_system.h>
+
+#define EVENT_FLASH_ERASED 0xFFFFFFFF  // Sequence of a never-written slot
+#define EVENT_FLASH_SECTOR_SIZE 4096
+#define EVENT_FLASH_SLOTS_PER_SECTOR (EVENT_FLASH_SECTOR_SIZE / EVENT_FLASH_RECORD_SIZE)
+#define EVENT_FLASH_SECTORS (EVENT_FLASH_LOG_SIZE / EVENT_FLASH_SECTOR_SIZE)
+#define EVENT_FLASH_PAYLOAD_MAX (EVENT_FLASH_RECORD_SIZE - 6)
+
+struct EventFlashRecord {
+  uint32_t sequence;
+  uint8_t length;
+  uint8_t checksum;
+  uint8_t payload[EVENT_FLASH_PAYLOAD_MAX];
+};
+
+static_assert(sizeof(EventFlashRecord) == EVENT_FLASH_RECORD_SIZE, "Flash record must fill its slot");
+
+static const esp_partition_t* flash_partition = nullptr;
+static uint32_t flash_base = 0;       // Offset of the log region in the partition
+static uint32_t flash_slot = 0;       // Next slot to write
+static uint32_t flash_sequence = 0;   // Sequence of the next record
+
+static uint32_t slot_offset(uint32_t slot) {
+  return flash_base + slot * EVENT_FLASH_RECORD_SIZE;
+}
+
+static uint32_t read_sequence(uint32_t slot) {
+  uint32_t sequence = EVENT_FLASH_ERASED;
+  esp_partition_read(flash_partition, slot_offset(slot), &sequence, sizeof(sequence));
+  return sequence;
+}
+
+// Newest record is the last written slot of the sector whose first record is newest
+static void find_write_head() {
+  int32_t newest_sector = -1;
+  uint32_t newest_sequence = 0;
+  for (uint32_t sector = 0; sector < EVENT_FLASH_SECTORS; sector++) {
+    uint32_t sequence = read_sequence(sector * EVENT_FLASH_SLOTS_PER_SECTOR);
+    if (sequence != EVENT_FLASH_ERASED && (newest_sector < 0 || sequence > newest_sequence)) {
+      newest_sector = sector;
+      newest_sequence = sequence;
+    }
+  }
+  if (newest_sector < 0) {
+    flash_slot = 0;  // Empty log
+    flash_sequence = 0;
+    return;
+  }
+
+  uint32_t slot = newest_sector * EVENT_FLASH_SLOTS_PER_SECTOR;
+  uint32_t sector_end = slot + EVENT_FLASH_SLOTS_PER_SECTOR;
+  flash_sequence = newest_sequence + 1;
+  for (slot++; slot < sector_end; slot++) {
+    uint32_t sequence = read_sequence(slot);
+    if (sequence == EVENT_FLASH_ERASED) break;
+    flash_sequence = sequence + 1;
+  }
+  flash_slot = slot % (EVENT_FLASH_SECTORS * EVENT_FLASH_SLOTS_PER_SECTOR);
+}
+
+bool setup_event_flash_log() {
+  flash_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                             EVENT_FLASH_PARTITION_LABEL);
+  if (flash_partition == nullptr || flash_partition->size < EVENT_FLASH_RESERVED + EVENT_FLASH_LOG_SIZE) {
+    flash_partition = nullptr;
+    return false;
+  }
+  flash_base = (flash_partition->size - EVENT_FLASH_LOG_SIZE) / EVENT_FLASH_SECTOR_SIZE * EVENT_FLASH_SECTOR_SIZE;
+  find_write_head();
+
+  uint8_t payload[EVENT_HEADER_SIZE + 11];
+  uint32_t id = EVENT_ID_BOOT;
+  uint32_t now = millis();
+  memcpy(payload, &id, 4);
+  memcpy(payload + 4, &now, 4);
+  payload[8] = LOG_LEVEL_INFO;
+  EventArgs args = {payload + EVENT_HEADER_SIZE, 0, sizeof(payload) - EVENT_HEADER_SIZE};
+  event_put(args, (int)esp_reset_reason());
+  event_flash_append(payload, EVENT_HEADER_SIZE + args.length);
+  return true;
+}
+
+void event_flash_append(const uint8_t* payload, size_t length) {
+  if (flash_partition == nullptr) return;
+
+  if (flash_slot % EVENT_FLASH_SLOTS_PER_SECTOR == 0) {
+    // Entering a sector - the oldest one once the log has wrapped
+    if (esp_partition_erase_range(flash_partition, slot_offset(flash_slot), EVENT_FLASH_SECTOR_SIZE) != ESP_OK) {
+      return;
+    }
+  }
+
+  EventFlashRecord record;
+  memset(&record, 0xFF, sizeof(record));
+  if (length > EVENT_FLASH_PAYLOAD_MAX) length = EVENT_FLASH_PAYLOAD_MAX;  // Decoder shows cut args as "?"
+  record.sequence = flash_sequence;
+  record.length = length;
+  record.checksum = event_checksum(payload, length);
+  memcpy(record.payload, payload, length);
+  if (esp_partition_write(flash_partition, slot_offset(flash_slot), &record, sizeof(record)) != ESP_OK) {
+    return;
+  }
+
+  flash_sequence++;
+  flash_slot = (flash_slot + 1) % (EVENT_FLASH_SECTORS * EVENT_FLASH_SLOTS_PER_SECTOR);
+}
+
+#else
+
+bool setup_event_flash_log() {
+  return false;
+}
+
+void event_flash_append(const uint8_t* payload, size_t length) {}
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+// Binary event records - what a LOGx call queues when LOG_BINARY is set (DebugLog.h)
+//
+// Nothing is formatted on the device. A call site stores the ID of its format string, a
+// timestamp, the level and its arguments; tools/decode_event_log.py turns records back into
+// text with the table tools/generate_event_log_table.py builds from the sources.
+//
+// Record payload (little-endian):
+//   u32 id         event_log_id(tag, format) - FNV-1a of tag, a 0 byte and the format
+//   u32 timestamp  millis()
+//   u8  level      LOG_LEVEL_*
+//   args...        one type byte each, then the value:
+//                    'u' unsigned LEB128   'i' signed, zigzag LEB128
+//                    's' u8 length + bytes 'd' 8-byte double
+//
+// On the UART each record is framed as EVENT_FRAME_START, u8 length, payload, u8 checksum
+// (sum of the payload bytes). Text lines never contain EVENT_FRAME_START, so DEBUG_PRINT
+// output and records share the port. The flash layout is described below.
+
+#define EVENT_FRAME_START 0x1E        // ASCII record separator
+#define EVENT_HEADER_SIZE 9           // id + timestamp + level
+#define EVENT_STRING_MAX 48           // Longer string arguments are cut
+#define EVENT_ID_BOOT 0               // Written to the flash log at every boot (args: reset reason)
+
+constexpr uint32_t event_fnv1a(const char* text, uint32_t hash) {
+  return *text == 0 ? hash : event_fnv1a(text + 1, (hash ^ (uint8_t)*text) * 16777619u);
+}
+
+// Format ID - the generator computes the same hash, and refuses to build on a collision
+constexpr uint32_t event_log_id(const char* tag, const char* format) {
+  return event_fnv1a(format, event_fnv1a(tag, 2166136261u) * 16777619u);
+}
+
+// Argument encoder - once the record is full, strings are cut and later arguments dropped (decoded as "?")
+struct EventArgs {
+  uint8_t* data;
+  size_t length;
+  size_t capacity;
+};
+
+inline void event_put_varint(EventArgs& out, uint8_t type, uint64_t value) {
+  uint8_t bytes[11];
+  size_t n = 0;
+  bytes[n++] = type;
+  do {
+    uint8_t b = value & 0x7F;
+    value >>= 7;
+    bytes[n++] = value != 0 ? (b | 0x80) : b;
+  } while (value != 0);
+  if (out.length + n > out.capacity) {
+    out.capacity = out.length;
+    return;
+  }
+  memcpy(out.data + out.length, bytes, n);
+  out.length += n;
+}
+
+inline void event_put(EventArgs& out, const char* text) {
+  if (out.length + 2 > out.capacity) {
+    out.capacity = out.length;
+    return;
+  }
+  if (text == nullptr) text = "(null)";
+  size_t room = out.capacity - out.length - 2;  // Cut to fit
+  uint8_t* dest = out.data + out.length + 2;
+  size_t n = 0;
+  while (n < EVENT_STRING_MAX && n < room && text[n] != 0) {
+    dest[n] = text[n];
+    n++;
+  }
+  out.data[out.length] = 's';
+  out.data[out.length + 1] = (uint8_t)n;
+  out.length += 2 + n;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type
+event_put(EventArgs& out, T value) {
+  event_put_varint(out, 'u', value);
+}
+
+template <typename T>
+inline typename std::enable_if<(std::is_integral<T>::value && std::is_signed<T>::value) || std::is_enum<T>::value>::type
+event_put(EventArgs& out, T value) {
+  int64_t v = (int64_t)value;
+  event_put_varint(out, 'i', ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type
+event_put(EventArgs& out, T value) {
+  double v = value;
+  if (out.length + 1 + sizeof(v) > out.capacity) {
+    out.capacity = out.length;
+    return;
+  }
+  out.data[out.length++] = 'd';
+  memcpy(out.data + out.length, &v, sizeof(v));
+  out.length += sizeof(v);
+}
+
+inline void event_put_all(EventArgs& out) {}
+
+template <typename T, typename... Rest>
+inline void event_put_all(EventArgs& out, T first, Rest... rest) {
+  event_put(out, first);
+  event_put_all(out, rest...);
+}
+
+inline uint8_t event_checksum(const uint8_t* payload, size_t length) {
+  uint8_t sum = 0;
+  for (size_t i = 0; i < length; i++) {
+    sum += payload[i];
+  }
+  return sum;
+}
+
+// Flash circular log - records at or above EVENT_FLASH_LEVEL survive a reset
+//
+// Lives in the last EVENT_FLASH_LOG_SIZE bytes of the "spiffs" partition, past the two
+// BandStore banks. Fixed EVENT_FLASH_RECORD_SIZE slots: u32 sequence (0xFFFFFFFF = never
+// written), u8 payload length, u8 checksum, payload (cut to fit). The oldest sector is erased
+// when the log wraps. Read it back with esptool and tools/decode_event_log.py --flash.
+//
+// Only the log task writes it, so a flash write never lands on the caller. A sector erase
+// still stalls both cores for tens of ms (flash cache off) - keep the level at WARN or
+// above unless chasing a specific field failure.
+
+#ifndef EVENT_FLASH_LOG
+#define EVENT_FLASH_LOG 1             // 0 keeps events in RAM and on the UART only
+#endif
+
+#ifndef EVENT_FLASH_LEVEL
+#define EVENT_FLASH_LEVEL LOG_LEVEL_WARN
+#endif
+
+#define EVENT_FLASH_PARTITION_LABEL "spiffs"
+#define EVENT_FLASH_LOG_SIZE (64 * 1024)      // 1024 records
+#define EVENT_FLASH_RECORD_SIZE 64
+#define EVENT_FLASH_RESERVED (512 * 1024)     // Start of the partition - BandStore's banks
+
+// Find the log region and the write head, then record the boot - false if there's no room
+bool setup_event_flash_log();
+
+// Append one record payload (log task only)
+void event_flash_append(const uint8_t* payload, size_t length);
+
+#endif // EVENT_LOG_H
@@ -0,0 +1,132 @@
+#include "ActivationBuffer.h"
+#include <DebugConfig.h>
+#if ACTIVATION_BUFFER_PERSIST
+#include <Preferences.h>
+#endif
+
+static constexpr char TAG[] = "HA";  // Log tag
+
+static ActivationEvent activation_events[ACTIVATION_BUFFER_SIZE];
+static uint32_t activation_head = 0;  // Next event to publish (free-running)
+static uint32_t activation_tail = 0;  // Next free slot (free-running)
+static uint32_t activations_dropped = 0;
+static uint16_t boot_id = 0;
+
+#if ACTIVATION_BUFFER_PERSIST
+static bool activation_dirty = false;
+static unsigned long activation_dirty_since = 0;
+static bool saved_empty = true;  // NVS holds no events
+
+// Write the live events, oldest first, as one blob
+static void save_activation_buffer() {
+  ActivationEvent events[ACTIVATION_BUFFER_SIZE];
+  int count = activation_buffer_count();
+  for (int i = 0; i < count; i++) {
+    events[i] = activation_events[(activation_head + i) % ACTIVATION_BUFFER_SIZE];
+  }
+
+  Preferences prefs;
+  if (!prefs.begin(ACTIVATION_BUFFER_NAMESPACE, false)) {
+    LOGW(TAG, "Activation buffer: NVS unavailable - events kept in RAM only");
+    return;
+  }
+  if (count > 0) {
+    prefs.putBytes("events", events, count * sizeof(ActivationEvent));
+  } else {
+    prefs.remove("events");
+  }
+  prefs.end();
+  saved_empty = (count == 0);
+}
+
+static void mark_dirty(unsigned long now) {
+  if (!activation_dirty) {
+    activation_dirty = true;
+    activation_dirty_since = now;
+  }
+}
+#endif
+
+void setup_activation_buffer() {
+  activation_head = activation_tail = 0;
+
+#if ACTIVATION_BUFFER_PERSIST
+  Preferences prefs;
+  if (!prefs.begin(ACTIVATION_BUFFER_NAMESPACE, false)) {
+    return;
+  }
+
+  boot_id = prefs.getUShort("boot", 0) + 1;
+  prefs.putUShort("boot", boot_id);
+
+  size_t size = prefs.getBytes("events", activation_events, sizeof(activation_events));
+  activation_tail = size / sizeof(ActivationEvent);
+  saved_empty = (activation_tail == 0);
+  prefs.end();
+
+  if (activation_tail > 0) {
+    LOGI(TAG, "Activation buffer: %lu events from before the reboot waiting to be published",
+         (unsigned long)activation_tail);
+  }
+#endif
+}
+
+void loop_activation_buffer(unsigned long now) {
+#if ACTIVATION_BUFFER_PERSIST
+  if (activation_dirty && now - activation_dirty_since >= ACTIVATION_PERSIST_INTERVAL_MS) {
+    activation_dirty = false;
+    save_activation_buffer();
+  }
+#endif
+}
+
+void activation_buffer_push(uint64_t band_id, int slot, uint32_t timestamp_ms) {
+  if (activation_tail - activation_head >= ACTIVATION_BUFFER_SIZE) {
+    activation_head++;  // Full - the oldest event makes room
+    activations_dropped++;
+  }
+  activation_events[activation_tail % ACTIVATION_BUFFER_SIZE] = {band_id, timestamp_ms, boot_id, (int16_t)slot};
+  activation_tail++;
+
+#if ACTIVATION_BUFFER_PERSIST
+  mark_dirty(timestamp_ms);
+#endif
+}
+
+bool activation_buffer_peek(ActivationEvent* event) {
+  if (activation_head == activation_tail) {
+    return false;
+  }
+  *event = activation_events[activation_head % ACTIVATION_BUFFER_SIZE];
+  return true;
+}
+
+void activation_buffer_pop() {
+  if (activation_head == activation_tail) {
+    return;
+  }
+  activation_head++;
+
+#if ACTIVATION_BUFFER_PERSIST
+  if (activation_buffer_count() > 0) {
+    mark_dirty(millis());
+  } else if (saved_empty) {
+    activation_dirty = false;  // Back to what NVS holds - a tap published while online never writes flash
+  } else {
+    save_activation_buffer();  // Replay finished - clear the saved copy so it isn't replayed again
+    activation_dirty = false;
+  }
+#endif
+}
+
+int activation_buffer_count() {
+  return activation_tail - activation_head;
+}
+
+uint32_t activation_buffer_dropped() {
+  return activations_dropped;
+}
+
+uint16_t activation_buffer_boot_id() {
+  return boot_id;
+}
@@ -0,0 +1,45 @@
+#ifndef ACTIVATION_BUFFER_H
+#define ACTIVATION_BUFFER_H
+
+#include <Arduino.h>
+
+// Activation buffer - every tap is queued here and published from loop_home_assistant()
+//
+// A fixed ring of events, so queuing a tap is O(1) and never touches the network. While MQTT
+// is down the events wait in the ring and are replayed in order, a batch per loop pass, once
+// the broker is back. When the ring is full the oldest event is dropped (and counted).
+// With ACTIVATION_BUFFER_PERSIST, the ring is saved to NVS a few seconds after it changes
+// (never on the tap itself), so events also survive a reboot.
+
+#define ACTIVATION_BUFFER_SIZE 64                // Events held while offline (power of two)
+#define ACTIVATION_REPLAY_BATCH 8                // Events published per loop pass
+#define ACTIVATION_BUFFER_PERSIST 1              // 0 = RAM only
+#define ACTIVATION_PERSIST_INTERVAL_MS 10000     // Longest a change waits before being saved
+#define ACTIVATION_BUFFER_NAMESPACE "activations"
+
+struct ActivationEvent {
+  uint64_t band_id;
+  uint32_t timestamp_ms;  // millis() at the tap
+  uint16_t boot_id;       // Boot the tap happened in - timestamps only compare within one boot
+  int16_t slot;           // Band registry slot at the tap (-1 = unknown band) - check band_id before use
+};
+
+// Restore persisted events and start a new boot (call once in setup)
+void setup_activation_buffer();
+
+// Save pending changes when due - call every loop iteration
+void loop_activation_buffer(unsigned long now);
+
+// Queue a tap - O(1), drops the oldest event if the ring is full
+void activation_buffer_push(uint64_t band_id, int slot, uint32_t timestamp_ms);
+
+// Oldest event, false if the ring is empty / remove it once published
+bool activation_buffer_peek(ActivationEvent* event);
+void activation_buffer_pop();
+
+// Status
+int activation_buffer_count();
+uint32_t activation_buffer_dropped();  // Events lost to a full ring since boot
+uint16_t activation_buffer_boot_id();
+
+#endif // ACTIVATION_BUFFER_H
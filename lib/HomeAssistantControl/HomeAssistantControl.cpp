@@ -1,7 +1,16 @@
 #include "HomeAssistantControl.h"
 #include <DebugConfig.h>
 #include <ArduinoJson.h>
-#include <BandConfig.h>
+#include <Preferences.h>
+#include "MQTTQueue.h"
+#include "JsonWriter.h"
+#include "ActivationBuffer.h"
+#include <BandRegistry.h>
+#include <BandStore.h>
+#include <Instrumentation.h>
+#include <TaskQueue.h>
+
+static constexpr char TAG[] = "HA";  // Log tag
 
 // WiFi and MQTT clients
 WiFiClient espClient;
@@ -20,94 +29,387 @@ HAStats ha_stats = {
   .activation_count = 0,
   .uptime = 0,
   .lid_is_open = false,
-  .time_until_ready = 0
+  .time_until_ready = 0,
+  .boot_ready_ms = 0,
+  .wifi_connect_ms = 0
 };
 
-unsigned long last_reconnect_attempt = 0;
+unsigned long last_reconnect_attempt = 0;  // MQTT task only
 unsigned long last_stats_publish = 0;
 const unsigned long STATS_PUBLISH_INTERVAL = 30000; // Publish stats every 30 seconds
 
-void setup_home_assistant() {
-  DEBUG_PRINTLN("Setting up Home Assistant integration...");
-  
-  // Connect to WiFi - non-blocking with shorter timeout
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  
-  DEBUG_PRINT("Connecting to WiFi");
-  int wifi_attempts = 0;
-  // Reduced from 20 to 10 attempts (5 seconds max instead of 10)
-  while (WiFi.status() != WL_CONNECTED && wifi_attempts < 10) {
-    delay(500);
-    DEBUG_PRINT(".");
-    wifi_attempts++;
+// WiFi connection management
+// WiFi events arrive on the WiFi task and only set flags - service_wifi() acts on them from
+// the loop. Failed attempts back off exponentially. The BSSID and channel of the last access
+// point that worked are cached in NVS, so a reconnect (or the next boot) can skip the scan
+// of every channel; if the cached AP doesn't answer, the next attempt scans normally.
+
+// Reason code the driver reports for our own WiFi.disconnect() - not a failed attempt
+#define WIFI_REASON_ASSOC_LEAVE 8
+
+static volatile bool wifi_got_ip = false;
+static volatile bool wifi_disconnected = false;
+static volatile uint8_t wifi_disconnect_reason = 0;
+
+static volatile bool wifi_connected = false;  // Also read by the MQTT task
+static bool wifi_attempt_active = false;
+static unsigned long wifi_attempt_start = 0;
+static unsigned long wifi_next_attempt = 0;
+static unsigned long wifi_retry_delay = WIFI_RETRY_MIN_MS;
+
+static uint8_t wifi_cached_bssid[6];
+static uint8_t wifi_cached_channel = 0;  // 0 = nothing cached
+static bool wifi_use_cache = false;      // Next attempt goes straight to the cached AP
+
+static void wifi_event_handler(WiFiEvent_t event, WiFiEventInfo_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      wifi_got_ip = true;
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      wifi_disconnect_reason = info.wifi_sta_disconnected.reason;
+      wifi_disconnected = true;
+      break;
+    default:
+      break;
   }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    DEBUG_PRINTLN();
-    DEBUG_PRINT("WiFi connected! IP: ");
-    DEBUG_PRINTLN(WiFi.localIP());
-    
-    // Setup MQTT
-    mqtt_client.setServer(MQTT_SERVER, MQTT_PORT);
-    mqtt_client.setCallback(mqtt_callback);
-    mqtt_client.setBufferSize(512); // Increase buffer for JSON messages
-    
-    // Try initial connection - but don't block if it fails
-    // Will retry in loop_home_assistant()
-    reconnect_mqtt();
+}
+
+static void load_wifi_cache() {
+  Preferences prefs;
+  if (!prefs.begin(WIFI_CACHE_NAMESPACE, true)) return;
+  if (prefs.getBytes("bssid", wifi_cached_bssid, sizeof(wifi_cached_bssid)) == sizeof(wifi_cached_bssid)) {
+    wifi_cached_channel = prefs.getUChar("channel", 0);
+  }
+  prefs.end();
+}
+
+// Remember the AP we're connected to - only writes flash when it changed
+static void save_wifi_cache() {
+  uint8_t* bssid = WiFi.BSSID();
+  uint8_t channel = WiFi.channel();
+  if (bssid == nullptr || channel == 0) return;
+  if (channel == wifi_cached_channel && memcmp(bssid, wifi_cached_bssid, sizeof(wifi_cached_bssid)) == 0) return;
+
+  memcpy(wifi_cached_bssid, bssid, sizeof(wifi_cached_bssid));
+  wifi_cached_channel = channel;
+
+  Preferences prefs;
+  if (!prefs.begin(WIFI_CACHE_NAMESPACE, false)) return;
+  prefs.putBytes("bssid", wifi_cached_bssid, sizeof(wifi_cached_bssid));
+  prefs.putUChar("channel", wifi_cached_channel);
+  prefs.end();
+}
+
+static void start_wifi_attempt(unsigned long now) {
+  wifi_attempt_active = true;
+  wifi_attempt_start = now;
+
+  if (wifi_use_cache && wifi_cached_channel != 0) {
+    LOGI(TAG, "WiFi: connecting to cached AP on channel %u", wifi_cached_channel);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD, wifi_cached_channel, wifi_cached_bssid);
   } else {
-    DEBUG_PRINTLN();
-    DEBUG_PRINTLN("WiFi connection timeout - will retry in background");
-    DEBUG_PRINTLN("System will continue without Home Assistant for now");
-    
-    // Setup MQTT anyway so reconnection can work in loop
-    mqtt_client.setServer(MQTT_SERVER, MQTT_PORT);
-    mqtt_client.setCallback(mqtt_callback);
-    mqtt_client.setBufferSize(512);
+    LOGI(TAG, "WiFi: connecting (full scan)");
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
   }
 }
 
-void loop_home_assistant() {
-  // Try to maintain WiFi connection - non-blocking
-  if (WiFi.status() != WL_CONNECTED) {
-    // Try to reconnect WiFi periodically but don't block
-    static unsigned long last_wifi_check = 0;
-    if (millis() - last_wifi_check > 30000) { // Check every 30 seconds
-      last_wifi_check = millis();
-      DEBUG_PRINTLN("WiFi disconnected - attempting reconnect...");
-      WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+static void wifi_attempt_failed(unsigned long now) {
+  wifi_attempt_active = false;
+
+  if (wifi_use_cache) {
+    // Cached AP gone or moved channel - scan right away instead of backing off
+    wifi_use_cache = false;
+    wifi_next_attempt = now;
+    return;
+  }
+
+  LOGW(TAG, "WiFi: attempt failed, retrying in %lums", wifi_retry_delay);
+  wifi_next_attempt = now + wifi_retry_delay;
+  wifi_retry_delay *= 2;
+  if (wifi_retry_delay > WIFI_RETRY_MAX_MS) {
+    wifi_retry_delay = WIFI_RETRY_MAX_MS;
+  }
+  wifi_use_cache = wifi_cached_channel != 0;  // Each round tries the cached AP first
+}
+
+// Act on WiFi events and start the next attempt when one is due - never blocks
+static void service_wifi(unsigned long now) {
+  if (wifi_got_ip) {
+    wifi_got_ip = false;
+    wifi_connected = true;
+    wifi_attempt_active = false;
+    wifi_retry_delay = WIFI_RETRY_MIN_MS;
+    if (ha_stats.wifi_connect_ms == 0) {
+      ha_stats.wifi_connect_ms = now;
     }
-    return; // Skip MQTT if WiFi not connected
+
+    IPAddress ip = WiFi.localIP();
+    LOGI(TAG, "WiFi connected! IP: %u.%u.%u.%u (%lums)", ip[0], ip[1], ip[2], ip[3], now - wifi_attempt_start);
+
+    save_wifi_cache();
+    wifi_use_cache = true;
+  }
+
+  if (wifi_disconnected) {
+    wifi_disconnected = false;
+    if (wifi_connected) {
+      LOGW(TAG, "WiFi lost (reason %u) - reconnecting", wifi_disconnect_reason);
+      wifi_connected = false;
+      wifi_next_attempt = now;
+    } else if (wifi_attempt_active && wifi_disconnect_reason != WIFI_REASON_ASSOC_LEAVE) {
+      wifi_attempt_failed(now);
+    }
+  }
+
+  if (wifi_connected) return;
+
+  if (wifi_attempt_active && now - wifi_attempt_start >= WIFI_CONNECT_TIMEOUT_MS) {
+    WiFi.disconnect();
+    wifi_attempt_failed(now);
+  }
+
+  if (!wifi_attempt_active && (long)(now - wifi_next_attempt) >= 0) {
+    start_wifi_attempt(now);
+  }
+}
+
+bool is_wifi_connected() {
+  return wifi_connected;
+}
+
+// MQTT session
+// The PubSubClient lives in its own FreeRTOS task: connecting to a broker that is down can
+// block for seconds, and that must never hold up WiFi, OTA or the message handlers. The task
+// and the network task only talk through two lock-free queues:
+//   outgoing - publish_*() on the network task -> task publishes
+//   incoming - task's subscription callback -> handle_mqtt_message() on the network task
+// so message handlers (band provisioning, settings) all run on the network task.
+
+static uint8_t mqtt_outgoing_buffer[MQTT_OUTGOING_QUEUE_SIZE];
+static uint8_t mqtt_incoming_buffer[MQTT_INCOMING_QUEUE_SIZE];
+static MQTTQueue mqtt_outgoing;
+static MQTTQueue mqtt_incoming;
+
+static volatile bool mqtt_connected = false;         // Written by the MQTT task
+static std::atomic<uint32_t> mqtt_sessions(0);       // Bumped by the MQTT task on every connect
+static uint32_t mqtt_sessions_seen = 0;              // Network task's copy - a change means "just connected"
+
+// Real-time task <-> network task
+// The reader, LEDs and audio run on the other core and never touch the network, ha_control
+// or ha_stats. They report taps through reader_events; settings changes go back as copies of
+// ha_control through control_updates. Both queues are bounded and neither side waits.
+enum ReaderEventType {
+  READER_EVENT_LIVE,        // Reader polled for the first time
+  READER_EVENT_TAP,         // Activation started
+  READER_EVENT_COOLDOWN,    // Cooldown start moved to the end of the activation's sounds
+  READER_EVENT_ACTIVATION   // Activation finished
+};
+
+struct ReaderEvent {
+  ReaderEventType type;
+  uint32_t time_ms;   // millis() on the real-time task
+  uint64_t band_id;
+};
+
+static TaskQueue<ReaderEvent, READER_EVENT_QUEUE_SIZE> reader_events;
+static TaskQueue<HAControlState, HA_CONTROL_QUEUE_SIZE> control_updates;
+static bool control_changed = false;       // ha_control changed and isn't queued yet (network task)
+static bool cooldown_started = false;      // A tap has started a cooldown since boot
+static unsigned long cooldown_from_ms = 0; // Where the real-time task counts the cooldown from - time_until_ready
+
+// Discovery bookkeeping - network task only, see publish_discovery_configs()
+static char discovery_hash[9];                  // Hex content hash of the current configs
+static bool discovery_check_pending = false;    // Waiting for the broker's retained hash
+static unsigned long discovery_check_deadline = 0;
+static uint32_t discovery_checked_session = 0;  // Session in which the broker's hash arrived
+static int discovery_cursor = -1;               // Next entity service_discovery() queues, -1 = idle
+
+// Per-band counters - indexed by band registry slot (slots never move, see BandRegistry.h)
+// Allocated once at boot; a group of BAND_STATS_GROUP_SIZE slots is one stats message
+struct BandActivity {
+  uint32_t count;      // Taps since boot
+  uint32_t last_seen;  // Uptime (s) at the last tap, 0 = not since boot
+};
+#define BAND_STATS_GROUPS (BAND_REGISTRY_CAPACITY / BAND_STATS_GROUP_SIZE)
+static BandActivity* band_activity = nullptr;
+static uint8_t band_stats_dirty[(BAND_STATS_GROUPS + 7) / 8];  // Groups waiting to be published
+
+static void handle_reader_events();
+static void publish_pending_activations(unsigned long now);
+static bool compute_discovery_hash();
+static void handle_discovery_hash(const char* message);
+static void service_discovery();
+static void service_band_stats();
+static void refresh_discovery();
+static void remove_band_config(uint64_t band_id);
+static void reset_band_activity(int slot);
+static void mark_band_stats_dirty(int slot);
+
+// Network task side: reserve room for a payload in the outgoing queue
+// The payload is then written in place with a JsonWriter and sent with mqtt_commit()
+static char* mqtt_reserve(const char* topic, uint16_t max_length, bool retain = false) {
+  char* payload = mqtt_queue_reserve(&mqtt_outgoing, topic, max_length, retain);
+  if (payload == nullptr) {
+    LOGW(TAG, "MQTT outgoing queue full - dropped %s", topic);
+  }
+  return payload;
+}
+
+static bool mqtt_commit(const JsonWriter& json, const char* topic) {
+  if (json.overflowed()) {
+    LOGE(TAG, "MQTT payload too large - dropped %s", topic);
+    return false;
+  }
+  mqtt_queue_commit(&mqtt_outgoing, json.length());
+  return true;
+}
+
+bool is_mqtt_connected() {
+  return mqtt_connected;
+}
+
+// One pass of the MQTT session - runs on the MQTT task
+// Connects when due (may block this task, never the network task), pumps the client and
+// sends whatever the network task queued
+static void mqtt_service() {
+  if (!wifi_connected) {
+    mqtt_connected = false;
+    return;
   }
   
-  // Maintain MQTT connection
   if (!mqtt_client.connected()) {
+    mqtt_connected = false;
     unsigned long now = millis();
-    if (now - last_reconnect_attempt > 5000) {
+    if (last_reconnect_attempt == 0 || now - last_reconnect_attempt > MQTT_RETRY_INTERVAL_MS) {
       last_reconnect_attempt = now;
       reconnect_mqtt();
     }
-  } else {
-    mqtt_client.loop();
-    
-    // Publish stats periodically
-    unsigned long now = millis();
-    if (now - last_stats_publish > STATS_PUBLISH_INTERVAL) {
-      last_stats_publish = now;
-      ha_stats.uptime = millis() / 1000;
-      publish_stats();
+    return;
+  }
+  
+  mqtt_client.loop();  // Incoming messages land in mqtt_incoming via mqtt_callback()
+  
+  MQTTQueuedMessage message;
+  for (int i = 0; i < MQTT_PUBLISH_BURST && mqtt_queue_peek(&mqtt_outgoing, &message); i++) {
+    // Stream the payload straight from the queue - no copy into the client's buffer
+    if (!mqtt_client.beginPublish(message.topic, message.length, message.retain) ||
+        mqtt_client.write(message.payload, message.length) != message.length ||
+        !mqtt_client.endPublish()) {
+      break;  // Connection dropped - keep the message for the next session
     }
+    mqtt_queue_pop(&mqtt_outgoing);
+  }
+}
+
+static void mqtt_task(void* parameter) {
+  for (;;) {
+    mqtt_service();
+    vTaskDelay(pdMS_TO_TICKS(MQTT_TASK_INTERVAL_MS));
   }
 }
 
+void setup_home_assistant() {
+  LOGI(TAG, "Setting up Home Assistant integration...");
+  
+  // Start WiFi in the background - loop_home_assistant() follows it up
+  // The SDK's own auto-reconnect and flash writes are off: service_wifi() owns retries
+  WiFi.onEvent(wifi_event_handler);
+  WiFi.persistent(false);
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false);
+  
+  setup_activation_buffer();
+  
+  band_activity = (BandActivity*)calloc(BAND_REGISTRY_CAPACITY, sizeof(BandActivity));
+  if (band_activity == nullptr) {
+    LOGW(TAG, "Not enough memory for per-band stats - not reported");
+  }
+  for (int slot = 0; slot < BAND_REGISTRY_CAPACITY; slot++) {
+    if (band_registry_at(slot) != nullptr) {
+      reset_band_activity(slot);  // Zero counts replace the previous boot's retained ones
+    }
+  }
+  compute_discovery_hash();
+  
+  load_wifi_cache();
+  wifi_use_cache = wifi_cached_channel != 0;
+  start_wifi_attempt(millis());
+  
+  // MQTT connects once WiFi is up
+  mqtt_queue_init(&mqtt_outgoing, mqtt_outgoing_buffer, sizeof(mqtt_outgoing_buffer));
+  mqtt_queue_init(&mqtt_incoming, mqtt_incoming_buffer, sizeof(mqtt_incoming_buffer));
+  mqtt_client.setServer(MQTT_SERVER, MQTT_PORT);
+  mqtt_client.setCallback(mqtt_callback);
+  mqtt_client.setBufferSize(MQTT_BUFFER_SIZE); // Large enough for band provisioning chunks
+  mqtt_client.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S);
+  
+  // Core 0 alongside the WiFi stack - the Arduino loop runs on core 1
+  // (the native environment runs the task as a host thread in step with its simulated clock)
+  xTaskCreatePinnedToCore(mqtt_task, "mqtt", MQTT_TASK_STACK_SIZE, nullptr, MQTT_TASK_PRIORITY, nullptr, 0);
+}
+
+void loop_home_assistant() {
+  // Keep WiFi going - non-blocking
+  service_wifi(millis());
+  
+  // Taps from the real-time task - before the activation buffer, so a new event is saved on time
+  handle_reader_events();
+  loop_activation_buffer(millis());
+  
+  // Handle messages the MQTT task received
+  MQTTQueuedMessage message;
+  while (mqtt_queue_peek(&mqtt_incoming, &message)) {
+    handle_mqtt_message(message.topic, message.payload, message.length);
+    mqtt_queue_pop(&mqtt_incoming);
+  }
+  
+  // Hand changed settings to the real-time task - retried next pass if its queue is full
+  if (control_changed && task_queue_push(&control_updates, ha_control)) {
+    control_changed = false;
+  }
+  
+  if (!mqtt_connected) {
+    return;
+  }
+  
+  unsigned long now = millis();
+  
+  // New session - discovery waits for the broker's retained hash (see handle_discovery_hash())
+  uint32_t sessions = mqtt_sessions.load(std::memory_order_acquire);
+  if (sessions != mqtt_sessions_seen) {
+    mqtt_sessions_seen = sessions;
+    discovery_check_pending = discovery_checked_session != sessions;
+    discovery_check_deadline = now + MQTT_DISCOVERY_HASH_WAIT_MS;
+    publish_state();
+    publish_stats();
+    LOGI(TAG, "Home Assistant integration ready");
+  }
+  
+  // Nothing retained (new broker, or it was cleared) - publish the configs
+  if (discovery_check_pending && (long)(now - discovery_check_deadline) >= 0) {
+    discovery_check_pending = false;
+    publish_discovery_configs();
+  }
+  service_discovery();
+  service_band_stats();
+  
+  publish_pending_activations(now);
+  
+  // Publish stats periodically
+  if (now - last_stats_publish > STATS_PUBLISH_INTERVAL) {
+    last_stats_publish = now;
+    ha_stats.uptime = millis() / 1000;
+    publish_stats();
+  }
+}
+
+// Runs on the MQTT task - blocks it for up to MQTT_SOCKET_TIMEOUT_S when the broker is down
 void reconnect_mqtt() {
-  DEBUG_PRINTLN("Attempting MQTT connection...");
+  LOGI(TAG, "Attempting MQTT connection...");
   
-  // mqtt_client.connect() can block, but it has internal timeout (~15 seconds)
-  // This is acceptable since it only happens during reconnection attempts
   if (mqtt_client.connect(MQTT_CLIENT_ID, MQTT_USER, MQTT_PASSWORD, MQTT_STATUS_TOPIC, 0, true, "offline")) {
-    DEBUG_PRINTLN("MQTT connected!");
+    LOGI(TAG, "MQTT connected!");
     
     // Publish online status
     mqtt_client.publish(MQTT_STATUS_TOPIC, "online", true);
@@ -116,41 +418,62 @@ void reconnect_mqtt() {
     mqtt_client.subscribe(MQTT_COMMAND_TOPIC);
     mqtt_client.subscribe(MQTT_BRIGHTNESS_TOPIC "/set");
     mqtt_client.subscribe(MQTT_COOLDOWN_TOPIC "/set");
+    mqtt_client.subscribe(MQTT_PROVISION_TOPIC);
+    mqtt_client.subscribe(MQTT_DISCOVERY_HASH_TOPIC);  // The broker answers with its retained hash
+    mqtt_client.subscribe(HA_STATUS_TOPIC);
     
-    // Publish Home Assistant discovery configs
-    publish_discovery_configs();
-    
-    // Publish initial state
-    publish_state();
-    publish_stats();
-    
-    DEBUG_PRINTLN("Home Assistant integration ready");
+    // State, stats and the discovery check are handled by the network task when it sees the new session
+    mqtt_connected = true;
+    if (mqtt_sessions.fetch_add(1, std::memory_order_release) > 0) {
+      instrument_count(INSTRUMENT_MQTT_RECONNECTS);
+    }
   } else {
-    DEBUG_PRINT("MQTT connection failed, rc=");
-    DEBUG_PRINTLN(mqtt_client.state());
-    DEBUG_PRINTLN("Will retry in 5 seconds");
+    LOGW(TAG, "MQTT connection failed, rc=%d - will retry in %d seconds", mqtt_client.state(),
+         MQTT_RETRY_INTERVAL_MS / 1000);
   }
 }
 
+// Subscription callback - runs on the MQTT task, so it only queues the message
 void mqtt_callback(char* topic, byte* payload, unsigned int length) {
-  // Convert payload to string
-  char message[length + 1];
-  memcpy(message, payload, length);
-  message[length] = '\0';
+  if (length > 0xFFFF || !mqtt_queue_push(&mqtt_incoming, topic, payload, length, false)) {
+    LOGW(TAG, "MQTT incoming queue full - dropped message on %s", topic);
+  }
+}
+
+// Handle one received message - network task only
+void handle_mqtt_message(const char* topic, const byte* payload, unsigned int length) {
+  // Provisioning chunks can be several KB - parse them straight from the queue
+  // instead of copying onto the stack
+  if (strcmp(topic, MQTT_PROVISION_TOPIC) == 0) {
+    handle_band_provisioning(payload, length);
+    return;
+  }
   
-  DEBUG_PRINT("MQTT message on ");
-  DEBUG_PRINT(topic);
-  DEBUG_PRINT(": ");
-  DEBUG_PRINTLN(message);
+  // Queued payloads are NUL-terminated - use them as strings in place
+  const char* message = (const char*)payload;
   
+  LOGD(TAG, "MQTT message on %s: %s", topic, message);
+  
+  if (strcmp(topic, MQTT_DISCOVERY_HASH_TOPIC) == 0) {
+    handle_discovery_hash(message);
+  }
+  // Home Assistant (re)started - it may have lost entities, announce them again
+  else if (strcmp(topic, HA_STATUS_TOPIC) == 0) {
+    if (strcmp(message, HA_BIRTH_PAYLOAD) == 0) {
+      publish_discovery_configs();
+      publish_state();
+    }
+  }
   // Handle command topic
-  if (strcmp(topic, MQTT_COMMAND_TOPIC) == 0) {
+  else if (strcmp(topic, MQTT_COMMAND_TOPIC) == 0) {
     if (strcmp(message, "ON") == 0 || strcmp(message, "on") == 0) {
       ha_control.system_enabled = true;
-      DEBUG_PRINTLN("System enabled via Home Assistant");
+      control_changed = true;
+      LOGI(TAG, "System enabled via Home Assistant");
     } else if (strcmp(message, "OFF") == 0 || strcmp(message, "off") == 0) {
       ha_control.system_enabled = false;
-      DEBUG_PRINTLN("System disabled via Home Assistant");
+      control_changed = true;
+      LOGI(TAG, "System disabled via Home Assistant");
     }
     publish_state();
   }
@@ -159,8 +482,8 @@ void mqtt_callback(char* topic, byte* payload, unsigned int length) {
     int brightness = atoi(message);
     if (brightness >= 0 && brightness <= 255) {
       ha_control.led_brightness = brightness;
-      DEBUG_PRINT("LED brightness set to: ");
-      DEBUG_PRINTLN(brightness);
+      control_changed = true;
+      LOGI(TAG, "LED brightness set to: %d", brightness);
       publish_state();
     }
   }
@@ -169,175 +492,749 @@ void mqtt_callback(char* topic, byte* payload, unsigned int length) {
     unsigned long cooldown = atol(message);
     if (cooldown >= 1000 && cooldown <= 60000) { // 1-60 seconds
       ha_control.cooldown_time = cooldown;
-      DEBUG_PRINT("Cooldown time set to: ");
-      DEBUG_PRINT(cooldown);
-      DEBUG_PRINTLN("ms");
+      control_changed = true;
+      LOGI(TAG, "Cooldown time set to: %lums", cooldown);
       publish_state();
     }
   }
 }
 
-void publish_discovery_configs() {
-  DEBUG_PRINTLN("Publishing Home Assistant discovery configs...");
-  
-  StaticJsonDocument<512> doc;
-  char buffer[512];
-  char topic[128];
-  
-  // Switch entity for system enable/disable
-  doc.clear();
-  doc["name"] = "MagicBand System";
-  doc["unique_id"] = "magicband_system";
-  doc["state_topic"] = MQTT_STATE_TOPIC;
-  doc["command_topic"] = MQTT_COMMAND_TOPIC;
-  doc["payload_on"] = "ON";
-  doc["payload_off"] = "OFF";
-  doc["value_template"] = "{{ value_json.enabled }}";
-  doc["device"]["identifiers"][0] = "magicband";
-  doc["device"]["name"] = "MagicBand";
-  doc["device"]["manufacturer"] = "Custom";
-  doc["device"]["model"] = "ESP32";
-  
-  serializeJson(doc, buffer);
-  snprintf(topic, sizeof(topic), "%s/switch/%s/config", HA_DISCOVERY_PREFIX, MQTT_CLIENT_ID);
-  mqtt_client.publish(topic, buffer, true);
-  
-  // Number entity for LED brightness
-  doc.clear();
-  doc["name"] = "LED Brightness";
-  doc["unique_id"] = "magicband_brightness";
-  doc["state_topic"] = MQTT_STATE_TOPIC;
-  doc["command_topic"] = MQTT_BRIGHTNESS_TOPIC "/set";
-  doc["value_template"] = "{{ value_json.brightness }}";
-  doc["min"] = 0;
-  doc["max"] = 255;
-  doc["device"]["identifiers"][0] = "magicband";
-  
-  serializeJson(doc, buffer);
-  snprintf(topic, sizeof(topic), "%s/number/%s_brightness/config", HA_DISCOVERY_PREFIX, MQTT_CLIENT_ID);
-  mqtt_client.publish(topic, buffer, true);
-  
-  // Number entity for cooldown time
-  doc.clear();
-  doc["name"] = "Cooldown Time";
-  doc["unique_id"] = "magicband_cooldown";
-  doc["state_topic"] = MQTT_STATE_TOPIC;
-  doc["command_topic"] = MQTT_COOLDOWN_TOPIC "/set";
-  doc["value_template"] = "{{ value_json.cooldown }}";
-  doc["unit_of_measurement"] = "ms";
-  doc["min"] = 1000;
-  doc["max"] = 60000;
-  doc["device"]["identifiers"][0] = "magicband";
-  
-  serializeJson(doc, buffer);
-  snprintf(topic, sizeof(topic), "%s/number/%s_cooldown/config", HA_DISCOVERY_PREFIX, MQTT_CLIENT_ID);
-  mqtt_client.publish(topic, buffer, true);
-  
-  // Sensor for last wand
-  doc.clear();
-  doc["name"] = "Last Wand";
-  doc["unique_id"] = "magicband_last_wand";
-  doc["state_topic"] = MQTT_WAND_TOPIC;
-  doc["value_template"] = "{{ value_json.wand_id }}";
-  doc["device"]["identifiers"][0] = "magicband";
-  
-  serializeJson(doc, buffer);
-  snprintf(topic, sizeof(topic), "%s/sensor/%s_last_wand/config", HA_DISCOVERY_PREFIX, MQTT_CLIENT_ID);
-  mqtt_client.publish(topic, buffer, true);
-  
-  // Sensor for activation count
-  doc.clear();
-  doc["name"] = "Activation Count";
-  doc["unique_id"] = "magicband_activations";
-  doc["state_topic"] = MQTT_STATS_TOPIC;
-  doc["value_template"] = "{{ value_json.activations }}";
-  doc["device"]["identifiers"][0] = "magicband";
-  
-  serializeJson(doc, buffer);
-  snprintf(topic, sizeof(topic), "%s/sensor/%s_activations/config", HA_DISCOVERY_PREFIX, MQTT_CLIENT_ID);
-  mqtt_client.publish(topic, buffer, true);
-  
-  DEBUG_PRINTLN("Discovery configs published");
+// Band provisioning
+//
+// Bands are loaded in batches, split into chunks that each fit one MQTT message:
+//   {"batch": "event-setup", "chunk": 0, "chunks": 25,
+//    "bands": [{"uid": "045C92F2876880", "name": "Candice", "color": "#800080", "sounds": [9, 5]}],
+//    "remove": ["27CB1805"]}
+// A chunk is validated in full before anything is applied, so it lands completely or
+// not at all. Every chunk is acknowledged on MQTT_PROVISION_STATUS_TOPIC.
+
+// Staging area for one chunk - static so large chunks stay off the loop task stack
+static BandConfig provision_bands[MQTT_PROVISION_MAX_BANDS];
+static uint64_t provision_removals[MQTT_PROVISION_MAX_BANDS];
+
+static int hex_digit_value(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
 }
 
-void publish_state() {
-  if (!mqtt_client.connected()) return;
+// UIDs are hex strings (as printed by the scanner output), or plain JSON numbers
+// Strings are 1-16 hex digits with an optional "0x" - no sign or whitespace, which strtoull
+// would quietly accept ("-1" is 0xFFFFFFFFFFFFFFFF)
+static bool parse_band_uid(JsonVariant value, uint64_t* band_id) {
+  if (value.is<const char*>()) {
+    const char* text = value.as<const char*>();
+    if (text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+      text += 2;
+    }
+    size_t digits = strlen(text);
+    if (digits == 0 || digits > 16) {
+      return false;
+    }
+    uint64_t uid = 0;
+    for (size_t i = 0; i < digits; i++) {
+      int nibble = hex_digit_value(text[i]);
+      if (nibble < 0) {
+        return false;
+      }
+      uid = (uid << 4) | (uint64_t)nibble;
+    }
+    *band_id = uid;
+    return uid != 0;
+  }
+  if (value.is<uint64_t>()) {
+    *band_id = value.as<uint64_t>();
+    return *band_id != 0;
+  }
+  return false;
+}
+
+// Colors are "#RRGGBB" strings or 0xRRGGBB numbers
+static bool parse_band_color(JsonVariant value, CRGB* color) {
+  uint32_t rgb;
+  if (value.is<const char*>()) {
+    const char* text = value.as<const char*>();
+    if (text[0] == '#') {
+      text++;
+    }
+    if (strlen(text) != 6) {
+      return false;
+    }
+    char* end;
+    rgb = strtoul(text, &end, 16);
+    if (*end != '\0') {
+      return false;
+    }
+  } else if (value.is<uint32_t>()) {
+    rgb = value.as<uint32_t>();
+    if (rgb > 0xFFFFFF) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  *color = CRGB(rgb);
+  return true;
+}
+
+// Fill band from one JSON entry - returns an error message, or nullptr if valid
+static const char* parse_band_entry(JsonObject entry, BandConfig* band) {
+  *band = BandConfig();
+  
+  if (!parse_band_uid(entry["uid"], &band->band_id)) {
+    return "invalid uid";
+  }
+  
+  const char* name = entry["name"] | "";
+  if (name[0] == '\0' || strlen(name) >= BAND_NAME_LENGTH) {
+    return "invalid name";
+  }
+  strncpy(band->name, name, BAND_NAME_LENGTH - 1);
+  
+  if (!parse_band_color(entry["color"], &band->led_color)) {
+    return "invalid color";
+  }
   
-  StaticJsonDocument<256> doc;
-  char buffer[256];
+  JsonArray sounds = entry["sounds"];
+  if (sounds.isNull() || sounds.size() < 1 || sounds.size() > 3) {
+    return "sounds must list 1-3 tracks";
+  }
+  for (JsonVariant sound : sounds) {
+    int track = sound | 0;
+    if (track < 1 || track > 255) {
+      return "invalid sound track";
+    }
+    band->sound_files[band->num_sounds++] = track;
+  }
   
-  doc["enabled"] = ha_control.system_enabled ? "ON" : "OFF";
-  doc["brightness"] = ha_control.led_brightness;
-  doc["cooldown"] = ha_control.cooldown_time;
-  doc["auto_close"] = ha_control.auto_close_enabled;
+  return nullptr;
+}
+
+static void publish_provision_status(const char* batch, int chunk, int chunks, const char* error, int index,
+                                     int applied, int removed, bool persisted) {
+  char* payload = mqtt_reserve(MQTT_PROVISION_STATUS_TOPIC, MQTT_PROVISION_STATUS_PAYLOAD_MAX);
+  if (payload != nullptr) {
+    JsonWriter json(payload, MQTT_PROVISION_STATUS_PAYLOAD_MAX + 1);
+    json.begin_object();
+    json.field("batch", batch);
+    json.field("chunk", chunk);
+    json.field("chunks", chunks);
+    if (error != nullptr) {
+      json.field("status", "error");
+      json.field("error", error);
+      if (index >= 0) {
+        json.field("index", index);
+      }
+    } else {
+      json.field("status", "ok");
+      json.field("applied", applied);
+      json.field("removed", removed);
+      json.field("persisted", persisted);
+    }
+    json.field("bands", band_registry_count());
+    json.end_object();
+    mqtt_commit(json, MQTT_PROVISION_STATUS_TOPIC);
+  }
   
-  serializeJson(doc, buffer);
-  mqtt_client.publish(MQTT_STATE_TOPIC, buffer, true);
+  LOGI(TAG, "Band provisioning chunk %d/%d: %s", chunk + 1, chunks, error != nullptr ? error : "ok");
 }
 
-void publish_wand_activation(uint64_t wand_id) {
-  if (!mqtt_client.connected()) return;
+void handle_band_provisioning(const byte* payload, unsigned int length) {
+  DynamicJsonDocument doc(MQTT_PROVISION_DOC_SIZE);
+  DeserializationError json_error = deserializeJson(doc, payload, length);
   
-  ha_stats.last_wand_id = wand_id;  // Store full 64-bit value
-  ha_stats.activation_count++;
+  const char* batch = doc["batch"] | "";
+  int chunk = doc["chunk"] | 0;
+  int chunks = doc["chunks"] | 1;
   
-  StaticJsonDocument<128> doc;
-  char buffer[128];
+  if (json_error) {
+    publish_provision_status(batch, chunk, chunks, json_error.c_str(), -1, 0, 0, false);
+    return;
+  }
   
-  // Send full 64-bit ID as string to avoid JSON integer overflow
-  char wand_id_str[20];
-  sprintf(wand_id_str, "%llu", wand_id);
-  doc["wand_id"] = wand_id_str;
-  doc["timestamp"] = millis();
+  JsonArray bands = doc["bands"];
+  JsonArray removals = doc["remove"];
+  int num_bands = bands.size();
+  int num_removals = removals.size();
+  if (num_bands + num_removals > MQTT_PROVISION_MAX_BANDS) {
+    publish_provision_status(batch, chunk, chunks, "too many bands in chunk", -1, 0, 0, false);
+    return;
+  }
   
-  // Look up band name from configuration
-  BandConfig* band = find_band_config(wand_id);
-  if (band != nullptr) {
-    doc["name"] = band->name;
+  // Validate the whole chunk before touching the registry
+  int index = 0;
+  for (JsonVariant uid : removals) {
+    if (!parse_band_uid(uid, &provision_removals[index])) {
+      publish_provision_status(batch, chunk, chunks, "invalid uid in remove", index, 0, 0, false);
+      return;
+    }
+    index++;
+  }
+  
+  index = 0;
+  for (JsonObject entry : bands) {
+    const char* error = parse_band_entry(entry, &provision_bands[index]);
+    if (error != nullptr) {
+      publish_provision_status(batch, chunk, chunks, error, index, 0, 0, false);
+      return;
+    }
+    index++;
+  }
+  
+  // Capacity check - removals aren't credited, so this errs on the side of rejecting
+  int projected = band_registry_count();
+  for (int i = 0; i < num_bands; i++) {
+    if (find_band_config(provision_bands[i].band_id) == nullptr) {
+      projected++;
+    }
+  }
+  if (projected > BAND_REGISTRY_MAX_BANDS) {
+    publish_provision_status(batch, chunk, chunks, "band registry full", -1, 0, 0, false);
+    return;
+  }
+  
+  // Apply - registry first, then the flash log (see BandStore.h)
+  bool persisted = true;
+  int removed = 0;
+  for (int i = 0; i < num_removals; i++) {
+    int slot = band_registry_slot(find_band_config(provision_removals[i]));
+    if (band_registry_remove(provision_removals[i])) {
+      persisted &= band_store_delete(provision_removals[i]);
+      reset_band_activity(slot);
+      remove_band_config(provision_removals[i]);
+      removed++;
+    }
+  }
+  
+  int applied = 0;
+  for (int i = 0; i < num_bands; i++) {
+    // Keep the sound rotation of bands that already exist
+    BandConfig* existing = find_band_config(provision_bands[i].band_id);
+    if (existing != nullptr && existing->current_sound_index < provision_bands[i].num_sounds) {
+      provision_bands[i].current_sound_index = existing->current_sound_index;
+    }
+    
+    BandConfig* band = band_registry_insert(provision_bands[i]);
+    if (band != nullptr) {
+      persisted &= band_store_save(*band);
+      if (existing == nullptr) {
+        reset_band_activity(band_registry_slot(band));  // The slot may have held a removed band
+      }
+      applied++;
+    }
+  }
+  
+  if (applied > 0 || removed > 0) {
+    refresh_discovery();
+  }
+  
+  publish_provision_status(batch, chunk, chunks, nullptr, -1, applied, removed, persisted);
+}
+
+// Home Assistant discovery
+//
+// The config messages are retained by the broker, so they only need sending when they change.
+// The fixed entities come from writers in discovery_entities[], followed by one sensor per
+// band in the registry (see write_band_config()). At boot they are all
+// written once into a scratch buffer to compute a content hash, which is published (retained)
+// on MQTT_DISCOVERY_HASH_TOPIC after the configs. Every new session subscribes to that topic
+// and the broker hands back the hash it holds - the configs are republished only when it
+// differs, when none arrives within MQTT_DISCOVERY_HASH_WAIT_MS, or when Home Assistant
+// announces itself on its birth topic. A reconnect storm costs a few bytes per session.
+
+struct DiscoveryEntity {
+  const char* topic;
+  void (*write)(JsonWriter& json);
+};
+
+// Every entity belongs to the same device - the first one describes it in full
+static void write_discovery_device(JsonWriter& json, bool full) {
+  json.begin_object("device");
+  json.begin_array("identifiers").element("magicband").end_array();
+  if (full) {
+    json.field("name", "MagicBand");
+    json.field("manufacturer", "Custom");
+    json.field("model", "ESP32");
+  }
+  json.end_object();
+}
+
+// Switch entity for system enable/disable
+static void write_system_switch_config(JsonWriter& json) {
+  json.begin_object();
+  json.field("name", "MagicBand System");
+  json.field("unique_id", "magicband_system");
+  json.field("state_topic", MQTT_STATE_TOPIC);
+  json.field("command_topic", MQTT_COMMAND_TOPIC);
+  json.field("payload_on", "ON");
+  json.field("payload_off", "OFF");
+  json.field("value_template", "{{ value_json.enabled }}");
+  write_discovery_device(json, true);
+  json.end_object();
+}
+
+// Number entity for LED brightness
+static void write_brightness_config(JsonWriter& json) {
+  json.begin_object();
+  json.field("name", "LED Brightness");
+  json.field("unique_id", "magicband_brightness");
+  json.field("state_topic", MQTT_STATE_TOPIC);
+  json.field("command_topic", MQTT_BRIGHTNESS_TOPIC "/set");
+  json.field("value_template", "{{ value_json.brightness }}");
+  json.field("min", 0);
+  json.field("max", 255);
+  write_discovery_device(json, false);
+  json.end_object();
+}
+
+// Number entity for cooldown time
+static void write_cooldown_config(JsonWriter& json) {
+  json.begin_object();
+  json.field("name", "Cooldown Time");
+  json.field("unique_id", "magicband_cooldown");
+  json.field("state_topic", MQTT_STATE_TOPIC);
+  json.field("command_topic", MQTT_COOLDOWN_TOPIC "/set");
+  json.field("value_template", "{{ value_json.cooldown }}");
+  json.field("unit_of_measurement", "ms");
+  json.field("min", 1000);
+  json.field("max", 60000);
+  write_discovery_device(json, false);
+  json.end_object();
+}
+
+// Sensor for last wand
+static void write_last_wand_config(JsonWriter& json) {
+  json.begin_object();
+  json.field("name", "Last Wand");
+  json.field("unique_id", "magicband_last_wand");
+  json.field("state_topic", MQTT_WAND_TOPIC);
+  json.field("value_template", "{{ value_json.wand_id }}");
+  write_discovery_device(json, false);
+  json.end_object();
+}
+
+// Sensor for activation count
+static void write_activations_config(JsonWriter& json) {
+  json.begin_object();
+  json.field("name", "Activation Count");
+  json.field("unique_id", "magicband_activations");
+  json.field("state_topic", MQTT_STATS_TOPIC);
+  json.field("value_template", "{{ value_json.activations }}");
+  write_discovery_device(json, false);
+  json.end_object();
+}
+
+static const DiscoveryEntity discovery_entities[] = {
+  {HA_DISCOVERY_PREFIX "/switch/" MQTT_CLIENT_ID "/config", write_system_switch_config},
+  {HA_DISCOVERY_PREFIX "/number/" MQTT_CLIENT_ID "_brightness/config", write_brightness_config},
+  {HA_DISCOVERY_PREFIX "/number/" MQTT_CLIENT_ID "_cooldown/config", write_cooldown_config},
+  {HA_DISCOVERY_PREFIX "/sensor/" MQTT_CLIENT_ID "_last_wand/config", write_last_wand_config},
+  {HA_DISCOVERY_PREFIX "/sensor/" MQTT_CLIENT_ID "_activations/config", write_activations_config},
+};
+#define DISCOVERY_ENTITY_COUNT (int)(sizeof(discovery_entities) / sizeof(discovery_entities[0]))
+
+// Discovery entity index space: the fixed entities above, then one per band registry slot
+#define DISCOVERY_INDEX_END (DISCOVERY_ENTITY_COUNT + BAND_REGISTRY_CAPACITY)
+
+static void band_config_topic(uint64_t band_id, char* topic, size_t size) {
+  snprintf(topic, size, HA_DISCOVERY_PREFIX "/sensor/" MQTT_CLIENT_ID "_band_%llu/config", (unsigned long long)band_id);
+}
+
+static void band_stats_topic(int slot, char* topic, size_t size) {
+  snprintf(topic, size, MQTT_BAND_STATS_TOPIC "/%d", slot / BAND_STATS_GROUP_SIZE);
+}
+
+// Sensor per band - state is its activation count, the last tap is an attribute
+// Home Assistant's last_changed for the entity is the wall-clock time of the last tap
+static void write_band_config(JsonWriter& json, int slot, const BandConfig* band) {
+  char stats_topic[64];
+  char value_template[64];
+  char attributes_template[64];
+  char unique_id[48];
+  band_stats_topic(slot, stats_topic, sizeof(stats_topic));
+  snprintf(value_template, sizeof(value_template), "{{ value_json['%llu'].count }}", (unsigned long long)band->band_id);
+  snprintf(attributes_template, sizeof(attributes_template), "{{ value_json['%llu'] | tojson }}",
+           (unsigned long long)band->band_id);
+  snprintf(unique_id, sizeof(unique_id), "magicband_band_%llu", (unsigned long long)band->band_id);
+  
+  json.begin_object();
+  json.field("name", band->name);
+  json.field("unique_id", unique_id);
+  json.field("state_topic", stats_topic);
+  json.field("value_template", value_template);
+  json.field("json_attributes_topic", stats_topic);
+  json.field("json_attributes_template", attributes_template);
+  json.field("state_class", "total_increasing");
+  json.field("unit_of_measurement", "taps");
+  write_discovery_device(json, false);
+  json.end_object();
+}
+
+// Topic of discovery entity `index` - false if there is none (a free registry slot)
+static bool discovery_entity_topic(int index, char* topic, size_t size) {
+  if (index < DISCOVERY_ENTITY_COUNT) {
+    snprintf(topic, size, "%s", discovery_entities[index].topic);
+    return true;
+  }
+  BandConfig* band = band_registry_at(index - DISCOVERY_ENTITY_COUNT);
+  if (band == nullptr) {
+    return false;
+  }
+  band_config_topic(band->band_id, topic, size);
+  return true;
+}
+
+static void write_discovery_entity(int index, JsonWriter& json) {
+  if (index < DISCOVERY_ENTITY_COUNT) {
+    discovery_entities[index].write(json);
   } else {
-    doc["name"] = "Unknown";
+    int slot = index - DISCOVERY_ENTITY_COUNT;
+    write_band_config(json, slot, band_registry_at(slot));
+  }
+}
+
+// FNV-1a - only has to notice a change, nobody is trying to forge a collision
+static uint32_t fnv1a(uint32_t hash, const char* data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Write every config once into a scratch buffer and hash topics and payloads
+// Returns true if the hash changed
+static bool compute_discovery_hash() {
+  uint32_t hash = 2166136261u;
+  char topic[96];
+  for (int i = 0; i < DISCOVERY_INDEX_END; i++) {
+    if (!discovery_entity_topic(i, topic, sizeof(topic))) {
+      continue;
+    }
+    JsonBuffer<MQTT_DISCOVERY_PAYLOAD_MAX + 1> json;
+    write_discovery_entity(i, json);
+    hash = fnv1a(hash, topic, strlen(topic) + 1);
+    hash = fnv1a(hash, json.c_str(), json.length() + 1);
   }
   
-  serializeJson(doc, buffer);
-  mqtt_client.publish(MQTT_WAND_TOPIC, buffer);
+  char previous[sizeof(discovery_hash)];
+  memcpy(previous, discovery_hash, sizeof(previous));
+  snprintf(discovery_hash, sizeof(discovery_hash), "%08lx", (unsigned long)hash);
+  return strcmp(previous, discovery_hash) != 0;
+}
+
+// The broker's retained hash - arrives right after every subscribe, and again as the echo
+// of our own publish
+static void handle_discovery_hash(const char* message) {
+  discovery_check_pending = false;
+  discovery_checked_session = mqtt_sessions.load(std::memory_order_acquire);
+  if (strcmp(message, discovery_hash) == 0) {
+    LOGI(TAG, "Discovery configs on the broker are current");
+    return;
+  }
+  publish_discovery_configs();
+}
+
+// Start (or restart) publishing the discovery set
+// There is a config per band, far more than the outgoing queue holds, so service_discovery()
+// queues them a burst per loop pass and picks up where it left off when the queue is full
+void publish_discovery_configs() {
+  LOGI(TAG, "Publishing Home Assistant discovery configs...");
+  discovery_cursor = 0;
+}
+
+// Discovery payloads are written straight into the outgoing queue - no JSON document
+static void service_discovery() {
+  if (discovery_cursor < 0) {
+    return;
+  }
   
-  DEBUG_PRINT("Published wand activation: ");
-  DEBUG_PRINTLN(wand_id_str);
+  char topic[96];
+  int queued = 0;
+  while (discovery_cursor < DISCOVERY_INDEX_END && queued < MQTT_DISCOVERY_BURST) {
+    if (!discovery_entity_topic(discovery_cursor, topic, sizeof(topic))) {
+      discovery_cursor++;  // Free registry slot
+      continue;
+    }
+    char* payload = mqtt_queue_reserve(&mqtt_outgoing, topic, MQTT_DISCOVERY_PAYLOAD_MAX, true);
+    if (payload == nullptr) {
+      return;  // Outgoing queue full - carry on next pass
+    }
+    JsonWriter json(payload, MQTT_DISCOVERY_PAYLOAD_MAX + 1);
+    write_discovery_entity(discovery_cursor, json);
+    mqtt_commit(json, topic);  // Too large is a bug, not something a retry fixes
+    discovery_cursor++;
+    queued++;
+  }
+  if (discovery_cursor < DISCOVERY_INDEX_END) {
+    return;
+  }
+  
+  // The hash goes last, so the broker only records it once the whole set is out
+  if (!mqtt_queue_push(&mqtt_outgoing, MQTT_DISCOVERY_HASH_TOPIC, (const uint8_t*)discovery_hash,
+                       strlen(discovery_hash), true)) {
+    return;
+  }
+  discovery_cursor = -1;
+  LOGI(TAG, "Discovery configs published");
 }
 
-void publish_stats() {
-  if (!mqtt_client.connected()) return;
+// The band set changed (provisioning) - republish discovery if that changed any config
+static void refresh_discovery() {
+  if (compute_discovery_hash() && mqtt_connected) {
+    publish_discovery_configs();
+  }
+  // Offline, the hash check on the next session catches it
+}
+
+// A removed band's entity is deleted in Home Assistant by clearing its retained config
+static void remove_band_config(uint64_t band_id) {
+  char topic[96];
+  band_config_topic(band_id, topic, sizeof(topic));
+  if (!mqtt_queue_push(&mqtt_outgoing, topic, nullptr, 0, true)) {
+    LOGW(TAG, "MQTT outgoing queue full - stale entity left for %s", topic);
+  }
+}
+
+void publish_state() {
+  if (!mqtt_connected) return;
   
-  StaticJsonDocument<256> doc;
-  char buffer[256];
+  char* payload = mqtt_reserve(MQTT_STATE_TOPIC, MQTT_STATE_PAYLOAD_MAX, true);
+  if (payload == nullptr) return;
   
-  doc["activations"] = ha_stats.activation_count;
-  doc["uptime"] = ha_stats.uptime;
-  doc["lid_open"] = ha_stats.lid_is_open;
-  doc["time_until_ready"] = ha_stats.time_until_ready;
+  JsonWriter json(payload, MQTT_STATE_PAYLOAD_MAX + 1);
+  json.begin_object();
+  json.field("enabled", ha_control.system_enabled ? "ON" : "OFF");
+  json.field("brightness", ha_control.led_brightness);
+  json.field("cooldown", ha_control.cooldown_time);
+  json.field("auto_close", ha_control.auto_close_enabled);
+  json.end_object();
+  mqtt_commit(json, MQTT_STATE_TOPIC);
+}
+
+// Real-time task: queue a reader event for the network task - O(1), never waits
+static void post_reader_event(ReaderEventType type, uint64_t band_id, unsigned long now) {
+  if (!task_queue_push(&reader_events, ReaderEvent{type, (uint32_t)now, band_id})) {
+    LOGW(TAG, "Reader event queue full - dropped event %d for 0x%llX", type, (unsigned long long)band_id);
+  }
+}
+
+void report_reader_live(unsigned long now) {
+  post_reader_event(READER_EVENT_LIVE, 0, now);
+}
+
+void report_wand_tap(uint64_t wand_id, unsigned long now) {
+  post_reader_event(READER_EVENT_TAP, wand_id, now);
+}
+
+void report_cooldown_start(unsigned long cooldown_from) {
+  post_reader_event(READER_EVENT_COOLDOWN, 0, cooldown_from);
+}
+
+// The event is published from loop_home_assistant(), right away when MQTT is up or
+// replayed once it reconnects
+void publish_wand_activation(uint64_t wand_id, unsigned long now) {
+  post_reader_event(READER_EVENT_ACTIVATION, wand_id, now);
+}
+
+// Record a finished activation - network task, which owns the band registry
+static void record_activation(uint64_t wand_id, uint32_t timestamp_ms) {
+  ha_stats.last_wand_id = wand_id;  // Store full 64-bit value
+  ha_stats.activation_count++;
   
-  // Send last_wand as string to avoid JSON integer overflow with 64-bit values
-  char wand_id_str[20];
-  sprintf(wand_id_str, "%llu", ha_stats.last_wand_id);
-  doc["last_wand"] = wand_id_str;
+  // Rotate to the next sound for the band's next tap (persisted so it survives a reboot)
+  // Written back with an insert so the real-time task never copies a half-updated entry
+  // A single-sound band has nothing to rotate - no flash write (and cache stall) per tap
+  BandConfig* band = find_band_config(wand_id);
+  if (band != nullptr && band->num_sounds > 1) {
+    BandConfig rotated = *band;
+    rotated.current_sound_index = (rotated.current_sound_index + 1) % rotated.num_sounds;
+    band = band_registry_insert(rotated);
+    band_store_save(*band);
+  }
   
-  serializeJson(doc, buffer);
-  mqtt_client.publish(MQTT_STATS_TOPIC, buffer);
+  int slot = band_registry_slot(band);
+  if (slot >= 0 && band_activity != nullptr) {
+    band_activity[slot].count++;
+    band_activity[slot].last_seen = timestamp_ms / 1000;
+    mark_band_stats_dirty(slot);
+  }
+  activation_buffer_push(wand_id, slot, timestamp_ms);
 }
 
-// Helper functions
-bool is_system_enabled() {
-  return ha_control.system_enabled;
+static void handle_reader_events() {
+  ReaderEvent event;
+  while (task_queue_pop(&reader_events, &event)) {
+    switch (event.type) {
+      case READER_EVENT_LIVE:
+        ha_stats.boot_ready_ms = event.time_ms;
+        break;
+      case READER_EVENT_TAP:
+      case READER_EVENT_COOLDOWN:
+        cooldown_started = true;
+        cooldown_from_ms = event.time_ms;
+        break;
+      case READER_EVENT_ACTIVATION:
+        record_activation(event.band_id, event.time_ms);
+        break;
+    }
+  }
 }
 
-uint8_t get_ha_brightness() {
-  return ha_control.led_brightness;
+// Real-time task: take the newest settings the network task queued
+bool ha_control_update(HAControlState* control) {
+  bool updated = false;
+  while (task_queue_pop(&control_updates, control)) {
+    updated = true;
+  }
+  return updated;
 }
 
-unsigned long get_ha_cooldown() {
-  return ha_control.cooldown_time;
+// Publish queued activations in order, up to one batch per call
+static void publish_pending_activations(unsigned long now) {
+  ActivationEvent event;
+  for (int i = 0; i < ACTIVATION_REPLAY_BATCH && activation_buffer_peek(&event); i++) {
+    char* payload = mqtt_reserve(MQTT_WAND_TOPIC, MQTT_WAND_PAYLOAD_MAX);
+    if (payload == nullptr) {
+      return;  // Outgoing queue full - try again next pass
+    }
+    
+    // Band name from the slot recorded at the tap - only searched for if the slot has been
+    // reused since (provisioning, or an event from before a reboot)
+    BandConfig* band = band_registry_at(event.slot);
+    if (band == nullptr || band->band_id != event.band_id) {
+      band = find_band_config(event.band_id);
+    }
+    
+    JsonWriter json(payload, MQTT_WAND_PAYLOAD_MAX + 1);
+    json.begin_object();
+    json.field_id("wand_id", event.band_id);  // Full 64-bit ID as a string
+    json.field("timestamp", event.timestamp_ms);
+    if (event.boot_id == activation_buffer_boot_id()) {
+      json.field("age_ms", (uint32_t)(now - event.timestamp_ms));  // How long it waited to be published
+    } else {
+      json.field("boot", event.boot_id);  // From before a reboot - timestamp is from that boot's clock
+    }
+    json.field("name", band != nullptr ? band->name : "Unknown");
+    json.end_object();
+    
+    mqtt_commit(json, MQTT_WAND_TOPIC);  // Can only fail on size - retrying wouldn't help
+    activation_buffer_pop();
+    
+    LOGD(TAG, "Published wand activation: 0x%llX (%s)", (unsigned long long)event.band_id,
+         band != nullptr ? band->name : "Unknown");
+  }
+}
+
+// Per-band stats
+// Counts change on the tap path (an array write and a dirty bit); service_band_stats() sends
+// each dirty group as one retained message on MQTT_BAND_STATS_TOPIC "/<group>":
+//   {"uptime": 5120, "1234567890123": {"count": 3, "seen": 4877}, ...}
+// where seen is the uptime (s) of the band's last tap.
+
+static void mark_band_stats_dirty(int slot) {
+  int group = slot / BAND_STATS_GROUP_SIZE;
+  band_stats_dirty[group / 8] |= (uint8_t)(1 << (group % 8));
+}
+
+// Clear a slot's counters for the band now in it (or none) and report the change
+static void reset_band_activity(int slot) {
+  if (slot < 0 || band_activity == nullptr) {
+    return;
+  }
+  band_activity[slot].count = 0;
+  band_activity[slot].last_seen = 0;
+  mark_band_stats_dirty(slot);
 }
 
-bool is_auto_close_enabled() {
-  return ha_control.auto_close_enabled;
+static bool publish_band_stats_group(int group) {
+  char topic[64];
+  band_stats_topic(group * BAND_STATS_GROUP_SIZE, topic, sizeof(topic));
+  char* payload = mqtt_queue_reserve(&mqtt_outgoing, topic, MQTT_BAND_STATS_PAYLOAD_MAX, true);
+  if (payload == nullptr) {
+    return false;  // Not dropped - the group stays dirty
+  }
+  
+  JsonWriter json(payload, MQTT_BAND_STATS_PAYLOAD_MAX + 1);
+  json.begin_object();
+  json.field("uptime", (uint32_t)(millis() / 1000));
+  for (int slot = group * BAND_STATS_GROUP_SIZE; slot < (group + 1) * BAND_STATS_GROUP_SIZE; slot++) {
+    BandConfig* band = band_registry_at(slot);
+    if (band != nullptr) {
+      json.key_id(band->band_id).begin_object();
+      json.field("count", band_activity[slot].count);
+      json.field("seen", band_activity[slot].last_seen);
+      json.end_object();
+    }
+  }
+  json.end_object();
+  mqtt_commit(json, topic);
+  return true;
+}
+
+static void service_band_stats() {
+  if (band_activity == nullptr) {
+    return;
+  }
+  int published = 0;
+  for (int i = 0; i < (int)sizeof(band_stats_dirty) && published < MQTT_PUBLISH_BURST; i++) {
+    while (band_stats_dirty[i] != 0 && published < MQTT_PUBLISH_BURST) {
+      int bit = __builtin_ctz(band_stats_dirty[i]);
+      if (!publish_band_stats_group(i * 8 + bit)) {
+        return;  // Outgoing queue full - still dirty, try again next pass
+      }
+      band_stats_dirty[i] &= (uint8_t)~(1 << bit);
+      published++;
+    }
+  }
+}
+
+// "key":[count,min,avg,max] for one instrumentation timer - starts its next window
+template <size_t N>
+static void write_perf_timer(JsonWriter& json, const char (&key)[N], InstrumentTimer timer) {
+  InstrumentTimerStats stats = instrument_take_timer(timer);
+  json.begin_array(key);
+  json.element(stats.count);
+  json.element(stats.min_us);
+  json.element(stats.count > 0 ? (uint32_t)(stats.total_us / stats.count) : 0);
+  json.element(stats.max_us);
+  json.end_array();
+}
+
+void publish_stats() {
+  if (!mqtt_connected) return;
+  
+  char* payload = mqtt_reserve(MQTT_STATS_TOPIC, MQTT_STATS_PAYLOAD_MAX);
+  if (payload == nullptr) return;
+  
+  // Counted as the real-time task counts it - from the end of the sounds, which can still
+  // be ahead of now while a greeting plays
+  long remaining_ms = (long)(cooldown_from_ms + ha_control.cooldown_time - millis());
+  ha_stats.time_until_ready = (cooldown_started && remaining_ms > 0) ? remaining_ms / 1000 : 0;
+  
+  JsonWriter json(payload, MQTT_STATS_PAYLOAD_MAX + 1);
+  json.begin_object();
+  json.field("activations", ha_stats.activation_count);
+  json.field("uptime", ha_stats.uptime);
+  json.field("lid_open", ha_stats.lid_is_open);
+  json.field("time_until_ready", ha_stats.time_until_ready);
+  json.field("boot_ready_ms", ha_stats.boot_ready_ms);
+  json.field("wifi_connect_ms", ha_stats.wifi_connect_ms);
+  json.field("activations_pending", activation_buffer_count());
+  json.field("activations_dropped", activation_buffer_dropped());
+  json.field_id("last_wand", ha_stats.last_wand_id);  // String - avoids JSON integer overflow with 64-bit values
+  
+  // Hot-path instrumentation - timers cover the time since the last stats publish
+  json.begin_object("perf");
+  write_perf_timer(json, "loop_us", INSTRUMENT_LOOP);
+  write_perf_timer(json, "pn532_us", INSTRUMENT_PN532_TRANSACTION);
+  write_perf_timer(json, "show_us", INSTRUMENT_LED_SHOW);
+  write_perf_timer(json, "dfplayer_us", INSTRUMENT_DFPLAYER_COMMAND);
+  json.field("pn532_fail", instrument_counter(INSTRUMENT_PN532_FAILURES));
+  json.field("dfplayer_timeout", instrument_counter(INSTRUMENT_DFPLAYER_TIMEOUTS));
+  json.field("mqtt_reconnect", instrument_counter(INSTRUMENT_MQTT_RECONNECTS));
+  json.end_object();
+  json.end_object();
+  mqtt_commit(json, MQTT_STATS_TOPIC);
 }
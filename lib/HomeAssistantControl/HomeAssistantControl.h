@@ -4,11 +4,19 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <PubSubClient.h>
+#include <BandConfig.h>
 
 // WiFi Configuration
 #define WIFI_SSID "OrbiMesh"
 #define WIFI_PASSWORD "05082013"
 
+// WiFi connection management
+// Association happens in the background - setup_home_assistant() returns immediately
+#define WIFI_RETRY_MIN_MS 1000          // Delay before the first retry after a failed attempt
+#define WIFI_RETRY_MAX_MS 60000         // Backoff doubles up to this
+#define WIFI_CONNECT_TIMEOUT_MS 10000   // Attempt without an IP after this long = failed
+#define WIFI_CACHE_NAMESPACE "wifi"     // NVS namespace for the cached BSSID/channel
+
 // MQTT Configuration (Home Assistant)
 #define MQTT_SERVER "homeassistant.local"  // Try IP if .local doesn't work
 #define MQTT_PORT 1883
@@ -25,9 +33,55 @@
 #define MQTT_BRIGHTNESS_TOPIC MQTT_BASE_TOPIC "/brightness"
 #define MQTT_COOLDOWN_TOPIC MQTT_BASE_TOPIC "/cooldown"
 #define MQTT_STATS_TOPIC MQTT_BASE_TOPIC "/stats"
+#define MQTT_PROVISION_TOPIC MQTT_BASE_TOPIC "/bands/provision"   // Bulk band definitions (JSON chunks)
+#define MQTT_PROVISION_STATUS_TOPIC MQTT_BASE_TOPIC "/bands/status" // Per-chunk acknowledgements
+#define MQTT_BAND_STATS_TOPIC MQTT_BASE_TOPIC "/bands/stats"     // Per-band counters, one retained message per slot group ("/<group>")
+#define MQTT_DISCOVERY_HASH_TOPIC MQTT_BASE_TOPIC "/discovery_hash" // Retained hash of the published discovery configs
+
+// MQTT buffer size - bounds the largest message in either direction
+// 4KB fits a provisioning chunk of ~40 bands
+#define MQTT_BUFFER_SIZE 4096
+
+// MQTT session task - owns the connection so a broker outage never blocks the network task
+// (WiFi, OTA and the message handling below run on the network task, src/main.cpp)
+#define MQTT_TASK_STACK_SIZE 6144
+#define MQTT_TASK_PRIORITY 1
+#define MQTT_TASK_INTERVAL_MS 10        // Pause between session passes
+#define MQTT_RETRY_INTERVAL_MS 5000     // Between connect attempts
+#define MQTT_SOCKET_TIMEOUT_S 5         // Longest a connect attempt can hold the task
+#define MQTT_PUBLISH_BURST 8            // Queued messages sent per pass
+#define MQTT_DISCOVERY_HASH_WAIT_MS 2000 // Wait for the broker's retained discovery hash before republishing
+#define MQTT_DISCOVERY_BURST 8          // Discovery configs queued per loop pass (one per band, so chunked)
+
+// Queues between the network task and the MQTT task (bytes, see MQTTQueue.h)
+#define MQTT_OUTGOING_QUEUE_SIZE 6144   // Discovery burst plus state/stats/activations
+#define MQTT_INCOMING_QUEUE_SIZE 8192   // Two full provisioning chunks
+
+// Largest payload of each message we publish - reserved in the outgoing queue and written
+// in place by JsonWriter (a payload that doesn't fit is dropped, never truncated)
+#define MQTT_DISCOVERY_PAYLOAD_MAX 512
+#define MQTT_STATE_PAYLOAD_MAX 96
+#define MQTT_STATS_PAYLOAD_MAX 512
+#define MQTT_WAND_PAYLOAD_MAX 160
+#define MQTT_PROVISION_STATUS_PAYLOAD_MAX 192
+#define MQTT_BAND_STATS_PAYLOAD_MAX 512
+
+// Per-band statistics - bands are reported in groups of consecutive registry slots, so each
+// stats message stays small however many bands there are (8 x 64-bit IDs fit in 512 bytes)
+#define BAND_STATS_GROUP_SIZE 8
+
+// Queues between the real-time task (reader, LEDs, audio) and the network task (records, see TaskQueue.h)
+#define READER_EVENT_QUEUE_SIZE 16      // Taps and activations waiting for the network task
+#define HA_CONTROL_QUEUE_SIZE 4         // Settings changes waiting for the real-time task
+
+// Band provisioning limits
+#define MQTT_PROVISION_MAX_BANDS 64          // Bands (adds + removes) accepted per chunk
+#define MQTT_PROVISION_DOC_SIZE 12288        // ArduinoJson pool for one parsed chunk
 
 // Home Assistant Discovery Topics
 #define HA_DISCOVERY_PREFIX "homeassistant"
+#define HA_STATUS_TOPIC HA_DISCOVERY_PREFIX "/status"  // Home Assistant birth and last-will messages
+#define HA_BIRTH_PAYLOAD "online"
 
 // Control flags that can be modified by Home Assistant
 struct HAControlState {
@@ -44,26 +98,32 @@ struct HAStats {
   unsigned long uptime;         // System uptime in seconds
   bool lid_is_open;             // Current lid state
   unsigned long time_until_ready; // Time until cooldown ends
+  unsigned long boot_ready_ms;  // millis() when the band reader was first polled (boot metric)
+  unsigned long wifi_connect_ms; // millis() of the first WiFi connection (0 = not connected yet)
 };
 
-// Global control state
+// Global control state - network task only (the real-time task gets copies, see ha_control_update())
 extern HAControlState ha_control;
 extern HAStats ha_stats;
 
-// Function declarations
+// Function declarations - network task
 void setup_home_assistant();
 void loop_home_assistant();
 void publish_discovery_configs();
 void publish_state();
-void publish_wand_activation(uint64_t wand_id);
 void publish_stats();
 void reconnect_mqtt();
-void mqtt_callback(char* topic, byte* payload, unsigned int length);
+void mqtt_callback(char* topic, byte* payload, unsigned int length);       // MQTT task - queues the message
+void handle_mqtt_message(const char* topic, const byte* payload, unsigned int length);  // Network task - acts on it
+bool is_mqtt_connected();
+void handle_band_provisioning(const byte* payload, unsigned int length);
+bool is_wifi_connected();
 
-// Helper functions to check states
-bool is_system_enabled();
-uint8_t get_ha_brightness();
-unsigned long get_ha_cooldown();
-bool is_auto_close_enabled();
+// Real-time task side - queued for loop_home_assistant(), never waits on the network task
+void report_reader_live(unsigned long now);                       // Reader polled for the first time (boot metric)
+void report_wand_tap(uint64_t wand_id, unsigned long now);        // Activation started - cooldown runs from here
+void report_cooldown_start(unsigned long cooldown_from);          // ...until moved to here (may be ahead of now)
+void publish_wand_activation(uint64_t wand_id, unsigned long now); // Activation finished - published, sound rotated
+bool ha_control_update(HAControlState* control);                  // Latest settings from Home Assistant, false if unchanged
 
 #endif // HOME_ASSISTANT_CONTROL_H
@@ -0,0 +1,207 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Zero-allocation JSON writer for the fixed MQTT payloads
+//
+// Writes compact JSON straight into a caller-provided buffer - for publishes that is the
+// record reserved in the outgoing MQTT queue, so there is no document, no second buffer and
+// no copy. Keys are string literals whose length is known at compile time, and the value
+// encoding is picked at compile time from the value's type. Output is byte-for-byte what
+// ArduinoJson's serializeJson() produces for the same fields (except control characters in
+// strings, which are escaped as \u00XX instead of written raw).
+//
+// Running out of room never writes past the buffer: the writer stops and overflowed() is
+// true, and the caller drops the message.
+//
+// No Arduino dependency - builds on the host for tools/json_writer_benchmark.cpp.
+
+class JsonWriter {
+ public:
+  // capacity includes the terminating NUL and must be at least 1
+  JsonWriter(char* buffer, size_t capacity)
+      : buffer_(buffer), capacity_(capacity - 1), length_(0), overflowed_(false), need_comma_(false) {
+    terminate();
+  }
+
+  // Objects and arrays - the keyed forms open a member of the enclosing object
+  JsonWriter& begin_object() { separator(); put('{'); need_comma_ = false; return *this; }
+  template <size_t N>
+  JsonWriter& begin_object(const char (&key)[N]) { write_key(key, N - 1); put('{'); need_comma_ = false; return *this; }
+  JsonWriter& end_object() { put('}'); need_comma_ = true; return terminate(); }
+
+  JsonWriter& begin_array() { separator(); put('['); need_comma_ = false; return *this; }
+  template <size_t N>
+  JsonWriter& begin_array(const char (&key)[N]) { write_key(key, N - 1); put('['); need_comma_ = false; return *this; }
+  JsonWriter& end_array() { put(']'); need_comma_ = true; return terminate(); }
+
+  // "key":value - the encoding is chosen by the type of value:
+  //   bool -> true/false, integers -> decimal, const char* -> escaped string (nullptr -> null)
+  template <size_t N, typename T>
+  JsonWriter& field(const char (&key)[N], T value) {
+    write_key(key, N - 1);
+    write_value(value);
+    need_comma_ = true;
+    return terminate();
+  }
+
+  // "key":"12345" - 64-bit band IDs go out as strings, JSON numbers lose precision past 2^53
+  template <size_t N>
+  JsonWriter& field_id(const char (&key)[N], uint64_t value) {
+    write_key(key, N - 1);
+    put('"');
+    write_unsigned(value);
+    put('"');
+    need_comma_ = true;
+    return terminate();
+  }
+
+  // "12345": - a 64-bit band ID as an object key, for maps keyed by band
+  // Follow it with a value-less call: begin_object() / begin_array()
+  JsonWriter& key_id(uint64_t value) {
+    separator();
+    put('"');
+    write_unsigned(value);
+    put('"');
+    put(':');
+    need_comma_ = false;
+    return *this;
+  }
+
+  // Array element
+  template <typename T>
+  JsonWriter& element(T value) {
+    separator();
+    write_value(value);
+    need_comma_ = true;
+    return terminate();
+  }
+
+  const char* c_str() const { return buffer_; }
+  size_t length() const { return length_; }
+  bool overflowed() const { return overflowed_; }
+
+ private:
+  char* buffer_;
+  size_t capacity_;  // Excludes the terminator
+  size_t length_;
+  bool overflowed_;
+  bool need_comma_;
+
+  void put(char c) {
+    if (length_ < capacity_) {
+      buffer_[length_++] = c;
+    } else {
+      overflowed_ = true;
+    }
+  }
+
+  void put(const char* text, size_t n) {
+    if (n > capacity_ - length_) {
+      n = capacity_ - length_;
+      overflowed_ = true;
+    }
+    memcpy(buffer_ + length_, text, n);
+    length_ += n;
+  }
+
+  JsonWriter& terminate() {
+    buffer_[length_] = '\0';
+    return *this;
+  }
+
+  void separator() {
+    if (need_comma_) {
+      put(',');
+    }
+  }
+
+  // Keys are literals we write ourselves - no escaping needed
+  void write_key(const char* key, size_t n) {
+    separator();
+    put('"');
+    put(key, n);
+    put('"');
+    put(':');
+  }
+
+  void write_unsigned(uint64_t value) {
+    char digits[20];
+    size_t n = 0;
+    do {
+      digits[n++] = '0' + (char)(value % 10);
+      value /= 10;
+    } while (value != 0);
+    while (n > 0) {
+      put(digits[--n]);
+    }
+  }
+
+  void write_value(bool value) {
+    if (value) {
+      put("true", 4);
+    } else {
+      put("false", 5);
+    }
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type write_value(T value) {
+    write_unsigned(value);
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type write_value(T value) {
+    if (value < 0) {
+      put('-');
+      write_unsigned((uint64_t)0 - (uint64_t)value);
+    } else {
+      write_unsigned((uint64_t)value);
+    }
+  }
+
+  void write_value(const char* value) {
+    if (value == nullptr) {
+      put("null", 4);
+      return;
+    }
+    static const char hex[] = "0123456789abcdef";
+    put('"');
+    for (const char* p = value; *p != '\0'; p++) {
+      unsigned char c = (unsigned char)*p;
+      switch (c) {
+        case '"': put("\\\"", 2); break;
+        case '\\': put("\\\\", 2); break;
+        case '\b': put("\\b", 2); break;
+        case '\f': put("\\f", 2); break;
+        case '\n': put("\\n", 2); break;
+        case '\r': put("\\r", 2); break;
+        case '\t': put("\\t", 2); break;
+        default:
+          if (c < 0x20) {
+            char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F]};
+            put(escaped, 6);
+          } else {
+            put((char)c);
+          }
+      }
+    }
+    put('"');
+  }
+};
+
+// A writer with its own storage, for payloads built on the stack
+template <size_t Capacity>
+class JsonBuffer : public JsonWriter {
+ public:
+  JsonBuffer() : JsonWriter(storage_, Capacity) {}
+
+ private:
+  char storage_[Capacity];
+};
+
+#endif // JSON_WRITER_H
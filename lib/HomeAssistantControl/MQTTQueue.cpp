@@ -0,0 +1,145 @@
+#include "MQTTQueue.h"
+
+// Record layout: header, topic + NUL, payload + NUL
+struct MQTTRecordHeader {
+  uint16_t topic_length;  // MQTT_RECORD_WRAP = rest of the buffer is unused, continue at 0
+  uint16_t payload_length;
+  uint8_t retain;
+};
+
+#define MQTT_RECORD_WRAP 0xFFFF
+#define MQTT_RECORD_HEADER_SIZE sizeof(MQTTRecordHeader)
+
+static uint32_t record_size(uint16_t topic_length, uint16_t payload_length) {
+  return MQTT_RECORD_HEADER_SIZE + topic_length + 1 + payload_length + 1;
+}
+
+void mqtt_queue_init(MQTTQueue* queue, uint8_t* buffer, uint32_t size) {
+  queue->buffer = buffer;
+  queue->size = size;
+  queue->head.store(0, std::memory_order_relaxed);
+  queue->tail.store(0, std::memory_order_relaxed);
+  queue->dropped = 0;
+  queue->reserved_at = 0;
+  queue->reserved_topic_length = 0;
+  queue->reserved_length = 0;
+}
+
+char* mqtt_queue_reserve(MQTTQueue* queue, const char* topic, uint16_t max_length, bool retain) {
+  size_t topic_length = strlen(topic);
+  if (topic_length >= MQTT_RECORD_WRAP) {
+    queue->dropped++;
+    return nullptr;
+  }
+  uint32_t needed = record_size(topic_length, max_length);
+
+  uint32_t head = queue->head.load(std::memory_order_relaxed);
+  uint32_t tail = queue->tail.load(std::memory_order_acquire);
+  uint32_t write_at;
+
+  // head == tail means empty, so the producer always leaves at least one byte free
+  if (head >= tail) {
+    uint32_t to_end = queue->size - head;
+    if (needed < to_end || (needed == to_end && tail != 0)) {
+      write_at = head;
+    } else if (needed < tail) {
+      // Doesn't fit before the end - mark the rest as unused and start over at 0
+      if (to_end >= MQTT_RECORD_HEADER_SIZE) {
+        MQTTRecordHeader wrap = {MQTT_RECORD_WRAP, 0, 0};
+        memcpy(queue->buffer + head, &wrap, sizeof(wrap));
+      }
+      write_at = 0;
+    } else {
+      queue->dropped++;
+      return nullptr;
+    }
+  } else if (needed < tail - head) {
+    write_at = head;
+  } else {
+    queue->dropped++;
+    return nullptr;
+  }
+
+  // Header now with the reserved length - the real one is filled in by the commit
+  MQTTRecordHeader header = {(uint16_t)topic_length, max_length, (uint8_t)retain};
+  uint8_t* record = queue->buffer + write_at;
+  memcpy(record, &header, sizeof(header));
+  memcpy(record + MQTT_RECORD_HEADER_SIZE, topic, topic_length + 1);
+
+  queue->reserved_at = write_at;
+  queue->reserved_topic_length = topic_length;
+  queue->reserved_length = max_length;
+  return (char*)(record + MQTT_RECORD_HEADER_SIZE + topic_length + 1);
+}
+
+void mqtt_queue_commit(MQTTQueue* queue, uint16_t length) {
+  if (length > queue->reserved_length) {
+    length = queue->reserved_length;
+  }
+  uint8_t* record = queue->buffer + queue->reserved_at;
+  MQTTRecordHeader header;
+  memcpy(&header, record, sizeof(header));
+  header.payload_length = length;
+  memcpy(record, &header, sizeof(header));
+  record[MQTT_RECORD_HEADER_SIZE + queue->reserved_topic_length + 1 + length] = '\0';
+
+  // Publish the record - the release pairs with the consumer's acquire of head
+  queue->head.store((queue->reserved_at + record_size(queue->reserved_topic_length, length)) % queue->size,
+                    std::memory_order_release);
+}
+
+bool mqtt_queue_push(MQTTQueue* queue, const char* topic, const uint8_t* payload, uint16_t length, bool retain) {
+  char* payload_at = mqtt_queue_reserve(queue, topic, length, retain);
+  if (payload_at == nullptr) {
+    return false;
+  }
+  if (length > 0) {
+    memcpy(payload_at, payload, length);
+  }
+  mqtt_queue_commit(queue, length);
+  return true;
+}
+
+// Position of the oldest record, following a wrap if there is one
+static uint32_t first_record(MQTTQueue* queue, uint32_t tail) {
+  if (queue->size - tail < MQTT_RECORD_HEADER_SIZE) {
+    return 0;  // Too little room left for even a header - the producer wrapped
+  }
+  MQTTRecordHeader header;
+  memcpy(&header, queue->buffer + tail, sizeof(header));
+  return header.topic_length == MQTT_RECORD_WRAP ? 0 : tail;
+}
+
+bool mqtt_queue_peek(MQTTQueue* queue, MQTTQueuedMessage* message) {
+  uint32_t tail = queue->tail.load(std::memory_order_relaxed);
+  uint32_t head = queue->head.load(std::memory_order_acquire);
+  if (head == tail) {
+    return false;
+  }
+
+  uint32_t at = first_record(queue, tail);
+  MQTTRecordHeader header;
+  memcpy(&header, queue->buffer + at, sizeof(header));
+
+  const uint8_t* record = queue->buffer + at;
+  message->topic = (const char*)(record + MQTT_RECORD_HEADER_SIZE);
+  message->payload = record + MQTT_RECORD_HEADER_SIZE + header.topic_length + 1;
+  message->length = header.payload_length;
+  message->retain = header.retain != 0;
+  return true;
+}
+
+void mqtt_queue_pop(MQTTQueue* queue) {
+  uint32_t tail = queue->tail.load(std::memory_order_relaxed);
+  if (queue->head.load(std::memory_order_acquire) == tail) {
+    return;
+  }
+
+  uint32_t at = first_record(queue, tail);
+  MQTTRecordHeader header;
+  memcpy(&header, queue->buffer + at, sizeof(header));
+
+  // Hand the space back - the release keeps the producer from overwriting it while we read
+  queue->tail.store((at + record_size(header.topic_length, header.payload_length)) % queue->size,
+                    std::memory_order_release);
+}
@@ -0,0 +1,58 @@
+#ifndef MQTT_QUEUE_H
+#define MQTT_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Lock-free message queue between the MQTT task and the network task
+//
+// Single producer, single consumer: one side only pushes, the other only peeks and pops,
+// so two atomic indices are all the synchronization needed - neither side ever waits.
+// Messages are variable-length records packed into one byte buffer, so a 3KB provisioning
+// chunk and a 40-byte state update share the same space. Each record is contiguous
+// (a record that doesn't fit before the end of the buffer starts again at the beginning),
+// which lets the consumer use the topic and payload in place without copying.
+//
+// No ESP-IDF dependency - builds and runs on the host.
+
+struct MQTTQueue {
+  uint8_t* buffer;
+  uint32_t size;
+  std::atomic<uint32_t> head;  // Next write position - written by the producer only
+  std::atomic<uint32_t> tail;  // Next read position - written by the consumer only
+  uint32_t dropped;            // Messages refused because the queue was full (producer side)
+  uint32_t reserved_at;        // Open reservation (producer side) - see mqtt_queue_reserve()
+  uint16_t reserved_topic_length;
+  uint16_t reserved_length;
+};
+
+// A message in the queue - pointers stay valid until mqtt_queue_pop()
+struct MQTTQueuedMessage {
+  const char* topic;       // NUL-terminated
+  const uint8_t* payload;  // Also NUL-terminated, so text payloads can be used as strings
+  uint16_t length;         // Payload length without the terminator
+  bool retain;
+};
+
+// Set up a queue over a caller-provided buffer
+void mqtt_queue_init(MQTTQueue* queue, uint8_t* buffer, uint32_t size);
+
+// Producer: copy a message in - false (and counted in dropped) if there is no room
+bool mqtt_queue_push(MQTTQueue* queue, const char* topic, const uint8_t* payload, uint16_t length, bool retain);
+
+// Producer: reserve room for a message and build its payload in place
+// Returns the payload area (max_length + 1 bytes, room for a terminator), nullptr (counted in
+// dropped) if there is no room. Nothing is visible to the consumer until mqtt_queue_commit();
+// a reservation that is never committed is simply reused by the next one.
+char* mqtt_queue_reserve(MQTTQueue* queue, const char* topic, uint16_t max_length, bool retain);
+
+// Producer: publish the reserved message with its actual payload length (<= max_length)
+void mqtt_queue_commit(MQTTQueue* queue, uint16_t length);
+
+// Consumer: look at the oldest message without removing it - false if the queue is empty
+bool mqtt_queue_peek(MQTTQueue* queue, MQTTQueuedMessage* message);
+
+// Consumer: drop the message returned by the last peek
+void mqtt_queue_pop(MQTTQueue* queue);
+
+#endif // MQTT_QUEUE_H
@@ -0,0 +1,49 @@
+#include "Instrumentation.h"
+
+#if INSTRUMENTATION_ENABLED
+
+#include <atomic>
+
+static std::atomic<uint32_t> counters[INSTRUMENT_COUNTER_COUNT];
+
+// Each timer has two windows: the recording task fills the active one while the other is
+// free. Taking a snapshot flips the active window, waits out a sample that was being added
+// to the old one (a few stores on the other core) and then reads it at leisure.
+static InstrumentTimerStats timers[INSTRUMENT_TIMER_COUNT][2];
+static std::atomic<uint8_t> timer_active[INSTRUMENT_TIMER_COUNT];     // Window being recorded into
+static std::atomic<bool> timer_recording[INSTRUMENT_TIMER_COUNT];     // Sample being added right now
+
+void instrument_count(InstrumentCounter counter) {
+  counters[counter].fetch_add(1, std::memory_order_relaxed);
+}
+
+void instrument_time(InstrumentTimer timer, uint32_t elapsed_us) {
+  timer_recording[timer].store(true);  // Sequentially consistent with the flip in instrument_take_timer()
+  InstrumentTimerStats& stats = timers[timer][timer_active[timer].load()];
+  if (stats.count == 0 || elapsed_us < stats.min_us) {
+    stats.min_us = elapsed_us;
+  }
+  if (elapsed_us > stats.max_us) {
+    stats.max_us = elapsed_us;
+  }
+  stats.total_us += elapsed_us;
+  stats.count++;
+  timer_recording[timer].store(false, std::memory_order_release);
+}
+
+uint32_t instrument_counter(InstrumentCounter counter) {
+  return counters[counter].load(std::memory_order_relaxed);
+}
+
+InstrumentTimerStats instrument_take_timer(InstrumentTimer timer) {
+  uint8_t window = timer_active[timer].load(std::memory_order_relaxed);
+  timer_active[timer].store(1 - window);
+  while (timer_recording[timer].load(std::memory_order_acquire)) {
+    // A sample that picked the old window before the flip - done in a few instructions
+  }
+  InstrumentTimerStats stats = timers[timer][window];
+  timers[timer][window] = InstrumentTimerStats{0, 0, 0, 0};
+  return stats;
+}
+
+#endif
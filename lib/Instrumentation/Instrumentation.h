@@ -0,0 +1,64 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <Arduino.h>
+
+// Hot-path instrumentation - fixed-slot counters and timers, published with the HA stats
+//
+// Every slot lives in one static array indexed by an enum, so recording is a few adds and
+// compares: no allocation, no lookup, no formatting. Cheap enough to leave on in production.
+//   Counters: running totals since boot. Safe from any task (the MQTT task counts reconnects).
+//   Timers:   count / min / max / total in microseconds since the last snapshot, so min and
+//             max describe the recent window rather than boot. Recorded by the real-time
+//             task only; taken by the network task when it publishes the stats.
+
+#define INSTRUMENTATION_ENABLED 1  // 0 = every call compiles to nothing
+
+enum InstrumentCounter {
+  INSTRUMENT_PN532_FAILURES,      // Reader refused a command or a detected card couldn't be read
+  INSTRUMENT_DFPLAYER_TIMEOUTS,   // Commands the module never acknowledged
+  INSTRUMENT_MQTT_RECONNECTS,     // Broker sessions after the first one
+  INSTRUMENT_COUNTER_COUNT
+};
+
+enum InstrumentTimer {
+  INSTRUMENT_LOOP,                // One loop() pass, excluding its closing delay()
+  INSTRUMENT_PN532_TRANSACTION,   // Poll, arm or collect on the reader
+  INSTRUMENT_LED_SHOW,            // Latching a frame (RMT hand-off or FastLED.show())
+  INSTRUMENT_DFPLAYER_COMMAND,    // Command sent to ACK (or error reply) received
+  INSTRUMENT_TIMER_COUNT
+};
+
+struct InstrumentTimerStats {
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t total_us;
+};
+
+#if INSTRUMENTATION_ENABLED
+
+void instrument_count(InstrumentCounter counter);
+void instrument_time(InstrumentTimer timer, uint32_t elapsed_us);
+
+// Time since a micros() taken at the start of the measured work
+inline void instrument_since(InstrumentTimer timer, unsigned long start_us) {
+  instrument_time(timer, (uint32_t)(micros() - start_us));
+}
+
+uint32_t instrument_counter(InstrumentCounter counter);
+
+// Copy a timer's window and start a new one - from any task, nothing recorded is lost
+InstrumentTimerStats instrument_take_timer(InstrumentTimer timer);
+
+#else
+
+inline void instrument_count(InstrumentCounter counter) {}
+inline void instrument_time(InstrumentTimer timer, uint32_t elapsed_us) {}
+inline void instrument_since(InstrumentTimer timer, unsigned long start_us) {}
+inline uint32_t instrument_counter(InstrumentCounter counter) { return 0; }
+inline InstrumentTimerStats instrument_take_timer(InstrumentTimer timer) { return InstrumentTimerStats{0, 0, 0, 0}; }
+
+#endif
+
+#endif // INSTRUMENTATION_H
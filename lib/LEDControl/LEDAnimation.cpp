@@ -0,0 +1,347 @@
+#include <LEDAnimation.h>
+#include <DebugConfig.h>
+
+// Draw a chase head at pos with a two-pixel tail behind it (direction +1 or -1)
+// LED 0 is never lit
+static void draw_chase(CRGB* buffer, int pos, int direction, CRGB color) {
+  fill_solid(buffer, NUM_LEDS, CRGB::Black);
+  buffer[pos] = color;
+
+  int tail1 = pos - direction;
+  int tail2 = pos - 2 * direction;
+  if (tail1 >= 1 && tail1 < NUM_LEDS) {
+    buffer[tail1] = color;
+    buffer[tail1].fadeToBlackBy(128);
+  }
+  if (tail2 >= 1 && tail2 < NUM_LEDS) {
+    buffer[tail2] = color;
+    buffer[tail2].fadeToBlackBy(192);
+  }
+}
+
+// Copy src into buffer scaled by scale (0 = black, 255 = unchanged)
+static void draw_scaled(CRGB* buffer, const CRGB* src, uint8_t scale) {
+  for (int i = 0; i < NUM_LEDS; i++) {
+    buffer[i] = src[i];
+    buffer[i].nscale8(scale);
+  }
+}
+
+// Linear ramp from 0 to 255 over duration_ms
+static uint8_t ramp(unsigned long elapsed_ms, unsigned long duration_ms) {
+  if (duration_ms == 0 || elapsed_ms >= duration_ms) {
+    return 255;
+  }
+  return (uint8_t)(elapsed_ms * 255 / duration_ms);
+}
+
+bool SolidEffect::render(CRGB* buffer, unsigned long frame_time) {
+  fill_solid(buffer, NUM_LEDS, color);
+  return false;  // Nothing to animate - the layer holds this frame
+}
+
+bool ChaseEffect::render(CRGB* buffer, unsigned long frame_time) {
+  // One cycle is a forward pass over LEDs 1..N-1 and a reverse pass back to 1
+  const int steps_per_pass = NUM_LEDS - 1;
+  unsigned long step = elapsed(frame_time) / speed_ms;
+
+  if (step >= (unsigned long)(num_cycles * 2 * steps_per_pass)) {
+    fill_solid(buffer, NUM_LEDS, CRGB::Black);
+    return false;
+  }
+
+  int pass_step = step % (2 * steps_per_pass);
+  if (pass_step < steps_per_pass) {
+    draw_chase(buffer, 1 + pass_step, 1, color);
+  } else {
+    draw_chase(buffer, NUM_LEDS - 1 - (pass_step - steps_per_pass), -1, color);
+  }
+  return true;
+}
+
+void AcceleratingChaseEffect::begin(unsigned long frame_time, const CRGB* current_frame) {
+  LEDEffect::begin(frame_time, current_frame);
+  position = 1;
+  next_position = 1;
+  next_step = frame_time;
+}
+
+// Step time at a point in the animation - shrinks linearly over duration_ms
+int AcceleratingChaseEffect::step_time(unsigned long at) const {
+  if (at >= duration_ms) {
+    return end_speed_ms;
+  }
+  return start_speed_ms - (int)((long)(start_speed_ms - end_speed_ms) * (long)at / (long)duration_ms);
+}
+
+bool AcceleratingChaseEffect::render(CRGB* buffer, unsigned long frame_time) {
+  unsigned long elapsed_ms = elapsed(frame_time);
+
+  if (elapsed_ms >= duration_ms) {
+    if (elapsed_ms < duration_ms + flash_ms) {
+      // Final flash - whole strip except LED 0
+      fill_solid(buffer, NUM_LEDS, color);
+      buffer[0] = CRGB::Black;
+      return true;
+    }
+    fill_solid(buffer, NUM_LEDS, CRGB::Black);
+    return false;
+  }
+
+  // Advance through every step that came due since the last frame
+  while ((long)(frame_time - next_step) >= 0) {
+    position = next_position;
+    next_position = (position + 1 < NUM_LEDS) ? position + 1 : 1;  // Wrap back to LED 1
+    next_step += step_time(next_step - start_time);
+  }
+
+  draw_chase(buffer, position, 1, color);
+  return true;
+}
+
+void FadeOutEffect::begin(unsigned long frame_time, const CRGB* current_frame) {
+  LEDEffect::begin(frame_time, current_frame);
+  memcpy(snapshot, current_frame, sizeof(snapshot));
+}
+
+bool FadeOutEffect::render(CRGB* buffer, unsigned long frame_time) {
+  uint8_t progress = ramp(elapsed(frame_time), duration_ms);
+  draw_scaled(buffer, snapshot, 255 - progress);
+  return progress < 255;
+}
+
+bool FadeInOutEffect::render(CRGB* buffer, unsigned long frame_time) {
+  unsigned long elapsed_ms = elapsed(frame_time);
+  uint8_t scale;
+  bool running = true;
+
+  if (elapsed_ms < fade_ms) {
+    scale = ramp(elapsed_ms, fade_ms);
+  } else if (elapsed_ms < fade_ms + hold_ms) {
+    scale = 255;
+  } else {
+    scale = 255 - ramp(elapsed_ms - fade_ms - hold_ms, fade_ms);
+    running = scale > 0;
+  }
+
+  fill_solid(buffer, NUM_LEDS, color);
+  nscale8(buffer, NUM_LEDS, scale);
+  return running;
+}
+
+bool FlashEffect::render(CRGB* buffer, unsigned long frame_time) {
+  // Even phases are "on", odd phases are "off"
+  unsigned long phase = elapsed(frame_time) / flash_speed_ms;
+  if (phase >= (unsigned long)(num_flashes * 2)) {
+    fill_solid(buffer, NUM_LEDS, CRGB::Black);
+    return false;
+  }
+  fill_solid(buffer, NUM_LEDS, (phase % 2 == 0) ? color : CRGB(CRGB::Black));
+  return true;
+}
+
+void PulseEffect::begin(unsigned long frame_time, const CRGB* current_frame) {
+  LEDEffect::begin(frame_time, current_frame);
+  memcpy(snapshot, current_frame, sizeof(snapshot));
+  finishing = false;
+}
+
+bool PulseEffect::render(CRGB* buffer, unsigned long frame_time) {
+  if (finishing) {
+    memcpy(buffer, snapshot, sizeof(snapshot));
+    return false;
+  }
+
+  // Triangle wave: min_scale -> 255 -> min_scale once per period
+  unsigned long half = period_ms / 2;
+  unsigned long t = elapsed(frame_time) % period_ms;
+  uint8_t level = (t < half) ? ramp(t, half) : 255 - ramp(t - half, half);
+  draw_scaled(buffer, snapshot, min_scale + scale8(level, 255 - min_scale));
+  return true;
+}
+
+bool StartupEffect::render(CRGB* buffer, unsigned long frame_time) {
+  // Timeline (ms): black 0-100, rainbow sweep 100-490, white 490-690, fade to black 690-1340
+  const unsigned long SWEEP_START = 100;
+  const unsigned long SWEEP_STEP = 30;
+  const unsigned long SWEEP_END = SWEEP_START + 13 * SWEEP_STEP;
+  const unsigned long WHITE_END = SWEEP_END + 200;
+  const unsigned long FADE_END = WHITE_END + 650;
+  const uint8_t WHITE_SCALE = 191;  // Slightly dimmer than the rainbow peak
+
+  unsigned long elapsed_ms = elapsed(frame_time);
+
+  if (elapsed_ms < SWEEP_START) {
+    fill_solid(buffer, NUM_LEDS, CRGB::Black);
+  } else if (elapsed_ms < SWEEP_END) {
+    // Rainbow sweep brightening in steps of 10 up to 120
+    uint8_t value = ((elapsed_ms - SWEEP_START) / SWEEP_STEP) * 10;
+    for (int i = 0; i < NUM_LEDS; i++) {
+      buffer[i] = CHSV(i * 255 / NUM_LEDS, 255, value);
+    }
+  } else if (elapsed_ms < FADE_END) {
+    uint8_t scale = WHITE_SCALE;
+    if (elapsed_ms >= WHITE_END) {
+      scale = scale8(WHITE_SCALE, 255 - ramp(elapsed_ms - WHITE_END, FADE_END - WHITE_END));
+    }
+    fill_solid(buffer, NUM_LEDS, CRGB::White);
+    nscale8(buffer, NUM_LEDS, scale);
+  } else {
+    fill_solid(buffer, NUM_LEDS, CRGB::Black);
+    return false;
+  }
+  return true;
+}
+
+// Scheduler state
+struct LEDLayer {
+  LEDEffect* effect;            // Running or holding effect, nullptr if the layer is empty
+  bool started;                 // begin() has been called
+  bool running;                 // Effect is still animating
+  LEDBlendMode blend;
+  unsigned long transition_ms;  // Crossfade length, 0 for none
+  unsigned long transition_start;
+  CRGB frame[NUM_LEDS];         // Layer's last rendered frame
+  CRGB transition_from[NUM_LEDS];
+};
+
+static LEDLayer led_layers[LED_MAX_LAYERS];
+static bool led_layers_changed = false;  // A layer was started or cleared since the last frame
+static unsigned long led_next_frame = 0;
+
+void led_play_effect(uint8_t layer, LEDEffect* effect, unsigned long transition_ms, LEDBlendMode blend) {
+  if (layer >= LED_MAX_LAYERS) {
+    return;
+  }
+
+  LEDLayer& l = led_layers[layer];
+  if (transition_ms > 0 && l.effect != nullptr) {
+    memcpy(l.transition_from, l.frame, sizeof(l.frame));
+    l.transition_ms = transition_ms;
+  } else {
+    l.transition_ms = 0;
+  }
+
+  // The base layer starts from what's on the strip, so fades and pulses work
+  // on colors drawn outside the engine too
+  if (layer == LED_LAYER_BASE && l.effect == nullptr) {
+    memcpy(l.frame, leds, sizeof(l.frame));
+  }
+
+  l.effect = effect;
+  l.started = false;
+  l.running = true;
+  l.blend = blend;
+  led_layers_changed = true;
+}
+
+void led_clear_layer(uint8_t layer) {
+  if (layer >= LED_MAX_LAYERS) {
+    return;
+  }
+
+  LEDLayer& l = led_layers[layer];
+  l.effect = nullptr;
+  l.running = false;
+  l.transition_ms = 0;
+  fill_solid(l.frame, NUM_LEDS, CRGB::Black);
+  led_layers_changed = true;
+}
+
+bool led_layer_running(uint8_t layer) {
+  return layer < LED_MAX_LAYERS && led_layers[layer].running;
+}
+
+LEDEffect* led_layer_effect(uint8_t layer) {
+  return layer < LED_MAX_LAYERS ? led_layers[layer].effect : nullptr;
+}
+
+// Render one layer into its frame buffer, applying any crossfade
+// Returns true while the layer still needs frames
+static bool render_layer(LEDLayer& l, unsigned long frame_time) {
+  if (!l.started) {
+    l.effect->begin(frame_time, l.frame);
+    l.started = true;
+    l.transition_start = frame_time;
+  }
+
+  // Finished effects only re-render during a crossfade (their last frame is stable)
+  if (l.running || l.transition_ms > 0) {
+    l.running = l.effect->render(l.frame, frame_time);
+  }
+
+  if (l.transition_ms > 0) {
+    unsigned long t = frame_time - l.transition_start;
+    if (t >= l.transition_ms) {
+      l.transition_ms = 0;
+    } else {
+      uint8_t amount = ramp(t, l.transition_ms);
+      for (int i = 0; i < NUM_LEDS; i++) {
+        l.frame[i] = blend(l.transition_from[i], l.frame[i], amount);
+      }
+      return true;
+    }
+  }
+
+  return l.running;
+}
+
+// An effect or a transition still needs frames, or the layer stack changed since the last one
+static bool layers_need_frame() {
+  bool any_running = false;
+  for (int i = 0; i < LED_MAX_LAYERS; i++) {
+    any_running |= led_layers[i].effect != nullptr && (led_layers[i].running || led_layers[i].transition_ms > 0);
+  }
+  return any_running || led_layers_changed;
+}
+
+bool loop_leds() {
+  unsigned long now = millis();
+  if ((long)(now - led_next_frame) < 0) {
+    return false;
+  }
+  // Fixed rate; after a long stall resume from now instead of rendering a burst of frames
+  led_next_frame += LED_FRAME_INTERVAL_MS;
+  if ((long)(now - led_next_frame) >= 0) {
+    led_next_frame = now + LED_FRAME_INTERVAL_MS;
+  }
+
+  if (!layers_need_frame()) {
+    // Nothing animating - leave leds[] to whoever drew it last, but still latch a
+    // brightness change (or pixels drawn without a show) at the frame rate
+    return led_is_dirty() && led_show();
+  }
+  led_layers_changed = false;
+
+  // Composite bottom to top
+  fill_solid(leds, NUM_LEDS, CRGB::Black);
+  for (int i = 0; i < LED_MAX_LAYERS; i++) {
+    LEDLayer& l = led_layers[i];
+    if (l.effect == nullptr) {
+      continue;
+    }
+    render_layer(l, now);
+
+    for (int p = 0; p < NUM_LEDS; p++) {
+      if (l.blend == LED_BLEND_ADD) {
+        leds[p] += l.frame[p];
+      } else if (l.frame[p]) {
+        leds[p] = l.frame[p];
+      }
+    }
+  }
+
+  // Only latches the strip when the picture changed
+  return led_show();
+}
+
+unsigned long led_idle_ms(unsigned long max_ms) {
+  if (!layers_need_frame()) {
+    return max_ms;
+  }
+  long until_frame = (long)(led_next_frame - millis());
+  if (until_frame <= 0) {
+    return 0;
+  }
+  return (unsigned long)until_frame < max_ms ? (unsigned long)until_frame : max_ms;
+}
@@ -0,0 +1,167 @@
+#ifndef LED_ANIMATION_H
+#define LED_ANIMATION_H
+
+#include <FastLED.h>
+#include <LEDControl.h>
+
+// Frame-based LED animation engine
+//
+// Effects are objects that draw one frame at a time into a layer buffer. loop_leds()
+// ticks at a fixed frame rate, renders every active layer, composites them into leds[]
+// and latches it with led_show(), which skips frames identical to what the strip shows.
+// Nothing here ever delays - effects are pure functions of the frame time.
+//
+// Layers are composited bottom to top. An effect that finishes keeps its last frame on
+// its layer until the layer is cleared or given a new effect, so "fade to black" stays black.
+
+#define LED_FRAME_RATE 50                               // Render ticks per second
+#define LED_FRAME_INTERVAL_MS (1000 / LED_FRAME_RATE)
+#define LED_MAX_LAYERS 2
+
+// Layer indices
+#define LED_LAYER_BASE 0      // Main effect (colors, chases, fades)
+#define LED_LAYER_OVERLAY 1   // Drawn on top of the base layer
+
+// How a layer is combined with the layers below it
+enum LEDBlendMode {
+  LED_BLEND_NORMAL,   // Lit pixels cover the layers below, black pixels are transparent
+  LED_BLEND_ADD       // Pixels are added (saturating) to the layers below
+};
+
+// Base class for all effects
+class LEDEffect {
+ public:
+  virtual ~LEDEffect() {}
+
+  // Called on the first frame after the effect is started
+  // current_frame is what the layer showed before - effects can fade or pulse it
+  virtual void begin(unsigned long frame_time, const CRGB* current_frame) { start_time = frame_time; }
+
+  // Draw the frame for frame_time into buffer (NUM_LEDS pixels)
+  // Returns true while the effect is still animating, false once it has finished
+  virtual bool render(CRGB* buffer, unsigned long frame_time) = 0;
+
+ protected:
+  unsigned long elapsed(unsigned long frame_time) const { return frame_time - start_time; }
+  unsigned long start_time = 0;
+};
+
+// Static color
+class SolidEffect : public LEDEffect {
+ public:
+  SolidEffect(CRGB color = CRGB::Black) : color(color) {}
+  bool render(CRGB* buffer, unsigned long frame_time) override;
+
+ private:
+  CRGB color;
+};
+
+// Light with a two-pixel tail bouncing along the strip (LED 0 stays off)
+class ChaseEffect : public LEDEffect {
+ public:
+  ChaseEffect(CRGB color = CRGB::Black, int speed_ms = 50, int num_cycles = 3)
+    : color(color), speed_ms(speed_ms), num_cycles(num_cycles) {}
+  bool render(CRGB* buffer, unsigned long frame_time) override;
+
+ private:
+  CRGB color;
+  int speed_ms;
+  int num_cycles;
+};
+
+// Forward chase whose step time shrinks linearly from start_speed_ms to end_speed_ms
+// over duration_ms, optionally ending with a full-strip flash (LED 0 stays off)
+class AcceleratingChaseEffect : public LEDEffect {
+ public:
+  AcceleratingChaseEffect(CRGB color = CRGB::Black, unsigned long duration_ms = 3000,
+                          int start_speed_ms = 150, int end_speed_ms = 10, unsigned long flash_ms = 0)
+    : color(color), duration_ms(duration_ms), start_speed_ms(start_speed_ms),
+      end_speed_ms(end_speed_ms), flash_ms(flash_ms) {}
+  void begin(unsigned long frame_time, const CRGB* current_frame) override;
+  bool render(CRGB* buffer, unsigned long frame_time) override;
+
+ private:
+  int step_time(unsigned long at) const;
+
+  CRGB color;
+  unsigned long duration_ms;
+  int start_speed_ms;
+  int end_speed_ms;
+  unsigned long flash_ms;
+  int position = 1;
+  int next_position = 1;
+  unsigned long next_step = 0;
+};
+
+// Fade whatever the layer showed down to black
+class FadeOutEffect : public LEDEffect {
+ public:
+  FadeOutEffect(unsigned long duration_ms = 1000) : duration_ms(duration_ms) {}
+  void begin(unsigned long frame_time, const CRGB* current_frame) override;
+  bool render(CRGB* buffer, unsigned long frame_time) override;
+
+ private:
+  unsigned long duration_ms;
+  CRGB snapshot[NUM_LEDS];
+};
+
+// Fade in to a color, hold it, then fade out
+class FadeInOutEffect : public LEDEffect {
+ public:
+  FadeInOutEffect(CRGB color = CRGB::Black, unsigned long fade_ms = 320, unsigned long hold_ms = 500)
+    : color(color), fade_ms(fade_ms), hold_ms(hold_ms) {}
+  bool render(CRGB* buffer, unsigned long frame_time) override;
+
+ private:
+  CRGB color;
+  unsigned long fade_ms;
+  unsigned long hold_ms;
+};
+
+// Flash a color on and off
+class FlashEffect : public LEDEffect {
+ public:
+  FlashEffect(CRGB color = CRGB::Black, int num_flashes = 3, int flash_speed_ms = 200)
+    : color(color), num_flashes(num_flashes), flash_speed_ms(flash_speed_ms) {}
+  bool render(CRGB* buffer, unsigned long frame_time) override;
+
+ private:
+  CRGB color;
+  int num_flashes;
+  int flash_speed_ms;
+};
+
+// Breathe whatever the layer showed between min_scale and full brightness until finish() is called
+class PulseEffect : public LEDEffect {
+ public:
+  PulseEffect(unsigned long period_ms = 840, uint8_t min_scale = 32)
+    : period_ms(period_ms), min_scale(min_scale) {}
+  void begin(unsigned long frame_time, const CRGB* current_frame) override;
+  bool render(CRGB* buffer, unsigned long frame_time) override;
+  void finish() { finishing = true; }  // Next frame restores full brightness and ends the effect
+
+ private:
+  unsigned long period_ms;
+  uint8_t min_scale;
+  bool finishing = false;
+  CRGB snapshot[NUM_LEDS];
+};
+
+// Power-on sequence: rainbow sweep, white, fade to black
+class StartupEffect : public LEDEffect {
+ public:
+  bool render(CRGB* buffer, unsigned long frame_time) override;
+};
+
+// Scheduler
+// Start effect on a layer (replacing what was running there)
+// transition_ms > 0 crossfades from the layer's current frame to the new effect
+void led_play_effect(uint8_t layer, LEDEffect* effect, unsigned long transition_ms = 0,
+                     LEDBlendMode blend = LED_BLEND_NORMAL);
+void led_clear_layer(uint8_t layer);          // Remove the layer's effect and frame
+bool led_layer_running(uint8_t layer);        // True while the layer's effect is animating
+LEDEffect* led_layer_effect(uint8_t layer);   // Effect on the layer (running or holding), or nullptr
+
+// The render tick is loop_leds() in LEDControl.h
+
+#endif // LED_ANIMATION_H
@@ -1,7 +1,12 @@
 
 
 #include <LEDControl.h>
+#include <LEDAnimation.h>
+#include <LEDOutput.h>
 #include <DebugConfig.h>
+#include <Instrumentation.h>
+
+static constexpr char TAG[] = "LED";  // Log tag
 
 CRGB leds[NUM_LEDS];
 
@@ -10,397 +15,196 @@ void setup_leds() {
   // Small delay helps when switching from USB to DC power
   delay(50);
   
+#ifdef LED_USE_RMT_OUTPUT
+  // FastLED still provides colors and brightness, the RMT peripheral drives the strip
+  if (!setup_led_output()) {
+    LOGW(TAG, "RMT output unavailable - LEDs will stay dark");
+  }
+#else
   //FastLED.addLeds<NEOPIXEL, DATA_PIN>(leds, NUM_LEDS);  // GRB ordering is assumed
   FastLED.addLeds<WS2812B, DATA_PIN, GRB>(leds, NUM_LEDS);  // GRB ordering is typical
+#endif
   FastLED.setMaxPowerInVoltsAndMilliamps(LED_MAX_VOLTAGE, LED_MAX_MILLIAMPS);
   FastLED.setBrightness(LED_DEFAULT_BRIGHTNESS);
 
   fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.show();
+  led_show();
   delay(10);  // Brief delay to ensure first show() completes
 }
 
-bool set_color(CRGB color) {
-  fill_solid(leds, NUM_LEDS, color);
-  FastLED.show();
+// Dirty tracking - what the strip currently shows
+static CRGB latched_leds[NUM_LEDS];
+static uint8_t latched_brightness = 0;
+static bool latched_valid = false;  // Nothing latched yet - first show always goes out
+static LEDShowStats led_show_stats = {0, 0, 0};
 
-  return true;
+bool led_is_dirty() {
+  return !latched_valid ||
+         FastLED.getBrightness() != latched_brightness ||
+         memcmp(leds, latched_leds, sizeof(latched_leds)) != 0;
 }
 
-// Startup light sequence - magical power-on animation
-// Optimized to reduce blocking time
-void startup_light_sequence() {
-  DEBUG_PRINTLN("Starting LED startup sequence");
-  
-  // Turn off all LEDs first
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.show();
-  delay(100); // Reduced from 200ms
-  
-  // Rainbow sweep effect
-  for (int brightness = 0; brightness <= 120; brightness += 10) {
-    for (int i = 0; i < NUM_LEDS; i++) {
-      leds[i] = CHSV(i * 255 / NUM_LEDS, 255, brightness);
-    }
-    FastLED.show();
-    delay(30); // Reduced from 50ms
+bool led_show() {
+  if (!led_is_dirty()) {
+    led_show_stats.skipped++;
+    return false;
   }
   
-  // Fade to white and then to black - faster
-  fill_solid(leds, NUM_LEDS, CRGB::White);
-  FastLED.setBrightness(60);
-  FastLED.show();
-  delay(200); // Reduced from 500ms
-  
-  // Fade out
-  for (int brightness = 60; brightness >= 0; brightness -= 5) {
-    FastLED.setBrightness(brightness);
-    FastLED.show();
-    delay(50);
+  unsigned long start = micros();
+#ifdef LED_USE_RMT_OUTPUT
+  // Same power limiting FastLED.show() applies
+  uint8_t brightness = calculate_max_brightness_for_power_mW(leds, NUM_LEDS, FastLED.getBrightness(),
+                                                             LED_MAX_VOLTAGE * LED_MAX_MILLIAMPS);
+  if (!led_output_write(leds, NUM_LEDS, brightness)) {
+    return false;  // Previous frame still on the wire - stays dirty, goes out next frame
   }
-  
-  // Set back to normal brightness and turn off
-  FastLED.setBrightness(LED_DEFAULT_BRIGHTNESS);
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
+#else
   FastLED.show();
-  
-  DEBUG_PRINTLN("LED startup sequence complete");
+#endif
+  led_show_stats.show_time_us += micros() - start;
+  instrument_since(INSTRUMENT_LED_SHOW, start);
+  led_show_stats.shows++;
+  
+  memcpy(latched_leds, leds, sizeof(latched_leds));
+  latched_brightness = FastLED.getBrightness();
+  latched_valid = true;
+  return true;
+}
+
+LEDShowStats get_led_show_stats() {
+  return led_show_stats;
+}
+
+// Effect instances - one per kind, reconfigured each time they are started
+static SolidEffect solid_effect;
+static StartupEffect startup_effect;
+static FadeOutEffect fade_out_effect;
+static PulseEffect pulse_effect;
+static ChaseEffect chase_effect;
+static AcceleratingChaseEffect accelerating_chase_effect;
+static FadeInOutEffect fade_in_out_effect;
+static FlashEffect flash_effect;
+
+// All effects below run on the animation engine (LEDAnimation.h) and return immediately
+// Frames are drawn by loop_leds()
+
+bool set_color(CRGB color) {
+  solid_effect = SolidEffect(color);
+  led_play_effect(LED_LAYER_BASE, &solid_effect);
+
+  return true;
+}
+
+// Startup light sequence - magical power-on animation
+void startup_light_sequence() {
+  LOGD(TAG, "Starting startup sequence");
+  led_play_effect(LED_LAYER_BASE, &startup_effect);
 }
 
 // Turn off all LEDs
 void turn_off_leds() {
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.show();
+  led_clear_layer(LED_LAYER_OVERLAY);
+  set_color(CRGB::Black);
 }
 
-// Fade out LEDs gradually
+// Fade out LEDs gradually - one brightness step per LED_FADE_STEP_DELAY, as before
 void fade_out_leds() {
-  int current_brightness = FastLED.getBrightness();
-  
-  // Fade from current brightness down to 0
-  for (int brightness = current_brightness; brightness >= 0; brightness -= 1) {
-    FastLED.setBrightness(brightness);
-    FastLED.show();
-    delay(LED_FADE_STEP_DELAY);
-  }
-  
-  // Turn off LEDs and restore original brightness
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.setBrightness(LED_DEFAULT_BRIGHTNESS);
-  FastLED.show();
+  fade_out_effect = FadeOutEffect((unsigned long)FastLED.getBrightness() * LED_FADE_STEP_DELAY);
+  led_play_effect(LED_LAYER_BASE, &fade_out_effect);
 }
 
-// Subtle pulse effect for cooldown - non-blocking
+// Subtle pulse effect for cooldown - call every loop iteration during the cooldown
 // Pulses the LEDs at their current color (from last wand activation)
 void cooldown_pulse() {
-  static unsigned long last_pulse = 0;
-  static uint8_t pulse_brightness = 0;
-  static bool pulse_direction = true;  // true = getting brighter, false = getting dimmer
-  
-  unsigned long current_time = millis();
-  
-  // Update pulse every 30ms for smooth animation
-  if (current_time - last_pulse >= 30) {
-    last_pulse = current_time;
-    
-    // Adjust brightness - pulse from 10 to 80
-    if (pulse_direction) {
-      pulse_brightness += 5;
-      if (pulse_brightness >= 80) {
-        pulse_direction = false;
-      }
-    } else {
-      if (pulse_brightness <= 10) {
-        pulse_brightness = 10;
-        pulse_direction = true;
-      } else {
-        pulse_brightness -= 5;
-      }
-    }
-    
-    // Keep LEDs at their current color, just adjust brightness
-    // This preserves the last wand's color during cooldown
-    FastLED.setBrightness(pulse_brightness);
-    FastLED.show();
+  if (led_layer_effect(LED_LAYER_BASE) != &pulse_effect || !led_layer_running(LED_LAYER_BASE)) {
+    led_play_effect(LED_LAYER_BASE, &pulse_effect);
+  }
+}
+
+// End the cooldown pulse, leaving the LEDs at full brightness
+void stop_cooldown_pulse() {
+  if (led_layer_effect(LED_LAYER_BASE) == &pulse_effect) {
+    pulse_effect.finish();
   }
 }
 
-// Chase animation - light moves along the strip
+// Chase animation - light moves along the strip and back
 // color: The color to use for the chase effect
-// speed_ms: Delay between each step (lower = faster)
+// speed_ms: Time per step (lower = faster)
 // num_cycles: How many times to run the full chase
 void chase_animation(CRGB color, int speed_ms, int num_cycles) {
-  DEBUG_PRINTLN("Starting chase animation (skipping first LED)");
-  
-  // Save original brightness
-  uint8_t original_brightness = FastLED.getBrightness();
-  FastLED.setBrightness(LED_DEFAULT_BRIGHTNESS);
-  
-  for (int cycle = 0; cycle < num_cycles; cycle++) {
-    // Forward chase - start at LED 1 (skip LED 0)
-    for (int i = 1; i < NUM_LEDS; i++) {
-      // Turn off all LEDs except first one
-      fill_solid(leds, NUM_LEDS, CRGB::Black);
-      
-      // Light up current LED and a trailing tail
-      leds[i] = color;
-      if (i > 1) {  // Changed from i > 0 to avoid lighting LED 0
-        leds[i-1] = color; // Tail 1
-        leds[i-1].fadeToBlackBy(128);
-      }
-      if (i > 2) {  // Changed from i > 1
-        leds[i-2] = color; // Tail 2
-        leds[i-2].fadeToBlackBy(192);
-      }
-      
-      FastLED.show();
-      delay(speed_ms);
-    }
-    
-    // Optional: Reverse chase - end at LED 1 (skip LED 0)
-    for (int i = NUM_LEDS - 1; i >= 1; i--) {  // Changed from i >= 0
-      // Turn off all LEDs except first one
-      fill_solid(leds, NUM_LEDS, CRGB::Black);
-      
-      // Light up current LED and a trailing tail
-      leds[i] = color;
-      if (i < NUM_LEDS - 1) {
-        leds[i+1] = color; // Tail 1
-        leds[i+1].fadeToBlackBy(128);
-      }
-      if (i < NUM_LEDS - 2) {
-        leds[i+2] = color; // Tail 2
-        leds[i+2].fadeToBlackBy(192);
-      }
-      
-      FastLED.show();
-      delay(speed_ms);
-    }
-  }
-  
-  // Clear strip
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.show();
-  
-  // Restore original brightness
-  FastLED.setBrightness(original_brightness);
-  
-  DEBUG_PRINTLN("Chase animation complete");
+  LOGD(TAG, "Starting chase animation (skipping first LED)");
+  chase_effect = ChaseEffect(color, speed_ms, num_cycles);
+  led_play_effect(LED_LAYER_BASE, &chase_effect);
 }
 
-// Accelerating chase - starts slow and speeds up
+// Accelerating chase - starts slow and speeds up, then flashes the strip
 // Creates excitement as detection happens
 void accelerating_chase(CRGB color) {
-  DEBUG_PRINTLN("Starting accelerating chase animation (skipping first LED)");
-  
-  // Save original brightness
-  uint8_t original_brightness = FastLED.getBrightness();
-  FastLED.setBrightness(LED_DEFAULT_BRIGHTNESS);
-  
-  // Start slow, then speed up progressively
-  int speeds[] = {150, 120, 90, 60, 40, 25, 15, 10};  // Decreasing delays = faster
-  int num_speeds = sizeof(speeds) / sizeof(speeds[0]);
-  
-  for (int speed_idx = 0; speed_idx < num_speeds; speed_idx++) {
-    int speed_ms = speeds[speed_idx];
-    
-    // Do one pass at this speed - start at LED 1 (skip LED 0)
-    for (int i = 1; i < NUM_LEDS; i++) {
-      // Turn off all LEDs except first one
-      fill_solid(leds, NUM_LEDS, CRGB::Black);
-      
-      // Light up current LED and a trailing tail
-      leds[i] = color;
-      if (i > 1) {  // Changed from i > 0 to avoid lighting LED 0
-        leds[i-1] = color;
-        leds[i-1].fadeToBlackBy(128);
-      }
-      if (i > 2) {  // Changed from i > 1
-        leds[i-2] = color;
-        leds[i-2].fadeToBlackBy(192);
-      }
-      
-      FastLED.show();
-      delay(speed_ms);
-    }
-  }
-  
-  // Final flash at the end - but keep first LED off
-  fill_solid(leds, NUM_LEDS, color);
-  leds[0] = CRGB::Black;  // Keep first LED off
-  FastLED.show();
-  delay(100);
-  
-  // Restore original brightness
-  FastLED.setBrightness(original_brightness);
-  
-  DEBUG_PRINTLN("Accelerating chase complete");
+  LOGD(TAG, "Starting accelerating chase animation (skipping first LED)");
+  accelerating_chase_effect = AcceleratingChaseEffect(color, 4000, 150, 10, 100);
+  led_play_effect(LED_LAYER_BASE, &accelerating_chase_effect);
 }
 
 // Fade in to a color, hold, then fade out
 // Perfect for success indication
 void fade_in_out(CRGB color, int fade_speed_ms) {
-  DEBUG_PRINTLN("Starting fade in/out animation");
-  
-  // Save original brightness
-  uint8_t original_brightness = FastLED.getBrightness();
-  
-  // Fill with color but at zero brightness
-  fill_solid(leds, NUM_LEDS, color);
-  FastLED.setBrightness(0);
-  FastLED.show();
-  
-  // Fade in
-  for (int brightness = 0; brightness <= LED_DEFAULT_BRIGHTNESS; brightness += 5) {
-    FastLED.setBrightness(brightness);
-    FastLED.show();
-    delay(fade_speed_ms);
-  }
-  
-  // Hold at full brightness
-  delay(500);
-  
-  // Fade out
-  for (int brightness = LED_DEFAULT_BRIGHTNESS; brightness >= 0; brightness -= 5) {
-    FastLED.setBrightness(brightness);
-    FastLED.show();
-    delay(fade_speed_ms);
-  }
-  
-  // Clear and restore
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.setBrightness(original_brightness);
-  FastLED.show();
-  
-  DEBUG_PRINTLN("Fade in/out complete");
+  LOGD(TAG, "Starting fade in/out animation");
+  // Same pace as the old 5-step brightness ramp up to LED_DEFAULT_BRIGHTNESS
+  fade_in_out_effect = FadeInOutEffect(color, (LED_DEFAULT_BRIGHTNESS / 5) * fade_speed_ms, 500);
+  led_play_effect(LED_LAYER_BASE, &fade_in_out_effect);
 }
 
 // Flash a color multiple times
 // Perfect for error/fail indication
 void flash_color(CRGB color, int num_flashes, int flash_speed_ms) {
-  DEBUG_PRINTLN("Starting flash animation");
-  
-  // Save original brightness
-  uint8_t original_brightness = FastLED.getBrightness();
-  FastLED.setBrightness(LED_DEFAULT_BRIGHTNESS);
-  
-  for (int i = 0; i < num_flashes; i++) {
-    // Flash on
-    fill_solid(leds, NUM_LEDS, color);
-    FastLED.show();
-    delay(flash_speed_ms);
-    
-    // Flash off
-    fill_solid(leds, NUM_LEDS, CRGB::Black);
-    FastLED.show();
-    delay(flash_speed_ms);
-  }
-  
-  // Restore original brightness
-  FastLED.setBrightness(original_brightness);
-  
-  DEBUG_PRINTLN("Flash animation complete");
+  LOGD(TAG, "Starting flash animation");
+  flash_effect = FlashEffect(color, num_flashes, flash_speed_ms);
+  led_play_effect(LED_LAYER_BASE, &flash_effect);
 }
 
-// Non-blocking chase animation state variables
-static bool chase_active = false;
-static unsigned long chase_start_time = 0;
-static unsigned long chase_last_update = 0;
-static int chase_position = 0;
-static int chase_speed_ms = 150; // Current speed
-static uint8_t saved_brightness = LED_DEFAULT_BRIGHTNESS; // Save brightness for restore
+// True while any effect is still animating
+bool is_led_animation_running() {
+  return led_layer_running(LED_LAYER_BASE) || led_layer_running(LED_LAYER_OVERLAY);
+}
+
+// Detection chase - accelerates from 150ms to 10ms per step over the detection window
+#define CHASE_ANIMATION_DURATION 3000
 
 // Start the chase animation (call when RFID is first detected)
 void start_chase_animation() {
-  DEBUG_PRINTLN("Starting non-blocking chase animation");
-  chase_active = true;
-  chase_start_time = millis();
-  chase_last_update = millis();
-  chase_position = 1;  // Start at LED 1 instead of 0
-  chase_speed_ms = 150; // Start slow
-  
-  // Save current brightness and set to default
-  saved_brightness = FastLED.getBrightness();
-  FastLED.setBrightness(LED_DEFAULT_BRIGHTNESS);
-  
-  // Clear LEDs
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.show();
+  LOGD(TAG, "Starting non-blocking chase animation");
+  accelerating_chase_effect = AcceleratingChaseEffect(CRGB(0, 150, 255), CHASE_ANIMATION_DURATION, 150, 10);  // Bright cyan-blue
+  led_play_effect(LED_LAYER_BASE, &accelerating_chase_effect);
 }
 
-// Update chase animation (call every loop iteration)
 // Returns true when the 3-second animation is complete
 bool update_chase_animation() {
-  if (!chase_active) {
-    return true; // Not running, so it's "done"
-  }
-  
-  unsigned long current_time = millis();
-  unsigned long elapsed_time = current_time - chase_start_time;
-  
-  // Animation runs for 3 seconds
-  const unsigned long ANIMATION_DURATION = 3000;
-  
-  // Check if animation is complete
-  if (elapsed_time >= ANIMATION_DURATION) {
-    DEBUG_PRINTLN("Chase animation complete (3 seconds elapsed)");
-    chase_active = false;
-    fill_solid(leds, NUM_LEDS, CRGB::Black);
-    FastLED.show();
-    return true;
-  }
-  
-  // Calculate speed based on elapsed time (accelerate over 3 seconds)
-  // Start at 150ms, end at 10ms
-  float progress = (float)elapsed_time / ANIMATION_DURATION;
-  chase_speed_ms = 150 - (int)(140 * progress); // 150 -> 10
-  if (chase_speed_ms < 10) chase_speed_ms = 10;
-  
-  // Update position if enough time has passed
-  if (current_time - chase_last_update >= chase_speed_ms) {
-    chase_last_update = current_time;
-    
-    // Turn off all LEDs except first one
-    fill_solid(leds, NUM_LEDS, CRGB::Black);
-    
-    // Skip LED 0 - if position is 0, move to 1
-    if (chase_position == 0) {
-      chase_position = 1;
-    }
-    
-    // Light up current LED and trailing tail with cyan/blue color (more visible)
-    CRGB chase_color = CRGB(0, 150, 255); // Bright cyan-blue
-    leds[chase_position] = chase_color;
-    
-    // Add trailing tail - but never light up LED 0
-    if (chase_position > 1) {  // Changed from chase_position > 0
-      leds[chase_position - 1] = chase_color;
-      leds[chase_position - 1].fadeToBlackBy(128);
-    }
-    
-    if (chase_position > 2) {  // Changed from chase_position > 1
-      leds[chase_position - 2] = chase_color;
-      leds[chase_position - 2].fadeToBlackBy(192);
-    }
-    
-    FastLED.show();
-    
-    // Move to next position
-    chase_position++;
-    if (chase_position >= NUM_LEDS) {
-      chase_position = 1; // Loop back to LED 1 (skip LED 0)
-    }
-  }
-  
-  return false; // Animation still running
+  return !(led_layer_effect(LED_LAYER_BASE) == &accelerating_chase_effect && led_layer_running(LED_LAYER_BASE));
 }
 
 // Stop the chase animation immediately
 void stop_chase_animation() {
-  DEBUG_PRINTLN("Stopping chase animation");
-  chase_active = false;
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.show();
-  // Restore original brightness
-  FastLED.setBrightness(saved_brightness);
+  LOGD(TAG, "Stopping chase animation");
+  set_color(CRGB::Black);
+}
+
+// Start fading the current color out (non-blocking version of fade_out_leds)
+void start_fade_out() {
+  fade_out_leds();
+}
+
+// Returns true when the LEDs are fully faded out
+bool update_fade_out() {
+  return !(led_layer_effect(LED_LAYER_BASE) == &fade_out_effect && led_layer_running(LED_LAYER_BASE));
+}
+
+// Start flashing a color (non-blocking version of flash_color)
+void start_flash_animation(CRGB color, int num_flashes, int flash_speed_ms) {
+  flash_color(color, num_flashes, flash_speed_ms);
+}
+
+// Returns true when all flashes are complete
+bool update_flash_animation() {
+  return !(led_layer_effect(LED_LAYER_BASE) == &flash_effect && led_layer_running(LED_LAYER_BASE));
 }
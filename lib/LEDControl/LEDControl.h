@@ -13,23 +13,59 @@
 #define LED_MAX_MILLIAMPS 200
 #define LED_FADE_STEP_DELAY 20  // Delay per brightness step during fade (ms)
 
+// LED output backend
+// RMT: frames are clocked out by the RMT peripheral (LEDOutput.h) - show returns at once
+//      and never masks interrupts, so LED refresh can overlap PN532 I2C transactions
+// Comment out to fall back to FastLED.show()
+#define LED_USE_RMT_OUTPUT
+
 // Define the array of leds
 extern CRGB leds[NUM_LEDS];
 
 void setup_leds();
+bool loop_leds(); // Render tick - call every loop iteration, returns true if a frame was shown
+// How long the loop may sleep without missing a frame: the time to the next frame while an
+// effect animates, otherwise max_ms
+unsigned long led_idle_ms(unsigned long max_ms);
+
+// Latch leds[] onto the strip - use instead of FastLED.show()
+// Skips the show when neither the pixels nor the global brightness changed since the
+// last latch. With FastLED output every show masks interrupts for ~0.5ms, which disturbs I2C (PN532).
+bool led_show(); // Returns true if the strip was actually updated
+bool led_is_dirty(); // True if leds[] or the brightness differ from what the strip shows
+
+// Show counters since boot
+struct LEDShowStats {
+  uint32_t shows;          // Frames latched onto the strip
+  uint32_t skipped;        // led_show() calls skipped because nothing changed
+  uint32_t show_time_us;   // Total time the CPU spent latching frames
+};
+LEDShowStats get_led_show_stats();
+
+// Effects - all non-blocking, drawn by loop_leds() (see LEDAnimation.h)
 bool set_color(CRGB color);
 void startup_light_sequence();
 void turn_off_leds(); // Turn off all LEDs
 void fade_out_leds(); // Fade out LEDs gradually
-void cooldown_pulse(); // Subtle pulse effect during cooldown
+void cooldown_pulse(); // Subtle pulse effect during cooldown (call every loop iteration)
+void stop_cooldown_pulse(); // End the cooldown pulse at full brightness
 void chase_animation(CRGB color, int speed_ms = 50, int num_cycles = 3); // Chase animation effect
 void accelerating_chase(CRGB color); // Chase that starts slow and speeds up
 void fade_in_out(CRGB color, int fade_speed_ms = 20); // Fade in to color, then fade out
 void flash_color(CRGB color, int num_flashes = 3, int flash_speed_ms = 200); // Flash a color multiple times
+bool is_led_animation_running(); // True while any effect is still animating
 
-// Non-blocking chase animation state management
+// Chase animation state management
 void start_chase_animation(); // Start the chase animation (call once when RFID detected)
-bool update_chase_animation(); // Update chase animation (call every loop iteration), returns true when animation is done
+bool update_chase_animation(); // Returns true when the animation is done
 void stop_chase_animation(); // Stop the chase animation immediately
 
+// Fade out state management
+void start_fade_out(); // Start fading the current color to black
+bool update_fade_out(); // Returns true when the fade is done
+
+// Flash state management
+void start_flash_animation(CRGB color, int num_flashes = 3, int flash_speed_ms = 200); // Start flashing a color
+bool update_flash_animation(); // Returns true when flashing is done
+
 #endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include <LEDOutput.h>
+#include <LEDControl.h>
+
+void led_encode_byte(uint8_t value, uint32_t* items) {
+  static const uint32_t ZERO = LED_RMT_ITEM(WS2812_T0H_TICKS, WS2812_T0L_TICKS);
+  static const uint32_t ONE = LED_RMT_ITEM(WS2812_T1H_TICKS, WS2812_T1L_TICKS);
+
+  for (int bit = 7; bit >= 0; bit--) {
+    *items++ = (value & (1 << bit)) ? ONE : ZERO;
+  }
+}
+
+void led_encode_frame(const CRGB* pixels, int count, uint8_t brightness, uint32_t* items) {
+  for (int i = 0; i < count; i++) {
+    led_encode_byte(scale8(pixels[i].g, brightness), items);
+    led_encode_byte(scale8(pixels[i].r, brightness), items + 8);
+    led_encode_byte(scale8(pixels[i].b, brightness), items + 16);
+    items += LED_RMT_ITEMS_PER_PIXEL;
+  }
+}
+
+#if defined(ESP32) && defined(LED_USE_RMT_OUTPUT)
+
+#include <driver/rmt.h>
+#include <DebugConfig.h>
+
+static constexpr char TAG[] = "LED";  // Log tag
+
+#define LED_RMT_CHANNEL RMT_CHANNEL_0
+#define LED_RMT_FRAME_ITEMS (NUM_LEDS * LED_RMT_ITEMS_PER_PIXEL)
+
+// Enough 64-symbol RMT memory blocks for the whole frame plus the end marker,
+// so the driver never has to refill from an interrupt mid-frame
+#define LED_RMT_MEM_BLOCKS ((LED_RMT_FRAME_ITEMS + 1 + 63) / 64)
+#if LED_RMT_MEM_BLOCKS > 8
+#error "NUM_LEDS too large for a single RMT transfer - reduce NUM_LEDS or use FastLED output"
+#endif
+
+static uint32_t led_rmt_items[LED_RMT_FRAME_ITEMS];
+static bool led_output_ready = false;
+
+bool setup_led_output() {
+  rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)DATA_PIN, LED_RMT_CHANNEL);
+  config.clk_div = LED_RMT_CLK_DIV;
+  config.mem_block_num = LED_RMT_MEM_BLOCKS;
+  config.tx_config.idle_output_en = true;
+  config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;  // Line idles low - the gap between frames is the reset
+
+  if (rmt_config(&config) != ESP_OK || rmt_driver_install(LED_RMT_CHANNEL, 0, 0) != ESP_OK) {
+    LOGE(TAG, "RMT output setup failed");
+    return false;
+  }
+
+  led_output_ready = true;
+  return true;
+}
+
+bool led_output_busy() {
+  return led_output_ready && rmt_wait_tx_done(LED_RMT_CHANNEL, 0) != ESP_OK;
+}
+
+bool led_output_write(const CRGB* pixels, int count, uint8_t brightness) {
+  if (!led_output_ready || count > NUM_LEDS || led_output_busy()) {
+    return false;
+  }
+
+  led_encode_frame(pixels, count, brightness, led_rmt_items);
+  // Copies the symbols into RMT memory and starts transmission - returns immediately
+  return rmt_write_items(LED_RMT_CHANNEL, (const rmt_item32_t*)led_rmt_items,
+                         count * LED_RMT_ITEMS_PER_PIXEL, false) == ESP_OK;
+}
+
+#elif defined(MAGICBAND_NATIVE)
+
+#include <HostLEDStrip.h>
+
+// Native build - frames go to the simulated strip, which stays busy for the wire time like
+// the RMT channel does
+static uint32_t led_rmt_items[NUM_LEDS * LED_RMT_ITEMS_PER_PIXEL];
+
+bool setup_led_output() { return true; }
+bool led_output_busy() { return host_led_strip_busy(); }
+
+bool led_output_write(const CRGB* pixels, int count, uint8_t brightness) {
+  if (count > NUM_LEDS || led_output_busy()) {
+    return false;
+  }
+  led_encode_frame(pixels, count, brightness, led_rmt_items);  // Same CPU work as on the board
+  return host_led_strip_write(pixels, count, brightness);
+}
+
+#else
+
+// Host build - no RMT hardware, frames are accepted and dropped
+bool setup_led_output() { return true; }
+bool led_output_busy() { return false; }
+bool led_output_write(const CRGB* pixels, int count, uint8_t brightness) { return true; }
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef LED_OUTPUT_H
+#define LED_OUTPUT_H
+
+#include <FastLED.h>
+
+// RMT output backend for the WS2812B strip
+//
+// FastLED.show() keeps the CPU busy for the whole frame and masks interrupts, which is
+// why I2C (PN532) setup has to finish before the first show. This backend encodes the
+// frame into RMT symbols and hands them to the RMT peripheral: all 17 pixels fit in the
+// RMT's own memory, so the hardware clocks the frame out while the CPU carries on and
+// interrupts stay enabled. LED refresh and PN532 transactions can overlap safely.
+//
+// The encoder below has no ESP-IDF dependency so it can be built and checked on the host.
+
+// RMT clock: 80MHz APB / 2 = 40MHz, 25ns per tick
+#define LED_RMT_CLK_DIV 2
+
+// WS2812B bit timings in RMT ticks (datasheet: T0H 0.4us, T0L 0.85us, T1H 0.8us, T1L 0.45us)
+#define WS2812_T0H_TICKS 16
+#define WS2812_T0L_TICKS 34
+#define WS2812_T1H_TICKS 32
+#define WS2812_T1L_TICKS 18
+
+// One RMT symbol per bit, 24 bits per pixel (GRB, MSB first)
+#define LED_RMT_ITEMS_PER_PIXEL 24
+
+// Pack one RMT symbol - same bit layout as rmt_item32_t:
+// duration0[14:0] level0[15] duration1[30:16] level1[31]
+#define LED_RMT_ITEM(high_ticks, low_ticks) \
+  ((uint32_t)(high_ticks) | (1UL << 15) | ((uint32_t)(low_ticks) << 16))
+
+// Encode one byte into 8 RMT symbols, MSB first
+void led_encode_byte(uint8_t value, uint32_t* items);
+
+// Encode count pixels into count * LED_RMT_ITEMS_PER_PIXEL RMT symbols
+// Applies brightness the same way FastLED does (scale8 per channel) and sends GRB order
+void led_encode_frame(const CRGB* pixels, int count, uint8_t brightness, uint32_t* items);
+
+// Hardware side (ESP32 only)
+bool setup_led_output();                                                 // Configure the RMT channel on DATA_PIN
+bool led_output_write(const CRGB* pixels, int count, uint8_t brightness); // Queue a frame, false if the previous one is still sending
+bool led_output_busy();                                                  // True while a frame is being clocked out
+
+#endif // LED_OUTPUT_H
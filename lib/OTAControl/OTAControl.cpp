@@ -1,6 +1,16 @@
 #include "OTAControl.h"
 #include <DebugConfig.h>
-#include <LEDControl.h>
+#include <TaskQueue.h>
+
+static bool ota_ready = false;
+
+// Statuses for the real-time task - pushed by the OTA callbacks on the network task
+static TaskQueue<OTAStatus, OTA_STATUS_QUEUE_SIZE> ota_statuses;
+static int ota_last_percent = -1;  // Last progress step queued
+
+static void post_ota_status(OTAPhase phase, uint8_t percent) {
+  task_queue_push(&ota_statuses, OTAStatus{phase, percent});  // A full queue only loses a progress step
+}
 
 /**
  * Initialize OTA (Over-The-Air) update functionality
@@ -32,9 +42,8 @@ void setup_ota() {
     DEBUG_PRINTLN("OTA Update Started: " + type);
     
     // Visual feedback - turn all LEDs white during update
-    fill_solid(leds, NUM_LEDS, CRGB::White);
-    FastLED.setBrightness(50);
-    FastLED.show();
+    ota_last_percent = -1;
+    post_ota_status(OTA_PHASE_STARTED, 0);
   });
   
   // When OTA update ends
@@ -42,10 +51,10 @@ void setup_ota() {
     DEBUG_PRINTLN("\nOTA Update Complete!");
     
     // Visual feedback - flash green for success
-    fill_solid(leds, NUM_LEDS, CRGB::Green);
-    FastLED.setBrightness(100);
-    FastLED.show();
+    // The real-time task draws it while this task waits out the second before the restart
+    post_ota_status(OTA_PHASE_DONE, 100);
     delay(1000);
+    log_flush();  // ArduinoOTA restarts right after this - don't lose the queued log
   });
   
   // During OTA update - show progress
@@ -57,10 +66,10 @@ void setup_ota() {
     DEBUG_PRINTLN("%");
     
     // Visual feedback - pulse LEDs to show activity
-    if (percent % 10 == 0) {  // Every 10%
-      fill_solid(leds, NUM_LEDS, CRGB::Blue);
-      FastLED.setBrightness(percent);
-      FastLED.show();
+    // Many chunks land on the same percentage - only the first one is queued
+    if (percent % 10 == 0 && (int)percent != ota_last_percent) {  // Every 10%
+      ota_last_percent = percent;
+      post_ota_status(OTA_PHASE_PROGRESS, percent);
     }
   });
   
@@ -83,19 +92,12 @@ void setup_ota() {
     }
     
     // Visual feedback - flash red for error
-    for (int i = 0; i < 5; i++) {
-      fill_solid(leds, NUM_LEDS, CRGB::Red);
-      FastLED.setBrightness(100);
-      FastLED.show();
-      delay(200);
-      fill_solid(leds, NUM_LEDS, CRGB::Black);
-      FastLED.show();
-      delay(200);
-    }
+    post_ota_status(OTA_PHASE_FAILED, 0);
   });
   
   // Start OTA service
   ArduinoOTA.begin();
+  ota_ready = true;
   
   DEBUG_PRINTLN("OTA updates ready!");
   DEBUG_PRINT("Hostname: ");
@@ -107,8 +109,23 @@ void setup_ota() {
 
 /**
  * Handle OTA update requests
- * Must be called regularly in the main loop
+ * Must be called regularly from the network task
  */
 void loop_ota() {
+  if (!ota_ready) return;
   ArduinoOTA.handle();
 }
+
+/**
+ * Check if OTA has been started
+ */
+bool is_ota_ready() {
+  return ota_ready;
+}
+
+/**
+ * Next OTA status for the LED feedback - called from the real-time task
+ */
+bool ota_take_status(OTAStatus* status) {
+  return task_queue_pop(&ota_statuses, status);
+}
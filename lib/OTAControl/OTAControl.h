@@ -9,8 +9,27 @@
 #define OTA_PASSWORD "magicband2025"  // Change this to your preferred password
 #define OTA_PORT 3232  // Default OTA port
 
+// Update progress for the LED feedback
+// OTA runs on the network task; the LEDs belong to the real-time task, so the callbacks
+// only queue these and the real-time task draws them (see ota_take_status())
+enum OTAPhase {
+  OTA_PHASE_STARTED,   // Update accepted - white
+  OTA_PHASE_PROGRESS,  // Every 10% - blue, brightness = percent
+  OTA_PHASE_DONE,      // Written - green, the board restarts a second later
+  OTA_PHASE_FAILED     // Aborted - red flashes, normal operation resumes
+};
+
+struct OTAStatus {
+  OTAPhase phase;
+  uint8_t percent;
+};
+
+#define OTA_STATUS_QUEUE_SIZE 16  // Statuses waiting for the real-time task (power of two)
+
 // Function declarations
-void setup_ota();
-void loop_ota();
+void setup_ota();            // Network task
+void loop_ota();             // Network task - blocks it for the length of an update
+bool is_ota_ready();
+bool ota_take_status(OTAStatus* status);  // Real-time task: next status to show, false if none
 
 #endif // OTA_CONTROL_H
@@ -1,5 +1,8 @@
 #include <RFIDControlPN532.h>
 #include <DebugConfig.h>
+#include <Instrumentation.h>
+
+static constexpr char TAG[] = "PN532";  // Log tag
 
 // PN532 library configuration
 #ifdef PN532_USE_I2C
@@ -10,7 +13,7 @@
   #define PN532_SCL 22
   
   // Global PN532 object (required by Adafruit library design)
-  Adafruit_PN532 nfc(-1, -1);  // IRQ and RESET pins not used in I2C mode
+  Adafruit_PN532 nfc(PN532_IRQ_PIN, PN532_RESET_PIN);
 #endif
 
 #ifdef PN532_USE_SPI
@@ -24,6 +27,39 @@
 // Global variable for current band information
 rfid_band_info current_band;
 
+// Cached result of the firmware handshake in setup_rfid()
+// Querying the PN532 again would cancel an armed detection in IRQ mode
+static bool rfid_initialized = false;
+
+// Polling timeout for readPassiveTargetID() when no IRQ line is wired
+#define PN532_POLL_TIMEOUT_MS 100
+
+// Card transactions issued to the PN532 (poll, arm, collect) - used to measure reads per tap
+static uint32_t rfid_transaction_count = 0;
+
+#if PN532_IRQ_PIN >= 0
+// Interrupt-driven detection state
+// InListPassiveTarget is armed once and returns immediately; the PN532 pulls IRQ low
+// when a card answers, so the main loop never waits on the reader
+static volatile bool rfid_irq_fired = false;
+static volatile unsigned long rfid_irq_time = 0;  // millis() of the last IRQ edge
+static bool rfid_detection_armed = false;
+static bool rfid_card_pending = false;   // UID collected but not yet consumed by loop_rfid()
+static uint32_t rfid_pending_id = 0;     // 32-bit ID of the pending card
+static TaskHandle_t rfid_wake_task = nullptr;  // Task that called setup_rfid() - woken by each edge
+
+static void IRAM_ATTR rfid_irq_handler() {
+  rfid_irq_time = millis();
+  rfid_irq_fired = true;
+  // End the loop task's idle wait now instead of after it times out
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(rfid_wake_task, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+static bool arm_rfid_detection();
+#endif
+
 // ISO 15693 not supported by Adafruit PN532 library
 // Use MIFARE/NFC wristbands instead - see docs/MAGIC_BAND_COMPATIBILITY.md
 bool read_iso15693_uid(uint8_t *uid, uint8_t *uidLength) {
@@ -31,63 +67,55 @@ bool read_iso15693_uid(uint8_t *uid, uint8_t *uidLength) {
 }
 
 void setup_rfid() {
-  Serial.println("[PN532] ========== RFID SETUP START ==========");
+  LOGI(TAG, "Setup start");
   
   #ifdef PN532_USE_I2C
-    Serial.print("[PN532] Initializing I2C bus...");
     Wire.begin(PN532_SDA, PN532_SCL);
     Wire.setClock(400000);
     delay(100);
-    Serial.println("[PN532] I2C bus initialized");
+    LOGD(TAG, "I2C bus initialized");
   #endif
   
   #ifdef PN532_USE_SPI
-    Serial.println("[PN532] Using SPI mode");
+    LOGD(TAG, "Using SPI mode");
   #endif
   
-  Serial.print("[PN532] Initializing PN532...");
   nfc.begin();
   
   uint32_t versiondata = nfc.getFirmwareVersion();
   
   if (!versiondata) {
-    Serial.println(" FAILED!");
-    DEBUG_PRINTLN("[PN532] ⚠️  ERROR: PN532 board not responding!");
-    DEBUG_PRINTLN("[PN532] System will continue WITHOUT RFID functionality");
+    LOGE(TAG, "Board not responding - continuing WITHOUT RFID functionality");
     return;
   }
-  Serial.println(" SUCCESS!");
-  Serial.print("\n[PN532] ✓ Found chip PN5"); 
-  Serial.println((versiondata >> 24) & 0xFF, HEX);
-  Serial.print("[PN532]   Firmware version: "); 
-  Serial.print((versiondata >> 16) & 0xFF, DEC); 
-  Serial.print('.'); 
-  Serial.println((versiondata >> 8) & 0xFF, DEC);
+  LOGI(TAG, "Found chip PN5%lX, firmware %lu.%lu", (unsigned long)((versiondata >> 24) & 0xFF),
+       (unsigned long)((versiondata >> 16) & 0xFF), (unsigned long)((versiondata >> 8) & 0xFF));
   
   // Configure board to read RFID tags
   nfc.SAMConfig();
+  rfid_initialized = true;
   
-  DEBUG_PRINTLN("[PN532] ========== RFID SETUP COMPLETE ==========");
-  DEBUG_PRINTLN("[PN532] ✓ Supports: ISO 14443A (MIFARE/NFC wristbands)");
-  DEBUG_PRINTLN("[PN532] ✗ Magic Bands NOT supported (see docs/MAGIC_BAND_COMPATIBILITY.md)");
-  DEBUG_PRINTLN("[PN532] Ready to scan RFID bands!");
+  #if PN532_IRQ_PIN >= 0
+    // Arm the first detection - the IRQ handler flags each card that answers
+    pinMode(PN532_IRQ_PIN, INPUT_PULLUP);
+    rfid_wake_task = xTaskGetCurrentTaskHandle();
+    attachInterrupt(digitalPinToInterrupt(PN532_IRQ_PIN), rfid_irq_handler, FALLING);
+    arm_rfid_detection();
+    LOGI(TAG, "Interrupt-driven detection on GPIO%d", PN532_IRQ_PIN);
+  #else
+    LOGI(TAG, "Polling for cards (no IRQ pin configured)");
+  #endif
+  
+  LOGI(TAG, "Ready - ISO 14443A (MIFARE/NFC wristbands); Magic Bands NOT supported "
+                "(see docs/MAGIC_BAND_COMPATIBILITY.md)");
 }
 
-uint32_t loop_rfid() {
-  uint8_t uid[8] = {0};
-  uint8_t uidLength;
-  
-  // Only ISO 14443A is supported (MIFARE/NFC cards)
-  bool success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100);
-  
-  if (!success) {
-    return 0;  // No card detected
-  }
-  
+// Store a freshly read UID in current_band
+// Returns the 32-bit ID for backward compatibility
+static uint32_t store_band_uid(uint8_t *uid, uint8_t uidLength, unsigned long read_time) {
+  current_band.read_time = read_time;
   current_band.protocol = PROTOCOL_ISO14443A;
   current_band.is_magic_band = false;
-  DEBUG_PRINTLN("[PN532] ISO 14443A card detected (MIFARE)");
-
   
   // Store UID length
   current_band.uid_length = uidLength;
@@ -109,23 +137,97 @@ uint32_t loop_rfid() {
   uint64_t band_id_64 = uid_to_uint64(uid, uidLength);
   current_band.uid.uid_64 = band_id_64;
   
-  DEBUG_PRINT("[PN532] Card detected - UID: 0x");
-  DEBUG_PRINTLN(band_id_64, HEX);
-  DEBUG_PRINT("[PN532] UID Bytes (");
-  DEBUG_PRINT(uidLength);
-  DEBUG_PRINT("): ");
-  for (uint8_t i = 0; i < uidLength; i++) {
-    if (uid[i] < 0x10) DEBUG_PRINT("0");
-    DEBUG_PRINT(uid[i], HEX);
-    DEBUG_PRINT(" ");
-  }
-  DEBUG_PRINTLN();
-  DEBUG_PRINT("[PN532] Protocol: ");
-  DEBUG_PRINTLN(get_protocol_name(current_band.protocol));
+  LOGD(TAG, "Card detected - UID 0x%llX (%u bytes, %s)", (unsigned long long)band_id_64, uidLength,
+       get_protocol_name(current_band.protocol));
   
   return band_id_32;
 }
 
+// Blocking read used when no IRQ line is available
+static uint32_t poll_rfid() {
+  uint8_t uid[8] = {0};
+  uint8_t uidLength;
+  
+  // Only ISO 14443A is supported (MIFARE/NFC cards)
+  rfid_transaction_count++;
+  unsigned long start = micros();
+  bool success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, PN532_POLL_TIMEOUT_MS);
+  instrument_since(INSTRUMENT_PN532_TRANSACTION, start);
+  
+  if (!success) {
+    return 0;  // No card detected
+  }
+  
+  return store_band_uid(uid, uidLength, millis());
+}
+
+#if PN532_IRQ_PIN >= 0
+// Arm InListPassiveTarget - returns as soon as the PN532 acknowledges the command
+static bool arm_rfid_detection() {
+  rfid_transaction_count++;
+  unsigned long start = micros();
+  rfid_detection_armed = nfc.startPassiveTargetIDDetection(PN532_MIFARE_ISO14443A);
+  instrument_since(INSTRUMENT_PN532_TRANSACTION, start);
+  if (!rfid_detection_armed) {
+    instrument_count(INSTRUMENT_PN532_FAILURES);
+  }
+  // The ACK for the command also pulls IRQ low - only a later edge means a card answered
+  rfid_irq_fired = false;
+  return rfid_detection_armed;
+}
+
+// Collect the UID once the PN532 signals a card, then re-arm for the next one
+// Never blocks waiting for a card; returns true when a new UID was stored
+static bool service_rfid_irq() {
+  if (!rfid_detection_armed) {
+    if (!arm_rfid_detection()) {
+      // Reader did not accept the command - fall back to a single polled read
+      rfid_pending_id = poll_rfid();
+      return rfid_pending_id != 0;
+    }
+    return false;
+  }
+  
+  // IRQ stays low until the response is read, so the level check also catches
+  // a card that answered before the edge flag was cleared
+  if (!rfid_irq_fired && digitalRead(PN532_IRQ_PIN) != LOW) {
+    return false;  // No card yet - nothing to do
+  }
+  
+  // Timestamp from the IRQ edge when we saw it, otherwise from now
+  unsigned long read_time = rfid_irq_fired ? rfid_irq_time : millis();
+  rfid_irq_fired = false;
+  rfid_detection_armed = false;
+  
+  uint8_t uid[8] = {0};
+  uint8_t uidLength = 0;
+  rfid_transaction_count++;
+  unsigned long start = micros();
+  bool success = nfc.readDetectedPassiveTargetID(uid, &uidLength);
+  instrument_since(INSTRUMENT_PN532_TRANSACTION, start);
+  if (success) {
+    rfid_pending_id = store_band_uid(uid, uidLength, read_time);
+  } else {
+    instrument_count(INSTRUMENT_PN532_FAILURES);  // IRQ fired but no UID came back
+  }
+  
+  arm_rfid_detection();
+  return success;
+}
+#endif
+
+uint32_t loop_rfid() {
+#if PN532_IRQ_PIN >= 0
+  if (!rfid_card_pending && !service_rfid_irq()) {
+    return 0;  // No card detected
+  }
+  rfid_card_pending = false;
+  return rfid_pending_id;
+#else
+  return poll_rfid();
+#endif
+}
+
 uint64_t loop_rfid_64() {
   // Call regular loop to do the detection
   loop_rfid();
@@ -170,11 +272,42 @@ uint64_t uid_to_uint64(uint8_t *uid_bytes, uint8_t size) {
   return result;
 }
 
-// Check if RFID card is present (100ms timeout for reliable detection)
+// Check if RFID card is present
+// IRQ mode: non-blocking, the UID is collected and kept for the next read_rfid_if_present()
+// Polling mode: 100ms timeout for reliable detection
 bool is_rfid_card_present() {
+#if PN532_IRQ_PIN >= 0
+  if (!rfid_card_pending) {
+    rfid_card_pending = service_rfid_irq();
+  }
+  return rfid_card_pending;
+#else
   uint8_t uid[8];
   uint8_t uidLength;
-  return nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100);
+  return nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, PN532_POLL_TIMEOUT_MS);
+#endif
+}
+
+// Single-transaction card read - the UID from the first successful
+// InListPassiveTarget is returned directly instead of being re-read
+bool rfid_read_card(rfid_band_info* info) {
+  if (!rfid_initialized) {
+    return false;
+  }
+  
+#if PN532_IRQ_PIN >= 0
+  if (!rfid_card_pending && !service_rfid_irq()) {
+    return false;
+  }
+  rfid_card_pending = false;
+#else
+  if (poll_rfid() == 0) {
+    return false;
+  }
+#endif
+  
+  *info = current_band;
+  return true;
 }
 
 // Read card if present
@@ -206,5 +339,15 @@ bool is_magic_band_detected() {
 
 // Check if RFID reader is initialized
 bool is_rfid_initialized() {
-  return (nfc.getFirmwareVersion() != 0);
+  return rfid_initialized;
+}
+
+// Number of PN532 card transactions issued since boot
+uint32_t get_rfid_transaction_count() {
+  return rfid_transaction_count;
+}
+
+// Check if cards are detected via the IRQ line
+bool is_rfid_irq_mode() {
+  return PN532_IRQ_PIN >= 0;
 }
@@ -16,7 +16,11 @@
   // SDA -> GPIO21
   // SCL -> GPIO22
   // Note: PN532 must have I2C mode selected (switch positions on module)
-  #define PN532_IRQ_PIN   -1  // Optional: GPIO for interrupt-driven reads
+  // IRQ is optional and most boards leave it unconnected - the driver would wait forever on a
+  // line that never falls. With it wired (e.g. to GPIO4) build with -D PN532_IRQ_PIN=4.
+  #ifndef PN532_IRQ_PIN
+  #define PN532_IRQ_PIN   -1  // GPIO for interrupt-driven reads (-1 = polling)
+  #endif
   #define PN532_RESET_PIN -1  // Optional: GPIO for hardware reset
 #endif
 
@@ -27,7 +31,7 @@
   // MISO -> GPIO19
   // MOSI -> GPIO23
   #define PN532_SS_PIN    5   // Chip Select (configurable)
-  #define PN532_IRQ_PIN   -1  // Optional: GPIO for interrupt (not required)
+  #define PN532_IRQ_PIN   -1  // Optional: GPIO for interrupt-driven reads (-1 = polling)
   #define PN532_RESET_PIN -1  // Optional: GPIO for hardware reset
 #endif
 
@@ -62,12 +66,15 @@ struct rfid_band_info {
   uint8_t uid_length;      // Actual UID length (4, 7, 8, or 10 bytes)
   RFIDProtocol protocol;   // Detected protocol type
   bool is_magic_band;      // True if detected as Magic Band (ISO 15693)
+  unsigned long read_time; // millis() when the card answered
 };
 
 // External declaration - actual definition is in RFIDControlPN532.cpp
 extern rfid_band_info current_band;
 
 // Function declarations - Same API as RFIDControl for easy swapping
+// In IRQ mode every IRQ edge sends a task notification to the task that called setup_rfid(),
+// so it can idle in ulTaskNotifyTake() and wake as soon as a card answers
 void setup_rfid();
 uint32_t loop_rfid();  // Returns 32-bit UID for backward compatibility
 uint64_t loop_rfid_64();  // Returns full 64-bit UID for Magic Bands
@@ -75,8 +82,16 @@ bool is_rfid_card_present();
 uint32_t read_rfid_if_present();
 uint64_t read_rfid_if_present_64();  // Full 64-bit version
 
+// Single-transaction card read
+// Fills info from the first successful InListPassiveTarget (UID, length, protocol, timestamp)
+// and returns true - no separate presence check, no second read. uid.uid_64 is the band ID.
+// Never blocks in IRQ mode; one 100ms-timeout transaction in polling mode.
+bool rfid_read_card(rfid_band_info* info);
+
 // Diagnostic and status functions
 bool is_rfid_initialized();  // Check if RFID reader is ready
+bool is_rfid_irq_mode();     // True when cards are detected via the PN532 IRQ line instead of polling
+uint32_t get_rfid_transaction_count();  // PN532 card transactions issued since boot
 
 // Helper functions
 uint32_t uid_to_uint32(uint8_t *uid_bytes, uint8_t size);
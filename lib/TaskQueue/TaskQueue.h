@@ -0,0 +1,54 @@
+#ifndef TASK_QUEUE_H
+#define TASK_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Lock-free queue of fixed-size records between two tasks (typically on different cores)
+//
+// Single producer, single consumer: one task only pushes, the other only pops, so two atomic
+// indices are all the synchronization needed - neither side ever waits or takes a lock.
+// Bounded: a push into a full queue fails (and is counted) instead of blocking, so a stalled
+// consumer can never hold up the producer. Records are copied in and out, so keep them small.
+// Variable-length MQTT messages use MQTTQueue.h instead.
+//
+// A zero-initialized static instance is an empty queue - no setup call needed.
+//
+// No ESP-IDF dependency - builds and runs on the host.
+
+template <typename T, uint32_t N>
+struct TaskQueue {
+  static_assert((N & (N - 1)) == 0, "TaskQueue size must be a power of two");
+
+  T items[N];
+  std::atomic<uint32_t> head;  // Next write (free-running) - written by the producer only
+  std::atomic<uint32_t> tail;  // Next read (free-running) - written by the consumer only
+  uint32_t dropped;            // Pushes refused because the queue was full (producer side)
+};
+
+// Producer: copy a record in - false (and counted in dropped) if the queue is full
+template <typename T, uint32_t N>
+bool task_queue_push(TaskQueue<T, N>* queue, const T& item) {
+  uint32_t head = queue->head.load(std::memory_order_relaxed);
+  if (head - queue->tail.load(std::memory_order_acquire) >= N) {
+    queue->dropped++;
+    return false;
+  }
+  queue->items[head % N] = item;
+  queue->head.store(head + 1, std::memory_order_release);  // Publishes the record
+  return true;
+}
+
+// Consumer: copy the oldest record out - false if the queue is empty
+template <typename T, uint32_t N>
+bool task_queue_pop(TaskQueue<T, N>* queue, T* item) {
+  uint32_t tail = queue->tail.load(std::memory_order_relaxed);
+  if (tail == queue->head.load(std::memory_order_acquire)) {
+    return false;
+  }
+  *item = queue->items[tail % N];
+  queue->tail.store(tail + 1, std::memory_order_release);  // Slot may be reused from here
+  return true;
+}
+
+#endif // TASK_QUEUE_H
@@ -0,0 +1,157 @@
+#include "Adafruit_PN532.h"
+#include "HostPN532.h"
+#include <HostHardware.h>
+
+// Simulated reader state - one reader per board
+static bool reader_present = true;
+static bool card_in_field = false;
+static uint8_t card_uid[HOST_PN532_MAX_UID];
+static uint8_t card_uid_length = 0;
+static uint32_t card_generation = 0;   // Cancels a pending answer when the card leaves
+static bool detection_armed = false;
+static bool response_ready = false;    // Card answered - IRQ low until the response is read
+static uint8_t irq_pin = 0xFF;
+static int failing_reads = 0;
+static uint32_t transactions = 0;
+static std::function<void()> detect_listener;
+static std::function<void(const uint8_t*, uint8_t)> read_listener;
+
+static void set_irq(int level) {
+  if (irq_pin != 0xFF) {
+    host_set_pin(irq_pin, level);
+  }
+}
+
+// Armed reader with a card in the field - the card answers after the RF exchange
+static void schedule_detection() {
+  if (!detection_armed || !card_in_field || response_ready) return;
+  uint32_t generation = card_generation;
+  host_schedule_us(HOST_PN532_DETECT_US, [generation]() {
+    if (generation != card_generation || !detection_armed || !card_in_field) return;
+    response_ready = true;
+    set_irq(LOW);
+    if (detect_listener) detect_listener();
+  });
+}
+
+static bool copy_card(uint8_t* uid, uint8_t* uid_length) {
+  if (failing_reads > 0) {
+    failing_reads--;
+    return false;
+  }
+  memcpy(uid, card_uid, card_uid_length);
+  *uid_length = card_uid_length;
+  if (read_listener) read_listener(uid, *uid_length);
+  return true;
+}
+
+bool Adafruit_PN532::begin() {
+  irq_pin = irq_;
+  if (irq_pin != 0xFF) {
+    host_set_pin(irq_pin, HIGH);
+  }
+  return true;
+}
+
+uint32_t Adafruit_PN532::getFirmwareVersion() {
+  transactions++;
+  host_advance_us(HOST_PN532_COMMAND_US);
+  return reader_present ? 0x32010607 : 0;  // PN532, firmware 1.6
+}
+
+bool Adafruit_PN532::SAMConfig() {
+  transactions++;
+  host_advance_us(HOST_PN532_COMMAND_US);
+  return reader_present;
+}
+
+bool Adafruit_PN532::readPassiveTargetID(uint8_t cardbaudrate, uint8_t* uid, uint8_t* uidLength, uint16_t timeout) {
+  transactions++;
+  if (!reader_present) return false;
+  host_advance_us(HOST_PN532_ARM_US);
+
+  // The chip keeps polling until a card answers or the driver gives up
+  uint64_t deadline = host_micros64() + (uint64_t)timeout * 1000;
+  while (!card_in_field) {
+    if (timeout != 0 && host_micros64() >= deadline) return false;
+    host_advance_us(1000);
+  }
+  host_advance_us(HOST_PN532_DETECT_US);
+  if (detect_listener) detect_listener();
+  host_advance_us(HOST_PN532_READ_US);
+  return card_in_field && copy_card(uid, uidLength);
+}
+
+bool Adafruit_PN532::startPassiveTargetIDDetection(uint8_t cardbaudrate) {
+  transactions++;
+  if (!reader_present) return false;
+  // The ACK pulls IRQ low until the driver reads it
+  set_irq(LOW);
+  host_advance_us(HOST_PN532_ARM_US);
+  set_irq(HIGH);
+  detection_armed = true;
+  response_ready = false;
+  schedule_detection();
+  return true;
+}
+
+bool Adafruit_PN532::readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLength) {
+  transactions++;
+  host_advance_us(HOST_PN532_READ_US);
+  bool answered = response_ready;
+  detection_armed = false;
+  response_ready = false;
+  set_irq(HIGH);
+  return answered && copy_card(uid, uidLength);
+}
+
+void host_pn532_set_present(bool present) {
+  reader_present = present;
+}
+
+void host_pn532_present_card(const uint8_t* uid, uint8_t uid_length) {
+  if (uid_length > HOST_PN532_MAX_UID) uid_length = HOST_PN532_MAX_UID;
+  memcpy(card_uid, uid, uid_length);
+  card_uid_length = uid_length;
+  card_in_field = true;
+  card_generation++;
+  schedule_detection();
+}
+
+void host_pn532_present_card(uint64_t uid, uint8_t uid_length) {
+  uint8_t bytes[8];
+  if (uid_length > sizeof(bytes)) uid_length = sizeof(bytes);
+  for (uint8_t i = 0; i < uid_length; i++) {
+    bytes[i] = uid >> (8 * (uid_length - 1 - i));
+  }
+  host_pn532_present_card(bytes, uid_length);
+}
+
+void host_pn532_remove_card() {
+  card_in_field = false;
+  card_generation++;
+}
+
+void host_pn532_tap(uint64_t uid, uint8_t uid_length, uint32_t hold_ms) {
+  host_pn532_present_card(uid, uid_length);
+  uint32_t generation = card_generation;
+  host_schedule_us((uint64_t)hold_ms * 1000, [generation]() {
+    if (generation == card_generation) host_pn532_remove_card();
+  });
+}
+
+void host_pn532_fail_next_reads(int count) {
+  failing_reads = count;
+}
+
+uint32_t host_pn532_transaction_count() {
+  return transactions;
+}
+
+void host_pn532_on_detect(std::function<void()> listener) {
+  detect_listener = std::move(listener);
+}
+
+void host_pn532_on_read(std::function<void(const uint8_t* uid, uint8_t uid_length)> listener) {
+  read_listener = std::move(listener);
+}
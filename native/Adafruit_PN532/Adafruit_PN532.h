@@ -0,0 +1,34 @@
+#ifndef ADAFRUIT_PN532_H
+#define ADAFRUIT_PN532_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <SPI.h>
+
+// Host stand-in for the Adafruit PN532 driver (native environment only)
+// Talks to the simulated reader in HostPN532.h - same calls, same blocking behavior and
+// the IRQ line driven the way the real chip drives it.
+
+#define PN532_MIFARE_ISO14443A 0x00
+
+class Adafruit_PN532 {
+public:
+  Adafruit_PN532(uint8_t irq, uint8_t reset, TwoWire* wire = &Wire) : irq_(irq) {}
+  Adafruit_PN532(uint8_t ss, SPIClass* spi = &SPI) : irq_(0xFF) {}
+
+  bool begin();
+  uint32_t getFirmwareVersion();
+  bool SAMConfig();
+
+  // Blocking read - waits up to timeout ms for a card (0 = forever)
+  bool readPassiveTargetID(uint8_t cardbaudrate, uint8_t* uid, uint8_t* uidLength, uint16_t timeout = 0);
+
+  // Interrupt-driven read - arm, wait for IRQ low, then collect
+  bool startPassiveTargetIDDetection(uint8_t cardbaudrate);
+  bool readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLength);
+
+private:
+  uint8_t irq_;
+};
+
+#endif // ADAFRUIT_PN532_H
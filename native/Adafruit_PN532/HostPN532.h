@@ -0,0 +1,36 @@
+#ifndef HOST_PN532_H
+#define HOST_PN532_H
+
+#include <stdint.h>
+#include <functional>
+
+// Simulated PN532 reader for the native environment
+// Transaction times are for I2C at 400kHz: frame bytes on the bus plus the chip's own
+// processing. The IRQ line goes low while a response is waiting, as on the real chip.
+#define HOST_PN532_COMMAND_US 1200       // Short command with ACK (firmware version, SAM config)
+#define HOST_PN532_ARM_US 900            // InListPassiveTarget written and acknowledged
+#define HOST_PN532_DETECT_US 6000        // Card in the field to IRQ low (RF anticollision)
+#define HOST_PN532_READ_US 1400          // Target data read back after IRQ
+#define HOST_PN532_MAX_UID 10
+
+// Reader present on the bus - false makes the firmware handshake fail
+void host_pn532_set_present(bool present);
+
+// Put a card in the field / take it away
+// A card left in the field is detected again each time the firmware re-arms the reader
+void host_pn532_present_card(const uint8_t* uid, uint8_t uid_length);
+void host_pn532_present_card(uint64_t uid, uint8_t uid_length);  // UID bytes big-endian, as uid_to_uint64() builds it
+void host_pn532_remove_card();
+void host_pn532_tap(uint64_t uid, uint8_t uid_length, uint32_t hold_ms);  // Present now, remove after hold_ms
+
+// Make the next reads fail (CRC error, card pulled mid-read)
+void host_pn532_fail_next_reads(int count);
+
+uint32_t host_pn532_transaction_count();
+
+// Called when a card answers an armed detection (IRQ goes low) and when the firmware has
+// read a UID back - the first two steps of a tap, for latency measurements
+void host_pn532_on_detect(std::function<void()> listener);
+void host_pn532_on_read(std::function<void(const uint8_t* uid, uint8_t uid_length)> listener);
+
+#endif // HOST_PN532_H
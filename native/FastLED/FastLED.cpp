@@ -0,0 +1,111 @@
+#include "FastLED.h"
+#include "HostLEDStrip.h"
+#include <HostHardware.h>
+
+CFastLED FastLED;
+
+void fill_solid(CRGB* leds, int num_leds, const CRGB& color) {
+  for (int i = 0; i < num_leds; i++) {
+    leds[i] = color;
+  }
+}
+
+void nscale8(CRGB* leds, uint16_t num_leds, uint8_t scale) {
+  for (uint16_t i = 0; i < num_leds; i++) {
+    leds[i].nscale8(scale);
+  }
+}
+
+void fadeToBlackBy(CRGB* leds, uint16_t num_leds, uint8_t fade_by) {
+  nscale8(leds, num_leds, 255 - fade_by);
+}
+
+CRGB blend(const CRGB& p1, const CRGB& p2, fract8 amount_of_p2) {
+  return CRGB(lerp8by8(p1.r, p2.r, amount_of_p2), lerp8by8(p1.g, p2.g, amount_of_p2),
+              lerp8by8(p1.b, p2.b, amount_of_p2));
+}
+
+// FastLED's "rainbow" hue mapping: eight 32-step sections with a brighter yellow
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb) {
+  uint8_t hue = hsv.h;
+  uint8_t offset8 = (hue & 0x1F) << 3;
+  uint8_t third = scale8(offset8, 85);
+  uint8_t twothirds = scale8(offset8, 170);
+  uint8_t r, g, b;
+
+  switch (hue >> 5) {
+    case 0: r = 255 - third; g = third; b = 0; break;                 // Red to orange
+    case 1: r = 171; g = 85 + third; b = 0; break;                    // Orange to yellow
+    case 2: r = 171 - twothirds; g = 170 + third; b = 0; break;       // Yellow to green
+    case 3: r = 0; g = 255 - offset8; b = offset8; break;             // Green to aqua
+    case 4: r = 0; g = 171 - twothirds; b = 85 + twothirds; break;    // Aqua to blue
+    case 5: r = third; g = 0; b = 255 - third; break;                 // Blue to purple
+    case 6: r = 85 + third; g = 0; b = 171 - third; break;            // Purple to pink
+    default: r = 170 + third; g = 0; b = 85 - third; break;           // Pink to red
+  }
+
+  if (hsv.s != 255) {
+    uint8_t desat = 255 - hsv.s;
+    desat = scale8(desat, desat);
+    uint8_t satscale = 255 - desat;
+    r = scale8(r, satscale) + desat;
+    g = scale8(g, satscale) + desat;
+    b = scale8(b, satscale) + desat;
+  }
+  if (hsv.v != 255) {
+    uint8_t val = scale8_video(hsv.v, hsv.v);
+    r = scale8(r, val);
+    g = scale8(g, val);
+    b = scale8(b, val);
+  }
+  rgb = CRGB(r, g, b);
+}
+
+CRGB::CRGB(const CHSV& hsv) {
+  hsv2rgb_rainbow(hsv, *this);
+}
+
+static const uint8_t RED_mW = 16 * 5;
+static const uint8_t GREEN_mW = 11 * 5;
+static const uint8_t BLUE_mW = 15 * 5;
+static const uint8_t DARK_mW = 1 * 5;  // Each LED's controller, even when dark
+
+uint32_t calculate_unscaled_power_mW(const CRGB* leds, uint16_t num_leds) {
+  uint32_t red = 0, green = 0, blue = 0;
+  for (uint16_t i = 0; i < num_leds; i++) {
+    red += leds[i].r;
+    green += leds[i].g;
+    blue += leds[i].b;
+  }
+  return ((red * RED_mW) >> 8) + ((green * GREEN_mW) >> 8) + ((blue * BLUE_mW) >> 8) + DARK_mW * num_leds;
+}
+
+uint8_t calculate_max_brightness_for_power_mW(const CRGB* leds, uint16_t num_leds, uint8_t target_brightness,
+                                              uint32_t max_power_mW) {
+  uint32_t requested = (calculate_unscaled_power_mW(leds, num_leds) * target_brightness) / 256;
+  if (requested <= max_power_mW) {
+    return target_brightness;
+  }
+  return (uint8_t)(((uint32_t)target_brightness * max_power_mW) / requested);
+}
+
+CLEDController& CFastLED::attach(CRGB* data, int num_leds) {
+  leds_ = data;
+  num_leds_ = num_leds;
+  return controller_;
+}
+
+// Bit-banged output - the CPU is busy until the whole frame is on the wire
+void CFastLED::show(uint8_t scale) {
+  if (leds_ == nullptr) return;
+  uint8_t brightness = calculate_max_brightness_for_power_mW(leds_, num_leds_, scale, max_power_mW_);
+  while (!host_led_strip_write(leds_, num_leds_, brightness)) {
+    host_advance_us(10);
+  }
+  host_advance_us(host_led_frame_time_us(num_leds_));
+}
+
+void CFastLED::clear(bool write_data) {
+  if (leds_ != nullptr) fill_solid(leds_, num_leds_, CRGB::Black);
+  if (write_data) show(0);
+}
@@ -0,0 +1,141 @@
+#ifndef FASTLED_H
+#define FASTLED_H
+
+#include <Arduino.h>
+
+// Host stand-in for FastLED (native environment only)
+//
+// The color math lib/ relies on (CRGB, CHSV, scale8, blend, power limiting) follows FastLED's
+// own definitions. Output goes to the simulated strip in HostLEDStrip.h: FastLED.show() blocks
+// for the frame's wire time like the bit-banged driver does, the RMT backend does not.
+
+typedef uint8_t fract8;
+
+inline uint8_t scale8(uint8_t i, fract8 scale) {
+  return ((uint16_t)i * (1 + (uint16_t)scale)) >> 8;
+}
+
+inline uint8_t scale8_video(uint8_t i, fract8 scale) {
+  return (((uint16_t)i * scale) >> 8) + ((i && scale) ? 1 : 0);
+}
+
+inline uint8_t qadd8(uint8_t i, uint8_t j) {
+  unsigned int t = i + j;
+  return t > 255 ? 255 : t;
+}
+
+inline uint8_t lerp8by8(uint8_t a, uint8_t b, fract8 frac) {
+  return b > a ? a + scale8(b - a, frac) : a - scale8(a - b, frac);
+}
+
+struct CHSV {
+  union {
+    struct {
+      uint8_t h;
+      uint8_t s;
+      uint8_t v;
+    };
+    uint8_t raw[3];
+  };
+  CHSV() : h(0), s(0), v(0) {}
+  CHSV(uint8_t hue, uint8_t sat, uint8_t val) : h(hue), s(sat), v(val) {}
+};
+
+struct CRGB {
+  union {
+    struct {
+      uint8_t r;
+      uint8_t g;
+      uint8_t b;
+    };
+    uint8_t raw[3];
+  };
+
+  typedef enum {
+    Black = 0x000000,
+    Blue = 0x0000FF,
+    Cyan = 0x00FFFF,
+    Green = 0x008000,
+    Magenta = 0xFF00FF,
+    Orange = 0xFFA500,
+    Purple = 0x800080,
+    Red = 0xFF0000,
+    White = 0xFFFFFF,
+    Yellow = 0xFFFF00
+  } HTMLColorCode;
+
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+  CRGB(HTMLColorCode colorcode) : CRGB((uint32_t)colorcode) {}
+  CRGB(const CHSV& hsv);
+
+  CRGB& operator=(const CHSV& hsv) { return *this = CRGB(hsv); }
+
+  CRGB& operator+=(const CRGB& rhs) {
+    r = qadd8(r, rhs.r);
+    g = qadd8(g, rhs.g);
+    b = qadd8(b, rhs.b);
+    return *this;
+  }
+
+  CRGB& nscale8(uint8_t scaledown) {
+    r = scale8(r, scaledown);
+    g = scale8(g, scaledown);
+    b = scale8(b, scaledown);
+    return *this;
+  }
+
+  CRGB& fadeToBlackBy(uint8_t fadefactor) { return nscale8(255 - fadefactor); }
+
+  explicit operator bool() const { return r || g || b; }  // Lit
+  bool operator==(const CRGB& rhs) const { return r == rhs.r && g == rhs.g && b == rhs.b; }
+  bool operator!=(const CRGB& rhs) const { return !(*this == rhs); }
+};
+
+void fill_solid(CRGB* leds, int num_leds, const CRGB& color);
+void nscale8(CRGB* leds, uint16_t num_leds, uint8_t scale);
+void fadeToBlackBy(CRGB* leds, uint16_t num_leds, uint8_t fade_by);
+CRGB blend(const CRGB& p1, const CRGB& p2, fract8 amount_of_p2);
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb);
+
+// Power model from FastLED's power_mgt (mW per channel at full on, at 5V)
+uint32_t calculate_unscaled_power_mW(const CRGB* leds, uint16_t num_leds);
+uint8_t calculate_max_brightness_for_power_mW(const CRGB* leds, uint16_t num_leds, uint8_t target_brightness,
+                                              uint32_t max_power_mW);
+
+// Chipsets and color orders - only used as template arguments
+enum EOrder { RGB = 0012, RBG = 0021, GRB = 0102, GBR = 0120, BRG = 0201, BGR = 0210 };
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = GRB> class WS2812B {};
+template <uint8_t DATA_PIN> class NEOPIXEL {};
+
+class CLEDController {};
+
+class CFastLED {
+public:
+  template <template <uint8_t, EOrder> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+  CLEDController& addLeds(CRGB* data, int num_leds) { return attach(data, num_leds); }
+  template <template <uint8_t> class CHIPSET, uint8_t DATA_PIN>
+  CLEDController& addLeds(CRGB* data, int num_leds) { return attach(data, num_leds); }
+
+  void show() { show(brightness_); }
+  void show(uint8_t scale);
+  void clear(bool write_data = false);
+  void setBrightness(uint8_t scale) { brightness_ = scale; }
+  uint8_t getBrightness() const { return brightness_; }
+  void setMaxPowerInVoltsAndMilliamps(uint8_t volts, uint32_t milliamps) { max_power_mW_ = volts * milliamps; }
+  void setMaxPowerInMilliWatts(uint32_t milliwatts) { max_power_mW_ = milliwatts; }
+
+private:
+  CRGB* leds_ = nullptr;
+  int num_leds_ = 0;
+  uint8_t brightness_ = 255;
+  uint32_t max_power_mW_ = 0xFFFFFFFF;
+  CLEDController controller_;
+
+  CLEDController& attach(CRGB* data, int num_leds);
+};
+
+extern CFastLED FastLED;
+
+#endif // FASTLED_H
@@ -0,0 +1,53 @@
+#include "HostLEDStrip.h"
+#include <HostHardware.h>
+
+static CRGB strip_pixels[HOST_LED_MAX_PIXELS];
+static uint8_t strip_brightness = 0;
+static uint32_t strip_frames = 0;
+static uint64_t strip_last_frame_us = 0;
+static uint64_t strip_busy_until_us = 0;
+static std::function<void(const CRGB*, int, uint8_t)> strip_listener;
+
+uint32_t host_led_frame_time_us(int count) {
+  return (uint32_t)count * 24 * HOST_LED_BIT_NS / 1000 + HOST_LED_RESET_US;
+}
+
+bool host_led_strip_busy() {
+  return host_micros64() < strip_busy_until_us;
+}
+
+bool host_led_strip_write(const CRGB* pixels, int count, uint8_t brightness) {
+  if (host_led_strip_busy() || count > HOST_LED_MAX_PIXELS) {
+    return false;
+  }
+  uint64_t now = host_micros64();
+  memcpy(strip_pixels, pixels, count * sizeof(CRGB));
+  strip_brightness = brightness;
+  strip_frames++;
+  strip_last_frame_us = now;
+  strip_busy_until_us = now + host_led_frame_time_us(count);
+  if (strip_listener) {
+    strip_listener(strip_pixels, count, brightness);
+  }
+  return true;
+}
+
+uint32_t host_led_frame_count() {
+  return strip_frames;
+}
+
+uint64_t host_led_last_frame_us() {
+  return strip_last_frame_us;
+}
+
+const CRGB* host_led_pixels() {
+  return strip_pixels;
+}
+
+uint8_t host_led_brightness() {
+  return strip_brightness;
+}
+
+void host_led_on_frame(std::function<void(const CRGB* pixels, int count, uint8_t brightness)> listener) {
+  strip_listener = std::move(listener);
+}
@@ -0,0 +1,27 @@
+#ifndef HOST_LED_STRIP_H
+#define HOST_LED_STRIP_H
+
+#include <FastLED.h>
+#include <functional>
+
+// Simulated WS2812B strip for the native environment
+// Frames take their real wire time: 24 bits at 1.25us per LED plus the latch gap. Each frame
+// is recorded with the time it started clocking out.
+#define HOST_LED_BIT_NS 1250
+#define HOST_LED_RESET_US 50
+#define HOST_LED_MAX_PIXELS 256
+
+// Start clocking out a frame (brightness already applied by the caller's scale) -
+// returns false while the previous frame is still on the wire
+bool host_led_strip_write(const CRGB* pixels, int count, uint8_t brightness);
+bool host_led_strip_busy();
+uint32_t host_led_frame_time_us(int count);
+
+// What the strip shows
+uint32_t host_led_frame_count();
+uint64_t host_led_last_frame_us();     // host_micros64() when the last frame started
+const CRGB* host_led_pixels();         // Pixels of the last frame, before brightness
+uint8_t host_led_brightness();         // Brightness of the last frame
+void host_led_on_frame(std::function<void(const CRGB* pixels, int count, uint8_t brightness)> listener);
+
+#endif // HOST_LED_STRIP_H
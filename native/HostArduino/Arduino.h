@@ -0,0 +1,180 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Host stand-in for the Arduino-ESP32 core (native environment only)
+//
+// Covers what lib/ and src/ use: timing, GPIO with interrupts, Serial/HardwareSerial,
+// Print/Stream, String and FreeRTOS tasks. Time and pin levels come from the simulated hardware in
+// HostHardware.h, so the firmware runs unmodified against scripted peripherals.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include "HostFreeRTOS.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define SERIAL_8N1 0x800001c
+
+#define IRAM_ATTR
+
+using std::min;
+using std::max;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+// Timing - see HostHardware.h for real vs virtual time
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// GPIO
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(pin) (pin)
+
+class String {
+public:
+  String() {}
+  String(const char* text) : value_(text != nullptr ? text : "") {}
+  String(const std::string& text) : value_(text) {}
+  explicit String(char c) : value_(1, c) {}
+  explicit String(int value, unsigned char base = DEC);
+  explicit String(unsigned int value, unsigned char base = DEC);
+  explicit String(long value, unsigned char base = DEC);
+  explicit String(unsigned long value, unsigned char base = DEC);
+
+  const char* c_str() const { return value_.c_str(); }
+  unsigned int length() const { return value_.length(); }
+  char operator[](unsigned int index) const { return index < value_.length() ? value_[index] : 0; }
+
+  String& operator+=(const String& other) { value_ += other.value_; return *this; }
+  String& operator+=(const char* other) { value_ += other; return *this; }
+  String& operator+=(char c) { value_ += c; return *this; }
+
+  bool operator==(const String& other) const { return value_ == other.value_; }
+  bool operator==(const char* other) const { return value_ == other; }
+  bool operator!=(const String& other) const { return value_ != other.value_; }
+  bool operator!=(const char* other) const { return value_ != other; }
+
+  friend String operator+(const String& a, const String& b) { return String(a.value_ + b.value_); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.value_); }
+  friend String operator+(const String& a, const char* b) { return String(a.value_ + b); }
+
+private:
+  std::string value_;
+};
+
+class Print;
+
+class Printable {
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* text) { return text != nullptr ? write((const uint8_t*)text, strlen(text)) : 0; }
+  size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+  virtual void flush() {}
+
+  size_t print(const char* text) { return write(text); }
+  size_t print(const String& text) { return write(text.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = DEC) { return print_unsigned(value, base); }
+  size_t print(int value, int base = DEC) { return print_signed(value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print_unsigned(value, base); }
+  size_t print(long value, int base = DEC) { return print_signed(value, base); }
+  size_t print(unsigned long value, int base = DEC) { return print_unsigned(value, base); }
+  size_t print(long long value, int base = DEC) { return print_signed(value, base); }
+  size_t print(unsigned long long value, int base = DEC) { return print_unsigned(value, base); }
+  size_t print(double value, int digits = 2);
+  size_t print(const Printable& value) { return value.printTo(*this); }
+
+  template <typename T>
+  size_t println(const T& value) { size_t n = print(value); return n + println(); }
+  template <typename T>
+  size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+  size_t println() { return write((const uint8_t*)"\r\n", 2); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+  size_t print_unsigned(unsigned long long value, int base);
+  size_t print_signed(long long value, int base);
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  size_t readBytes(uint8_t* buffer, size_t length);
+};
+
+// UART 0 is the console (stdout). Other UARTs talk to simulated devices attached
+// with host_uart_attach() - bytes arrive after their wire time at the configured baud rate.
+class HardwareSerial : public Stream {
+public:
+  explicit HardwareSerial(int uart_num) : uart_num_(uart_num) {}
+
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rx_pin = -1, int8_t tx_pin = -1);
+  void end();
+  operator bool() const { return true; }
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+private:
+  int uart_num_;
+  unsigned long baud_ = 0;
+};
+
+extern HardwareSerial Serial;
+
+// Sketch entry points (src/main.cpp)
+void setup();
+void loop();
+
+#endif // ARDUINO_H
@@ -0,0 +1,46 @@
+#ifndef ARDUINO_OTA_H
+#define ARDUINO_OTA_H
+
+#include <Arduino.h>
+#include <functional>
+
+// Host stand-in for ArduinoOTA - accepts the configuration and never receives an update
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+typedef enum {
+  OTA_AUTH_ERROR,
+  OTA_BEGIN_ERROR,
+  OTA_CONNECT_ERROR,
+  OTA_RECEIVE_ERROR,
+  OTA_END_ERROR
+} ota_error_t;
+
+class ArduinoOTAClass {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+  typedef std::function<void(ota_error_t)> THandlerFunction_Error;
+  typedef std::function<void(unsigned int, unsigned int)> THandlerFunction_Progress;
+
+  ArduinoOTAClass& setHostname(const char* hostname) { return *this; }
+  ArduinoOTAClass& setPassword(const char* password) { return *this; }
+  ArduinoOTAClass& setPort(uint16_t port) { return *this; }
+  ArduinoOTAClass& onStart(THandlerFunction fn) { on_start_ = fn; return *this; }
+  ArduinoOTAClass& onEnd(THandlerFunction fn) { on_end_ = fn; return *this; }
+  ArduinoOTAClass& onError(THandlerFunction_Error fn) { on_error_ = fn; return *this; }
+  ArduinoOTAClass& onProgress(THandlerFunction_Progress fn) { on_progress_ = fn; return *this; }
+  void begin() {}
+  void handle() {}
+  int getCommand() { return U_FLASH; }
+
+private:
+  THandlerFunction on_start_;
+  THandlerFunction on_end_;
+  THandlerFunction_Error on_error_;
+  THandlerFunction_Progress on_progress_;
+};
+
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif // ARDUINO_OTA_H
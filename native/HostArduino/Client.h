@@ -0,0 +1,12 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <Arduino.h>
+
+// Network client base - the simulated broker (HostBroker.h) stands in for the socket
+class Client {
+public:
+  virtual ~Client() {}
+};
+
+#endif // CLIENT_H
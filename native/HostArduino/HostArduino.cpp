@@ -0,0 +1,274 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <SPI.h>
+#include <ArduinoOTA.h>
+#include "HostHardware.h"
+#include <stdarg.h>
+#include <deque>
+#include <map>
+#include <vector>
+
+// GPIO, UARTs, Print/String and the native main()
+
+#define HOST_PIN_COUNT 40
+#define HOST_UART_COUNT 3
+
+struct HostPin {
+  uint8_t mode;
+  int level;
+  bool driven;               // Set by host_set_pin() - otherwise the pull resistor decides
+  void (*handler)(void);
+  int interrupt_mode;
+};
+
+static HostPin pins[HOST_PIN_COUNT];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= HOST_PIN_COUNT) return;
+  pins[pin].mode = mode;
+  if (!pins[pin].driven) {
+    pins[pin].level = (mode & PULLUP) ? HIGH : LOW;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= HOST_PIN_COUNT) return;
+  pins[pin].level = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < HOST_PIN_COUNT ? pins[pin].level : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+  if (pin >= HOST_PIN_COUNT) return;
+  pins[pin].handler = handler;
+  pins[pin].interrupt_mode = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin >= HOST_PIN_COUNT) return;
+  pins[pin].handler = nullptr;
+}
+
+void host_set_pin(uint8_t pin, int level) {
+  if (pin >= HOST_PIN_COUNT) return;
+  HostPin& p = pins[pin];
+  int previous = p.level;
+  p.level = level ? HIGH : LOW;
+  p.driven = true;
+  if (p.handler == nullptr || previous == p.level) return;
+
+  bool rising = p.level == HIGH;
+  if (p.interrupt_mode == CHANGE || (p.interrupt_mode == RISING && rising) ||
+      (p.interrupt_mode == FALLING && !rising)) {
+    p.handler();
+  }
+}
+
+int host_get_pin(uint8_t pin) {
+  return digitalRead(pin);
+}
+
+TwoWire Wire;
+SPIClass SPI;
+ArduinoOTAClass ArduinoOTA;
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// UARTs
+
+HostUARTDevice* host_default_uart_device(int uart);  // HostDFPlayer.cpp
+
+static HostUARTDevice* uart_devices[HOST_UART_COUNT];
+static std::deque<uint8_t> uart_rx[HOST_UART_COUNT];
+static unsigned long uart_baud[HOST_UART_COUNT] = {115200, 115200, 115200};
+static bool serial_output = true;
+
+HardwareSerial Serial(0);
+
+void host_set_serial_output(bool enabled) {
+  serial_output = enabled;
+}
+
+void host_uart_attach(int uart, HostUARTDevice* device) {
+  if (uart > 0 && uart < HOST_UART_COUNT) {
+    uart_devices[uart] = device;
+  }
+}
+
+uint32_t host_uart_byte_time_us(int uart) {
+  return 10000000UL / uart_baud[uart];  // Start bit, 8 data bits, stop bit
+}
+
+void host_uart_send(int uart, const uint8_t* data, size_t length) {
+  if (uart <= 0 || uart >= HOST_UART_COUNT) return;
+  std::vector<uint8_t> bytes(data, data + length);
+  host_schedule_us((uint64_t)length * host_uart_byte_time_us(uart), [uart, bytes]() {
+    uart_rx[uart].insert(uart_rx[uart].end(), bytes.begin(), bytes.end());
+  });
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rx_pin, int8_t tx_pin) {
+  baud_ = baud;
+  if (uart_num_ < 0 || uart_num_ >= HOST_UART_COUNT) return;
+  uart_baud[uart_num_] = baud;
+  if (uart_num_ > 0 && uart_devices[uart_num_] == nullptr) {
+    uart_devices[uart_num_] = host_default_uart_device(uart_num_);
+  }
+}
+
+void HardwareSerial::end() {}
+
+int HardwareSerial::available() {
+  if (uart_num_ <= 0 || uart_num_ >= HOST_UART_COUNT) return 0;
+  host_run_events();
+  return uart_rx[uart_num_].size();
+}
+
+int HardwareSerial::read() {
+  if (available() == 0) return -1;
+  uint8_t b = uart_rx[uart_num_].front();
+  uart_rx[uart_num_].pop_front();
+  return b;
+}
+
+int HardwareSerial::peek() {
+  if (available() == 0) return -1;
+  return uart_rx[uart_num_].front();
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  if (uart_num_ == 0) {
+    if (serial_output) fwrite(buffer, 1, size, stdout);
+    return size;
+  }
+  if (uart_num_ >= HOST_UART_COUNT || uart_devices[uart_num_] == nullptr) {
+    return size;  // Nothing on the other end
+  }
+  // The TX FIFO takes the bytes at once - the device sees them after their wire time
+  HostUARTDevice* device = uart_devices[uart_num_];
+  std::vector<uint8_t> bytes(buffer, buffer + size);
+  host_schedule_us((uint64_t)size * host_uart_byte_time_us(uart_num_), [device, bytes]() {
+    device->receive(bytes.data(), bytes.size());
+  });
+  return size;
+}
+
+// Print and String
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print_unsigned(unsigned long long value, int base) {
+  if (base < 2) base = DEC;
+  char buffer[65];
+  char* p = buffer + sizeof(buffer) - 1;
+  *p = '\0';
+  do {
+    int digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value != 0);
+  return write(p);
+}
+
+size_t Print::print_signed(long long value, int base) {
+  if (base != DEC) {
+    return print_unsigned((unsigned long long)value, base);
+  }
+  if (value < 0) {
+    return print('-') + print_unsigned(0ULL - (unsigned long long)value, base);
+  }
+  return print_unsigned(value, base);
+}
+
+size_t Print::print(double value, int digits) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+  return write(buffer);
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (length < 0) return 0;
+  if ((size_t)length < sizeof(buffer)) return write((const uint8_t*)buffer, length);
+
+  std::vector<char> large(length + 1);
+  va_start(args, format);
+  vsnprintf(large.data(), large.size(), format, args);
+  va_end(args);
+  return write((const uint8_t*)large.data(), length);
+}
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+  size_t n = 0;
+  while (n < length && available() > 0) {
+    buffer[n++] = read();
+  }
+  return n;
+}
+
+static std::string number_text(unsigned long long value, unsigned char base, bool negative) {
+  std::string text;
+  do {
+    int digit = value % base;
+    text.insert(text.begin(), digit < 10 ? '0' + digit : 'a' + digit - 10);
+    value /= base;
+  } while (value != 0);
+  if (negative) text.insert(text.begin(), '-');
+  return text;
+}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+String::String(long value, unsigned char base)
+    : value_(base == DEC && value < 0 ? number_text(0UL - (unsigned long)value, base, true)
+                                      : number_text((unsigned long)value, base, false)) {}
+String::String(unsigned long value, unsigned char base) : value_(number_text(value, base, false)) {}
+
+// Native entry point
+
+void host_loop_tick() {
+  loop();
+  host_run_events();
+}
+
+// Unit test builds (pio test) bring their own main()
+#if !defined(HOST_NO_MAIN) && !defined(PIO_UNIT_TESTING)
+int main(int argc, char** argv) {
+  unsigned long duration_ms = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--virtual-time") == 0) {
+      host_set_virtual_time(true);
+    } else if (strcmp(argv[i], "--duration-ms") == 0 && i + 1 < argc) {
+      duration_ms = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--quiet") == 0) {
+      host_set_serial_output(false);
+    } else {
+      fprintf(stderr, "usage: %s [--virtual-time] [--duration-ms N] [--quiet]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  setup();
+  while (duration_ms == 0 || millis() < duration_ms) {
+    host_loop_tick();
+  }
+
+  // The task threads are still parked in delay() - leave without running destructors
+  fflush(stdout);
+  quick_exit(0);
+}
+#endif
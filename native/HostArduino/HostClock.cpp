@@ -0,0 +1,201 @@
+#include <Arduino.h>
+#include "HostHardware.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Host clock and event scheduler (see HostHardware.h)
+
+struct ScheduledEvent {
+  uint64_t at_us;
+  uint64_t sequence;  // Keeps events due at the same time in scheduling order
+  std::function<void()> run;
+};
+
+struct EventLater {
+  bool operator()(const ScheduledEvent& a, const ScheduledEvent& b) const {
+    return a.at_us != b.at_us ? a.at_us > b.at_us : a.sequence > b.sequence;
+  }
+};
+
+// Another thread that waits in delay() - a FreeRTOS task such as the MQTT task
+struct WorkerThread {
+  uint64_t wake_us;
+  bool waiting;
+};
+
+static std::mutex clock_mutex;
+static std::condition_variable clock_changed;
+static bool virtual_time = false;
+static std::atomic<uint64_t> virtual_us(0);
+static const std::chrono::steady_clock::time_point real_start = std::chrono::steady_clock::now();
+static const std::thread::id main_thread = std::this_thread::get_id();  // Static init runs on the main thread
+static std::map<std::thread::id, WorkerThread> workers;
+static std::priority_queue<ScheduledEvent, std::vector<ScheduledEvent>, EventLater> events;
+static uint64_t event_sequence = 0;
+
+void host_set_virtual_time(bool enabled) {
+  std::lock_guard<std::mutex> lock(clock_mutex);
+  virtual_time = enabled;
+}
+
+bool host_is_virtual_time() {
+  return virtual_time;
+}
+
+uint64_t host_micros64() {
+  if (virtual_time) {
+    return virtual_us.load(std::memory_order_acquire);
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - real_start).count();
+}
+
+void host_schedule_us(uint64_t delay_us, std::function<void()> event) {
+  uint64_t at = host_micros64() + delay_us;
+  std::lock_guard<std::mutex> lock(clock_mutex);
+  events.push({at, event_sequence++, std::move(event)});
+}
+
+void host_run_events() {
+  if (std::this_thread::get_id() != main_thread) {
+    return;  // Hardware events only ever preempt the main loop
+  }
+  for (;;) {
+    std::function<void()> run;
+    {
+      std::lock_guard<std::mutex> lock(clock_mutex);
+      if (events.empty() || events.top().at_us > host_micros64()) {
+        return;
+      }
+      run = events.top().run;
+      events.pop();
+    }
+    run();  // Unlocked - events may schedule further events
+  }
+}
+
+// A task created with xTaskCreatePinnedToCore() - counts as running until its first delay()
+void host_register_task(std::thread& thread) {
+  std::lock_guard<std::mutex> lock(clock_mutex);
+  workers.emplace(thread.get_id(), WorkerThread{0, false});  // Keeps the entry if it already waits
+}
+
+// Worker thread wait - virtual time parks the thread until the main thread moves the clock
+static void worker_wait_until(uint64_t target_us) {
+  if (!virtual_time) {
+    uint64_t now = host_micros64();
+    if (target_us > now) {
+      std::this_thread::sleep_for(std::chrono::microseconds(target_us - now));
+    }
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(clock_mutex);
+  WorkerThread& self = workers[std::this_thread::get_id()];
+  self.wake_us = target_us;
+  self.waiting = true;
+  clock_changed.notify_all();
+  clock_changed.wait(lock, [&self]() { return !self.waiting; });
+}
+
+// Virtual time: advance to the next thing that happens - an event, a worker waking up or
+// the main thread's own deadline - once every worker is parked
+static void advance_virtual_clock(uint64_t target_us) {
+  std::unique_lock<std::mutex> lock(clock_mutex);
+  clock_changed.wait(lock, []() {
+    for (const auto& worker : workers) {
+      if (!worker.second.waiting) return false;
+    }
+    return true;
+  });
+
+  uint64_t next = target_us;
+  if (!events.empty() && events.top().at_us < next) {
+    next = events.top().at_us;
+  }
+  for (const auto& worker : workers) {
+    if (worker.second.wake_us < next) {
+      next = worker.second.wake_us;
+    }
+  }
+  if (next > virtual_us.load(std::memory_order_relaxed)) {
+    virtual_us.store(next, std::memory_order_release);
+  }
+
+  // Mark the woken workers running before releasing the lock, so the next advance waits for them
+  bool woke = false;
+  for (auto& worker : workers) {
+    if (worker.second.waiting && worker.second.wake_us <= next) {
+      worker.second.waiting = false;
+      woke = true;
+    }
+  }
+  if (woke) {
+    clock_changed.notify_all();
+  }
+}
+
+// Main thread wait - runs the events due meanwhile and returns early once woken() holds
+// after one of them (a task notification from an interrupt handler)
+static void host_wait_until(uint64_t target_us, const std::function<bool()>& woken = nullptr) {
+  if (std::this_thread::get_id() != main_thread) {
+    worker_wait_until(target_us);
+    return;
+  }
+
+  for (;;) {
+    host_run_events();
+    uint64_t now = host_micros64();
+    if (now >= target_us || (woken && woken())) {
+      return;
+    }
+    if (virtual_time) {
+      advance_virtual_clock(target_us);
+      continue;
+    }
+
+    uint64_t next = target_us;
+    {
+      std::lock_guard<std::mutex> lock(clock_mutex);
+      if (!events.empty() && events.top().at_us < next) {
+        next = events.top().at_us;
+      }
+    }
+    // Short sleeps keep events scheduled meanwhile on time
+    uint64_t sleep_us = next > now ? next - now : 0;
+    std::this_thread::sleep_for(std::chrono::microseconds(sleep_us < 1000 ? sleep_us : 1000));
+  }
+}
+
+void host_wait_until_woken(uint64_t target_us, const std::function<bool()>& woken) {
+  host_wait_until(target_us, woken);
+}
+
+void host_advance_us(uint32_t us) {
+  host_wait_until(host_micros64() + us);
+}
+
+unsigned long millis() {
+  return (unsigned long)(host_micros64() / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)host_micros64();
+}
+
+void delay(uint32_t ms) {
+  host_wait_until(host_micros64() + (uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+  host_wait_until(host_micros64() + us);
+}
+
+void yield() {
+  host_run_events();
+}
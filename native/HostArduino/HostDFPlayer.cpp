@@ -0,0 +1,167 @@
+#include <Arduino.h>
+#include "HostHardware.h"
+#include <TrackManifest.h>
+#include <map>
+
+// Simulated DFPlayer Mini (see HostHardware.h)
+// Speaks the module's 10-byte serial protocol: 7E FF 06 CMD ACK PARAM_H PARAM_L CHECK_H CHECK_L EF
+
+#define FRAME_SIZE 10
+#define DEFAULT_TRACK_DURATION_MS 3000  // Tracks TrackManifest.h doesn't list
+
+class HostDFPlayer : public HostUARTDevice {
+public:
+  bool present = true;
+  bool busy_wired = true;        // false = BUSY left unconnected, the firmware's pull-up reads idle
+  uint16_t file_count = 13;
+  uint16_t playing_track = 0;
+  uint32_t play_generation = 0;  // Cancels the end of a track that was stopped or replaced
+  std::map<uint16_t, uint32_t> track_durations;
+  std::function<void(uint8_t, uint16_t)> listener;
+
+  void receive(const uint8_t* data, size_t length) override {
+    for (size_t i = 0; i < length; i++) {
+      receive_byte(data[i]);
+    }
+  }
+
+private:
+  uint8_t frame_[FRAME_SIZE];
+
+  // The simulated card holds the files TrackManifest.h was generated from
+  static uint32_t default_duration_ms(uint16_t track) {
+    if (track >= 1 && track <= TRACK_MANIFEST_COUNT && TRACK_MANIFEST[track].duration_ms > 0) {
+      return TRACK_MANIFEST[track].duration_ms;
+    }
+    return DEFAULT_TRACK_DURATION_MS;
+  }
+
+  size_t frame_length_ = 0;
+
+  static uint16_t checksum(const uint8_t* frame) {
+    uint16_t sum = 0;
+    for (int i = 1; i < 7; i++) {
+      sum += frame[i];
+    }
+    return -sum;
+  }
+
+  void receive_byte(uint8_t b) {
+    if (frame_length_ == 0 && b != 0x7E) return;
+    frame_[frame_length_++] = b;
+    if (frame_length_ < FRAME_SIZE) return;
+    frame_length_ = 0;
+
+    uint16_t check = ((uint16_t)frame_[7] << 8) | frame_[8];
+    if (frame_[9] != 0xEF || check != checksum(frame_)) return;  // Real modules ignore bad frames
+    handle_command(frame_[3], frame_[4] != 0, ((uint16_t)frame_[5] << 8) | frame_[6]);
+  }
+
+  void reply(uint64_t delay_us, uint8_t command, uint16_t param) {
+    host_schedule_us(delay_us, [command, param]() {
+      uint8_t frame[FRAME_SIZE] = {0x7E, 0xFF, 0x06, command, 0x00,
+                                   (uint8_t)(param >> 8), (uint8_t)(param & 0xFF), 0, 0, 0xEF};
+      uint16_t check = checksum(frame);
+      frame[7] = check >> 8;
+      frame[8] = check & 0xFF;
+      host_uart_send(HOST_DFPLAYER_UART, frame, FRAME_SIZE);
+    });
+  }
+
+  void set_busy(int level) {
+    if (busy_wired) host_set_pin(HOST_DFPLAYER_BUSY_PIN, level);
+  }
+
+  void stop_track() {
+    play_generation++;
+    playing_track = 0;
+    set_busy(HIGH);
+  }
+
+  void play_track(uint16_t track) {
+    if (playing_track != 0) {
+      stop_track();  // BUSY blips high when one track replaces another
+    }
+    uint32_t generation = ++play_generation;
+    auto duration = track_durations.find(track);
+    uint32_t duration_ms = duration != track_durations.end() ? duration->second : default_duration_ms(track);
+
+    host_schedule_us(HOST_DFPLAYER_PLAY_LATENCY_US, [this, generation, track]() {
+      if (generation != play_generation) return;
+      playing_track = track;
+      set_busy(LOW);
+    });
+    host_schedule_us(HOST_DFPLAYER_PLAY_LATENCY_US + (uint64_t)duration_ms * 1000, [this, generation, track]() {
+      if (generation != play_generation) return;
+      stop_track();
+      reply(0, 0x3D, track);  // Finished playing from the SD card
+    });
+  }
+
+  void handle_command(uint8_t command, bool ack, uint16_t param) {
+    if (!present) return;
+    if (listener) listener(command, param);
+
+    switch (command) {
+      case 0x0C:  // Reset
+        stop_track();
+        reply(HOST_DFPLAYER_BOOT_US, 0x3F, 0x02);  // Online, SD card present
+        return;
+      case 0x03:  // Play track
+      case 0x0F:  // Play folder track
+        if (command == 0x03 && (param == 0 || param > file_count)) {
+          reply(HOST_DFPLAYER_REPLY_US, 0x40, 0x05);  // File index out of bounds - replaces the ACK
+          return;
+        }
+        play_track(param);
+        break;
+      case 0x16:  // Stop
+        stop_track();
+        break;
+      case 0x42:  // Query status
+        reply(HOST_DFPLAYER_REPLY_US, 0x42, playing_track != 0 ? 0x0201 : 0x0200);
+        break;
+      case 0x48:  // Query SD file count
+        reply(HOST_DFPLAYER_REPLY_US, 0x48, file_count);
+        break;
+      default:
+        break;
+    }
+    if (ack) {
+      reply(HOST_DFPLAYER_REPLY_US, 0x41, 0);
+    }
+  }
+};
+
+static HostDFPlayer dfplayer;
+
+HostUARTDevice* host_default_uart_device(int uart) {
+  return uart == HOST_DFPLAYER_UART ? &dfplayer : nullptr;
+}
+
+void host_dfplayer_set_present(bool present) {
+  dfplayer.present = present;
+}
+
+void host_dfplayer_set_busy_wired(bool wired) {
+  if (!wired) {
+    host_set_pin(HOST_DFPLAYER_BUSY_PIN, HIGH);  // What the pull-up reads from here on
+  }
+  dfplayer.busy_wired = wired;
+}
+
+void host_dfplayer_set_file_count(uint16_t files) {
+  dfplayer.file_count = files;
+}
+
+void host_dfplayer_set_track_duration(uint16_t track, uint32_t duration_ms) {
+  dfplayer.track_durations[track] = duration_ms;
+}
+
+void host_dfplayer_on_command(std::function<void(uint8_t command, uint16_t param)> listener) {
+  dfplayer.listener = std::move(listener);
+}
+
+uint16_t host_dfplayer_playing_track() {
+  return dfplayer.playing_track;
+}
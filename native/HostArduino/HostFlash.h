@@ -0,0 +1,25 @@
+#ifndef HOST_FLASH_H
+#define HOST_FLASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Simulated flash behind the esp_partition API (esp_partition.h) for the native environment
+//
+// The "spiffs" partition lives in RAM unless a file backs it: then every write and erase goes
+// through to the file, and attaching the same file again is a reboot - the firmware finds
+// exactly the bytes that reached flash.
+//
+// Power cuts: after a given number of further writes/erases, the next one is torn (only its
+// first bytes land) and nothing after it reaches flash until power is restored. The firmware
+// keeps running meanwhile, as if the cut came after its last instruction.
+
+// Back the partition with a file, loading what it holds (created erased if missing)
+bool host_flash_attach_file(const char* path);
+
+void host_flash_power_cut_after(uint32_t operations, size_t torn_bytes);
+void host_flash_restore_power();
+bool host_flash_powered();
+uint32_t host_flash_operation_count();  // Writes and erases issued since boot
+
+#endif // HOST_FLASH_H
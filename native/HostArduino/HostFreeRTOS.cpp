@@ -0,0 +1,66 @@
+#include <Arduino.h>
+#include "HostHardware.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+void host_register_task(std::thread& thread);  // HostClock.cpp
+void host_wait_until_woken(uint64_t target_us, const std::function<bool()>& woken);
+
+struct HostTask {
+  std::atomic<uint32_t> notifications{0};
+};
+
+static thread_local BaseType_t task_core = 1;  // Arduino's loop task runs on core 1
+static thread_local HostTask current_task;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack_depth, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core_id) {
+  std::thread thread([task, parameter, core_id]() {
+    task_core = core_id == tskNO_AFFINITY ? 0 : core_id;
+    task(parameter);
+  });
+  // Known to the clock before it runs - virtual time waits for it from the start
+  host_register_task(thread);
+  thread.detach();
+  if (handle != nullptr) {
+    *handle = nullptr;
+  }
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char* name, uint32_t stack_depth, void* parameter,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(task, name, stack_depth, parameter, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  delay(ticks * portTICK_PERIOD_MS);
+}
+
+BaseType_t xPortGetCoreID() {
+  return task_core;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return &current_task;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken) {
+  static_cast<HostTask*>(task)->notifications++;
+  if (higher_priority_task_woken != nullptr) {
+    *higher_priority_task_woken = pdTRUE;
+  }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait) {
+  HostTask& self = current_task;
+  if (self.notifications.load() == 0) {
+    host_wait_until_woken(host_micros64() + (uint64_t)ticks_to_wait * portTICK_PERIOD_MS * 1000,
+                          [&self]() { return self.notifications.load() > 0; });
+  }
+  uint32_t count = self.notifications.load();
+  while (count > 0 && !self.notifications.compare_exchange_weak(count, clear_count_on_exit ? 0 : count - 1)) {
+  }
+  return count;
+}
@@ -0,0 +1,38 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+
+// Host stand-in for the FreeRTOS task calls the firmware uses (native environment only)
+// Each task is a host thread that runs in lock step with the virtual clock (HostHardware.h).
+// Core affinity is recorded but not enforced - the host schedules threads itself.
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void*);
+typedef void* TaskHandle_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define portYIELD_FROM_ISR(woken) ((void)(woken))  // Interrupt handlers already run on the waiting thread
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack_depth, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core_id);
+BaseType_t xTaskCreate(TaskFunction_t task, const char* name, uint32_t stack_depth, void* parameter,
+                       UBaseType_t priority, TaskHandle_t* handle);
+void vTaskDelay(TickType_t ticks);
+BaseType_t xPortGetCoreID();  // Core the calling task was pinned to (the loop task runs on core 1)
+TaskHandle_t xTaskGetCurrentTaskHandle();
+
+// Direct-to-task notifications, counting semaphore style - only the main thread (loop task)
+// is woken early, by interrupt handlers the clock runs while it waits
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait);
+
+#endif // HOST_FREERTOS_H
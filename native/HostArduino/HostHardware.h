@@ -0,0 +1,75 @@
+#ifndef HOST_HARDWARE_H
+#define HOST_HARDWARE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+// Simulated hardware for the native environment
+//
+// The firmware runs on the host against stand-ins for the ESP32 peripherals. Each stand-in
+// models the time its real counterpart takes (I2C transactions, UART wire time, LED frames)
+// so loop latency, tap-to-sound time and cooldown can be measured without a board.
+//
+// Time runs in one of two modes:
+//   Real:    millis() follows the host clock, delay() sleeps
+//   Virtual: millis() only moves when the firmware waits (delay()) or a stand-in models a
+//            blocking transfer (host_advance_us()). Runs as fast as the host allows and is
+//            repeatable - what CI uses. FreeRTOS tasks (HostFreeRTOS.h - network, MQTT, log) run
+//            in lock step: time only advances once every task is waiting in delay().
+//
+// Hardware events (card taps, DFPlayer replies, BUSY edges) are scheduled on the clock and
+// run on the main thread, the way interrupts preempt the Arduino loop.
+
+// Clock
+void host_set_virtual_time(bool enabled);  // Call before setup()
+bool host_is_virtual_time();
+uint64_t host_micros64();
+void host_advance_us(uint32_t us);         // Time spent inside a blocking driver call
+
+// Scheduled hardware events - run on the main thread once the clock reaches them
+void host_schedule_us(uint64_t delay_us, std::function<void()> event);
+void host_run_events();                    // Run everything that is due
+
+// GPIO - drive an input as external hardware would; attached interrupts fire on the edge
+void host_set_pin(uint8_t pin, int level);
+int host_get_pin(uint8_t pin);
+
+// UART devices attached to HardwareSerial(uart)
+class HostUARTDevice {
+public:
+  virtual ~HostUARTDevice() {}
+  virtual void receive(const uint8_t* data, size_t length) = 0;  // Bytes the firmware wrote
+};
+void host_uart_attach(int uart, HostUARTDevice* device);
+void host_uart_send(int uart, const uint8_t* data, size_t length);  // To the firmware, after wire time
+uint32_t host_uart_byte_time_us(int uart);                          // 10 bits at the configured baud
+
+// Simulated DFPlayer Mini on UART 2 with BUSY on GPIO27 (AudioControlDFPlayer.h wiring)
+// Acknowledges commands, reports the SD card's file count, drives BUSY while a track plays
+// and sends the finished notification when it ends.
+#define HOST_DFPLAYER_UART 2
+#define HOST_DFPLAYER_BUSY_PIN 27
+#define HOST_DFPLAYER_REPLY_US 5000         // Command received to reply sent
+#define HOST_DFPLAYER_PLAY_LATENCY_US 80000 // Play command to BUSY low (SD read and decode)
+#define HOST_DFPLAYER_BOOT_US 1000000       // Reset to the "online" message
+
+void host_dfplayer_set_present(bool present);      // false = module never answers
+void host_dfplayer_set_busy_wired(bool wired);     // false = BUSY not connected to GPIO27
+void host_dfplayer_set_file_count(uint16_t files);
+void host_dfplayer_set_track_duration(uint16_t track, uint32_t duration_ms);  // Default: TrackManifest.h
+void host_dfplayer_on_command(std::function<void(uint8_t command, uint16_t param)> listener);
+uint16_t host_dfplayer_playing_track();            // 0 when idle
+
+// Console
+void host_set_serial_output(bool enabled);  // Mute Serial (e.g. while benchmarking)
+
+// Native main - parses the options below, then runs setup() and loop()
+//   --virtual-time     Use virtual time (default: real time)
+//   --duration-ms N    Stop after N ms of firmware time (default: run forever)
+//   --quiet            Mute Serial
+// Build with -D HOST_NO_MAIN to provide your own main() (scripted scenarios, benchmarks) -
+// unit tests (pio test -e native) leave it out automatically
+void host_loop_tick();  // One loop() pass, then any hardware events that fell due
+
+#endif // HOST_HARDWARE_H
@@ -0,0 +1,20 @@
+#ifndef IPADDRESS_H
+#define IPADDRESS_H
+
+#include <Arduino.h>
+
+class IPAddress : public Printable {
+public:
+  IPAddress() : bytes_{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes_{a, b, c, d} {}
+  uint8_t operator[](int index) const { return bytes_[index]; }
+
+  size_t printTo(Print& p) const override {
+    return p.printf("%u.%u.%u.%u", bytes_[0], bytes_[1], bytes_[2], bytes_[3]);
+  }
+
+private:
+  uint8_t bytes_[4];
+};
+
+#endif // IPADDRESS_H
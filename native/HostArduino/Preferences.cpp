@@ -0,0 +1,67 @@
+#include "Preferences.h"
+#include <map>
+#include <mutex>
+#include <vector>
+
+// NVS limits: 15-character namespace and key names
+#define NVS_NAME_MAX 15
+
+typedef std::map<std::string, std::vector<uint8_t>> PreferencesNamespace;
+
+static std::mutex nvs_mutex;
+static std::map<std::string, PreferencesNamespace> nvs;
+
+bool Preferences::begin(const char* name, bool read_only) {
+  if (open_ || name == nullptr || strlen(name) > NVS_NAME_MAX) return false;
+  namespace_ = name;
+  read_only_ = read_only;
+  open_ = true;
+  return true;
+}
+
+void Preferences::end() {
+  open_ = false;
+}
+
+bool Preferences::clear() {
+  if (!open_ || read_only_) return false;
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  nvs[namespace_].clear();
+  return true;
+}
+
+bool Preferences::remove(const char* key) {
+  if (!open_ || read_only_) return false;
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  return nvs[namespace_].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+  return getBytesLength(key) > 0;
+}
+
+size_t Preferences::put(const char* key, const void* value, size_t length) {
+  if (!open_ || read_only_ || key == nullptr || strlen(key) > NVS_NAME_MAX) return 0;
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  const uint8_t* bytes = (const uint8_t*)value;
+  nvs[namespace_][key].assign(bytes, bytes + length);
+  return length;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  if (!open_) return 0;
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  PreferencesNamespace& entries = nvs[namespace_];
+  auto entry = entries.find(key);
+  return entry != entries.end() ? entry->second.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t max_length) {
+  if (!open_) return 0;
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  PreferencesNamespace& entries = nvs[namespace_];
+  auto entry = entries.find(key);
+  if (entry == entries.end() || entry->second.size() > max_length) return 0;  // Too small = nothing, as on NVS
+  memcpy(buffer, entry->second.data(), entry->second.size());
+  return entry->second.size();
+}
@@ -0,0 +1,43 @@
+#ifndef PREFERENCES_H
+#define PREFERENCES_H
+
+#include <Arduino.h>
+
+// Host stand-in for the NVS-backed Preferences library
+// Namespaces live in memory for the life of the process - a restart of the program is a
+// factory-fresh board. Same API and size limits as the ESP32 version for what lib/ uses.
+class Preferences {
+public:
+  bool begin(const char* name, bool read_only = false);
+  void end();
+  bool clear();
+  bool remove(const char* key);
+  bool isKey(const char* key);
+
+  size_t putUChar(const char* key, uint8_t value) { return put(key, &value, sizeof(value)); }
+  size_t putUShort(const char* key, uint16_t value) { return put(key, &value, sizeof(value)); }
+  size_t putUInt(const char* key, uint32_t value) { return put(key, &value, sizeof(value)); }
+  size_t putBool(const char* key, bool value) { return putUChar(key, value ? 1 : 0); }
+  size_t putBytes(const char* key, const void* value, size_t length) { return put(key, value, length); }
+
+  uint8_t getUChar(const char* key, uint8_t default_value = 0) { return get(key, default_value); }
+  uint16_t getUShort(const char* key, uint16_t default_value = 0) { return get(key, default_value); }
+  uint32_t getUInt(const char* key, uint32_t default_value = 0) { return get(key, default_value); }
+  bool getBool(const char* key, bool default_value = false) { return getUChar(key, default_value ? 1 : 0) != 0; }
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buffer, size_t max_length);
+
+private:
+  std::string namespace_;
+  bool open_ = false;
+  bool read_only_ = false;
+
+  size_t put(const char* key, const void* value, size_t length);
+  template <typename T>
+  T get(const char* key, T default_value) {
+    T value;
+    return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : default_value;
+  }
+};
+
+#endif // PREFERENCES_H
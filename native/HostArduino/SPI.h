@@ -0,0 +1,15 @@
+#ifndef SPI_H
+#define SPI_H
+
+#include <Arduino.h>
+
+// Host stand-in for the SPI bus (only the PN532's SPI wiring option refers to it)
+class SPIClass {
+public:
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+  void end() {}
+};
+
+extern SPIClass SPI;
+
+#endif // SPI_H
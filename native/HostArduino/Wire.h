@@ -0,0 +1,20 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+
+// Host stand-in for the I2C bus - the PN532 stand-in (Adafruit_PN532.h) models its own
+// transaction time, so the bus itself only needs to accept configuration
+class TwoWire {
+public:
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { if (frequency) clock_ = frequency; return true; }
+  void setClock(uint32_t frequency) { clock_ = frequency; }
+  uint32_t getClock() const { return clock_; }
+
+private:
+  uint32_t clock_ = 100000;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H
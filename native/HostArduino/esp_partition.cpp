@@ -0,0 +1,129 @@
+#include "esp_partition.h"
+#include "HostFlash.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+static const esp_partition_t spiffs_partition = {
+  ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, 0x290000, HOST_PARTITION_SIZE, "spiffs", false
+};
+
+// Contents allocated on first use, erased
+static std::vector<uint8_t>& partition_data() {
+  static std::vector<uint8_t> data(HOST_PARTITION_SIZE, 0xFF);
+  return data;
+}
+
+// Backing file and power cut state (HostFlash.h)
+static FILE* backing_file = nullptr;
+static uint32_t operation_count = 0;
+static bool power_cut_armed = false;
+static uint32_t operations_before_cut = 0;
+static size_t torn_bytes = 0;
+static bool powered = true;
+
+// How many bytes of the next write or erase reach flash
+static size_t landed_bytes(size_t size) {
+  operation_count++;
+  if (!powered) return 0;
+  if (!power_cut_armed || operations_before_cut-- > 0) return size;
+  powered = false;  // This is the operation the cut interrupts
+  power_cut_armed = false;
+  return torn_bytes < size ? torn_bytes : size;
+}
+
+static void write_through(size_t offset, size_t size) {
+  if (backing_file == nullptr || size == 0) return;
+  fseek(backing_file, (long)offset, SEEK_SET);
+  fwrite(partition_data().data() + offset, 1, size, backing_file);
+  fflush(backing_file);
+}
+
+static bool in_range(const esp_partition_t* partition, size_t offset, size_t size) {
+  return partition == &spiffs_partition && offset <= partition->size && size <= partition->size - offset;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+  if (type != spiffs_partition.type) return nullptr;
+  if (subtype != ESP_PARTITION_SUBTYPE_ANY && subtype != spiffs_partition.subtype) return nullptr;
+  if (label != nullptr && strcmp(label, spiffs_partition.label) != 0) return nullptr;
+  return &spiffs_partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size) {
+  if (!in_range(partition, offset, size)) return ESP_ERR_INVALID_SIZE;
+  memcpy(dst, partition_data().data() + offset, size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* src, size_t size) {
+  if (!in_range(partition, offset, size)) return ESP_ERR_INVALID_SIZE;
+  const uint8_t* bytes = (const uint8_t*)src;
+  uint8_t* flash = partition_data().data() + offset;
+  size_t landed = landed_bytes(size);
+  for (size_t i = 0; i < landed; i++) {
+    flash[i] &= bytes[i];  // NOR flash only programs 1 -> 0
+  }
+  write_through(offset, landed);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+  if (offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) return ESP_ERR_INVALID_ARG;
+  if (!in_range(partition, offset, size)) return ESP_ERR_INVALID_SIZE;
+  size_t landed = landed_bytes(size);
+  memset(partition_data().data() + offset, 0xFF, landed);
+  write_through(offset, landed);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             spi_flash_mmap_memory_t memory, const void** out_ptr,
+                             spi_flash_mmap_handle_t* out_handle) {
+  if (!in_range(partition, offset, size)) return ESP_ERR_INVALID_SIZE;
+  *out_ptr = partition_data().data() + offset;
+  *out_handle = 1;
+  return ESP_OK;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle) {}
+
+bool host_flash_attach_file(const char* path) {
+  if (backing_file != nullptr) {
+    fclose(backing_file);
+  }
+  backing_file = fopen(path, "r+b");
+  if (backing_file == nullptr) {
+    backing_file = fopen(path, "w+b");  // New file - starts erased
+    if (backing_file == nullptr) return false;
+    std::fill(partition_data().begin(), partition_data().end(), 0xFF);
+    write_through(0, HOST_PARTITION_SIZE);
+    return true;
+  }
+  std::vector<uint8_t>& data = partition_data();
+  std::fill(data.begin(), data.end(), 0xFF);
+  fseek(backing_file, 0, SEEK_SET);
+  size_t loaded = fread(data.data(), 1, data.size(), backing_file);
+  return loaded == data.size();
+}
+
+void host_flash_power_cut_after(uint32_t operations, size_t torn) {
+  power_cut_armed = true;
+  operations_before_cut = operations;
+  torn_bytes = torn;
+}
+
+void host_flash_restore_power() {
+  power_cut_armed = false;
+  powered = true;
+}
+
+bool host_flash_powered() {
+  return powered;
+}
+
+uint32_t host_flash_operation_count() {
+  return operation_count;
+}
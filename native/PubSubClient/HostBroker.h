@@ -0,0 +1,28 @@
+#ifndef HOST_BROKER_H
+#define HOST_BROKER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+
+// In-process MQTT broker for the native environment
+// Keeps retained messages, honors + and # in subscriptions and publishes a client's will
+// when its session is dropped. The device's messages arrive on the MQTT task thread, so
+// listeners must be thread-safe. Messages published here reach the device on its next
+// client loop().
+#define HOST_BROKER_CONNECT_US 15000    // TCP and MQTT handshake on a LAN
+
+void host_broker_set_online(bool online);  // false refuses connects and drops sessions
+void host_broker_drop_sessions();          // Broker restart - sessions lost, wills published
+
+// Publish as another client (e.g. Home Assistant) - retained messages are kept for later subscribers
+void host_broker_publish(const char* topic, const void* payload, size_t length, bool retain);
+void host_broker_publish(const char* topic, const char* payload, bool retain);
+
+bool host_broker_retained(const char* topic, std::string* payload);  // false if nothing retained
+uint32_t host_broker_message_count();                                // Messages published by the device
+void host_broker_on_publish(std::function<void(const char* topic, const uint8_t* payload, size_t length,
+                                               bool retain)> listener);
+
+#endif // HOST_BROKER_H
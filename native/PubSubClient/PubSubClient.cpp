@@ -0,0 +1,296 @@
+#include "PubSubClient.h"
+#include "HostBroker.h"
+#include <HostHardware.h>
+#include <HostWiFi.h>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Fixed header plus the two-byte topic length of a PUBLISH packet
+#define MQTT_PUBLISH_OVERHEAD 5
+
+struct HostBrokerMessage {
+  std::string topic;
+  std::string payload;
+};
+
+struct HostBrokerSession {
+  bool alive = true;
+  std::vector<std::string> subscriptions;
+  std::deque<HostBrokerMessage> inbox;
+  std::string will_topic;
+  std::string will_message;
+  bool will_retain = false;
+};
+
+static std::mutex broker_mutex;
+static bool broker_online = true;
+static std::list<std::shared_ptr<HostBrokerSession>> broker_sessions;
+static std::map<std::string, std::string> broker_retained;
+static uint32_t broker_device_messages = 0;
+static std::function<void(const char*, const uint8_t*, size_t, bool)> broker_listener;
+
+// MQTT topic filter match - "+" is one level, a trailing "#" is any number of levels
+static bool topic_matches(const std::string& filter, const std::string& topic) {
+  size_t f = 0, t = 0;
+  while (f < filter.size()) {
+    if (filter[f] == '#') return true;
+    if (filter[f] == '+') {
+      while (t < topic.size() && topic[t] != '/') t++;
+      f++;
+    } else {
+      if (t >= topic.size() || filter[f] != topic[t]) return false;
+      f++;
+      t++;
+    }
+  }
+  return t == topic.size();
+}
+
+// Caller holds broker_mutex
+static void route_message(const std::string& topic, const std::string& payload, bool retain) {
+  if (retain) {
+    if (payload.empty()) {
+      broker_retained.erase(topic);
+    } else {
+      broker_retained[topic] = payload;
+    }
+  }
+  for (auto& session : broker_sessions) {
+    for (const std::string& filter : session->subscriptions) {
+      if (topic_matches(filter, topic)) {
+        session->inbox.push_back({topic, payload});
+        break;
+      }
+    }
+  }
+}
+
+// Caller holds broker_mutex
+static void drop_sessions() {
+  std::list<std::shared_ptr<HostBrokerSession>> dropped;
+  dropped.swap(broker_sessions);
+  for (auto& session : dropped) {
+    session->alive = false;
+    if (!session->will_topic.empty()) {
+      route_message(session->will_topic, session->will_message, session->will_retain);
+    }
+  }
+}
+
+static void device_published(const std::string& topic, const std::string& payload, bool retain) {
+  std::function<void(const char*, const uint8_t*, size_t, bool)> listener;
+  {
+    std::lock_guard<std::mutex> lock(broker_mutex);
+    route_message(topic, payload, retain);
+    broker_device_messages++;
+    listener = broker_listener;
+  }
+  if (listener) {
+    listener(topic.c_str(), (const uint8_t*)payload.data(), payload.size(), retain);
+  }
+}
+
+void host_broker_set_online(bool online) {
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  broker_online = online;
+  if (!online) {
+    drop_sessions();
+  }
+}
+
+void host_broker_drop_sessions() {
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  drop_sessions();
+}
+
+void host_broker_publish(const char* topic, const void* payload, size_t length, bool retain) {
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  route_message(topic, std::string((const char*)payload, length), retain);
+}
+
+void host_broker_publish(const char* topic, const char* payload, bool retain) {
+  host_broker_publish(topic, payload, strlen(payload), retain);
+}
+
+bool host_broker_retained(const char* topic, std::string* payload) {
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  auto entry = broker_retained.find(topic);
+  if (entry == broker_retained.end()) return false;
+  if (payload != nullptr) *payload = entry->second;
+  return true;
+}
+
+uint32_t host_broker_message_count() {
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  return broker_device_messages;
+}
+
+void host_broker_on_publish(std::function<void(const char* topic, const uint8_t* payload, size_t length,
+                                               bool retain)> listener) {
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  broker_listener = std::move(listener);
+}
+
+// PubSubClient
+
+PubSubClient::PubSubClient() {}
+PubSubClient::PubSubClient(Client& client) {}
+
+PubSubClient::~PubSubClient() {
+  disconnect();
+}
+
+bool PubSubClient::connect(const char* id) {
+  return connect(id, nullptr, nullptr, nullptr, 0, false, nullptr);
+}
+
+bool PubSubClient::connect(const char* id, const char* user, const char* pass) {
+  return connect(id, user, pass, nullptr, 0, false, nullptr);
+}
+
+bool PubSubClient::connect(const char* id, const char* user, const char* pass, const char* will_topic,
+                           uint8_t will_qos, bool will_retain, const char* will_message) {
+  if (connected()) return true;
+
+  if (!host_wifi_connected()) {
+    host_advance_us((uint32_t)socket_timeout_s_ * 1000000);  // No route - the socket times out
+    state_ = MQTT_CONNECTION_TIMEOUT;
+    return false;
+  }
+  host_advance_us(HOST_BROKER_CONNECT_US);
+
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  if (!broker_online) {
+    state_ = MQTT_CONNECT_FAILED;  // Connection refused
+    return false;
+  }
+  auto session = std::make_shared<HostBrokerSession>();
+  if (will_topic != nullptr) {
+    session->will_topic = will_topic;
+    session->will_message = will_message != nullptr ? will_message : "";
+    session->will_retain = will_retain;
+  }
+  broker_sessions.push_back(session);
+  session_ = session;
+  state_ = MQTT_CONNECTED;
+  return true;
+}
+
+void PubSubClient::disconnect() {
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  if (session_ == nullptr) return;
+  // A clean disconnect discards the will
+  broker_sessions.remove(session_);
+  session_.reset();
+  state_ = MQTT_DISCONNECTED;
+}
+
+bool PubSubClient::connected() {
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  if (session_ == nullptr) return false;
+  if (session_->alive && host_wifi_connected()) return true;
+
+  if (session_->alive) {
+    // WiFi dropped under the session - the broker sees the socket die and sends the will
+    session_->alive = false;
+    broker_sessions.remove(session_);
+    if (!session_->will_topic.empty()) {
+      route_message(session_->will_topic, session_->will_message, session_->will_retain);
+    }
+  }
+  session_.reset();
+  state_ = MQTT_CONNECTION_LOST;
+  return false;
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload, bool retained) {
+  return publish(topic, (const uint8_t*)payload, payload != nullptr ? strlen(payload) : 0, retained);
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+  if (!connected()) return false;
+  if (MQTT_PUBLISH_OVERHEAD + strlen(topic) + length > buffer_size_) return false;
+  device_published(topic, std::string((const char*)payload, length), retained);
+  return true;
+}
+
+bool PubSubClient::beginPublish(const char* topic, unsigned int length, bool retained) {
+  if (!connected()) return false;
+  stream_topic_ = topic;
+  stream_payload_.clear();
+  stream_length_ = length;
+  stream_retained_ = retained;
+  streaming_ = true;
+  return true;
+}
+
+size_t PubSubClient::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t PubSubClient::write(const uint8_t* buffer, size_t size) {
+  if (!streaming_) return 0;
+  stream_payload_.insert(stream_payload_.end(), buffer, buffer + size);
+  return size;
+}
+
+int PubSubClient::endPublish() {
+  if (!streaming_) return 0;
+  streaming_ = false;
+  if (stream_payload_.size() != stream_length_ || !connected()) return 0;
+  device_published(stream_topic_, std::string(stream_payload_.begin(), stream_payload_.end()), stream_retained_);
+  return 1;
+}
+
+bool PubSubClient::subscribe(const char* topic, uint8_t qos) {
+  if (!connected()) return false;
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  session_->subscriptions.push_back(topic);
+  // Retained messages go to each new subscription
+  for (const auto& retained : broker_retained) {
+    if (topic_matches(topic, retained.first)) {
+      session_->inbox.push_back({retained.first, retained.second});
+    }
+  }
+  return true;
+}
+
+bool PubSubClient::unsubscribe(const char* topic) {
+  if (!connected()) return false;
+  std::lock_guard<std::mutex> lock(broker_mutex);
+  auto& subscriptions = session_->subscriptions;
+  for (auto it = subscriptions.begin(); it != subscriptions.end(); ++it) {
+    if (*it == topic) {
+      subscriptions.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Deliver everything waiting for this client - runs the callback unlocked
+bool PubSubClient::loop() {
+  if (!connected()) return false;
+  for (;;) {
+    HostBrokerMessage message;
+    {
+      std::lock_guard<std::mutex> lock(broker_mutex);
+      if (session_->inbox.empty()) break;
+      message = std::move(session_->inbox.front());
+      session_->inbox.pop_front();
+    }
+    if (MQTT_PUBLISH_OVERHEAD + message.topic.size() + message.payload.size() > buffer_size_) {
+      continue;  // Too large for the client's buffer - PubSubClient drops it
+    }
+    if (callback) {
+      std::vector<char> topic(message.topic.begin(), message.topic.end());
+      topic.push_back('\0');
+      std::vector<uint8_t> payload(message.payload.begin(), message.payload.end());
+      callback(topic.data(), payload.data(), payload.size());
+    }
+  }
+  return true;
+}
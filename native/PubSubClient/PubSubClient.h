@@ -0,0 +1,79 @@
+#ifndef PUBSUBCLIENT_H
+#define PUBSUBCLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Host stand-in for PubSubClient (native environment only)
+// Connects to the in-process broker in HostBroker.h instead of a socket. Same return
+// values and limits: publish() fails above the buffer size, incoming messages that
+// don't fit the buffer are dropped, and nothing works while WiFi is down.
+
+#define MQTT_VERSION_3_1_1 4
+#define MQTT_MAX_PACKET_SIZE 256
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+struct HostBrokerSession;
+
+class PubSubClient : public Print {
+public:
+  PubSubClient();
+  explicit PubSubClient(Client& client);
+  ~PubSubClient();
+
+  PubSubClient& setServer(const char* domain, uint16_t port) { return *this; }
+  PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE) { this->callback = callback; return *this; }
+  PubSubClient& setClient(Client& client) { return *this; }
+  PubSubClient& setKeepAlive(uint16_t keep_alive) { return *this; }
+  PubSubClient& setSocketTimeout(uint16_t timeout) { socket_timeout_s_ = timeout; return *this; }
+  bool setBufferSize(uint16_t size) { buffer_size_ = size; return true; }
+  uint16_t getBufferSize() { return buffer_size_; }
+
+  bool connect(const char* id);
+  bool connect(const char* id, const char* user, const char* pass);
+  bool connect(const char* id, const char* user, const char* pass, const char* will_topic, uint8_t will_qos,
+               bool will_retain, const char* will_message);
+  void disconnect();
+
+  bool publish(const char* topic, const char* payload, bool retained = false);
+  bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained = false);
+
+  // Streamed publish - the payload is written in pieces, no buffer limit
+  bool beginPublish(const char* topic, unsigned int length, bool retained);
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  int endPublish();
+
+  bool subscribe(const char* topic, uint8_t qos = 0);
+  bool unsubscribe(const char* topic);
+  bool loop();
+  bool connected();
+  int state() { return state_; }
+
+private:
+  MQTT_CALLBACK_SIGNATURE;
+  std::shared_ptr<HostBrokerSession> session_;  // Shared with the broker, which may drop it
+  uint16_t buffer_size_ = MQTT_MAX_PACKET_SIZE;
+  uint16_t socket_timeout_s_ = 15;
+  int state_ = MQTT_DISCONNECTED;
+
+  // Streamed publish in progress
+  std::string stream_topic_;
+  std::vector<uint8_t> stream_payload_;
+  unsigned int stream_length_ = 0;
+  bool stream_retained_ = false;
+  bool streaming_ = false;
+};
+
+#endif // PUBSUBCLIENT_H
@@ -0,0 +1,16 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <stdint.h>
+
+// Simulated access point for the native environment
+// A connect with the cached channel and BSSID skips the scan, as on the ESP32.
+#define HOST_WIFI_SCAN_CONNECT_MS 2500   // Full scan, association and DHCP
+#define HOST_WIFI_FAST_CONNECT_MS 600    // Known channel and BSSID
+#define HOST_WIFI_CHANNEL 6
+
+void host_wifi_set_available(bool available);  // AP in range - false fails attempts with NO_AP_FOUND
+void host_wifi_drop();                         // AP goes away under a connected station (beacon timeout)
+bool host_wifi_connected();
+
+#endif // HOST_WIFI_H
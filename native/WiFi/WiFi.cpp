@@ -0,0 +1,86 @@
+#include "WiFi.h"
+#include "HostWiFi.h"
+#include <HostHardware.h>
+#include <atomic>
+
+WiFiClass WiFi;
+
+static const uint8_t ap_bssid[6] = {0x02, 0x00, 0x5E, 0x10, 0x00, 0x01};
+static bool ap_available = true;
+static std::atomic<wl_status_t> station_status(WL_DISCONNECTED);  // Also read by the MQTT task
+static uint32_t attempt_generation = 0;  // Cancels the outcome of an attempt that was abandoned
+
+void host_wifi_deliver(WiFiEvent_t event, uint8_t reason) {
+  if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    station_status = WL_CONNECTED;
+  } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+    station_status = reason == WIFI_REASON_NO_AP_FOUND ? WL_NO_SSID_AVAIL : WL_DISCONNECTED;
+  }
+  if (WiFi.callback_ != nullptr) {
+    WiFiEventInfo_t info = {};
+    info.wifi_sta_disconnected.reason = reason;
+    memcpy(info.wifi_sta_disconnected.bssid, ap_bssid, sizeof(ap_bssid));
+    WiFi.callback_(event, info);
+  }
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel, const uint8_t* bssid,
+                             bool connect) {
+  uint32_t generation = ++attempt_generation;
+  station_status = WL_IDLE_STATUS;
+
+  bool cached = channel != 0 && bssid != nullptr;
+  bool reachable = ap_available && (!cached || (channel == HOST_WIFI_CHANNEL && memcmp(bssid, ap_bssid, 6) == 0));
+  uint32_t connect_ms = cached ? HOST_WIFI_FAST_CONNECT_MS : HOST_WIFI_SCAN_CONNECT_MS;
+
+  host_schedule_us((uint64_t)connect_ms * 1000, [generation, reachable]() {
+    if (generation != attempt_generation) return;
+    if (reachable) {
+      host_wifi_deliver(ARDUINO_EVENT_WIFI_STA_GOT_IP, 0);
+    } else {
+      host_wifi_deliver(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_NO_AP_FOUND);
+    }
+  });
+  return station_status;
+}
+
+bool WiFiClass::disconnect(bool wifi_off, bool erase_ap) {
+  attempt_generation++;
+  host_schedule_us(0, []() { host_wifi_deliver(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE); });
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  return station_status;
+}
+
+uint8_t* WiFiClass::BSSID() {
+  static uint8_t bssid[6];
+  if (station_status != WL_CONNECTED) return nullptr;
+  memcpy(bssid, ap_bssid, sizeof(bssid));
+  return bssid;
+}
+
+int32_t WiFiClass::channel() {
+  return station_status == WL_CONNECTED ? HOST_WIFI_CHANNEL : 0;
+}
+
+IPAddress WiFiClass::localIP() {
+  return station_status == WL_CONNECTED ? IPAddress(192, 168, 1, 77) : IPAddress();
+}
+
+void host_wifi_set_available(bool available) {
+  ap_available = available;
+}
+
+void host_wifi_drop() {
+  ap_available = false;
+  if (station_status == WL_CONNECTED) {
+    attempt_generation++;
+    host_schedule_us(0, []() { host_wifi_deliver(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_BEACON_TIMEOUT); });
+  }
+}
+
+bool host_wifi_connected() {
+  return station_status == WL_CONNECTED;
+}
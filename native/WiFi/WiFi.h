@@ -0,0 +1,82 @@
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <IPAddress.h>
+
+// Host stand-in for the ESP32 WiFi library (native environment only)
+// Station mode against the simulated access point in HostWiFi.h. Events are delivered
+// like the WiFi task delivers them - asynchronously, after the association time.
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+  WIFI_AP = 2,
+  WIFI_AP_STA = 3
+} wifi_mode_t;
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+  ARDUINO_EVENT_WIFI_READY = 0,
+  ARDUINO_EVENT_WIFI_STA_START = 2,
+  ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+  ARDUINO_EVENT_WIFI_STA_LOST_IP = 8
+} arduino_event_id_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+
+typedef union {
+  struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+  } wifi_sta_disconnected;
+} arduino_event_info_t;
+
+typedef arduino_event_info_t WiFiEventInfo_t;
+typedef void (*WiFiEventSysCb)(WiFiEvent_t event, WiFiEventInfo_t info);
+
+// Disconnect reasons the firmware looks at (esp_wifi_types.h)
+#define WIFI_REASON_ASSOC_LEAVE 8
+#define WIFI_REASON_BEACON_TIMEOUT 200
+#define WIFI_REASON_NO_AP_FOUND 201
+
+class WiFiClass {
+public:
+  void onEvent(WiFiEventSysCb callback) { callback_ = callback; }
+  void persistent(bool persistent) {}
+  bool mode(wifi_mode_t mode) { return true; }
+  bool setAutoReconnect(bool auto_reconnect) { return true; }
+
+  wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0,
+                    const uint8_t* bssid = nullptr, bool connect = true);
+  bool disconnect(bool wifi_off = false, bool erase_ap = false);
+  wl_status_t status();
+
+  uint8_t* BSSID();
+  int32_t channel();
+  IPAddress localIP();
+  int8_t RSSI() { return -55; }
+
+private:
+  WiFiEventSysCb callback_ = nullptr;
+  friend void host_wifi_deliver(WiFiEvent_t event, uint8_t reason);
+};
+
+extern WiFiClass WiFi;
+
+class WiFiClient : public Client {};
+
+#endif // WIFI_H
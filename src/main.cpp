@@ -2,16 +2,22 @@
 #include <DebugConfig.h>
 
 #include <BandConfig.h>
+#include <BandRegistry.h>
+#include <BandStore.h>
 #include <RFIDControlPN532.h>
 #include <LEDControl.h>
 #include <AudioControlDFPlayer.h>
+#include <AudioSequencer.h>
 #include <HomeAssistantControl.h>
 #include <OTAControl.h>
+#include <Instrumentation.h>
 
 // Firmware version for tracking OTA updates
 #define FIRMWARE_VERSION "1.0.0-RFID"
 #define BUILD_TIMESTAMP __DATE__ " " __TIME__
 
+static constexpr char TAG[] = "MAIN";  // Log tag
+
 // Note: Now using DFPlayer Mini for high-quality SD card audio playback
 // Audio files must be on SD card as 0001.mp3, 0002.mp3, etc.
 
@@ -20,10 +26,74 @@ const unsigned long COOLDOWN_PERIOD = 5000;        // 5 seconds cooldown between
 const unsigned long STARTUP_LIGHT_DELAY = 500;     // Delay between startup light and sound
 const unsigned long AUDIO_SETTLE_DELAY = 150;      // Delay after starting audio
 const unsigned long MAIN_LOOP_DELAY = 100;         // Main loop iteration delay
-const unsigned long DETECTION_WINDOW = 3000;       // 3 second detection window for RFID reading
+const unsigned long ACTIVE_LOOP_DELAY = 10;        // Loop iteration delay while an activation is running
+const unsigned long DETECTION_WINDOW = 3000;       // 3 second chase animation after a tap
+
+// Activation sequence timing (each step is one state of the activation state machine)
+const unsigned long TAP_BEEP_DURATION = 300;       // Let the tap beep play before the chase starts
+const unsigned long COLOR_PREVIEW_DURATION = 200;  // Brief moment to see the band color
+const unsigned long CHIME_GAP_DURATION = 500;      // Gap between chime and band sound (color stays on)
+const unsigned long COLOR_HOLD_DURATION = 1000;    // Hold the color before fading out
+
+// Sounds end on the DFPlayer's finished event - these only cap a missed notification
+// (the sequencer tightens them to the track's length from TrackManifest.h)
+const uint16_t CHIME_TIMEOUT = 5000;              // Chime is ~3s (TrackManifest.h)
+const uint16_t BAND_SOUND_TIMEOUT = 30000;         // Long enough for the longest band clip
+const uint16_t ERROR_SOUND_TIMEOUT = 3000;
+
+// Task layout - the two cores never wait on each other
+// Core 1, real-time: Arduino's loop() below polls the reader, runs the activation state
+//   machine and drives the LED frames and the DFPlayer.
+// Core 0, network:   network_task() services WiFi, OTA and Home Assistant next to the WiFi
+//   stack. The MQTT session has a task of its own there (HomeAssistantControl.cpp), since a
+//   connect to a broker that is down blocks for seconds.
+// They only exchange copies through bounded lock-free queues (TaskQueue.h): taps go to the
+// network task, settings and OTA progress come back. The band registry belongs to the network
+// task; taps copy their band out with band_registry_lookup().
+const uint32_t NETWORK_TASK_STACK_SIZE = 8192;     // Provisioning and OTA run on this stack
+const UBaseType_t NETWORK_TASK_PRIORITY = 1;
+const unsigned long NETWORK_TASK_INTERVAL_MS = 10; // Pause between network passes
+const BaseType_t NETWORK_TASK_CORE = 0;
 
 // Cooldown management - prevent activations too close together
+// The cooldown counts from when the activation's sounds are due to end (TrackManifest.h), so
+// a long band clip doesn't use it up while it plays
 unsigned long last_activation = 0;
+unsigned long cooldown_from = 0;        // millis() the cooldown counts from
+unsigned long last_activation_end = 0;  // millis() when the last activation returned to idle
+
+// Real-time task's copy of the Home Assistant settings (updated through ha_control_update())
+HAControlState settings;
+
+bool reader_live = false;  // Reader polled at least once (boot metric reported)
+bool ota_updating = false; // Update being written by the network task - taps wait
+
+// Activation state machine
+// A tap walks through these states one loop tick at a time instead of blocking in delay(),
+// so LED frames and the DFPlayer keep being serviced while the greeting plays
+enum ActivationState {
+  ACTIVATION_IDLE,          // Waiting for a card
+  ACTIVATION_TAP_BEEP,      // Tap beep playing before the chase starts
+  ACTIVATION_DETECTING,     // Chase animation running after the UID was read
+  ACTIVATION_COLOR_PREVIEW, // Band color shown before the chime
+  ACTIVATION_GREETING,      // Chime, then the band's sound (audio sequencer)
+  ACTIVATION_COLOR_HOLD,    // Color held before fading out
+  ACTIVATION_FADE,          // Fading the band color out
+  ACTIVATION_ERROR_FLASH,   // Red flash for unknown or unreadable bands
+  ACTIVATION_ERROR_SOUND    // Error sound playing
+};
+
+struct Activation {
+  ActivationState state;
+  unsigned long state_entered;   // millis() when the current state was entered
+  unsigned long state_duration;  // How long timed states last
+  rfid_band_info tap;            // Card read that started this activation
+  uint64_t band_id;              // Full band UID from the tap
+  bool known;                    // Band is registered - band holds its configuration
+  BandConfig band;               // Copy taken at the tap (the registry is written on the network task)
+};
+
+Activation activation = {};
 
 // Centralized band configurations with sound variations
 // All band properties in one place: ID, name, color, sounds
@@ -56,15 +126,22 @@ BandConfig BAND_CONFIGS[] = {
 
 const int NUM_BANDS = sizeof(BAND_CONFIGS) / sizeof(BAND_CONFIGS[0]);
 
-// Helper function to find band configuration by ID
-// Returns pointer to BandConfig or nullptr if not found
-BandConfig* find_band_config(uint64_t band_id) {
-  for (int i = 0; i < NUM_BANDS; i++) {
-    if (band_id == BAND_CONFIGS[i].band_id) {
-      return &BAND_CONFIGS[i];
+// Network task - WiFi, OTA and Home Assistant, pinned to core 0
+// Free to block (an OTA update holds it for the whole transfer): the real-time loop only ever
+// sees what this task queues for it
+static void network_task(void* parameter) {
+  for (;;) {
+    // OTA needs the network - start it the first time WiFi comes up
+    if (!is_ota_ready() && is_wifi_connected()) {
+      setup_ota();
     }
+    loop_ota();
+    
+    // WiFi, received commands, discovery, stats and the taps reported by loop()
+    loop_home_assistant();
+    
+    vTaskDelay(pdMS_TO_TICKS(NETWORK_TASK_INTERVAL_MS));
   }
-  return nullptr;
 }
 
 void setup() {
@@ -72,6 +149,7 @@ void setup() {
   // Initialize Serial for debugging (non-blocking)
   Serial.begin(115200);
   delay(100);  // Brief delay for Serial to stabilize
+  setup_debug_log();  // Log output is written by a background task from here on
 
   DEBUG_PRINTLN("\n=== MagicBand (RFID) Initializing ===");
   DEBUG_PRINT("Firmware Version: ");
@@ -81,9 +159,18 @@ void setup() {
   DEBUG_PRINTLN("=========================================\n");
   DEBUG_PRINTLN("Comms enabled - beginning sensing");
 
+  // Load band configurations into the hash-indexed registry
+  // Compiled-in bands first, then persisted bands from flash override them
+  setup_band_registry(BAND_CONFIGS, NUM_BANDS);
+  if (!setup_band_store(BAND_CONFIGS, NUM_BANDS)) {
+    DEBUG_PRINTLN("WARNING: Band store unavailable - using compiled-in bands only");
+  }
+
   // CRITICAL INITIALIZATION ORDER!
   // I2C devices MUST be fully initialized before FastLED.show() is called
   // FastLED.show() disables interrupts which corrupts I2C bus state
+  // (The default RMT LED output doesn't mask interrupts - the order is kept so the
+  // FastLED fallback in LEDControl.h stays safe)
   
   // STEP 1: Initialize RFID COMPLETELY (including firmware handshake)
   setup_rfid();
@@ -108,32 +195,30 @@ void setup() {
   // Show immediate visual feedback - system is alive!
   fill_solid(leds, NUM_LEDS, CRGB::Blue);
   FastLED.setBrightness(30);
-  FastLED.show();
+  led_show();
   
   // Audio Setup (DFPlayer Mini with SD card)
-  // Non-blocking - if it fails, system continues without audio
-  if (!setup_audio_dfplayer()) {
-    DEBUG_PRINTLN("WARNING: DFPlayer Mini failed to initialize!");
-    DEBUG_PRINTLN("Check wiring and SD card. System will continue without audio.");
-  } else {
-    DEBUG_PRINTLN("DFPlayer Mini ready - audio system online");
-  }
+  // Non-blocking - the module resets in the background (serviced by loop_audio_dfplayer())
+  // If it never answers, the system continues without audio
+  setup_audio_dfplayer();
   
-  // Startup sequence - lights BEFORE WiFi to show system is alive
+  // Startup sequence - queued now, plays from loop() once setup is done
   DEBUG_PRINTLN("Starting magical startup sequence...");
   startup_light_sequence();
   
-  // Home Assistant Setup (WiFi + MQTT) - done AFTER LED sequence
-  // This way users see LEDs even if WiFi is slow/unavailable
+  // Home Assistant Setup (WiFi + MQTT) - returns immediately, WiFi connects in the background
+  // The band reader is live from the first loop() whether or not the network is up
+  // OTA is started by the network task once WiFi first connects
   setup_home_assistant();
+  settings = ha_control;
   
-  // OTA Setup (must be after WiFi is connected)
-  setup_ota();
+  // Play startup sound - queued until the DFPlayer is online
+  play_sound_file(SOUND_STARTOURS);
   
-  // Play startup sound if DFPlayer is ready (using chime as startup sound)
-  if (dfplayer_is_ready()) {
-    play_sound_file(SOUND_STARTOURS);
-  }
+  // Everything network from here on runs on core 0 (the native environment runs the task as
+  // a host thread in step with its simulated clock)
+  xTaskCreatePinnedToCore(network_task, "network", NETWORK_TASK_STACK_SIZE, nullptr, NETWORK_TASK_PRIORITY,
+                          nullptr, NETWORK_TASK_CORE);
   
   DEBUG_PRINTLN("MagicBand RFID system ready!");
   DEBUG_PRINT("Total startup time: ");
@@ -141,226 +226,293 @@ void setup() {
   DEBUG_PRINTLN("ms");
 }
 
-void loop() {
-  
-  // Handle OTA update requests (must be called frequently)
-  loop_ota();
-  
-  // Process Home Assistant connection and commands
-  loop_home_assistant();
-  
-  // Get current time for timing checks
-  unsigned long current_time = millis();
+// Move the activation state machine to a new state
+static void enter_activation_state(ActivationState state, unsigned long duration, unsigned long now) {
+  activation.state = state;
+  activation.state_entered = now;
+  activation.state_duration = duration;
+}
+
+// True once a timed state has lasted its full duration
+static bool activation_state_elapsed(unsigned long now) {
+  return now - activation.state_entered >= activation.state_duration;
+}
+
+// Log the UID in scanner format, ready to paste into BAND_CONFIGS
+static void log_band_uid(const rfid_band_info& tap) {
+  // uid_64 is the value BAND_CONFIGS and band_registry_lookup() use - uid_bytes is its
+  // little-endian storage, so printing those in order would give the bytes reversed
+  LOGI(TAG, "Band UID 0x%llX (%u bytes, %s) - #define BAND_NAME 0x%llXULL", (unsigned long long)tap.uid.uid_64,
+       tap.uid_length, get_protocol_name(tap.protocol), (unsigned long long)tap.uid.uid_64);
+}
+
+// Start a new activation when a card is tapped
+// The UID from the first read is used directly - no second read during the chase
+static void begin_activation(const rfid_band_info& tap, unsigned long now) {
+  activation.tap = tap;
+  activation.band_id = tap.uid.uid_64;  // Use 64-bit to support both MIFARE and Magic Bands
+  last_activation = now;
+  cooldown_from = now;  // Moved to the end of the sounds once they are scheduled
   
-  // Update stats for Home Assistant
-  ha_stats.time_until_ready = (current_time - last_activation < get_ha_cooldown()) ? 
-    (get_ha_cooldown() - (current_time - last_activation)) / 1000 : 0;
+  LOGI(TAG, "Band tapped: 0x%llX", (unsigned long long)activation.band_id);
+  report_wand_tap(activation.band_id, now);
   
-  // Check if system is enabled via Home Assistant
-  if (!is_system_enabled()) {
-    delay(MAIN_LOOP_DELAY);
-    return; // Skip band detection if disabled
-  }
+  // Search for matching band configuration
+  activation.known = band_registry_lookup(activation.band_id, &activation.band);
   
-  // Apply Home Assistant brightness setting
-  uint8_t ha_brightness = get_ha_brightness();
-  if (ha_brightness != FastLED.getBrightness()) {
-    FastLED.setBrightness(ha_brightness);
+  // Play detection beep sound to indicate card detected
+  if (dfplayer_is_ready()) {
+    play_sound_file(SOUND_TAP_START);  // Quick beep to indicate detection started
+    enter_activation_state(ACTIVATION_TAP_BEEP, TAP_BEEP_DURATION, now);
+  } else {
+    start_chase_animation();
+    enter_activation_state(ACTIVATION_DETECTING, DETECTION_WINDOW, now);
   }
+}
+
+// Chase animation is over - greet a known band or signal an error
+static void finish_detection(unsigned long now) {
+  // Stop the chase animation
+  stop_chase_animation();
   
-  // Use HA-controlled cooldown period
-  unsigned long cooldown = get_ha_cooldown();
+  log_band_uid(activation.tap);
   
-  // Check for RFID card detection (only when not in cooldown AND RFID is working)
-  if (is_rfid_initialized() && is_rfid_card_present() && current_time - last_activation >= cooldown) {
-    DEBUG_PRINTLN("RFID card detected! Starting read sequence...");
+  if (activation.known) {
+    LOGI(TAG, "Known band: %s", activation.band.name);
     
-    // Play detection beep sound to indicate card detected
-    if (dfplayer_is_ready()) {
-      play_sound_file(SOUND_TAP_START);  // Quick beep to indicate detection started
-      delay(300);
-    }
+    // Show band-specific color FIRST
+    set_color(activation.band.led_color);
+    enter_activation_state(ACTIVATION_COLOR_PREVIEW, COLOR_PREVIEW_DURATION, now);
+  } else {
+    LOGW(TAG, "Unknown band - not in configuration (add the define above to BAND_CONFIGS)");
     
-    // Start the chase animation
-    start_chase_animation();
+    // Flash red, then play error sound
+    start_flash_animation(CRGB::Red, 3, 200);
+    enter_activation_state(ACTIVATION_ERROR_FLASH, 0, now);
+  }
+}
+
+// Count the cooldown from the end of the activation's sounds - Home Assistant's
+// time_until_ready counts from the same point
+static void start_cooldown_at(unsigned long at) {
+  cooldown_from = at;
+  report_cooldown_start(at);
+}
+
+// How long the chime, the gap and the band's sound take - known before a note is played
+static unsigned long greeting_sounds_length(uint8_t band_sound) {
+  return get_track_duration(SOUND_CHIME) + CHIME_GAP_DURATION + get_track_duration(band_sound);
+}
+
+// Activation finished - report it and return to idle
+static void finish_activation(unsigned long now) {
+  // Publish band activation to Home Assistant (the network task also rotates the band's sound)
+  publish_wand_activation(activation.band_id, now);
+  last_activation_end = now;
+  enter_activation_state(ACTIVATION_IDLE, 0, now);
+}
+
+// True if the card answered before the last activation finished
+// A band left on the reader answers the detection re-armed right after its own tap, and the
+// PN532 holds that response until it is read - which is only once the greeting is over
+static bool answered_during_activation(const rfid_band_info& tap) {
+  return last_activation_end != 0 && (long)(tap.read_time - last_activation_end) < 0;
+}
+
+// Advance the activation state machine by one loop tick
+// Never blocks - each state checks its own deadline and returns
+static void update_activation(unsigned long now) {
+  switch (activation.state) {
+    case ACTIVATION_IDLE:
+      break;
     
-    // Run the 3-second accelerating chase animation while trying to read the band
-    unsigned long animation_start = millis();
-    uint64_t band_id = 0;  // Use 64-bit to support both MIFARE and Magic Bands
-    int read_attempts = 0;
+    case ACTIVATION_TAP_BEEP:
+      if (activation_state_elapsed(now)) {
+        // Start the chase animation
+        start_chase_animation();
+        enter_activation_state(ACTIVATION_DETECTING, DETECTION_WINDOW, now);
+      }
+      break;
     
-    // Try to read during the animation window
-    // IMPORTANT: Let animation run for full 3 seconds even if we read the band early
-    while (millis() - animation_start < DETECTION_WINDOW) {
-      update_chase_animation();
-      
-      // Only try to read if we haven't successfully read yet
-      if (band_id == 0) {
-        // Read and get the full 64-bit UID from current_band structure
-        uint32_t temp_id = read_rfid_if_present();
-        if (temp_id != 0) {
-          // For 7+ byte UIDs, use the full 64-bit UID
-          if (current_band.uid_length >= 7) {
-            band_id = current_band.uid.uid_64;
-          } else {
-            // For 4-byte UIDs, use the 32-bit value
-            band_id = temp_id;
-          }
-          DEBUG_PRINT("Successfully read band ID: 0x");
-          if (current_band.uid_length >= 7) {
-            DEBUG_PRINT((uint32_t)(band_id >> 32), HEX);
-          }
-          DEBUG_PRINTLN((uint32_t)(band_id & 0xFFFFFFFF), HEX);
-          DEBUG_PRINT("Read attempts: ");
-          DEBUG_PRINTLN(read_attempts + 1);
-          // Don't break - let animation finish!
-        }
-        read_attempts++;
+    case ACTIVATION_DETECTING:
+      // The 3-second accelerating chase is drawn by loop_leds()
+      if (activation_state_elapsed(now)) {
+        finish_detection(now);
       }
-      
-      delay(10); // Small delay for animation smoothness
-    }
+      break;
     
-    // Stop the chase animation
-    stop_chase_animation();
+    case ACTIVATION_COLOR_PREVIEW:
+      if (activation_state_elapsed(now)) {
+        // Play success chime while showing the color, then the current sound variation
+        uint8_t band_sound = activation.band.sound_files[activation.band.current_sound_index];
+        AudioSequenceStep greeting[] = {
+          { SOUND_CHIME, CHIME_TIMEOUT, CHIME_GAP_DURATION },
+          { band_sound, BAND_SOUND_TIMEOUT, 0 }
+        };
+        bool playing = dfplayer_is_ready() && audio_sequence_start(greeting, 2);
+        // Without audio the color still stays on for as long as the greeting would have played
+        unsigned long sounds_length = greeting_sounds_length(band_sound);
+        start_cooldown_at(now + sounds_length);
+        enter_activation_state(ACTIVATION_GREETING, playing ? 0 : sounds_length, now);
+      }
+      break;
     
-    DEBUG_PRINT("Detection complete - Final ID: 0x");
-    if (current_band.uid_length >= 7) {
-      DEBUG_PRINT((uint32_t)(band_id >> 32), HEX);
-    }
-    DEBUG_PRINTLN((uint32_t)(band_id & 0xFFFFFFFF), HEX);
+    case ACTIVATION_GREETING:
+      // Ends when the band sound actually finishes, however long the clip is
+      if (!audio_sequence_running() && activation_state_elapsed(now)) {
+        // Fade out the color after a moment
+        enter_activation_state(ACTIVATION_COLOR_HOLD, COLOR_HOLD_DURATION, now);
+      }
+      break;
     
-    // Check if we successfully read a band ID
-    if (band_id != 0) {
-      // Display UID in scanner format for easy identification
-      DEBUG_PRINTLN("\n╔════════════════════════════════════════════════════╗");
-      DEBUG_PRINTLN("║           RFID CARD DETECTED!                      ║");
-      DEBUG_PRINTLN("╚════════════════════════════════════════════════════╝");
-      
-      // Get full band info with protocol and UID length
-      uint8_t uid_length = current_band.uid_length;
-      
-      if (uid_length == 4) {
-        // 4-byte UID (MIFARE)
-        DEBUG_PRINTLN("Protocol: ISO 14443A (MIFARE)");
-        DEBUG_PRINT("UID Length: ");
-        DEBUG_PRINT(uid_length);
-        DEBUG_PRINTLN(" bytes");
-        DEBUG_PRINT("UID Bytes: ");
-        for (uint8_t i = 0; i < uid_length; i++) {
-          if (current_band.uid.uid_bytes[i] < 0x10) DEBUG_PRINT("0");
-          DEBUG_PRINT(current_band.uid.uid_bytes[i], HEX);
-          if (i < uid_length - 1) DEBUG_PRINT(" ");
-        }
-        DEBUG_PRINTLN();
-        DEBUG_PRINT("UID as uint32_t: ");
-        DEBUG_PRINT(band_id);
-        DEBUG_PRINT(" (decimal) = 0x");
-        DEBUG_PRINT(band_id, HEX);
-        DEBUG_PRINTLN(" (hex)");
-        DEBUG_PRINTLN();
-        DEBUG_PRINT(">>> C++ Define: #define BAND_NAME 0x");
-        DEBUG_PRINT(band_id, HEX);
-        DEBUG_PRINTLN("UL");
-      } else if (uid_length >= 7) {
-        // 7+ byte UID (Magic Band / NFC Type 2)
-        DEBUG_PRINTLN("Protocol: ISO 14443A (7+ byte UID - NFC Type 2)");
-        DEBUG_PRINT("UID Length: ");
-        DEBUG_PRINT(uid_length);
-        DEBUG_PRINTLN(" bytes");
-        DEBUG_PRINT("UID Bytes: ");
-        for (uint8_t i = 0; i < uid_length; i++) {
-          if (current_band.uid.uid_bytes[i] < 0x10) DEBUG_PRINT("0");
-          DEBUG_PRINT(current_band.uid.uid_bytes[i], HEX);
-          if (i < uid_length - 1) DEBUG_PRINT(" ");
-        }
-        DEBUG_PRINTLN();
-        DEBUG_PRINT("UID as uint64_t: ");
-        DEBUG_PRINT((uint32_t)(current_band.uid.uid_64 >> 32), HEX);
-        DEBUG_PRINT((uint32_t)(current_band.uid.uid_64 & 0xFFFFFFFF), HEX);
-        DEBUG_PRINTLN(" (hex)");
-        DEBUG_PRINTLN();
-        DEBUG_PRINT(">>> C++ Define (64-bit): #define BAND_NAME 0x");
-        for (uint8_t i = 0; i < uid_length; i++) {
-          if (current_band.uid.uid_bytes[i] < 0x10) DEBUG_PRINT("0");
-          DEBUG_PRINT(current_band.uid.uid_bytes[i], HEX);
-        }
-        DEBUG_PRINTLN("ULL");
-        DEBUG_PRINTLN();
-        DEBUG_PRINT(">>> C++ Define (32-bit): #define BAND_NAME 0x");
-        DEBUG_PRINT(band_id, HEX);
-        DEBUG_PRINTLN("UL");
+    case ACTIVATION_COLOR_HOLD:
+      if (activation_state_elapsed(now)) {
+        start_fade_out();
+        enter_activation_state(ACTIVATION_FADE, 0, now);
       }
-      
-      DEBUG_PRINTLN("────────────────────────────────────────────────────\n");
-      
-      // Search for matching band configuration
-      BandConfig* band = find_band_config(band_id);
-      
-      if (band != nullptr) {
-        DEBUG_PRINT("✓ Known RFID Band: ");
-        DEBUG_PRINTLN(band->name);
-        
-        // Show band-specific color FIRST
-        set_color(band->led_color);
-        delay(200); // Brief moment to see the color
-        
-        // Play success chime while showing the color
-        if (dfplayer_is_ready()) {
-          play_sound_file(SOUND_CHIME);
-          delay(1500); // Wait for chime to play completely
-        }
-        
-        // Delay between chime and band sound (color stays on)
-        delay(500);
-        
-        // Play current sound variation
-        uint8_t sound_file = band->sound_files[band->current_sound_index];
-        if (dfplayer_is_ready()) {
-          play_sound_file(sound_file);
-          delay(3000); // Let the sound play
-        }
-        
-        // Fade out the color after a few seconds
-        delay(1000);
-        fade_out_leds();
-        
-        // Rotate to next sound for next activation
-        band->current_sound_index = 
-          (band->current_sound_index + 1) % band->num_sounds;
-      } else {
-        DEBUG_PRINTLN("⚠️  Unknown RFID Band - Not in configuration");
-        DEBUG_PRINTLN("   Copy the define above and add to BandConfig.h");
-        
-        // Flash red and play error sound
-        flash_color(CRGB::Red, 3, 200);
-        if (dfplayer_is_ready()) {
-          play_sound_file(SOUND_ERROR);
-          delay(1500);
+      break;
+    
+    case ACTIVATION_FADE:
+      if (update_fade_out()) {
+        finish_activation(now);
+      }
+      break;
+    
+    case ACTIVATION_ERROR_FLASH:
+      if (update_flash_animation()) {
+        AudioSequenceStep error_sound[] = { { SOUND_ERROR, ERROR_SOUND_TIMEOUT, 0 } };
+        if (dfplayer_is_ready() && audio_sequence_start(error_sound, 1)) {
+          start_cooldown_at(now + get_track_duration(SOUND_ERROR));
+          enter_activation_state(ACTIVATION_ERROR_SOUND, 0, now);
+        } else {
+          finish_activation(now);
         }
       }
-      
-      // Publish band activation to Home Assistant
-      publish_wand_activation(band_id);
-
-    } else {
-      DEBUG_PRINTLN("Failed to read band UID during 3-second window");
-      
-      // Flash red and play error sound
-      flash_color(CRGB::Red, 3, 200);
-      if (dfplayer_is_ready()) {
-        play_sound_file(SOUND_ERROR);
-        delay(1500);
+      break;
+    
+    case ACTIVATION_ERROR_SOUND:
+      if (!audio_sequence_running()) {
+        finish_activation(now);
       }
-    }
+      break;
+  }
+}
+
+// Draw the progress of an OTA update the network task is writing
+static void show_ota_status(const OTAStatus& status) {
+  switch (status.phase) {
+    case OTA_PHASE_STARTED:
+      // Turn all LEDs white during update - any activation waits where it is
+      ota_updating = true;
+      fill_solid(leds, NUM_LEDS, CRGB::White);
+      FastLED.setBrightness(50);
+      led_show();
+      break;
+    
+    case OTA_PHASE_PROGRESS:
+      fill_solid(leds, NUM_LEDS, CRGB::Blue);
+      FastLED.setBrightness(status.percent);
+      led_show();
+      break;
     
-    last_activation = current_time;
+    case OTA_PHASE_DONE:
+      // Green until the network task restarts the board
+      fill_solid(leds, NUM_LEDS, CRGB::Green);
+      FastLED.setBrightness(100);
+      led_show();
+      break;
     
-  } else if (current_time - last_activation < cooldown && last_activation > 0) {
+    case OTA_PHASE_FAILED:
+      // Flash red, then carry on with the running firmware
+      ota_updating = false;
+      FastLED.setBrightness(settings.led_brightness);
+      flash_color(CRGB::Red, 5, 200);
+      break;
+  }
+}
+
+// Real-time task (core 1) - reader, activation, LEDs and audio; never waits on the network
+void loop() {
+  unsigned long loop_start = micros();  // Loop time excludes the closing delay()
+  
+  // Show OTA progress - nothing else runs while an update is being written
+  OTAStatus ota_status;
+  while (ota_take_status(&ota_status)) {
+    show_ota_status(ota_status);
+  }
+  if (ota_updating) {
+    instrument_since(INSTRUMENT_LOOP, loop_start);
+    delay(MAIN_LOOP_DELAY);
+    return;
+  }
+  
+  // Pick up settings changed from Home Assistant
+  ha_control_update(&settings);
+  
+  // Draw the next LED frame if one is due
+  loop_leds();
+  
+  // Exchange queued commands and events with the DFPlayer
+  loop_audio_dfplayer();
+  
+  // Get current time for timing checks
+  unsigned long current_time = millis();
+  
+  // An activation already in progress always runs to completion
+  if (activation.state != ACTIVATION_IDLE) {
+    update_activation(current_time);
+    instrument_since(INSTRUMENT_LOOP, loop_start);
+    delay(ACTIVE_LOOP_DELAY);
+    return;
+  }
+  
+  // Check if system is enabled via Home Assistant
+  if (!settings.system_enabled) {
+    instrument_since(INSTRUMENT_LOOP, loop_start);
+    delay(led_idle_ms(MAIN_LOOP_DELAY));
+    return; // Skip band detection if disabled
+  }
+  
+  // Apply Home Assistant brightness setting (latched by loop_leds() on the next frame)
+  if (settings.led_brightness != FastLED.getBrightness()) {
+    FastLED.setBrightness(settings.led_brightness);
+  }
+  
+  // Use HA-controlled cooldown period, counted from the end of the last activation's sounds
+  // (cooldown_from can still be ahead of now if the sounds ended early)
+  bool cooling_down = last_activation > 0 && (long)(current_time - cooldown_from) < (long)settings.cooldown_time;
+  
+  // Check for RFID card detection (only when not in cooldown AND RFID is working)
+  // A single read returns the UID, so the activation can act on it immediately
+  rfid_band_info tap;
+  if (!reader_live) {
+    // Boot metric: time from power-on until the reader is first polled
+    reader_live = true;
+    report_reader_live(current_time);
+    LOGI(TAG, "Band reader live after %lums", current_time);
+  }
+  bool card_read = is_rfid_initialized() && rfid_read_card(&tap);
+  if (card_read && answered_during_activation(tap)) {
+    LOGD(TAG, "Dropped stale read of 0x%llX from the last activation", (unsigned long long)tap.uid.uid_64);
+    card_read = false;  // Same tap - the reader is already re-armed for the next one
+  }
+  if (card_read && !cooling_down) {
+    begin_activation(tap, current_time);
+  } else if (cooling_down) {
     // Show cooldown visual feedback
     cooldown_pulse();
+  } else {
+    stop_cooldown_pulse();
   }
 
   // wait a bit, and then back to receiving and decoding
-  delay(MAIN_LOOP_DELAY);
+  instrument_since(INSTRUMENT_LOOP, loop_start);
+  if (activation.state != ACTIVATION_IDLE) {
+    delay(ACTIVE_LOOP_DELAY);
+  } else {
+    // Idle - the reader's IRQ notifies this task, so a tap is read when the card answers
+    // rather than after the rest of the delay (polling mode just sleeps it out). A running
+    // effect (startup sequence, cooldown pulse) shortens it to its next frame.
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(led_idle_ms(MAIN_LOOP_DELAY)));
+  }
 }
@@ -0,0 +1,357 @@
+/**
+ * Activation state machine - native build, virtual time
+ *
+ * Runs the firmware (src/main.cpp) against the simulated hardware and taps bands the way a
+ * guest would. Each activation ends with one publish on the wand topic.
+ *
+ * Every state of a greeting shows up on the hardware - the tap beep, the chase, the band
+ * color, the chime, the band sound, the fade - so the transitions are checked in order and
+ * against the timing constants in main.cpp. The loop must keep running the whole time: no
+ * single pass may hold it much longer than its own loop delay. The simulated SD card holds
+ * tracks as long as TrackManifest.h says, as the real card does.
+ *
+ * Run with: pio test -e native -f test_activation
+ */
+
+#include <Arduino.h>
+#include <HostHardware.h>
+#include <HostPN532.h>
+#include <HostLEDStrip.h>
+#include <HostBroker.h>
+#include <HostFlash.h>
+#include <AudioControlDFPlayer.h>
+#include <TrackManifest.h>
+#include <HomeAssistantControl.h>
+#include <Instrumentation.h>
+#include <RFIDControlPN532.h>
+#include <unity.h>
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define WARMUP_MS 15000             // Boot, WiFi, MQTT and the startup sound
+#define KNOWN_BAND 0x27CB1805       // "August" in BAND_CONFIGS - blue, pirate clip
+#define UNKNOWN_BAND 0xDEADBEEF
+#define ACTIVATION_TIMEOUT_MS 30000
+#define SETTLE_MS 15000             // Past the cooldown after a greeting
+#define TAP_HOLD_MS 200
+#define CHIME_MS TRACK_MANIFEST[SOUND_CHIME].duration_ms
+#define BAND_SOUND_MS TRACK_MANIFEST[SOUND_PIRATE_CLIP].duration_ms
+#define COOLDOWN_MS 5000            // Home Assistant's default cooldown_time
+
+// From src/main.cpp
+#define TAP_BEEP_DURATION_MS 300
+#define DETECTION_WINDOW_MS 3000
+#define COLOR_PREVIEW_DURATION_MS 200
+#define CHIME_GAP_DURATION_MS 500
+#define COLOR_HOLD_DURATION_MS 1000
+#define MAIN_LOOP_DELAY_MS 100
+#define LED_FRAME_INTERVAL_MS 20    // 50fps, from LEDAnimation.h
+#define STATS_PUBLISH_INTERVAL_MS 30000  // From HomeAssistantControl.cpp
+#define STARTUP_MS 2000             // Startup light sequence, from its first frame
+#define STARTUP_FADE_MS 650         // Its fade to black after the white hold - a new picture every frame
+
+#define TIMING_EARLY_MS 10          // Bus and UART time between a state change and the hardware seeing it
+#define TIMING_LATE_MS 150          // Loop ticks, DFPlayer replies and BUSY latency
+#define MAX_LOOP_STALL_MS (MAIN_LOOP_DELAY_MS + 20)  // Longest loop() pass including its delay
+#define MAX_LOOP_WORK_US 20000      // Longest loop() pass excluding its delay
+
+struct PlayCommand {
+  uint16_t track;
+  uint64_t at_us;
+};
+
+// Recorded on the main thread (hardware events and loop())
+static int uid_reads = 0;
+static std::vector<PlayCommand> plays;
+static uint64_t band_color_us = 0;        // First frame with every pixel in the band color
+static uint64_t dark_after_color_us = 0;  // First dark frame after that (fade done)
+static std::vector<uint64_t> startup_frames_us;  // Frames of the startup light sequence (warmup)
+
+// Written on the MQTT task thread
+static std::atomic<int> publishes(0);
+static std::atomic<uint64_t> publish_us(0);  // First publish since setUp()
+static std::atomic<uint64_t> stats_us(0);    // Last stats publish, and its time_until_ready
+static std::atomic<int> stats_time_until_ready(0);
+
+static bool frame_is(const CRGB* pixels, int count, CRGB color) {
+  for (int i = 0; i < count; i++) {
+    if (!(pixels[i] == color)) return false;
+  }
+  return count > 0;
+}
+
+static void on_led_frame(const CRGB* pixels, int count, uint8_t brightness) {
+  uint64_t now = host_micros64();
+  if (startup_frames_us.empty() || now - startup_frames_us.front() < (uint64_t)STARTUP_MS * 1000) {
+    startup_frames_us.push_back(now);
+  }
+  if (band_color_us == 0 && frame_is(pixels, count, CRGB(CRGB::Blue))) {
+    band_color_us = host_micros64();
+  } else if (band_color_us != 0 && dark_after_color_us == 0 &&
+             (brightness == 0 || frame_is(pixels, count, CRGB(CRGB::Black)))) {
+    dark_after_color_us = host_micros64();
+  }
+}
+
+static void on_dfplayer_command(uint8_t command, uint16_t param) {
+  if (command == 0x03) {  // Play track
+    plays.push_back({param, host_micros64()});
+  }
+}
+
+static void on_publish(const char* topic, const uint8_t* payload, size_t length, bool retain) {
+  if (strcmp(topic, MQTT_STATS_TOPIC) == 0) {
+    std::string json((const char*)payload, length);
+    size_t field = json.find("\"time_until_ready\":");
+    if (field != std::string::npos) {
+      stats_time_until_ready.store(atoi(json.c_str() + field + strlen("\"time_until_ready\":")));
+      stats_us.store(host_micros64());
+    }
+  }
+  if (strcmp(topic, MQTT_WAND_TOPIC) == 0) {
+    uint64_t expected = 0;
+    publish_us.compare_exchange_strong(expected, host_micros64());
+    publishes++;
+  }
+}
+
+static const PlayCommand* find_play(uint16_t track) {
+  for (const PlayCommand& play : plays) {
+    if (play.track == track) return &play;
+  }
+  return nullptr;
+}
+
+// One state lasted as long as main.cpp says, give or take the hardware's own latency
+static void check_elapsed(uint32_t expected_ms, uint64_t from_us, uint64_t to_us) {
+  TEST_ASSERT_GREATER_OR_EQUAL(from_us, to_us);
+  uint32_t elapsed_ms = (uint32_t)((to_us - from_us) / 1000);
+  TEST_ASSERT_GREATER_OR_EQUAL(expected_ms - TIMING_EARLY_MS, elapsed_ms);
+  TEST_ASSERT_LESS_OR_EQUAL(expected_ms + TIMING_LATE_MS, elapsed_ms);
+}
+
+static void run_for(uint32_t ms) {
+  uint64_t until = host_micros64() + (uint64_t)ms * 1000;
+  while (host_micros64() < until) {
+    host_loop_tick();
+  }
+}
+
+// Run until the next activation is published - false on timeout
+static bool wait_for_publish(int count) {
+  uint64_t deadline = host_micros64() + (uint64_t)ACTIVATION_TIMEOUT_MS * 1000;
+  while (publishes.load() < count && host_micros64() < deadline) {
+    host_loop_tick();
+  }
+  return publishes.load() >= count;
+}
+
+// Tap a band and run until its activation is published
+// Returns the longest single loop() pass seen meanwhile (virtual us, delay included)
+static uint64_t tap_and_wait(uint64_t uid) {
+  host_pn532_tap(uid, 4, TAP_HOLD_MS);
+  uint64_t longest = 0;
+  uint64_t deadline = host_micros64() + (uint64_t)ACTIVATION_TIMEOUT_MS * 1000;
+  while (publishes.load() == 0 && host_micros64() < deadline) {
+    uint64_t start = host_micros64();
+    host_loop_tick();
+    longest = std::max(longest, host_micros64() - start);
+  }
+  return longest;
+}
+
+void setUp(void) {
+  publishes.store(0);
+  publish_us.store(0);
+  uid_reads = 0;
+  plays.clear();
+  band_color_us = 0;
+  dark_after_color_us = 0;
+}
+
+void tearDown(void) {
+  run_for(SETTLE_MS);  // Next tap lands outside the cooldown
+}
+
+// Tap beep -> chase -> band color -> chime -> band sound -> hold -> fade -> publish
+void test_known_band_walks_through_the_greeting(void) {
+  uint32_t flash_operations = host_flash_operation_count();
+  tap_and_wait(KNOWN_BAND);
+  TEST_ASSERT_EQUAL(1, publishes.load());
+  TEST_ASSERT_EQUAL_UINT32(flash_operations, host_flash_operation_count());  // One sound - no rotation to save
+
+  const PlayCommand* beep = find_play(SOUND_TAP_START);
+  const PlayCommand* chime = find_play(SOUND_CHIME);
+  const PlayCommand* band_sound = find_play(SOUND_PIRATE_CLIP);
+  TEST_ASSERT_NOT_NULL(beep);
+  TEST_ASSERT_NOT_NULL(chime);
+  TEST_ASSERT_NOT_NULL(band_sound);
+  TEST_ASSERT_EQUAL(3, (int)plays.size());
+  TEST_ASSERT_NOT_EQUAL(0, band_color_us);
+  TEST_ASSERT_NOT_EQUAL(0, dark_after_color_us);
+
+  // Tap beep, then the chase for the detection window, then the band color
+  check_elapsed(TAP_BEEP_DURATION_MS + DETECTION_WINDOW_MS, beep->at_us, band_color_us);
+  // Color preview, then the chime
+  check_elapsed(COLOR_PREVIEW_DURATION_MS, band_color_us, chime->at_us);
+  // The band sound waits for the chime to finish, plus the gap
+  check_elapsed(CHIME_MS + CHIME_GAP_DURATION_MS, chime->at_us, band_sound->at_us);
+  // Color held once the band sound ends, then faded out before the activation is published
+  TEST_ASSERT_GREATER_OR_EQUAL(band_sound->at_us + (uint64_t)(BAND_SOUND_MS + COLOR_HOLD_DURATION_MS) * 1000,
+                               dark_after_color_us);
+  TEST_ASSERT_LESS_OR_EQUAL(publish_us.load(), dark_after_color_us);
+}
+
+// Unknown band - red flash and the error sound instead of a greeting
+void test_unknown_band_plays_the_error_sound(void) {
+  tap_and_wait(UNKNOWN_BAND);
+  TEST_ASSERT_EQUAL(1, publishes.load());
+
+  TEST_ASSERT_NOT_NULL(find_play(SOUND_TAP_START));
+  TEST_ASSERT_NOT_NULL(find_play(SOUND_ERROR));
+  TEST_ASSERT_NULL(find_play(SOUND_CHIME));
+  TEST_ASSERT_EQUAL(0, band_color_us);
+}
+
+// The greeting runs for seconds, but no loop() pass may hold the CPU for more than a tick
+void test_loop_never_stalls_during_an_activation(void) {
+  instrument_take_timer(INSTRUMENT_LOOP);  // Start a fresh window
+  uint64_t longest_us = tap_and_wait(KNOWN_BAND);
+  InstrumentTimerStats loop_stats = instrument_take_timer(INSTRUMENT_LOOP);
+
+  TEST_ASSERT_EQUAL(1, publishes.load());
+  TEST_ASSERT_LESS_OR_EQUAL((uint64_t)MAX_LOOP_STALL_MS * 1000, longest_us);
+  TEST_ASSERT_GREATER_THAN(0, loop_stats.count);
+  TEST_ASSERT_LESS_OR_EQUAL(MAX_LOOP_WORK_US, loop_stats.max_us);
+}
+
+// One tap, one greeting - the card is still in the field when the reader re-arms, and the
+// response it leaves waiting must not start a second greeting once the first one ends
+static void check_single_activation(uint32_t hold_ms) {
+  host_pn532_tap(KNOWN_BAND, 4, hold_ms);
+  TEST_ASSERT_TRUE(wait_for_publish(1));
+  run_for(SETTLE_MS);
+
+  TEST_ASSERT_EQUAL(1, publishes.load());
+  if (is_rfid_irq_mode()) {
+    TEST_ASSERT_GREATER_OR_EQUAL(2, uid_reads);  // The stale response was read - and dropped
+  }
+}
+
+void test_one_tap_is_one_activation(void) {
+  check_single_activation(500);
+}
+
+void test_slow_tap_is_one_activation(void) {
+  check_single_activation(2000);
+}
+
+// Effects outside an activation still get every frame - the idle loop delay must not cut
+// the startup fade to one frame per pass
+void test_startup_sequence_runs_at_the_frame_rate(void) {
+  if (!is_rfid_irq_mode()) {
+    TEST_IGNORE_MESSAGE("Polling mode holds each idle pass in the reader's read timeout");
+  }
+  // The white hold is the one long pause - the fade follows it
+  const std::vector<uint64_t>& frames = startup_frames_us;
+  TEST_ASSERT_GREATER_THAN(2, frames.size());
+  size_t fade = 1;
+  for (size_t i = 1; i < frames.size(); i++) {
+    if (frames[i] - frames[i - 1] > frames[fade] - frames[fade - 1]) fade = i;
+  }
+  for (size_t i = fade + 1; i < frames.size() && frames[i] - frames[fade] < (uint64_t)STARTUP_FADE_MS * 1000; i++) {
+    TEST_ASSERT_LESS_OR_EQUAL((uint64_t)(LED_FRAME_INTERVAL_MS + TIMING_EARLY_MS) * 1000, frames[i] - frames[i - 1]);
+  }
+}
+
+// Run until ms after the band sound ended (as the simulated card plays it)
+static void run_until_after_band_sound(uint32_t ms) {
+  const PlayCommand* band_sound = find_play(SOUND_PIRATE_CLIP);
+  TEST_ASSERT_NOT_NULL(band_sound);
+  uint64_t until = band_sound->at_us + (uint64_t)(BAND_SOUND_MS + ms) * 1000;
+  TEST_ASSERT_GREATER_OR_EQUAL(host_micros64(), until);
+  while (host_micros64() < until) {
+    host_loop_tick();
+  }
+}
+
+// The cooldown counts from the end of the band sound, not from the tap - a 12.8s clip must
+// not use up a 5s cooldown while it plays
+void test_cooldown_starts_when_the_greeting_ends(void) {
+  host_pn532_tap(KNOWN_BAND, 4, 500);
+  TEST_ASSERT_TRUE(wait_for_publish(1));
+  run_until_after_band_sound(COOLDOWN_MS - 1000);
+  host_pn532_tap(KNOWN_BAND, 4, 500);
+  TEST_ASSERT_FALSE(wait_for_publish(2));
+}
+
+// The dropped read must not cost the next guest their tap
+void test_next_tap_after_cooldown_is_greeted(void) {
+  host_pn532_tap(KNOWN_BAND, 4, 500);
+  TEST_ASSERT_TRUE(wait_for_publish(1));
+  run_until_after_band_sound(COOLDOWN_MS + TIMING_LATE_MS);
+  host_pn532_tap(KNOWN_BAND, 4, 500);
+  TEST_ASSERT_TRUE(wait_for_publish(2));
+}
+
+// Run until the next stats publish - its time
+static uint64_t wait_for_stats() {
+  uint64_t last = stats_us.load();
+  uint64_t deadline = host_micros64() + (uint64_t)(STATS_PUBLISH_INTERVAL_MS + 1000) * 1000;
+  while (stats_us.load() == last && host_micros64() < deadline) {
+    host_loop_tick();
+  }
+  TEST_ASSERT_NOT_EQUAL(last, stats_us.load());
+  return stats_us.load();
+}
+
+// Home Assistant's time_until_ready counts the cooldown from where the reader does - the end
+// of the band sound - so a unit still greeting never shows as ready
+void test_time_until_ready_counts_from_the_greeting_end(void) {
+  uint64_t stats = wait_for_stats();
+  // Tap so the next stats publish lands while the band sound plays
+  run_for(STATS_PUBLISH_INTERVAL_MS - 10000 - (uint32_t)((host_micros64() - stats) / 1000));
+  host_pn532_tap(KNOWN_BAND, 4, 500);
+  stats = wait_for_stats();
+  const PlayCommand* band_sound = find_play(SOUND_PIRATE_CLIP);
+  TEST_ASSERT_NOT_NULL(band_sound);
+  TEST_ASSERT_LESS_THAN(band_sound->at_us + (uint64_t)BAND_SOUND_MS * 1000, stats);
+
+  uint64_t ready_us = band_sound->at_us + (uint64_t)(BAND_SOUND_MS + COOLDOWN_MS) * 1000;
+  int expected_s = (int)((ready_us - stats) / 1000000);
+  TEST_ASSERT_INT_WITHIN(1, expected_s, stats_time_until_ready.load());
+  TEST_ASSERT_TRUE(wait_for_publish(1));
+}
+
+int main(int argc, char** argv) {
+  host_set_virtual_time(true);
+  host_set_serial_output(false);
+  host_dfplayer_set_track_duration(SOUND_CHIME, CHIME_MS);
+  host_dfplayer_set_track_duration(SOUND_PIRATE_CLIP, BAND_SOUND_MS);
+  host_pn532_on_read([](const uint8_t* uid, uint8_t uid_length) { uid_reads++; });
+  host_led_on_frame(on_led_frame);
+  host_dfplayer_on_command(on_dfplayer_command);
+  host_broker_on_publish(on_publish);
+
+  setup();
+  run_for(WARMUP_MS);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_startup_sequence_runs_at_the_frame_rate);
+  RUN_TEST(test_known_band_walks_through_the_greeting);
+  RUN_TEST(test_unknown_band_plays_the_error_sound);
+  RUN_TEST(test_loop_never_stalls_during_an_activation);
+  RUN_TEST(test_one_tap_is_one_activation);
+  RUN_TEST(test_slow_tap_is_one_activation);
+  RUN_TEST(test_cooldown_starts_when_the_greeting_ends);
+  RUN_TEST(test_time_until_ready_counts_from_the_greeting_end);
+  RUN_TEST(test_next_tap_after_cooldown_is_greeted);
+  int failures = UNITY_END();
+
+  // The network and MQTT task threads are still parked in delay() - leave without destructors
+  fflush(stdout);
+  quick_exit(failures);
+}
@@ -0,0 +1,190 @@
+/**
+ * Band registry vs the linear scan it replaced - native build
+ *
+ * Loads 5, 500 and 5,000 bands and checks that the hash table finds every one of them (and
+ * nothing else) exactly as a scan of the config array does, then times both on the host
+ * clock. The scan is the old find_band_config(): a walk over BAND_CONFIGS[]. At event sizes
+ * the table must win by a wide margin; at 5 bands the numbers are only reported. Provisioning
+ * churn at full load must not slow it down either.
+ *
+ * Run with: pio test -e native -f test_band_registry
+ */
+
+#include <Arduino.h>
+#include <HostHardware.h>
+#include <BandRegistry.h>
+#include <unity.h>
+#include <chrono>
+#include <vector>
+
+#define LOOKUP_ROUNDS 200000       // Lookups timed per variant and size
+#define MIN_SPEEDUP_500 5          // Table must beat the scan by this factor at 500 bands
+#define MIN_SPEEDUP_5000 20        // ... and at 5,000
+#define CHURN_ROUNDS (8 * BAND_REGISTRY_CAPACITY)  // Remove/insert pairs - without cleanup, tombstones fill every empty slot
+#define MAX_CHURN_SLOWDOWN 3       // Lookups after the churn vs freshly loaded
+
+static std::vector<BandConfig> configs;
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t next_uid() {
+  rng_state ^= rng_state << 13;  // xorshift64
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  // Mix of 4-byte and 7-byte UIDs, like a box of MIFARE and NTAG bands
+  return (rng_state & 1) ? (rng_state >> 32) : (rng_state >> 8);
+}
+
+static void make_bands(int count) {
+  configs.clear();
+  for (int i = 0; i < count; i++) {
+    BandConfig band = {};
+    band.band_id = next_uid();
+    snprintf(band.name, sizeof(band.name), "Guest %d", i);
+    band.led_color = CRGB(i & 0xFF, (i >> 8) & 0xFF, 0x80);
+    band.sound_files[0] = 1 + i % 13;
+    band.num_sounds = 1;
+    configs.push_back(band);
+  }
+}
+
+// The old find_band_config()
+static const BandConfig* scan_band_config(uint64_t band_id) {
+  for (const BandConfig& band : configs) {
+    if (band.band_id == band_id) return &band;
+  }
+  return nullptr;
+}
+
+// Host ns per lookup, hits and misses interleaved the way taps arrive
+template <typename Lookup>
+static double time_lookups(Lookup lookup) {
+  volatile uintptr_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < LOOKUP_ROUNDS; i++) {
+    uint64_t uid = (i & 7) == 7 ? (uint64_t)i * 0x100000001ULL : configs[i % configs.size()].band_id;
+    sink = sink + (uintptr_t)lookup(uid);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / LOOKUP_ROUNDS;
+}
+
+// Load count bands, check the table against the scan, return scan time / table time
+static double compare_at(int count) {
+  make_bands(count);
+  setup_band_registry(configs.data(), count);
+  TEST_ASSERT_EQUAL(count, band_registry_count());
+
+  for (const BandConfig& band : configs) {
+    const BandConfig* found = find_band_config(band.band_id);
+    TEST_ASSERT_NOT_NULL(found);
+    TEST_ASSERT_TRUE(found == find_band_config(band.band_id));  // Entries don't move
+    TEST_ASSERT_EQUAL_STRING(band.name, found->name);
+    BandConfig copy;
+    TEST_ASSERT_TRUE(band_registry_lookup(band.band_id, &copy));
+    TEST_ASSERT_EQUAL_MEMORY(&band, &copy, sizeof(BandConfig));
+  }
+  for (int i = 0; i < 1000; i++) {
+    uint64_t uid = next_uid();
+    TEST_ASSERT_EQUAL(scan_band_config(uid) != nullptr, find_band_config(uid) != nullptr);
+  }
+
+  double scan_ns = time_lookups([](uint64_t uid) { return scan_band_config(uid); });
+  double table_ns = time_lookups([](uint64_t uid) { return find_band_config(uid); });
+  char line[96];
+  snprintf(line, sizeof(line), "%d bands: scan %.1f ns, registry %.1f ns per lookup", count, scan_ns, table_ns);
+  TEST_MESSAGE(line);
+  return scan_ns / table_ns;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_lookup_at_5_bands(void) {
+  compare_at(5);
+}
+
+void test_lookup_at_500_bands(void) {
+  TEST_ASSERT_GREATER_OR_EQUAL(MIN_SPEEDUP_500, compare_at(500));
+}
+
+void test_lookup_at_5000_bands(void) {
+  TEST_ASSERT_GREATER_OR_EQUAL(MIN_SPEEDUP_5000, compare_at(5000));
+}
+
+// Runtime removes leave tombstones - bands further along a probe chain must stay reachable
+// and the freed slots must be reused
+void test_remove_and_insert_at_runtime(void) {
+  make_bands(5000);
+  setup_band_registry(configs.data(), (int)configs.size());
+
+  for (size_t i = 0; i < configs.size(); i += 2) {
+    TEST_ASSERT_TRUE(band_registry_remove(configs[i].band_id));
+  }
+  TEST_ASSERT_FALSE(band_registry_remove(configs[0].band_id));
+  TEST_ASSERT_EQUAL(2500, band_registry_count());
+  for (size_t i = 0; i < configs.size(); i++) {
+    TEST_ASSERT_EQUAL(i % 2 == 1, find_band_config(configs[i].band_id) != nullptr);
+  }
+
+  for (size_t i = 0; i < configs.size(); i += 2) {
+    TEST_ASSERT_NOT_NULL(band_registry_insert(configs[i]));
+  }
+  TEST_ASSERT_EQUAL(5000, band_registry_count());
+  for (const BandConfig& band : configs) {
+    TEST_ASSERT_NOT_NULL(find_band_config(band.band_id));
+  }
+}
+
+// Bands replaced one by one at full load - the tombstones must not pile up until an unknown
+// UID probes the whole table, and bands that stayed keep their slot
+void test_churn_keeps_lookups_fast(void) {
+  make_bands(BAND_REGISTRY_MAX_BANDS);
+  setup_band_registry(configs.data(), (int)configs.size());
+  const BandConfig* kept = find_band_config(configs[0].band_id);
+  double fresh_ns = time_lookups([](uint64_t uid) { return find_band_config(uid); });
+
+  for (int i = 0; i < CHURN_ROUNDS; i++) {
+    BandConfig& band = configs[1 + next_uid() % (configs.size() - 1)];
+    TEST_ASSERT_TRUE(band_registry_remove(band.band_id));
+    band.band_id = next_uid();
+    TEST_ASSERT_NOT_NULL(band_registry_insert(band));
+  }
+  TEST_ASSERT_EQUAL(BAND_REGISTRY_MAX_BANDS, band_registry_count());
+  for (const BandConfig& band : configs) {
+    TEST_ASSERT_NOT_NULL(find_band_config(band.band_id));
+  }
+  for (int i = 0; i < 1000; i++) {
+    uint64_t uid = next_uid();
+    TEST_ASSERT_EQUAL(scan_band_config(uid) != nullptr, find_band_config(uid) != nullptr);
+  }
+  TEST_ASSERT_TRUE(kept == find_band_config(configs[0].band_id));
+
+  double churned_ns = time_lookups([](uint64_t uid) { return find_band_config(uid); });
+  char line[96];
+  snprintf(line, sizeof(line), "After churn: %.1f ns per lookup, freshly loaded %.1f ns", churned_ns, fresh_ns);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_LESS_OR_EQUAL(fresh_ns * MAX_CHURN_SLOWDOWN, churned_ns);
+}
+
+// Past 75% load inserts are refused instead of letting probe chains grow
+void test_full_registry_refuses_inserts(void) {
+  make_bands(BAND_REGISTRY_MAX_BANDS + 1);
+  setup_band_registry(configs.data(), BAND_REGISTRY_MAX_BANDS);
+  TEST_ASSERT_EQUAL(BAND_REGISTRY_MAX_BANDS, band_registry_count());
+  TEST_ASSERT_NULL(band_registry_insert(configs.back()));
+  TEST_ASSERT_NOT_NULL(band_registry_insert(configs.front()));  // Replacing still works
+}
+
+int main(int argc, char** argv) {
+  host_set_serial_output(false);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_lookup_at_5_bands);
+  RUN_TEST(test_lookup_at_500_bands);
+  RUN_TEST(test_lookup_at_5000_bands);
+  RUN_TEST(test_remove_and_insert_at_runtime);
+  RUN_TEST(test_churn_keeps_lookups_fast);
+  RUN_TEST(test_full_registry_refuses_inserts);
+  return UNITY_END();
+}
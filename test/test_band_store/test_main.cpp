@@ -0,0 +1,277 @@
+/**
+ * Band store crash safety - native build, file-backed flash
+ *
+ * The store's partition is backed by a file (HostFlash.h), so a reboot is just the firmware
+ * mounting the same bytes again. Power is cut at every write and erase of an update and of a
+ * compaction, both cleanly and halfway through a record, and the store must come back with
+ * the bands exactly as they were before some prefix of the changes - never a torn band, a
+ * band from nowhere or a lost one - and keep working after that. Bands compiled into the
+ * firmware only have their sound rotation stored, so a new build's BAND_CONFIGS still applies.
+ *
+ * Run with: pio test -e native -f test_band_store
+ */
+
+#include <Arduino.h>
+#include <HostHardware.h>
+#include <HostFlash.h>
+#include <BandRegistry.h>
+#include <BandStore.h>
+#include <unity.h>
+#include <stdio.h>
+#include <map>
+#include <vector>
+
+#define FLASH_FILE "test_band_store_flash.bin"
+#define SNAPSHOT_FILE "test_band_store_snapshot.bin"
+#define BAND_COUNT 50
+#define TORN_RECORD_BYTES 32      // Power fails halfway through a 64-byte record
+#define MAX_CUT_POINTS 200        // More writes and erases than any change below needs
+
+typedef std::map<uint64_t, BandConfig> BandSet;
+
+static std::vector<BandConfig> compiled_bands;  // BAND_CONFIGS of the firmware that boots next
+
+static BandConfig make_band(int index, uint8_t sound_index) {
+  BandConfig band = {};
+  band.band_id = 0x04A0000000000000ULL + index * 0x10001ULL;
+  snprintf(band.name, sizeof(band.name), "Guest %d", index);
+  band.led_color = CRGB(index, 255 - index, 0x40);
+  band.sound_files[0] = 1 + index % 13;
+  band.sound_files[1] = 1 + (index + 1) % 13;
+  band.num_sounds = 2;
+  band.current_sound_index = sound_index;
+  return band;
+}
+
+static bool same_band(const BandConfig& a, const BandConfig& b) {
+  return a.band_id == b.band_id && strcmp(a.name, b.name) == 0 && a.led_color == b.led_color &&
+         memcmp(a.sound_files, b.sound_files, sizeof(a.sound_files)) == 0 && a.num_sounds == b.num_sounds &&
+         a.current_sound_index == b.current_sound_index;
+}
+
+static bool same_bands(const BandSet& a, const BandSet& b) {
+  if (a.size() != b.size()) return false;
+  for (const auto& entry : a) {
+    auto other = b.find(entry.first);
+    if (other == b.end() || !same_band(entry.second, other->second)) return false;
+  }
+  return true;
+}
+
+static BandSet registry_bands() {
+  BandSet bands;
+  for (int slot = 0; slot < BAND_REGISTRY_CAPACITY; slot++) {
+    BandConfig* band = band_registry_at(slot);
+    if (band != nullptr) bands[band->band_id] = *band;
+  }
+  return bands;
+}
+
+// Power back on and mount whatever reached the file
+static void reboot() {
+  host_flash_restore_power();
+  TEST_ASSERT_TRUE(host_flash_attach_file(FLASH_FILE));
+  setup_band_registry(compiled_bands.data(), (int)compiled_bands.size());
+  TEST_ASSERT_TRUE(setup_band_store(compiled_bands.data(), (int)compiled_bands.size()));
+}
+
+static void copy_file(const char* from, const char* to) {
+  FILE* in = fopen(from, "rb");
+  FILE* out = fopen(to, "wb");
+  TEST_ASSERT_NOT_NULL(in);
+  TEST_ASSERT_NOT_NULL(out);
+  static uint8_t buffer[64 * 1024];
+  size_t length;
+  while ((length = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    fwrite(buffer, 1, length, out);
+  }
+  fclose(in);
+  fclose(out);
+}
+
+// A change as the firmware makes it: registry first, then the store
+struct BandChange {
+  bool remove;
+  BandConfig band;
+};
+
+static void apply(const BandChange& change, BandSet* expected) {
+  if (change.remove) {
+    band_registry_remove(change.band.band_id);
+    band_store_delete(change.band.band_id);
+    expected->erase(change.band.band_id);
+  } else {
+    band_registry_insert(change.band);
+    band_store_save(change.band);
+    (*expected)[change.band.band_id] = change.band;
+  }
+}
+
+// Cut power at every write/erase the changes make, reboot, and check that the store holds the
+// bands as they were after some prefix of the changes - and that it still takes new changes
+static void check_power_cuts(const BandSet& before, const std::vector<BandChange>& changes, size_t torn_bytes) {
+  // What the bands look like after each prefix of the changes
+  std::vector<BandSet> prefixes(1, before);
+  for (const BandChange& change : changes) {
+    BandSet next = prefixes.back();
+    if (change.remove) {
+      next.erase(change.band.band_id);
+    } else {
+      next[change.band.band_id] = change.band;
+    }
+    prefixes.push_back(next);
+  }
+
+  copy_file(FLASH_FILE, SNAPSHOT_FILE);
+  bool completed = false;
+  for (uint32_t cut = 0; cut < MAX_CUT_POINTS && !completed; cut++) {
+    copy_file(SNAPSHOT_FILE, FLASH_FILE);
+    reboot();
+    TEST_ASSERT_TRUE(same_bands(before, registry_bands()));
+
+    host_flash_power_cut_after(cut, torn_bytes);
+    BandSet ignored;
+    for (const BandChange& change : changes) {
+      apply(change, &ignored);
+    }
+    completed = host_flash_powered();  // Every write landed before the cut point
+    reboot();
+
+    BandSet after = registry_bands();
+    size_t landed = prefixes.size();
+    for (size_t p = 0; p < prefixes.size(); p++) {
+      if (same_bands(prefixes[p], after)) landed = p;
+    }
+    char message[96];
+    snprintf(message, sizeof(message), "power cut after %u flash operations: bands match no prefix", cut);
+    TEST_ASSERT_TRUE_MESSAGE(landed < prefixes.size(), message);
+    if (completed) {
+      TEST_ASSERT_EQUAL(changes.size(), landed);
+    }
+
+    // Still usable after the crash, and that survives another reboot
+    BandSet expected = after;
+    apply({false, make_band(999, 1)}, &expected);
+    reboot();
+    TEST_ASSERT_TRUE(same_bands(expected, registry_bands()));
+  }
+  TEST_ASSERT_TRUE(completed);
+  copy_file(SNAPSHOT_FILE, FLASH_FILE);
+  reboot();
+}
+
+void setUp(void) {
+  remove(FLASH_FILE);
+  reboot();  // Fresh file - the store formats it
+}
+
+void tearDown(void) {
+  compiled_bands.clear();
+  host_flash_restore_power();
+  remove(FLASH_FILE);
+  remove(SNAPSHOT_FILE);
+}
+
+void test_bands_survive_reboot(void) {
+  BandSet expected;
+  for (int i = 0; i < BAND_COUNT; i++) {
+    apply({false, make_band(i, 0)}, &expected);
+  }
+  apply({false, make_band(7, 1)}, &expected);  // Sound rotation
+  apply({true, make_band(9, 0)}, &expected);
+
+  reboot();
+  TEST_ASSERT_EQUAL(BAND_COUNT - 1, band_registry_count());
+  TEST_ASSERT_TRUE(same_bands(expected, registry_bands()));
+}
+
+// Update, delete and insert - one log record each
+void test_power_cut_during_updates(void) {
+  BandSet before;
+  for (int i = 0; i < BAND_COUNT; i++) {
+    apply({false, make_band(i, 0)}, &before);
+  }
+  std::vector<BandChange> changes = {
+    {false, make_band(7, 1)},
+    {true, make_band(9, 0)},
+    {false, make_band(BAND_COUNT, 0)},
+  };
+  check_power_cuts(before, changes, 0);
+  check_power_cuts(before, changes, TORN_RECORD_BYTES);
+}
+
+// The bank is full, so the next save compacts the live bands into the spare bank
+void test_power_cut_during_compaction(void) {
+  BandSet before;
+  for (int i = 0; i < BAND_COUNT; i++) {
+    apply({false, make_band(i, 0)}, &before);
+  }
+  for (int i = 0; band_store_record_count() < band_store_capacity(); i++) {
+    apply({false, make_band(i % BAND_COUNT, (i / BAND_COUNT) % 2)}, &before);
+  }
+  reboot();
+  TEST_ASSERT_TRUE(same_bands(before, registry_bands()));
+
+  std::vector<BandChange> changes = { {false, make_band(3, 1)} };
+  check_power_cuts(before, changes, 0);
+  check_power_cuts(before, changes, TORN_RECORD_BYTES);
+}
+
+// Rotate a band's sound the way an activation does
+static void rotate(uint64_t band_id, uint8_t sound_index) {
+  BandConfig band = *find_band_config(band_id);
+  band.current_sound_index = sound_index;
+  band_store_save(*band_registry_insert(band));
+}
+
+// A compiled-in band keeps its rotation across reboots, compactions included, but takes its
+// name, color and sounds from the firmware that boots - a provisioned band keeps its own
+void test_compiled_in_band_follows_its_defaults(void) {
+  compiled_bands = { make_band(1, 0), make_band(2, 0) };
+  reboot();
+  uint64_t rotated_id = compiled_bands[0].band_id;
+  uint64_t provisioned_id = compiled_bands[1].band_id;
+  rotate(rotated_id, 1);
+  BandConfig provisioned = make_band(2, 0);
+  snprintf(provisioned.name, sizeof(provisioned.name), "Provisioned");
+  BandSet ignored;
+  apply({false, provisioned}, &ignored);
+
+  compiled_bands[0].led_color = CRGB::Orange;
+  compiled_bands[1].led_color = CRGB::Orange;
+  reboot();
+  TEST_ASSERT_TRUE(find_band_config(rotated_id)->led_color == CRGB(CRGB::Orange));
+  TEST_ASSERT_EQUAL_UINT8(1, find_band_config(rotated_id)->current_sound_index);
+  TEST_ASSERT_TRUE(same_band(provisioned, *find_band_config(provisioned_id)));
+
+  // Fill the bank so the next save compacts
+  uint8_t sound_index = 1;
+  while (band_store_record_count() < band_store_capacity()) {
+    sound_index = 1 - sound_index;
+    rotate(rotated_id, sound_index);
+  }
+  rotate(rotated_id, 1 - sound_index);
+  TEST_ASSERT_LESS_THAN(band_store_capacity(), band_store_record_count());
+  compiled_bands[0].led_color = CRGB::Purple;
+  reboot();
+  TEST_ASSERT_TRUE(find_band_config(rotated_id)->led_color == CRGB(CRGB::Purple));
+  TEST_ASSERT_EQUAL_UINT8(1 - sound_index, find_band_config(rotated_id)->current_sound_index);
+  TEST_ASSERT_TRUE(same_band(provisioned, *find_band_config(provisioned_id)));
+
+  // Dropped from BAND_CONFIGS - dropped from the registry
+  compiled_bands.erase(compiled_bands.begin());
+  reboot();
+  TEST_ASSERT_NULL(find_band_config(rotated_id));
+  TEST_ASSERT_TRUE(same_band(provisioned, *find_band_config(provisioned_id)));
+}
+
+int main(int argc, char** argv) {
+  host_set_serial_output(false);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_bands_survive_reboot);
+  RUN_TEST(test_power_cut_during_updates);
+  RUN_TEST(test_power_cut_during_compaction);
+  RUN_TEST(test_compiled_in_band_follows_its_defaults);
+  return UNITY_END();
+}
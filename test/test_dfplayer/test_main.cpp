@@ -0,0 +1,429 @@
+/**
+ * Non-blocking DFPlayer driver - native build, virtual time
+ *
+ * The driver talks to a scripted fake serial port instead of the simulated module: every
+ * frame the firmware writes is recorded, and the test decides what the "module" answers and
+ * when. Checks the wire format byte-for-byte, that commands are paced by ACKs, that nothing
+ * the firmware calls ever waits on the port, and how the parser copes with errors, silence
+ * and line noise.
+ *
+ * Run with: pio test -e native -f test_dfplayer
+ */
+
+#include <Arduino.h>
+#include <HostHardware.h>
+#include <AudioControlDFPlayer.h>
+#include <unity.h>
+#include <deque>
+#include <vector>
+
+#define FRAME_SIZE 10
+#define LOOP_INTERVAL_MS 1
+#define BOOT_MS 1000                // Reset to "online", like a real module
+
+// Module messages
+#define MSG_ONLINE 0x3F
+#define MSG_SD_FINISHED 0x3D
+#define MSG_ERROR 0x40
+#define MSG_ACK 0x41
+#define MSG_SD_FILES 0x48
+#define MSG_STATUS 0x42
+#define STATUS_PLAYING 0x0201       // SD card, playing
+#define STATUS_STOPPED 0x0200
+
+struct Frame {
+  uint8_t command;
+  uint16_t param;
+  unsigned long at;  // millis() when the firmware wrote it
+};
+
+struct Event {
+  AudioEvent event;
+  uint16_t value;
+};
+
+static void build_frame(uint8_t command, uint16_t param, bool ack, uint8_t* frame) {
+  uint8_t bytes[FRAME_SIZE] = {0x7E, 0xFF, 0x06, command, (uint8_t)(ack ? 1 : 0),
+                               (uint8_t)(param >> 8), (uint8_t)(param & 0xFF), 0, 0, 0xEF};
+  uint16_t sum = 0;
+  for (int i = 1; i < 7; i++) sum += bytes[i];
+  uint16_t check = -sum;
+  bytes[7] = check >> 8;
+  bytes[8] = check & 0xFF;
+  memcpy(frame, bytes, FRAME_SIZE);
+}
+
+// Scripted module: records what the firmware sends, answers what the test queues
+class ScriptedPort : public Stream {
+public:
+  std::vector<uint8_t> written;
+  std::vector<Frame> frames;
+  bool auto_ack = true;  // Answer every command with an ACK, as a healthy module does
+  int status_reply = -1; // Answer status queries with this word (-1 = leave them to the test)
+
+  int available() override { return (int)rx_.size(); }
+  int read() override {
+    if (rx_.empty()) return -1;
+    uint8_t b = rx_.front();
+    rx_.pop_front();
+    return b;
+  }
+  int peek() override { return rx_.empty() ? -1 : rx_.front(); }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    for (size_t i = 0; i < size; i++) {
+      written.push_back(buffer[i]);
+      if (written.size() % FRAME_SIZE == 0) {
+        const uint8_t* frame = &written[written.size() - FRAME_SIZE];
+        frames.push_back({frame[3], (uint16_t)((frame[5] << 8) | frame[6]), millis()});
+        if (auto_ack) send(MSG_ACK, 0);
+        if (frame[3] == MSG_STATUS && status_reply >= 0) send(MSG_STATUS, status_reply);
+      }
+    }
+    return size;
+  }
+  using Print::write;
+
+  void send(uint8_t command, uint16_t param) {
+    uint8_t frame[FRAME_SIZE];
+    build_frame(command, param, false, frame);
+    send_bytes(frame, FRAME_SIZE);
+  }
+  void send_bytes(const uint8_t* bytes, size_t length) {
+    rx_.insert(rx_.end(), bytes, bytes + length);
+  }
+
+private:
+  std::deque<uint8_t> rx_;
+};
+
+static ScriptedPort* port = nullptr;
+static std::vector<Event> events;
+
+static void on_event(AudioEvent event, uint16_t value) {
+  events.push_back({event, value});
+}
+
+static int count_events(AudioEvent event) {
+  int count = 0;
+  for (const Event& e : events) {
+    if (e.event == event) count++;
+  }
+  return count;
+}
+
+static const Event* last_event(AudioEvent event) {
+  for (auto e = events.rbegin(); e != events.rend(); ++e) {
+    if (e->event == event) return &*e;
+  }
+  return nullptr;
+}
+
+static int count_frames(uint8_t command, size_t from = 0) {
+  int count = 0;
+  for (size_t i = from; i < port->frames.size(); i++) {
+    if (port->frames[i].command == command) count++;
+  }
+  return count;
+}
+
+static void run_for(uint32_t ms) {
+  for (uint32_t t = 0; t < ms; t += LOOP_INTERVAL_MS) {
+    loop_audio_dfplayer();
+    delay(LOOP_INTERVAL_MS);
+  }
+}
+
+// Reset the driver onto a fresh port and bring the module online
+static void start_module() {
+  delete port;
+  port = new ScriptedPort();
+  events.clear();
+  setup_audio_dfplayer_stream(*port);
+  run_for(BOOT_MS);
+  port->send(MSG_ONLINE, 0x02);
+  run_for(DFPLAYER_RESET_TIME_MS);  // Configuration goes out once the reset time is up
+}
+
+void setUp(void) {
+  start_module();
+}
+
+void tearDown(void) {}
+
+// The reset frame, byte for byte, and nothing that waits for the module
+void test_setup_returns_without_waiting(void) {
+  ScriptedPort fresh;
+  unsigned long before = millis();
+  TEST_ASSERT_TRUE(setup_audio_dfplayer_stream(fresh));
+  TEST_ASSERT_EQUAL_UINT32(before, millis());
+
+  static const uint8_t reset[FRAME_SIZE] = {0x7E, 0xFF, 0x06, 0x0C, 0x01, 0x00, 0x00, 0xFE, 0xEE, 0xEF};
+  TEST_ASSERT_EQUAL(FRAME_SIZE, (int)fresh.written.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(reset, fresh.written.data(), FRAME_SIZE);
+  TEST_ASSERT_TRUE(dfplayer_is_starting());
+
+  start_module();  // Leave the driver on a port that outlives this test
+}
+
+// Online -> volume, EQ, output device and file count query, one per ACK, in that order
+void test_configuration_after_online(void) {
+  TEST_ASSERT_TRUE(dfplayer_is_ready());
+  TEST_ASSERT_EQUAL(1, count_events(AUDIO_EVENT_READY));
+  TEST_ASSERT_EQUAL(5, (int)port->frames.size());
+  TEST_ASSERT_EQUAL_HEX8(0x0C, port->frames[0].command);
+  TEST_ASSERT_EQUAL_HEX8(0x06, port->frames[1].command);
+  TEST_ASSERT_EQUAL_UINT16(get_volume(), port->frames[1].param);
+  TEST_ASSERT_EQUAL_HEX8(0x07, port->frames[2].command);
+  TEST_ASSERT_EQUAL_HEX8(0x09, port->frames[3].command);
+  TEST_ASSERT_EQUAL_UINT16(2, port->frames[3].param);  // SD card
+  TEST_ASSERT_EQUAL_HEX8(0x48, port->frames[4].command);
+  for (size_t i = 2; i < port->frames.size(); i++) {
+    TEST_ASSERT_GREATER_OR_EQUAL(DFPLAYER_COMMAND_GAP_MS, port->frames[i].at - port->frames[i - 1].at);
+  }
+
+  port->send(MSG_SD_FILES, 13);
+  run_for(10);
+  TEST_ASSERT_EQUAL_UINT16(13, get_file_count());
+}
+
+// Play is queued, not sent - the frame goes out on the next loop pass
+void test_play_is_queued_and_reported(void) {
+  size_t sent = port->frames.size();
+  unsigned long before = millis();
+  TEST_ASSERT_TRUE(play_sound_file(SOUND_CHIME));
+  TEST_ASSERT_EQUAL_UINT32(before, millis());
+  TEST_ASSERT_EQUAL(sent, port->frames.size());
+  TEST_ASSERT_EQUAL(1, get_audio_queue_depth());
+
+  run_for(10);
+  TEST_ASSERT_EQUAL(sent + 1, port->frames.size());
+  TEST_ASSERT_EQUAL_HEX8(0x03, port->frames.back().command);
+  TEST_ASSERT_EQUAL_UINT16(SOUND_CHIME, port->frames.back().param);
+  TEST_ASSERT_EQUAL(1, count_events(AUDIO_EVENT_PLAY_STARTED));
+  TEST_ASSERT_TRUE(is_audio_playing());
+
+  // Many modules send the finished message twice - reported once
+  run_for(2000);
+  port->send(MSG_SD_FINISHED, SOUND_CHIME);
+  port->send(MSG_SD_FINISHED, SOUND_CHIME);
+  run_for(10);
+  TEST_ASSERT_EQUAL(1, count_events(AUDIO_EVENT_PLAY_FINISHED));
+  TEST_ASSERT_EQUAL_UINT16(SOUND_CHIME, last_event(AUDIO_EVENT_PLAY_FINISHED)->value);
+  TEST_ASSERT_FALSE(is_audio_playing());
+}
+
+// Nothing goes out while the module is still buffering a track - then the queue drains
+void test_commands_wait_out_the_play_settle_time(void) {
+  size_t sent = port->frames.size();
+  play_sound_file(SOUND_HELLO);
+  set_volume(10);
+  run_for(DFPLAYER_PLAY_SETTLE_MS + 50);
+  TEST_ASSERT_EQUAL(sent + 2, port->frames.size());
+  TEST_ASSERT_GREATER_OR_EQUAL(DFPLAYER_PLAY_SETTLE_MS, port->frames.back().at - port->frames[sent].at);
+  set_volume(DEFAULT_VOLUME);
+}
+
+// A command the module never acknowledges holds the queue for the ACK timeout only
+void test_missing_ack_times_out(void) {
+  port->auto_ack = false;
+  size_t sent = port->frames.size();
+  set_volume(20);
+  set_volume(DEFAULT_VOLUME);
+  run_for(DFPLAYER_ACK_TIMEOUT_MS + 50);
+
+  TEST_ASSERT_EQUAL(1, count_events(AUDIO_EVENT_ACK_TIMEOUT));
+  TEST_ASSERT_EQUAL_HEX16(0x06, last_event(AUDIO_EVENT_ACK_TIMEOUT)->value);
+  TEST_ASSERT_EQUAL(sent + 2, port->frames.size());
+  TEST_ASSERT_GREATER_OR_EQUAL(DFPLAYER_ACK_TIMEOUT_MS, port->frames.back().at - port->frames[sent].at);
+}
+
+// An error replaces the ACK and ends the play
+void test_error_replaces_the_ack(void) {
+  port->auto_ack = false;
+  play_sound_file(200);
+  run_for(10);
+  port->send(MSG_ERROR, DFPLAYER_ERROR_FILE_INDEX);
+  run_for(10);
+
+  TEST_ASSERT_EQUAL(1, count_events(AUDIO_EVENT_ERROR));
+  TEST_ASSERT_EQUAL_UINT16(DFPLAYER_ERROR_FILE_INDEX, last_event(AUDIO_EVENT_ERROR)->value);
+  TEST_ASSERT_EQUAL(0, count_events(AUDIO_EVENT_PLAY_STARTED));
+  TEST_ASSERT_FALSE(is_audio_playing());
+
+  size_t sent = port->frames.size();
+  set_volume(DEFAULT_VOLUME);  // Goes out after the play settle time, not the ACK timeout
+  run_for(DFPLAYER_PLAY_SETTLE_MS);
+  TEST_ASSERT_EQUAL(sent + 1, port->frames.size());
+  TEST_ASSERT_EQUAL(0, count_events(AUDIO_EVENT_ACK_TIMEOUT));
+}
+
+// Noise, a stray start byte, a bad checksum and a frame split across loop passes
+void test_parser_resynchronizes(void) {
+  static const uint8_t noise[] = {0x00, 0x7E, 0x13, 0xEF, 0x7E, 0x7E};
+  port->send_bytes(noise, sizeof(noise));
+  uint8_t corrupt[FRAME_SIZE];
+  build_frame(MSG_SD_FILES, 99, false, corrupt);
+  corrupt[8] ^= 0x01;
+  port->send_bytes(corrupt, FRAME_SIZE);
+  run_for(5);
+  TEST_ASSERT_EQUAL(0, count_events(AUDIO_EVENT_FILE_COUNT));
+
+  uint8_t good[FRAME_SIZE];
+  build_frame(MSG_SD_FILES, 42, false, good);
+  port->send_bytes(good, 4);
+  run_for(5);
+  port->send_bytes(good + 4, FRAME_SIZE - 4);
+  run_for(5);
+  TEST_ASSERT_EQUAL(1, count_events(AUDIO_EVENT_FILE_COUNT));
+  TEST_ASSERT_EQUAL_UINT16(42, get_file_count());
+}
+
+// The ring buffer is bounded - a full queue refuses instead of blocking
+void test_queue_is_bounded(void) {
+  port->auto_ack = false;
+  int accepted = 0;
+  for (int i = 0; i < DFPLAYER_QUEUE_SIZE + 4; i++) {
+    accepted += play_sound_file(SOUND_CHIME) ? 1 : 0;
+  }
+  TEST_ASSERT_EQUAL(DFPLAYER_QUEUE_SIZE, accepted);
+  TEST_ASSERT_EQUAL(DFPLAYER_QUEUE_SIZE, get_audio_queue_depth());
+
+  stop_audio();  // Drops the backlog
+  TEST_ASSERT_EQUAL(1, get_audio_queue_depth());
+  port->auto_ack = true;
+  run_for(DFPLAYER_ACK_TIMEOUT_MS + 50);
+  TEST_ASSERT_EQUAL(0, get_audio_queue_depth());
+}
+
+// A module that never answers fails the driver after the init timeout - no hang
+void test_silent_module_fails_init(void) {
+  delete port;
+  port = new ScriptedPort();
+  port->auto_ack = false;
+  events.clear();
+  setup_audio_dfplayer_stream(*port);
+  run_for(DFPLAYER_INIT_TIMEOUT_MS + 50);
+
+  TEST_ASSERT_EQUAL(1, count_events(AUDIO_EVENT_INIT_FAILED));
+  TEST_ASSERT_FALSE(dfplayer_is_ready());
+  TEST_ASSERT_FALSE(play_sound_file(SOUND_CHIME));
+  TEST_ASSERT_EQUAL(1, (int)port->frames.size());  // Only the reset
+}
+
+// Without BUSY a lost finished message would leave the track "playing" forever - the status
+// query, sent only while playing and only on an idle link, catches the end
+void test_status_query_catches_a_lost_finish(void) {
+  port->status_reply = STATUS_PLAYING;
+  size_t sent = port->frames.size();
+  play_sound_file(SOUND_CHIME);
+  run_for(DFPLAYER_STATUS_POLL_MS - 10);
+  TEST_ASSERT_EQUAL(0, count_frames(MSG_STATUS, sent));
+
+  run_for(3 * DFPLAYER_STATUS_POLL_MS);
+  TEST_ASSERT_EQUAL(3, count_frames(MSG_STATUS, sent));
+  TEST_ASSERT_TRUE(is_audio_playing());
+  for (size_t i = sent + 1; i < port->frames.size(); i++) {
+    TEST_ASSERT_GREATER_OR_EQUAL(DFPLAYER_STATUS_POLL_MS, port->frames[i].at - port->frames[i - 1].at);
+  }
+
+  port->status_reply = STATUS_STOPPED;  // Track ended, finished message lost
+  run_for(DFPLAYER_STATUS_POLL_MS + 10);
+  TEST_ASSERT_FALSE(is_audio_playing());
+  TEST_ASSERT_EQUAL(1, count_events(AUDIO_EVENT_PLAY_FINISHED));
+  TEST_ASSERT_EQUAL_UINT16(SOUND_CHIME, last_event(AUDIO_EVENT_PLAY_FINISHED)->value);
+
+  size_t after = port->frames.size();
+  run_for(2 * DFPLAYER_STATUS_POLL_MS);
+  TEST_ASSERT_EQUAL(0, count_frames(MSG_STATUS, after));  // Idle - no more queries
+}
+
+// A "stopped" answer to a query sent before the current play command is about the old track
+void test_stale_status_reply_is_ignored(void) {
+  play_sound_file(SOUND_CHIME);
+  run_for(DFPLAYER_STATUS_POLL_MS + 10);
+  TEST_ASSERT_EQUAL_HEX8(MSG_STATUS, port->frames.back().command);
+
+  play_sound_file(SOUND_HELLO);
+  run_for(DFPLAYER_COMMAND_GAP_MS + 10);
+  TEST_ASSERT_EQUAL_HEX8(0x03, port->frames.back().command);
+  port->send(MSG_STATUS, STATUS_STOPPED);  // Late answer to the query
+  run_for(10);
+
+  TEST_ASSERT_TRUE(is_audio_playing());
+  TEST_ASSERT_EQUAL(0, count_events(AUDIO_EVENT_PLAY_FINISHED));
+}
+
+// BUSY wired (simulated module on UART2, BUSY on GPIO27) - the pin is proven by the first
+// track and trusted from then on, so no status queries
+void test_wired_busy_is_trusted(void) {
+  int queries = 0;
+  host_dfplayer_on_command([&queries](uint8_t command, uint16_t param) { queries += command == MSG_STATUS; });
+  host_dfplayer_set_busy_wired(true);
+  setup_audio_dfplayer();
+  run_for(DFPLAYER_RESET_TIME_MS + 500);
+  TEST_ASSERT_TRUE(dfplayer_is_ready());
+
+  events.clear();
+  play_sound_file(SOUND_CHIME);  // 3 s on the simulated card
+  run_for(DFPLAYER_BUSY_VERIFY_MS + 100);
+  TEST_ASSERT_TRUE(is_audio_busy_pin_mode());
+  TEST_ASSERT_TRUE(is_audio_playing());
+
+  run_for(3000);
+  TEST_ASSERT_FALSE(is_audio_playing());
+  TEST_ASSERT_EQUAL(1, count_events(AUDIO_EVENT_PLAY_FINISHED));
+  TEST_ASSERT_EQUAL(0, queries);
+  host_dfplayer_on_command(nullptr);
+}
+
+// BUSY left unconnected - the pull-up reads "idle" through the whole track. The pin is
+// dropped once the track should long have pulled it low, and playback is tracked over serial
+void test_unwired_busy_falls_back_to_serial(void) {
+  int queries = 0;
+  host_dfplayer_on_command([&queries](uint8_t command, uint16_t param) { queries += command == MSG_STATUS; });
+  host_dfplayer_set_busy_wired(false);
+  setup_audio_dfplayer();
+  run_for(DFPLAYER_RESET_TIME_MS + 500);
+  TEST_ASSERT_TRUE(dfplayer_is_ready());
+
+  events.clear();
+  play_sound_file(SOUND_CHIME);
+  run_for(DFPLAYER_BUSY_VERIFY_MS / 2);
+  TEST_ASSERT_TRUE(is_audio_playing());  // Not the pull-up's "idle"
+  TEST_ASSERT_TRUE(is_audio_busy_pin_mode());
+
+  run_for(DFPLAYER_BUSY_VERIFY_MS);
+  TEST_ASSERT_FALSE(is_audio_busy_pin_mode());
+  TEST_ASSERT_TRUE(is_audio_playing());
+
+  run_for(2500);
+  TEST_ASSERT_FALSE(is_audio_playing());
+  TEST_ASSERT_EQUAL(1, count_events(AUDIO_EVENT_PLAY_FINISHED));
+  TEST_ASSERT_GREATER_THAN(0, queries);
+
+  host_dfplayer_on_command(nullptr);
+  host_dfplayer_set_busy_wired(true);
+}
+
+int main(int argc, char** argv) {
+  host_set_virtual_time(true);
+  host_set_serial_output(false);
+  set_audio_event_callback(on_event);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_setup_returns_without_waiting);
+  RUN_TEST(test_configuration_after_online);
+  RUN_TEST(test_play_is_queued_and_reported);
+  RUN_TEST(test_commands_wait_out_the_play_settle_time);
+  RUN_TEST(test_missing_ack_times_out);
+  RUN_TEST(test_error_replaces_the_ack);
+  RUN_TEST(test_parser_resynchronizes);
+  RUN_TEST(test_queue_is_bounded);
+  RUN_TEST(test_silent_module_fails_init);
+  RUN_TEST(test_status_query_catches_a_lost_finish);
+  RUN_TEST(test_stale_status_reply_is_ignored);
+  RUN_TEST(test_wired_busy_is_trusted);
+  RUN_TEST(test_unwired_busy_falls_back_to_serial);
+  return UNITY_END();
+}
@@ -0,0 +1,130 @@
+/**
+ * RMT LED encoder - native build
+ *
+ * The RMT backend (LEDOutput.h) turns a frame into one 32-bit RMT symbol per bit and the
+ * peripheral clocks those out as-is, so the symbol words are the waveform. They are checked
+ * here byte-for-byte against words written out by hand from the WS2812B datasheet, in the
+ * little-endian rmt_item32_t layout the driver copies into RMT memory.
+ *
+ * Run with: pio test -e native -f test_led_output
+ */
+
+#include <Arduino.h>
+#include <LEDControl.h>
+#include <LEDOutput.h>
+#include <unity.h>
+#include <string.h>
+
+// WS2812B datasheet: T0H 0.4us, T0L 0.85us, T1H 0.8us, T1L 0.45us, each +-150ns
+#define RMT_TICK_NS 25              // 80MHz APB / LED_RMT_CLK_DIV
+#define WS2812_TOLERANCE_NS 150
+#define RMT_MEM_BLOCK_ITEMS 64
+#define RMT_MAX_MEM_BLOCKS 8
+
+// rmt_item32_t in memory: duration0 | level0 << 15 | duration1 << 16 | level1 << 31, little-endian
+static const uint8_t ZERO_BIT[4] = { 0x10, 0x80, 0x22, 0x00 };  // 16 ticks high, 34 low
+static const uint8_t ONE_BIT[4] = { 0x20, 0x80, 0x12, 0x00 };   // 32 ticks high, 18 low
+
+// The bytes the RMT should get for value, MSB first
+static void expected_byte(uint8_t value, uint8_t* bytes) {
+  for (int bit = 7; bit >= 0; bit--) {
+    memcpy(bytes, (value >> bit) & 1 ? ONE_BIT : ZERO_BIT, 4);
+    bytes += 4;
+  }
+}
+
+static void check_phase(uint32_t ticks, uint32_t datasheet_ns) {
+  TEST_ASSERT_UINT32_WITHIN(WS2812_TOLERANCE_NS, datasheet_ns, ticks * RMT_TICK_NS);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// The symbol constants sit inside the datasheet windows, high phase first
+void test_bit_timings_match_the_datasheet(void) {
+  TEST_ASSERT_EQUAL(RMT_TICK_NS, 1000 / (80 / LED_RMT_CLK_DIV));
+  check_phase(WS2812_T0H_TICKS, 400);
+  check_phase(WS2812_T0L_TICKS, 850);
+  check_phase(WS2812_T1H_TICKS, 800);
+  check_phase(WS2812_T1L_TICKS, 450);
+
+  uint32_t zero = LED_RMT_ITEM(WS2812_T0H_TICKS, WS2812_T0L_TICKS);
+  TEST_ASSERT_EQUAL_UINT32(WS2812_T0H_TICKS, zero & 0x7FFF);
+  TEST_ASSERT_EQUAL_UINT32(1, (zero >> 15) & 1);        // High...
+  TEST_ASSERT_EQUAL_UINT32(WS2812_T0L_TICKS, (zero >> 16) & 0x7FFF);
+  TEST_ASSERT_EQUAL_UINT32(0, zero >> 31);              // ...then low
+}
+
+// Every byte value, against the hand-written words
+void test_every_byte_encodes_exactly(void) {
+  for (int value = 0; value < 256; value++) {
+    uint32_t items[8];
+    uint8_t expected[sizeof(items)];
+    led_encode_byte((uint8_t)value, items);
+    expected_byte((uint8_t)value, expected);
+    char message[16];
+    snprintf(message, sizeof(message), "byte 0x%02X", value);
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, items, sizeof(items), message);
+  }
+}
+
+// One pixel written out bit by bit: G=0xA5, R=0x0F, B=0x80 go out as G, R, B
+void test_pixel_is_sent_grb_msb_first(void) {
+  static const uint8_t expected[LED_RMT_ITEMS_PER_PIXEL * 4] = {
+    // G = 0xA5 = 1010 0101
+    0x20, 0x80, 0x12, 0x00,  0x10, 0x80, 0x22, 0x00,  0x20, 0x80, 0x12, 0x00,  0x10, 0x80, 0x22, 0x00,
+    0x10, 0x80, 0x22, 0x00,  0x20, 0x80, 0x12, 0x00,  0x10, 0x80, 0x22, 0x00,  0x20, 0x80, 0x12, 0x00,
+    // R = 0x0F = 0000 1111
+    0x10, 0x80, 0x22, 0x00,  0x10, 0x80, 0x22, 0x00,  0x10, 0x80, 0x22, 0x00,  0x10, 0x80, 0x22, 0x00,
+    0x20, 0x80, 0x12, 0x00,  0x20, 0x80, 0x12, 0x00,  0x20, 0x80, 0x12, 0x00,  0x20, 0x80, 0x12, 0x00,
+    // B = 0x80 = 1000 0000
+    0x20, 0x80, 0x12, 0x00,  0x10, 0x80, 0x22, 0x00,  0x10, 0x80, 0x22, 0x00,  0x10, 0x80, 0x22, 0x00,
+    0x10, 0x80, 0x22, 0x00,  0x10, 0x80, 0x22, 0x00,  0x10, 0x80, 0x22, 0x00,  0x10, 0x80, 0x22, 0x00,
+  };
+  CRGB pixel(0x0F, 0xA5, 0x80);
+  uint32_t items[LED_RMT_ITEMS_PER_PIXEL];
+  led_encode_frame(&pixel, 1, 255, items);
+  TEST_ASSERT_EQUAL_MEMORY(expected, items, sizeof(expected));
+}
+
+// A whole strip at partial brightness: each channel scaled as FastLED's scale8 does
+// (v * (1 + brightness) >> 8), and not one symbol written past the frame
+void test_frame_with_brightness(void) {
+  const uint8_t brightness = 100;
+  CRGB pixels[NUM_LEDS];
+  for (int i = 0; i < NUM_LEDS; i++) {
+    pixels[i] = CRGB(i * 15, 255 - i * 7, (i * 37) & 0xFF);
+  }
+
+  const uint32_t canary = 0xDEADBEEF;
+  uint32_t items[NUM_LEDS * LED_RMT_ITEMS_PER_PIXEL + 1];
+  items[NUM_LEDS * LED_RMT_ITEMS_PER_PIXEL] = canary;
+  led_encode_frame(pixels, NUM_LEDS, brightness, items);
+
+  uint8_t expected[NUM_LEDS * LED_RMT_ITEMS_PER_PIXEL * 4];
+  for (int i = 0; i < NUM_LEDS; i++) {
+    uint8_t* pixel = expected + i * LED_RMT_ITEMS_PER_PIXEL * 4;
+    expected_byte((uint8_t)((pixels[i].g * (1 + brightness)) >> 8), pixel);
+    expected_byte((uint8_t)((pixels[i].r * (1 + brightness)) >> 8), pixel + 32);
+    expected_byte((uint8_t)((pixels[i].b * (1 + brightness)) >> 8), pixel + 64);
+  }
+  TEST_ASSERT_EQUAL_MEMORY(expected, items, sizeof(expected));
+  TEST_ASSERT_EQUAL_HEX32(canary, items[NUM_LEDS * LED_RMT_ITEMS_PER_PIXEL]);
+}
+
+// The whole frame plus the end marker fits in RMT memory, so no refill interrupt mid-frame
+void test_frame_fits_in_rmt_memory(void) {
+  int items = NUM_LEDS * LED_RMT_ITEMS_PER_PIXEL + 1;
+  TEST_ASSERT_LESS_OR_EQUAL(RMT_MAX_MEM_BLOCKS * RMT_MEM_BLOCK_ITEMS, items);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bit_timings_match_the_datasheet);
+  RUN_TEST(test_every_byte_encodes_exactly);
+  RUN_TEST(test_pixel_is_sent_grb_msb_first);
+  RUN_TEST(test_frame_with_brightness);
+  RUN_TEST(test_frame_fits_in_rmt_memory);
+  return UNITY_END();
+}
@@ -0,0 +1,168 @@
+/**
+ * Broker outages - native build, virtual time
+ *
+ * Runs the firmware against the in-process broker and stops it, restarts it and brings it
+ * back while bands are being tapped. The MQTT session lives on its own task, so a guest must
+ * not be able to tell: the tap beep comes as fast as with the broker up and no loop() pass
+ * takes longer than it did then. Activations made while the broker is away are published once the session is back.
+ *
+ * Run with: pio test -e native -f test_mqtt_outage
+ */
+
+#include <Arduino.h>
+#include <HostHardware.h>
+#include <HostPN532.h>
+#include <HostBroker.h>
+#include <AudioControlDFPlayer.h>
+#include <HomeAssistantControl.h>
+#include <unity.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#define WARMUP_MS 15000             // Boot, WiFi, MQTT and the startup sound
+#define UNKNOWN_BAND 0xDEADBEEF     // Shortest activation - the error sound instead of a greeting
+#define TAP_HOLD_MS 200
+#define ACTIVATION_MS 15000         // Chase, red flash and error sound, then the cooldown
+#define OUTAGE_TAPS 3               // Long enough for several reconnect attempts
+#define MAX_TAP_RESPONSE_MS 150     // Tap to beep: one loop delay plus the read and the UART
+#define MAIN_LOOP_DELAY_MS 100      // From src/main.cpp
+#define OUTAGE_SLACK_MS 5           // Beyond the broker-up figures - scheduling noise, not a connect
+#define RECONNECT_MS (MQTT_RETRY_INTERVAL_MS + 1000)
+
+// Recorded on the main thread (hardware events and loop())
+static uint64_t beep_us = 0;      // Last tap beep sent to the DFPlayer
+static uint64_t longest_pass_us = 0;
+static uint32_t baseline_response_ms = 0;  // Slowest tap to beep and loop() pass with the broker up
+static uint64_t baseline_pass_us = 0;
+
+// Written on the MQTT task thread
+static std::atomic<int> wand_publishes(0);
+
+static void on_dfplayer_command(uint8_t command, uint16_t param) {
+  if (command == 0x03 && param == SOUND_TAP_START) {  // Play track
+    beep_us = host_micros64();
+  }
+}
+
+static void on_publish(const char* topic, const uint8_t* payload, size_t length, bool retain) {
+  if (strcmp(topic, MQTT_WAND_TOPIC) == 0) {
+    wand_publishes++;
+  }
+}
+
+static void run_for(uint32_t ms) {
+  uint64_t until = host_micros64() + (uint64_t)ms * 1000;
+  while (host_micros64() < until) {
+    uint64_t start = host_micros64();
+    host_loop_tick();
+    longest_pass_us = std::max(longest_pass_us, host_micros64() - start);
+  }
+}
+
+static std::string device_status() {
+  std::string status;
+  host_broker_retained(MQTT_STATUS_TOPIC, &status);
+  return status;
+}
+
+// Run until the device's retained status reads status - false on timeout
+static bool wait_for_status(const char* status, uint32_t timeout_ms) {
+  uint64_t deadline = host_micros64() + (uint64_t)timeout_ms * 1000;
+  while (device_status() != status && host_micros64() < deadline) {
+    run_for(MAIN_LOOP_DELAY_MS);
+  }
+  return device_status() == status;
+}
+
+// Tap a band and let its activation and cooldown run out - returns tap to beep in ms
+static uint32_t tap_response_ms() {
+  beep_us = 0;
+  uint64_t tap_us = host_micros64();
+  host_pn532_tap(UNKNOWN_BAND, 4, TAP_HOLD_MS);
+  run_for(ACTIVATION_MS);
+  TEST_ASSERT_NOT_EQUAL(0, beep_us);
+  return (uint32_t)((beep_us - tap_us) / 1000);
+}
+
+void setUp(void) {
+  longest_pass_us = 0;
+}
+
+void tearDown(void) {
+  host_broker_set_online(true);
+}
+
+// Taps while the broker is away answer and loop as fast as the baseline did
+static void check_taps_unaffected(int taps) {
+  for (int i = 0; i < taps; i++) {
+    TEST_ASSERT_LESS_OR_EQUAL(baseline_response_ms + OUTAGE_SLACK_MS, tap_response_ms());
+  }
+  TEST_ASSERT_LESS_OR_EQUAL(baseline_pass_us + OUTAGE_SLACK_MS * 1000, longest_pass_us);
+}
+
+// Baseline - the broker is up and each activation is published
+void test_taps_with_the_broker_up(void) {
+  TEST_ASSERT_TRUE(is_mqtt_connected());
+  int before = wand_publishes.load();
+  for (int i = 0; i < 2; i++) {
+    baseline_response_ms = std::max(baseline_response_ms, tap_response_ms());
+  }
+  baseline_pass_us = longest_pass_us;
+  TEST_ASSERT_LESS_OR_EQUAL(MAX_TAP_RESPONSE_MS, baseline_response_ms);
+  TEST_ASSERT_EQUAL(before + 2, wand_publishes.load());
+}
+
+// Broker stopped - connects are refused every retry, taps are answered as fast as before,
+// and their activations wait for the broker
+void test_broker_stopped_then_started(void) {
+  int before = wand_publishes.load();
+  host_broker_set_online(false);
+  TEST_ASSERT_EQUAL_STRING("offline", device_status().c_str());  // Will, published by the broker
+  run_for(MAIN_LOOP_DELAY_MS);
+  TEST_ASSERT_FALSE(is_mqtt_connected());
+
+  check_taps_unaffected(OUTAGE_TAPS);
+  TEST_ASSERT_FALSE(is_mqtt_connected());
+  TEST_ASSERT_EQUAL(before, wand_publishes.load());
+
+  // Started again - the next retry connects and the held activations go out
+  host_broker_set_online(true);
+  TEST_ASSERT_TRUE(wait_for_status("online", RECONNECT_MS));
+  run_for(1000);
+  TEST_ASSERT_TRUE(is_mqtt_connected());
+  TEST_ASSERT_EQUAL(before + OUTAGE_TAPS, wand_publishes.load());
+}
+
+// Broker restarted under the session - a tap right after it is answered while the device
+// reconnects, and published once it has
+void test_broker_restart_during_a_tap(void) {
+  int before = wand_publishes.load();
+  host_broker_drop_sessions();
+  TEST_ASSERT_EQUAL_STRING("offline", device_status().c_str());
+
+  check_taps_unaffected(1);
+  TEST_ASSERT_TRUE(wait_for_status("online", RECONNECT_MS));
+  run_for(1000);
+  TEST_ASSERT_EQUAL(before + 1, wand_publishes.load());
+}
+
+int main(int argc, char** argv) {
+  host_set_virtual_time(true);
+  host_set_serial_output(false);
+  host_dfplayer_on_command(on_dfplayer_command);
+  host_broker_on_publish(on_publish);
+
+  setup();
+  run_for(WARMUP_MS);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_taps_with_the_broker_up);
+  RUN_TEST(test_broker_stopped_then_started);
+  RUN_TEST(test_broker_restart_during_a_tap);
+  int failures = UNITY_END();
+
+  // The network and MQTT task threads are still parked in delay() - leave without destructors
+  fflush(stdout);
+  quick_exit(failures);
+}
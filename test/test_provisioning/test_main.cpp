@@ -0,0 +1,208 @@
+/**
+ * Band provisioning over MQTT - native build, virtual time
+ *
+ * Runs the firmware against the in-process broker and sends chunks on the provisioning topic
+ * the way tools/provision_bands.py does: one chunk, wait for its acknowledgement, next chunk.
+ * A chunk is validated in full before anything is applied - one bad entry anywhere in it
+ * rejects the whole chunk, adds and removes alike, and leaves the registry untouched.
+ *
+ * Run with: pio test -e native -f test_provisioning
+ */
+
+#include <Arduino.h>
+#include <HostHardware.h>
+#include <HostBroker.h>
+#include <HomeAssistantControl.h>
+#include <BandRegistry.h>
+#include <unity.h>
+#include <mutex>
+#include <string>
+
+#define WARMUP_MS 15000             // Boot, WiFi, MQTT and the startup sound
+#define ACK_TIMEOUT_MS 5000         // As tools/provision_bands.py
+#define BATCH_BANDS 1000
+#define BANDS_PER_CHUNK 25          // ~2.5 KB per chunk, inside MQTT_BUFFER_SIZE
+#define MAX_BATCH_MS 10000          // 1,000 bands in seconds, not minutes
+#define KNOWN_BAND 0x27CB1805       // "August" in BAND_CONFIGS
+
+// Written on the MQTT task thread
+static std::mutex ack_mutex;
+static std::string last_ack;
+static int acks = 0;
+
+static void on_publish(const char* topic, const uint8_t* payload, size_t length, bool retain) {
+  if (strcmp(topic, MQTT_PROVISION_STATUS_TOPIC) == 0) {
+    std::lock_guard<std::mutex> lock(ack_mutex);
+    last_ack.assign((const char*)payload, length);
+    acks++;
+  }
+}
+
+// Send one chunk and run until it is acknowledged - returns the ack, or "" on timeout
+static std::string send_chunk(const std::string& payload) {
+  int before;
+  {
+    std::lock_guard<std::mutex> lock(ack_mutex);
+    before = acks;
+  }
+  host_broker_publish(MQTT_PROVISION_TOPIC, payload.data(), payload.size(), false);
+  uint64_t deadline = host_micros64() + (uint64_t)ACK_TIMEOUT_MS * 1000;
+  while (host_micros64() < deadline) {
+    host_loop_tick();
+    std::lock_guard<std::mutex> lock(ack_mutex);
+    if (acks > before) return last_ack;
+  }
+  return "";
+}
+
+static bool ack_has(const std::string& ack, const char* field) {
+  return ack.find(field) != std::string::npos;
+}
+
+static std::string band_json(uint64_t uid, const char* name, const char* color, const char* sounds) {
+  char entry[160];
+  snprintf(entry, sizeof(entry), "{\"uid\":\"%llX\",\"name\":\"%s\",\"color\":\"%s\",\"sounds\":[%s]}",
+           (unsigned long long)uid, name, color, sounds);
+  return entry;
+}
+
+static std::string chunk_json(const char* batch, int chunk, int chunks, const std::string& bands,
+                              const std::string& removals) {
+  char head[96];
+  snprintf(head, sizeof(head), "{\"batch\":\"%s\",\"chunk\":%d,\"chunks\":%d,", batch, chunk, chunks);
+  return std::string(head) + "\"bands\":[" + bands + "],\"remove\":[" + removals + "]}";
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// One chunk - acknowledged, and every field of every band lands in the registry
+void test_chunk_is_applied_and_acknowledged(void) {
+  std::string bands = band_json(0x04A1B2C3D4E5F6ULL, "Mickey", "#FF0000", "9, 5") + "," +
+                      band_json(0x11223344, "Minnie", "#00FF80", "3");
+  std::string ack = send_chunk(chunk_json("single", 0, 1, bands, ""));
+
+  TEST_ASSERT_TRUE_MESSAGE(ack_has(ack, "\"status\":\"ok\""), ack.c_str());
+  TEST_ASSERT_TRUE(ack_has(ack, "\"applied\":2"));
+  TEST_ASSERT_TRUE(ack_has(ack, "\"persisted\":true"));
+
+  BandConfig band;
+  TEST_ASSERT_TRUE(band_registry_lookup(0x04A1B2C3D4E5F6ULL, &band));
+  TEST_ASSERT_EQUAL_STRING("Mickey", band.name);
+  TEST_ASSERT_TRUE(band.led_color == CRGB(0xFF0000));
+  TEST_ASSERT_EQUAL(2, band.num_sounds);
+  TEST_ASSERT_EQUAL(9, band.sound_files[0]);
+  TEST_ASSERT_EQUAL(5, band.sound_files[1]);
+  TEST_ASSERT_TRUE(band_registry_lookup(0x11223344, &band));
+  TEST_ASSERT_EQUAL_STRING("Minnie", band.name);
+}
+
+// 1,000 bands in chunks, each sent once the previous one is acknowledged
+void test_batch_of_1000_bands(void) {
+  int bands_before = band_registry_count();
+  int chunks = BATCH_BANDS / BANDS_PER_CHUNK;
+  uint64_t start_us = host_micros64();
+  for (int chunk = 0; chunk < chunks; chunk++) {
+    std::string bands;
+    for (int i = 0; i < BANDS_PER_CHUNK; i++) {
+      int index = chunk * BANDS_PER_CHUNK + i;
+      char name[16];
+      snprintf(name, sizeof(name), "Guest %d", index);
+      bands += (i > 0 ? "," : "") + band_json(0x0500000000000000ULL + index, name, "#102030", "1, 2, 3");
+    }
+    std::string ack = send_chunk(chunk_json("event-setup", chunk, chunks, bands, ""));
+    TEST_ASSERT_TRUE_MESSAGE(ack_has(ack, "\"status\":\"ok\""), ack.c_str());
+  }
+  uint32_t elapsed_ms = (uint32_t)((host_micros64() - start_us) / 1000);
+
+  char line[64];
+  snprintf(line, sizeof(line), "%d bands in %u ms", BATCH_BANDS, elapsed_ms);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL(bands_before + BATCH_BANDS, band_registry_count());
+  TEST_ASSERT_NOT_NULL(find_band_config(0x0500000000000000ULL + BATCH_BANDS - 1));
+  TEST_ASSERT_LESS_OR_EQUAL(MAX_BATCH_MS, elapsed_ms);
+}
+
+// Valid adds and a valid removal, then one bad UID at the end - nothing in the chunk lands
+static void check_chunk_rejected(const char* bad_uid, int bad_index) {
+  int bands_before = band_registry_count();
+  std::string bands = band_json(0x0600000000000001ULL, "Goofy", "#00FF00", "4") + "," +
+                      band_json(0x0600000000000002ULL, "Pluto", "#0000FF", "6") + "," +
+                      "{\"uid\":" + bad_uid + ",\"name\":\"Donald\",\"color\":\"#FFFFFF\",\"sounds\":[1]}";
+  std::string ack = send_chunk(chunk_json("bad", 0, 1, bands, "\"27CB1805\""));
+
+  TEST_ASSERT_TRUE_MESSAGE(ack_has(ack, "\"status\":\"error\""), bad_uid);
+  TEST_ASSERT_TRUE(ack_has(ack, "\"error\":\"invalid uid\""));
+  char index[16];
+  snprintf(index, sizeof(index), "\"index\":%d", bad_index);
+  TEST_ASSERT_TRUE(ack_has(ack, index));
+
+  TEST_ASSERT_EQUAL(bands_before, band_registry_count());
+  TEST_ASSERT_NULL(find_band_config(0x0600000000000001ULL));
+  TEST_ASSERT_NULL(find_band_config(0x0600000000000002ULL));
+  TEST_ASSERT_NOT_NULL(find_band_config(KNOWN_BAND));  // The removal didn't land either
+}
+
+// strtoull would take all of these - a sign, whitespace, or nothing after the prefix
+void test_chunk_with_a_bad_uid_is_rejected_whole(void) {
+  check_chunk_rejected("\"-1\"", 2);
+  check_chunk_rejected("\"+27CB1806\"", 2);
+  check_chunk_rejected("\" 27CB1806\"", 2);
+  check_chunk_rejected("\"0x\"", 2);
+  check_chunk_rejected("\"0x-5\"", 2);
+  check_chunk_rejected("\"27CB18G6\"", 2);
+  check_chunk_rejected("\"11223344556677889\"", 2);  // 17 digits
+  check_chunk_rejected("\"0\"", 2);
+}
+
+// A bad UID in the removals rejects the adds too
+void test_bad_removal_rejects_the_chunk(void) {
+  int bands_before = band_registry_count();
+  std::string bands = band_json(0x0700000000000001ULL, "Daisy", "#FF00FF", "2");
+  std::string ack = send_chunk(chunk_json("bad-remove", 0, 1, bands, "\"27CB1805\", \"-27CB1805\""));
+
+  TEST_ASSERT_TRUE_MESSAGE(ack_has(ack, "\"error\":\"invalid uid in remove\""), ack.c_str());
+  TEST_ASSERT_TRUE(ack_has(ack, "\"index\":1"));
+  TEST_ASSERT_EQUAL(bands_before, band_registry_count());
+  TEST_ASSERT_NULL(find_band_config(0x0700000000000001ULL));
+  TEST_ASSERT_NOT_NULL(find_band_config(KNOWN_BAND));
+}
+
+// Hex with or without "0x", either case, or a plain JSON number
+void test_uid_forms(void) {
+  std::string bands =
+    "{\"uid\":\"0x0800AbCd\",\"name\":\"Chip\",\"color\":\"#010203\",\"sounds\":[1]},"
+    "{\"uid\":\"0X0800ABCE\",\"name\":\"Dale\",\"color\":\"#010203\",\"sounds\":[1]},"
+    "{\"uid\":134261711,\"name\":\"Scrooge\",\"color\":\"#010203\",\"sounds\":[1]}";  // 0x0800ABCF
+  std::string ack = send_chunk(chunk_json("forms", 0, 1, bands, ""));
+
+  TEST_ASSERT_TRUE_MESSAGE(ack_has(ack, "\"applied\":3"), ack.c_str());
+  TEST_ASSERT_NOT_NULL(find_band_config(0x0800ABCD));
+  TEST_ASSERT_NOT_NULL(find_band_config(0x0800ABCE));
+  TEST_ASSERT_NOT_NULL(find_band_config(0x0800ABCF));
+}
+
+int main(int argc, char** argv) {
+  host_set_virtual_time(true);
+  host_set_serial_output(false);
+  host_broker_on_publish(on_publish);
+
+  setup();
+  uint64_t warm_until = host_micros64() + (uint64_t)WARMUP_MS * 1000;
+  while (host_micros64() < warm_until) {
+    host_loop_tick();
+  }
+
+  UNITY_BEGIN();
+  RUN_TEST(test_chunk_is_applied_and_acknowledged);
+  RUN_TEST(test_batch_of_1000_bands);
+  RUN_TEST(test_chunk_with_a_bad_uid_is_rejected_whole);
+  RUN_TEST(test_bad_removal_rejects_the_chunk);
+  RUN_TEST(test_uid_forms);
+  int failures = UNITY_END();
+
+  // The network and MQTT task threads are still parked in delay() - leave without destructors
+  fflush(stdout);
+  quick_exit(failures);
+}
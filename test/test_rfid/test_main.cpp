@@ -0,0 +1,164 @@
+/**
+ * Single-transaction card read - native build, virtual time
+ *
+ * Drives the RFID library directly against the simulated PN532, which counts every command
+ * it sees on the bus. A tap must cost one transaction to get the UID - the collect after the
+ * IRQ, or one poll without an IRQ line - plus the re-arm for the next card, and the loop
+ * must not touch the bus at all while no card is in the field.
+ *
+ * Run with: pio test -e native -f test_rfid
+ */
+
+#include <Arduino.h>
+#include <HostHardware.h>
+#include <HostPN532.h>
+#include <RFIDControlPN532.h>
+#include <Instrumentation.h>
+#include <unity.h>
+
+#define LOOP_INTERVAL_MS 10     // Reader polled at the activation loop's pace
+#define READ_TIMEOUT_MS 1000
+#define IDLE_MS 5000
+#define IDLE_WAIT_MS 100        // The loop's idle delay (MAIN_LOOP_DELAY in src/main.cpp)
+
+// Transactions for one tap, from the card entering the field to the UID in hand
+#define IRQ_TAP_TRANSACTIONS 2  // Collect the answer, re-arm for the next card
+#define POLL_TAP_TRANSACTIONS 1 // The poll that found the card
+
+// Read until a card comes back - false on timeout
+static bool wait_for_card(rfid_band_info* info) {
+  for (uint32_t waited = 0; waited < READ_TIMEOUT_MS; waited += LOOP_INTERVAL_MS) {
+    if (rfid_read_card(info)) return true;
+    delay(LOOP_INTERVAL_MS);
+  }
+  return false;
+}
+
+// Let the card leave and any answer it left behind be read and thrown away
+static void clear_field() {
+  host_pn532_remove_card();
+  rfid_band_info info;
+  for (int i = 0; i < 10; i++) {
+    rfid_read_card(&info);
+    delay(LOOP_INTERVAL_MS);
+  }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {
+  clear_field();
+}
+
+void test_reader_initialized(void) {
+  TEST_ASSERT_TRUE(is_rfid_initialized());
+}
+
+// One tap - UID, length, protocol and the time the card answered from a single read
+void test_tap_is_read_in_one_transaction(void) {
+  uint32_t before = host_pn532_transaction_count();
+  unsigned long tap_time = millis();
+  host_pn532_tap(0x27CB1805, 4, 500);
+
+  rfid_band_info info;
+  TEST_ASSERT_TRUE(wait_for_card(&info));
+  uint32_t used = host_pn532_transaction_count() - before;
+
+  TEST_ASSERT_EQUAL_HEX64(0x27CB1805, info.uid.uid_64);
+  TEST_ASSERT_EQUAL_UINT8(4, info.uid_length);
+  TEST_ASSERT_EQUAL(PROTOCOL_ISO14443A, info.protocol);
+  TEST_ASSERT_GREATER_OR_EQUAL(tap_time, info.read_time);
+  TEST_ASSERT_LESS_OR_EQUAL(millis(), info.read_time);
+
+  if (is_rfid_irq_mode()) {
+    TEST_ASSERT_EQUAL_UINT32(IRQ_TAP_TRANSACTIONS, used);
+  } else {
+    TEST_ASSERT_EQUAL_UINT32(POLL_TAP_TRANSACTIONS, used);
+  }
+}
+
+// 7-byte UIDs come back whole - uid_64 is the band ID used by BAND_CONFIGS
+void test_seven_byte_uid(void) {
+  host_pn532_tap(0x045C92F2876880ULL, 7, 500);
+
+  rfid_band_info info;
+  TEST_ASSERT_TRUE(wait_for_card(&info));
+  TEST_ASSERT_EQUAL_HEX64(0x045C92F2876880ULL, info.uid.uid_64);
+  TEST_ASSERT_EQUAL_UINT8(7, info.uid_length);
+}
+
+// The firmware's own count matches what the reader saw
+void test_transaction_count_matches_the_bus(void) {
+  uint32_t bus_before = host_pn532_transaction_count();
+  uint32_t firmware_before = get_rfid_transaction_count();
+  host_pn532_tap(0x34567890, 4, 500);
+
+  rfid_band_info info;
+  TEST_ASSERT_TRUE(wait_for_card(&info));
+  TEST_ASSERT_EQUAL_UINT32(host_pn532_transaction_count() - bus_before,
+                           get_rfid_transaction_count() - firmware_before);
+}
+
+// No card, no bus traffic - the armed reader waits on its IRQ line
+void test_idle_reader_stays_off_the_bus(void) {
+  if (!is_rfid_irq_mode()) {
+    TEST_IGNORE_MESSAGE("Polling mode reads the bus every pass");
+  }
+  uint32_t before = host_pn532_transaction_count();
+  rfid_band_info info;
+  for (uint32_t waited = 0; waited < IDLE_MS; waited += LOOP_INTERVAL_MS) {
+    TEST_ASSERT_FALSE(rfid_read_card(&info));
+    delay(LOOP_INTERVAL_MS);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, host_pn532_transaction_count() - before);
+}
+
+// An idle loop waiting on its task notification wakes when the card answers - the UID is
+// there to read at once, not after the rest of the idle delay
+void test_card_ends_the_idle_wait(void) {
+  if (!is_rfid_irq_mode()) {
+    TEST_IGNORE_MESSAGE("Polling mode has no IRQ to wake the loop");
+  }
+  ulTaskNotifyTake(pdTRUE, 0);  // Drop the edge from the last re-arm's ACK
+  unsigned long tap_time = millis();
+  host_pn532_tap(0x3A4B5C6D, 4, 500);
+
+  TEST_ASSERT_NOT_EQUAL(0, ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IDLE_WAIT_MS)));
+  TEST_ASSERT_LESS_THAN(IDLE_WAIT_MS, millis() - tap_time);
+  rfid_band_info info;
+  TEST_ASSERT_TRUE(rfid_read_card(&info));
+  TEST_ASSERT_EQUAL_HEX64(0x3A4B5C6D, info.uid.uid_64);
+}
+
+// A read that fails (CRC error, card pulled mid-read) reports no card - the card is picked
+// up again on the next attempt
+void test_failed_read_recovers(void) {
+  uint32_t failures_before = instrument_counter(INSTRUMENT_PN532_FAILURES);
+  uint32_t reads_before = host_pn532_transaction_count();
+  host_pn532_fail_next_reads(1);
+  host_pn532_tap(0x56789012, 4, 500);
+
+  rfid_band_info info;
+  TEST_ASSERT_TRUE(wait_for_card(&info));
+  TEST_ASSERT_EQUAL_HEX64(0x56789012, info.uid.uid_64);
+  if (is_rfid_irq_mode()) {
+    TEST_ASSERT_EQUAL_UINT32(failures_before + 1, instrument_counter(INSTRUMENT_PN532_FAILURES));
+    TEST_ASSERT_EQUAL_UINT32(2 * IRQ_TAP_TRANSACTIONS, host_pn532_transaction_count() - reads_before);
+  }
+}
+
+int main(int argc, char** argv) {
+  host_set_virtual_time(true);
+  host_set_serial_output(false);
+  setup_rfid();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_reader_initialized);
+  RUN_TEST(test_tap_is_read_in_one_transaction);
+  RUN_TEST(test_seven_byte_uid);
+  RUN_TEST(test_transaction_count_matches_the_bus);
+  RUN_TEST(test_idle_reader_stays_off_the_bus);
+  RUN_TEST(test_card_ends_the_idle_wait);
+  RUN_TEST(test_failed_read_recovers);
+  return UNITY_END();
+}
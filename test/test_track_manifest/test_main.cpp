@@ -0,0 +1,226 @@
+/**
+ * Track manifest - native build
+ *
+ * TrackManifest.h is generated from assets/mp3_for_sd by tools/generate_track_manifest.py.
+ * The firmware times greetings and the cooldown from it, so a header left stale after the
+ * files changed would have the LEDs and the sounds drift apart. This walks the MPEG frames
+ * of the files again, independently of the script, and checks the numbering and every
+ * duration against the header.
+ *
+ * Run with: pio test -e native -f test_track_manifest (from the project directory)
+ */
+
+#include <Arduino.h>
+#include <HostHardware.h>
+#include <AudioControlDFPlayer.h>
+#include <TrackManifest.h>
+#include <unity.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <strings.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define SOURCE_DIR "assets/mp3_for_sd"
+#define DURATION_TOLERANCE_MS 1     // The script rounds to the nearest ms
+#define MIN_LOUDNESS_X10 -700       // -70 LUFS is the EBU R128 absolute gate
+#define MAX_LOUDNESS_X10 0
+
+// Bitrates in kbps by [MPEG1][layer - 1][index], sample rates by [version bits][index]
+static const uint16_t BITRATES[2][3][15] = {
+  { { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+    { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+    { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 } },
+  { { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+    { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+    { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 } },
+};
+static const uint32_t SAMPLE_RATES[4][3] = {
+  { 11025, 12000, 8000 },   // MPEG2.5
+  { 0, 0, 0 },              // Reserved
+  { 22050, 24000, 16000 },  // MPEG2
+  { 44100, 48000, 32000 },  // MPEG1
+};
+
+struct MpegFrame {
+  size_t length;
+  uint32_t samples;
+  uint32_t sample_rate;
+};
+
+static bool parse_frame(const std::vector<uint8_t>& data, size_t pos, MpegFrame* frame) {
+  if (pos + 4 > data.size() || data[pos] != 0xFF || (data[pos + 1] & 0xE0) != 0xE0) return false;
+  uint8_t version = (data[pos + 1] >> 3) & 0x03;
+  uint8_t layer = 4 - ((data[pos + 1] >> 1) & 0x03);
+  uint8_t bitrate_index = data[pos + 2] >> 4;
+  uint8_t rate_index = (data[pos + 2] >> 2) & 0x03;
+  uint8_t padding = (data[pos + 2] >> 1) & 0x01;
+  if (version == 1 || layer == 4 || bitrate_index == 0 || bitrate_index == 15 || rate_index == 3) return false;
+
+  bool mpeg1 = version == 3;
+  uint32_t bitrate = BITRATES[mpeg1][layer - 1][bitrate_index] * 1000;
+  frame->sample_rate = SAMPLE_RATES[version][rate_index];
+  if (layer == 1) {
+    frame->samples = 384;
+    frame->length = (12 * bitrate / frame->sample_rate + padding) * 4;
+  } else {
+    frame->samples = layer == 2 || mpeg1 ? 1152 : 576;
+    frame->length = (layer == 3 && !mpeg1 ? 72 : 144) * bitrate / frame->sample_rate + padding;
+  }
+  return true;
+}
+
+static bool has_tag(const uint8_t* bytes, size_t length, const char* tag) {
+  for (size_t i = 0; i + 4 <= length && i < 64; i++) {
+    if (memcmp(bytes + i, tag, 4) == 0) return true;
+  }
+  return false;
+}
+
+// Encoder delay + padding from a LAME tag after the Xing/Info fields (0 without one)
+static uint32_t gapless_trim(const uint8_t* frame, size_t length) {
+  for (size_t xing = 0; xing + 8 <= length && xing < 64; xing++) {
+    if (memcmp(frame + xing, "Xing", 4) != 0 && memcmp(frame + xing, "Info", 4) != 0) continue;
+    uint32_t flags = (uint32_t)frame[xing + 4] << 24 | frame[xing + 5] << 16 | frame[xing + 6] << 8 | frame[xing + 7];
+    size_t tag = xing + 8 + (flags & 1 ? 4 : 0) + (flags & 2 ? 4 : 0) + (flags & 4 ? 100 : 0) + (flags & 8 ? 4 : 0);
+    if (tag + 24 > length) return 0;
+    if (memcmp(frame + tag, "LAME", 4) != 0 && memcmp(frame + tag, "Lavc", 4) != 0 &&
+        memcmp(frame + tag, "Lavf", 4) != 0) {
+      return 0;
+    }
+    return ((frame[tag + 21] << 4) | (frame[tag + 22] >> 4)) + (((frame[tag + 22] & 0x0F) << 8) | frame[tag + 23]);
+  }
+  return 0;
+}
+
+// Decoded length in ms - every frame that is followed by another (or the end), less the
+// Xing/Info/VBRI frame and the samples its LAME tag says a gapless decoder trims
+static uint32_t mp3_duration_ms(const std::string& path) {
+  std::vector<uint8_t> data;
+  FILE* file = fopen(path.c_str(), "rb");
+  TEST_ASSERT_NOT_NULL_MESSAGE(file, path.c_str());
+  uint8_t buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.insert(data.end(), buffer, buffer + read);
+  }
+  fclose(file);
+
+  size_t end = data.size();
+  if (end >= 128 && memcmp(&data[end - 128], "TAG", 3) == 0) end -= 128;  // ID3v1
+  size_t pos = 0;
+  if (end >= 10 && memcmp(&data[0], "ID3", 3) == 0) {
+    pos = 10 + ((data[6] << 21) | (data[7] << 14) | (data[8] << 7) | data[9]) + (data[5] & 0x10 ? 10 : 0);
+  }
+  data.resize(end);
+
+  uint64_t samples = 0;
+  uint32_t trim = 0;
+  uint32_t sample_rate = 0;
+  bool first = true;
+  while (pos < end) {
+    MpegFrame frame, next;
+    if (parse_frame(data, pos, &frame) && pos + frame.length <= end &&
+        (pos + frame.length == end || parse_frame(data, pos + frame.length, &next))) {
+      const uint8_t* bytes = &data[pos];
+      if (first && (has_tag(bytes, frame.length, "Xing") || has_tag(bytes, frame.length, "Info") ||
+                    has_tag(bytes, frame.length, "VBRI"))) {
+        trim = gapless_trim(bytes, frame.length);
+      } else {
+        if (sample_rate == 0) sample_rate = frame.sample_rate;
+        TEST_ASSERT_EQUAL_MESSAGE(sample_rate, frame.sample_rate, path.c_str());
+        samples += frame.samples;
+      }
+      first = false;
+      pos += frame.length;
+    } else {
+      pos++;  // Resync
+    }
+  }
+  TEST_ASSERT_NOT_EQUAL_MESSAGE(0, sample_rate, path.c_str());
+  TEST_ASSERT_LESS_THAN_MESSAGE(samples, trim, path.c_str());
+  return (uint32_t)(((samples - trim) * 1000 + sample_rate / 2) / sample_rate);
+}
+
+// The SD card files in track order - prepare_sd_card.ps1 sorts by name, ignoring case
+static std::vector<std::string> sd_card_files() {
+  std::vector<std::string> files;
+  DIR* dir = opendir(SOURCE_DIR);
+  TEST_ASSERT_NOT_NULL_MESSAGE(dir, "run from the project directory");
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name.size() > 4 && strcasecmp(name.c_str() + name.size() - 4, ".mp3") == 0) {
+      files.push_back(name);
+    }
+  }
+  closedir(dir);
+  std::sort(files.begin(), files.end(), [](const std::string& a, const std::string& b) {
+    return strcasecmp(a.c_str(), b.c_str()) < 0;
+  });
+  return files;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// One entry per file, and the SoundFile numbers land on the files they are named after
+void test_numbering_matches_the_files(void) {
+  std::vector<std::string> files = sd_card_files();
+  TEST_ASSERT_EQUAL(TRACK_MANIFEST_COUNT, (int)files.size());
+
+  static const struct { uint8_t track; const char* file; } SOUNDS[] = {
+    { SOUND_ADDAMS_FAMILY, "addams-family.mp3" }, { SOUND_CHIME, "chime.mp3" },
+    { SOUND_ERROR, "error.mp3" },                 { SOUND_EXCELLENT, "excellent.mp3" },
+    { SOUND_FOOLISH, "foolish.mp3" },             { SOUND_HELLO, "hello.mp3" },
+    { SOUND_IMPERIAL_MARCH, "imperial_march.mp3" }, { SOUND_OPERATIONAL, "operational.mp3" },
+    { SOUND_PIRATE_CLIP, "pirate-clip.mp3" },     { SOUND_STARTOURS, "startours.mp3" },
+    { SOUND_TAP_START, "tap-start.mp3" },         { SOUND_VADER_BREATHING, "vader_breathing.mp3" },
+    { SOUND_WIZARD_HARRY, "wizard_harry.mp3" },
+  };
+  for (const auto& sound : SOUNDS) {
+    TEST_ASSERT_EQUAL_STRING(sound.file, files[sound.track - 1].c_str());
+  }
+}
+
+// Every duration in the header is what the file decodes to
+void test_durations_match_the_files(void) {
+  std::vector<std::string> files = sd_card_files();
+  TEST_ASSERT_EQUAL(TRACK_MANIFEST_COUNT, (int)files.size());
+  for (int track = 1; track <= TRACK_MANIFEST_COUNT; track++) {
+    uint32_t duration_ms = mp3_duration_ms(SOURCE_DIR "/" + files[track - 1]);
+    char message[64];
+    snprintf(message, sizeof(message), "%04d_%s", track, files[track - 1].c_str());
+    TEST_ASSERT_UINT32_WITHIN_MESSAGE(DURATION_TOLERANCE_MS, duration_ms, TRACK_MANIFEST[track].duration_ms, message);
+  }
+}
+
+// Loudness is optional (it needs ffmpeg), but a measured value must be a real one
+void test_loudness_is_unknown_or_plausible(void) {
+  for (int track = 1; track <= TRACK_MANIFEST_COUNT; track++) {
+    int16_t loudness = TRACK_MANIFEST[track].loudness_x10;
+    if (loudness == TRACK_LOUDNESS_UNKNOWN) continue;
+    TEST_ASSERT_INT16_WITHIN((MAX_LOUDNESS_X10 - MIN_LOUDNESS_X10) / 2, (MAX_LOUDNESS_X10 + MIN_LOUDNESS_X10) / 2,
+                             loudness);
+  }
+}
+
+// The firmware reads the header, not the files - get_track_duration() falls back to it
+void test_firmware_uses_the_manifest(void) {
+  for (int track = 1; track <= TRACK_MANIFEST_COUNT; track++) {
+    TEST_ASSERT_EQUAL_UINT32(TRACK_MANIFEST[track].duration_ms, get_track_duration(track));
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, get_track_duration(TRACK_MANIFEST_COUNT + 1));
+}
+
+int main(int argc, char** argv) {
+  host_set_serial_output(false);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_numbering_matches_the_files);
+  RUN_TEST(test_durations_match_the_files);
+  RUN_TEST(test_loudness_is_unknown_or_plausible);
+  RUN_TEST(test_firmware_uses_the_manifest);
+  return UNITY_END();
+}
@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""
+Decode MagicBand binary event records back into log text
+
+Reads the serial stream (LOG_BINARY firmware interleaves framed event records with plain
+DEBUG_PRINT text) or a dump of the flash event log, and prints each record as the text
+build would have: `[ms] L TAG: message`. Plain text passes through unchanged.
+
+The decode table comes from tools/generate_event_log_table.py - every firmware build
+writes .pio/build/<env>/event_log_table.json. Without --table it is generated from the
+sources in this checkout, which is right as long as they match the flashed firmware.
+
+Usage:
+    python3 tools/decode_event_log.py --port /dev/ttyUSB0           # Live (needs pyserial)
+    .pio/build/native/program | python3 tools/decode_event_log.py   # Native build
+    python3 tools/decode_event_log.py capture.bin                   # Saved serial capture
+
+    # Post-mortem: the last 64KB of the "spiffs" partition (0x290000 + 0x160000 - 0x10000
+    # in the default 4MB table)
+    esptool.py read_flash 0x3E0000 0x10000 events.bin
+    python3 tools/decode_event_log.py --flash events.bin
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import generate_event_log_table  # noqa: E402
+
+FRAME_START = 0x1E         # EVENT_FRAME_START
+HEADER_SIZE = 9            # id + timestamp + level
+FLASH_RECORD_SIZE = 64     # EVENT_FLASH_RECORD_SIZE
+FLASH_ERASED = 0xFFFFFFFF
+BOOT_ID = 0                # EVENT_ID_BOOT
+
+LEVEL_LETTERS = "-EWIDV"
+RESET_REASONS = ["UNKNOWN", "POWERON", "EXT", "SW", "PANIC", "INT_WDT", "TASK_WDT", "WDT",
+                 "DEEPSLEEP", "BROWNOUT", "SDIO"]
+
+CONVERSION_RE = re.compile(r"%([-+ #0]*)(\d*|\*)(?:\.(\d*))?(hh|h|ll|l|z|j|t|L)?([diouxXeEfgGcsp%])")
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data):
+            raise IndexError
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def decode_args(data):
+    """Arguments of a record - a cut-off last number is dropped, a cut-off string kept"""
+    args = []
+    pos = 0
+    try:
+        while pos < len(data):
+            kind = chr(data[pos])
+            pos += 1
+            if kind == "u":
+                value, pos = read_varint(data, pos)
+            elif kind == "i":
+                value, pos = read_varint(data, pos)
+                value = (value >> 1) ^ -(value & 1)
+            elif kind == "s":
+                length = data[pos]
+                value = data[pos + 1:pos + 1 + length].decode("utf-8", "replace")
+                if pos + 1 + length > len(data):
+                    args.append(value + "...")  # Cut to fit a flash slot
+                    break
+                pos += 1 + length
+            elif kind == "d":
+                if pos + 8 > len(data):
+                    raise IndexError
+                value = struct.unpack_from("<d", data, pos)[0]
+                pos += 8
+            else:
+                break  # Corrupt
+            args.append(value)
+    except IndexError:
+        pass
+    return args
+
+
+def format_printf(fmt, args):
+    """printf-style formatting with C semantics for the conversions the firmware uses"""
+    args = list(args)
+    out = []
+    last = 0
+    for match in CONVERSION_RE.finditer(fmt):
+        out.append(fmt[last:match.start()])
+        last = match.end()
+        flags, width, precision, length, conversion = match.groups()
+        if conversion == "%":
+            out.append("%")
+            continue
+        if width == "*":
+            width = str(args.pop(0)) if args else ""
+        if not args:
+            out.append("?")
+            continue
+        value = args.pop(0)
+        spec = "%" + flags + width + ("." + precision if precision is not None else "")
+        try:
+            if conversion in "diouxX":
+                if isinstance(value, str):
+                    raise TypeError
+                value = int(value)
+                if value < 0 and conversion in "ouxX":
+                    value += 1 << (64 if length in ("ll", "j") else 32)
+                out.append((spec + ("d" if conversion in "iu" else conversion)) % value)
+            elif conversion == "c":
+                out.append((spec + "c") % chr(int(value) & 0xFF))
+            elif conversion == "s":
+                out.append((spec + "s") % value)
+            elif conversion == "p":
+                out.append("0x%x" % int(value))
+            else:
+                out.append((spec + conversion) % float(value))
+        except (TypeError, ValueError):
+            out.append("<%r>" % (value,))
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def render_record(payload, table):
+    """Text line for one record payload"""
+    if len(payload) < HEADER_SIZE:
+        return "<short record>"
+    event_id, timestamp, level = struct.unpack_from("<IIB", payload)
+    args = decode_args(payload[HEADER_SIZE:])
+    letter = LEVEL_LETTERS[level] if level < len(LEVEL_LETTERS) else "?"
+    if event_id == BOOT_ID:
+        reason = args[0] if args else 0
+        name = RESET_REASONS[reason] if 0 <= reason < len(RESET_REASONS) else str(reason)
+        return "=== boot (reset reason %s) ===" % name
+    entry = table.get("%08x" % event_id)
+    if entry is None:
+        return "[%d] %s ?: unknown event %08x %r - table out of date?" % (timestamp, letter, event_id, args)
+    return "[%d] %s %s: %s" % (timestamp, letter, entry["tag"], format_printf(entry["format"], args))
+
+
+def read_some(stream):
+    """Whatever is available, at least one byte - b"" at the end of the input"""
+    if hasattr(stream, "in_waiting"):
+        return stream.read(stream.in_waiting or 1)  # pyserial
+    if hasattr(stream, "read1"):
+        return stream.read1(4096)
+    return stream.read(1)
+
+
+def decode_stream(stream, table, out):
+    """Serial bytes: frames are decoded, everything else passes through"""
+    text = bytearray()
+    frame = None  # Bytes of the frame being collected, from the start byte
+    while True:
+        data = bytearray(read_some(stream))
+        if not data:
+            break
+        while data:
+            b = data.pop(0)
+            if frame is None:
+                if b == FRAME_START:
+                    frame = bytearray([b])
+                else:
+                    text.append(b)
+                    if b == 0x0A:
+                        out.write(text.decode("utf-8", "replace"))
+                        text.clear()
+                continue
+            frame.append(b)
+            if len(frame) < 2 or len(frame) < 3 + frame[1]:
+                continue
+            payload = bytes(frame[2:-1])
+            if len(payload) >= HEADER_SIZE and sum(payload) & 0xFF == frame[-1]:
+                if text:
+                    out.write(text.decode("utf-8", "replace"))
+                    text.clear()
+                out.write(render_record(payload, table) + "\n")
+            else:
+                text.append(frame[0])  # Not a frame (line noise) - resync after the start byte
+                data[0:0] = frame[1:]
+            frame = None
+        out.flush()
+    if frame is not None:
+        text += frame  # Cut off at the end
+    out.write(text.decode("utf-8", "replace"))
+
+
+def decode_flash(data, table, out):
+    """Flash log dump: fixed slots, oldest first by sequence"""
+    records = []
+    for offset in range(0, len(data) - FLASH_RECORD_SIZE + 1, FLASH_RECORD_SIZE):
+        sequence, length, checksum = struct.unpack_from("<IBB", data, offset)
+        if sequence == FLASH_ERASED:
+            continue
+        payload = data[offset + 6:offset + 6 + length]
+        if length > FLASH_RECORD_SIZE - 6 or sum(payload) & 0xFF != checksum:
+            records.append((sequence, "<corrupt record %d>" % sequence))  # Torn write
+            continue
+        records.append((sequence, render_record(payload, table)))
+    for _, line in sorted(records):
+        out.write(line + "\n")
+    return len(records)
+
+
+def load_table(path):
+    if path is not None:
+        with open(path) as f:
+            return json.load(f)["events"]
+    root = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir)
+    return generate_event_log_table.build_table(root)["events"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode MagicBand binary event records")
+    parser.add_argument("input", nargs="?", default="-", help="Serial capture file, - for stdin")
+    parser.add_argument("--table", help="event_log_table.json from the build (default: generate from the sources)")
+    parser.add_argument("--port", help="Read a serial port live (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--flash", help="Dump of the flash event log region")
+    args = parser.parse_args()
+
+    try:
+        table = load_table(args.table)
+    except ValueError as e:
+        print("decode_event_log: %s" % e, file=sys.stderr)
+        return 1
+
+    if args.flash:
+        with open(args.flash, "rb") as f:
+            count = decode_flash(f.read(), table, sys.stdout)
+        print("%d records" % count, file=sys.stderr)
+        return 0
+
+    try:
+        if args.port:
+            import serial
+            with serial.Serial(args.port, args.baud) as port:
+                decode_stream(port, table, sys.stdout)
+        elif args.input == "-":
+            decode_stream(sys.stdin.buffer, table, sys.stdout)
+        else:
+            with open(args.input, "rb") as f:
+                decode_stream(f, table, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
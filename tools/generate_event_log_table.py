@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+Generate the event log decode table from the LOGx call sites
+
+With LOG_BINARY the firmware sends event records (lib/DebugConfig/EventLog.h) instead of
+text: a 32-bit ID per format string plus the raw arguments. This scans src/ and lib/ for
+LOGE/LOGW/LOGI/LOGD/LOGV calls, computes the same ID the compiler does (FNV-1a of the tag,
+a 0 byte and the format) and writes a JSON table tools/decode_event_log.py turns records
+back into text with.
+
+The tag is a string literal or a `static constexpr char NAME[] = "..."` constant in the same
+file; the format is one or more adjacent string literals. Anything else, or two different
+messages with the same ID, fails the run - rename the message.
+
+Runs before every firmware build (extra_scripts in platformio.ini) and writes
+.pio/build/<env>/event_log_table.json. Output depends only on the sources.
+
+Usage:
+    python3 tools/generate_event_log_table.py --output event_log_table.json
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+SOURCE_DIRS = ("src", "lib")
+SOURCE_EXTENSIONS = (".cpp", ".h")
+TABLE_NAME = "event_log_table.json"
+
+LEVELS = {"E": 1, "W": 2, "I": 3, "D": 4, "V": 5}
+
+CALL_RE = re.compile(r"\bLOG([EWIDV])\s*\(")
+TAG_CONSTANT_RE = re.compile(r"\bconstexpr\s+char\s+(\w+)\s*\[\s*\]\s*=\s*\"((?:[^\"\\]|\\.)*)\"\s*;")
+STRING_RE = re.compile(r"\"((?:[^\"\\]|\\.)*)\"")
+IDENTIFIER_RE = re.compile(r"[A-Za-z_]\w*")
+SIMPLE_ESCAPES = {"n": "\n", "r": "\r", "t": "\t", "0": "\0", "\\": "\\", "\"": "\"", "'": "'"}
+
+FNV_OFFSET = 2166136261
+FNV_PRIME = 16777619
+
+
+def fnv1a(data, value):
+    for byte in data:
+        value = ((value ^ byte) * FNV_PRIME) & 0xFFFFFFFF
+    return value
+
+
+def event_id(tag, fmt):
+    """Same hash as event_log_id() in EventLog.h"""
+    value = fnv1a(tag.encode("utf-8"), FNV_OFFSET)
+    value = (value * FNV_PRIME) & 0xFFFFFFFF  # The 0 byte between tag and format
+    return fnv1a(fmt.encode("utf-8"), value)
+
+
+def unescape(body):
+    """Contents of a C string literal"""
+    out = []
+    i = 0
+    while i < len(body):
+        c = body[i]
+        if c != "\\":
+            out.append(c)
+            i += 1
+            continue
+        e = body[i + 1]
+        if e == "x":
+            digits = re.match(r"[0-9A-Fa-f]+", body[i + 2:]).group(0)
+            out.append(chr(int(digits, 16)))
+            i += 2 + len(digits)
+        elif e in SIMPLE_ESCAPES:
+            out.append(SIMPLE_ESCAPES[e])
+            i += 2
+        else:
+            raise ValueError("unsupported escape \\" + e)
+    return "".join(out)
+
+
+def skip_space(text, pos):
+    while pos < len(text) and text[pos] in " \t\r\n":
+        pos += 1
+    return pos
+
+
+def parse_call(text, pos, constants):
+    """Tag and format of the LOGx call whose arguments start at pos"""
+    pos = skip_space(text, pos)
+    match = STRING_RE.match(text, pos)
+    if match:
+        tag = unescape(match.group(1))
+    else:
+        match = IDENTIFIER_RE.match(text, pos)
+        if not match or match.group(0) not in constants:
+            raise ValueError("tag must be a string literal or a constexpr char[] in the same file")
+        tag = constants[match.group(0)]
+    pos = skip_space(text, match.end())
+    if pos >= len(text) or text[pos] != ",":
+        raise ValueError("expected a format string after the tag")
+
+    pieces = []
+    pos = skip_space(text, pos + 1)
+    while True:
+        match = STRING_RE.match(text, pos)
+        if not match:
+            break
+        pieces.append(unescape(match.group(1)))
+        pos = skip_space(text, match.end())
+    if not pieces or pos >= len(text) or text[pos] not in ",)":
+        raise ValueError("format must be string literals only")
+    return tag, "".join(pieces)
+
+
+def strip_comments(text):
+    """Blank out comments, keeping line numbers and string literals intact"""
+    def blank(match):
+        s = match.group(0)
+        return s if s[0] in "\"'" else re.sub(r"[^\n]", " ", s)
+    return re.sub(r"\"(?:[^\"\\\n]|\\.)*\"|'(?:[^'\\\n]|\\.)+'|//[^\n]*|/\*.*?\*/", blank, text, flags=re.S)
+
+
+def scan_file(path, root):
+    with open(path, encoding="utf-8") as f:
+        text = strip_comments(f.read())
+    constants = {m.group(1): unescape(m.group(2)) for m in TAG_CONSTANT_RE.finditer(text)}
+    events = []
+    for match in CALL_RE.finditer(text):
+        line_start = text.rfind("\n", 0, match.start()) + 1
+        if text[line_start:match.start()].lstrip().startswith("#"):
+            continue  # The macro definitions themselves
+        line = text.count("\n", 0, match.start()) + 1
+        site = "%s:%d" % (os.path.relpath(path, root).replace(os.sep, "/"), line)
+        try:
+            tag, fmt = parse_call(text, match.end(), constants)
+        except ValueError as e:
+            raise ValueError("%s: %s" % (site, e))
+        events.append((event_id(tag, fmt), LEVELS[match.group(1)], tag, fmt, site))
+    return events
+
+
+def build_table(root):
+    events = {}
+    for source_dir in SOURCE_DIRS:
+        for directory, _, files in sorted(os.walk(os.path.join(root, source_dir))):
+            for name in sorted(files):
+                if not name.endswith(SOURCE_EXTENSIONS):
+                    continue
+                for eid, level, tag, fmt, site in scan_file(os.path.join(directory, name), root):
+                    key = "%08x" % eid
+                    if eid == 0:
+                        raise ValueError("%s: ID 0 is the boot record - rename the message" % site)
+                    if key in events and (events[key]["tag"], events[key]["format"]) != (tag, fmt):
+                        raise ValueError("%s: ID %s collides with %s - rename one of the messages"
+                                         % (site, key, events[key]["site"]))
+                    events.setdefault(key, {"tag": tag, "format": fmt, "level": level, "site": site})
+    return {"version": 1, "events": dict(sorted(events.items()))}
+
+
+def write_table(table, output):
+    with open(output, "w", newline="\n") as f:
+        json.dump(table, f, indent=1, sort_keys=True)
+        f.write("\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate the event log decode table")
+    parser.add_argument("--root", default=".", help="Project directory")
+    parser.add_argument("--output", default=TABLE_NAME, help="JSON table to write")
+    args = parser.parse_args()
+
+    try:
+        table = build_table(args.root)
+    except ValueError as e:
+        print("generate_event_log_table: %s" % e, file=sys.stderr)
+        return 1
+    write_table(table, args.output)
+    print("Wrote %s (%d events)" % (args.output, len(table["events"])))
+    return 0
+
+
+def pio_pre_build(env):
+    """PlatformIO extra_scripts hook - the table lands next to firmware.bin"""
+    build_dir = env.subst("$BUILD_DIR")
+    try:
+        table = build_table(env.subst("$PROJECT_DIR"))
+    except ValueError as e:
+        print("generate_event_log_table: %s" % e, file=sys.stderr)
+        env.Exit(1)
+    os.makedirs(build_dir, exist_ok=True)
+    write_table(table, os.path.join(build_dir, TABLE_NAME))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
+elif "Import" in globals():
+    Import("env")  # noqa: F821 - SCons, when run from extra_scripts
+    pio_pre_build(env)  # noqa: F821
@@ -0,0 +1,307 @@
+#!/usr/bin/env python3
+"""
+Generate the track manifest header from the SD card MP3 files
+
+Numbers the files exactly like prepare_sd_card.ps1 (alphabetical order, 0001 first)
+and writes lib/AudioControlDFPlayer/TrackManifest.h with each track's decoded
+duration and integrated loudness. The firmware uses the durations to schedule
+greetings without waiting to learn them from the player. Loudness is recorded for
+leveling the files before they go on the card - the firmware doesn't use it.
+
+Duration comes from walking the MPEG frame headers (frames x samples per frame /
+sample rate), less the encoder delay and padding the LAME tag records in the
+Xing/Info frame (what a gapless decoder trims), so it needs nothing but Python. Loudness (EBU R128 integrated, LUFS)
+needs ffmpeg on the PATH - the same ffmpeg convert_audio_for_dfplayer.ps1 uses.
+Without it the script fails rather than write the header without loudness;
+--no-loudness skips the measurement and keeps the values already in the header
+(unknown for new files).
+
+Output depends only on the file contents and names, so running it twice on the same
+files gives a byte-identical header.
+
+Usage:
+    python3 tools/generate_track_manifest.py
+    python3 tools/generate_track_manifest.py --check   # Fail if the header is out of date
+    python3 tools/generate_track_manifest.py --no-loudness   # No ffmpeg - keep the measured loudness
+"""
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+DEFAULT_SOURCE_DIR = os.path.join("assets", "mp3_for_sd")
+DEFAULT_OUTPUT = os.path.join("lib", "AudioControlDFPlayer", "TrackManifest.h")
+
+LOUDNESS_UNKNOWN = -32768  # INT16_MIN, matches TRACK_LOUDNESS_UNKNOWN
+
+# Bitrates in kbps indexed by [version is MPEG1][layer][bitrate index]
+BITRATES = {
+    (True, 1): [0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448],
+    (True, 2): [0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384],
+    (True, 3): [0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320],
+    (False, 1): [0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256],
+    (False, 2): [0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160],
+    (False, 3): [0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160],
+}
+
+# Sample rates indexed by [version bits][sample rate index]
+SAMPLE_RATES = {
+    0b11: [44100, 48000, 32000],  # MPEG1
+    0b10: [22050, 24000, 16000],  # MPEG2
+    0b00: [11025, 12000, 8000],   # MPEG2.5
+}
+
+
+def parse_frame_header(data, pos):
+    """Decode the 4-byte frame header at pos - returns (frame_length, samples, sample_rate) or None"""
+    if pos + 4 > len(data) or data[pos] != 0xFF or (data[pos + 1] & 0xE0) != 0xE0:
+        return None
+
+    version = (data[pos + 1] >> 3) & 0x03
+    layer = 4 - ((data[pos + 1] >> 1) & 0x03)  # 1, 2 or 3 (4 = reserved)
+    bitrate_index = data[pos + 2] >> 4
+    rate_index = (data[pos + 2] >> 2) & 0x03
+    padding = (data[pos + 2] >> 1) & 0x01
+
+    if version == 0b01 or layer == 4 or bitrate_index in (0, 15) or rate_index == 3:
+        return None  # Reserved values, or free-format bitrate (never produced by our ffmpeg settings)
+
+    mpeg1 = version == 0b11
+    bitrate = BITRATES[(mpeg1, layer)][bitrate_index] * 1000
+    sample_rate = SAMPLE_RATES[version][rate_index]
+
+    if layer == 1:
+        samples = 384
+        length = (12 * bitrate // sample_rate + padding) * 4
+    elif layer == 2:
+        samples = 1152
+        length = 144 * bitrate // sample_rate + padding
+    else:
+        samples = 1152 if mpeg1 else 576
+        length = (144 if mpeg1 else 72) * bitrate // sample_rate + padding
+
+    return length, samples, sample_rate
+
+
+def skip_id3v2(data):
+    """Offset of the first byte after an ID3v2 tag (0 if there is none)"""
+    if len(data) < 10 or data[:3] != b"ID3":
+        return 0
+    size = (data[6] << 21) | (data[7] << 14) | (data[8] << 7) | data[9]
+    footer = 10 if data[5] & 0x10 else 0
+    return 10 + size + footer
+
+
+def is_info_frame(data, pos, length):
+    """True for a Xing/Info/VBRI header frame - metadata, not audio"""
+    frame = data[pos:pos + length]
+    return b"Xing" in frame[:64] or b"Info" in frame[:64] or b"VBRI" in frame[:64]
+
+
+def gapless_trim_samples(data, pos, length):
+    """Encoder delay + padding from the LAME tag of a Xing/Info frame (0 if it has none)
+
+    The tag follows the Xing fields that its flags say are present: frame count (1),
+    byte count (2), seek TOC (4, 100 bytes) and quality (8). Delay and padding are two
+    12-bit values 21 bytes into the tag. LAME writes "LAME", ffmpeg's encoder "Lavc"/"Lavf".
+    """
+    frame = data[pos:pos + length]
+    xing = max(frame.find(b"Xing", 0, 64), frame.find(b"Info", 0, 64))
+    if xing < 0 or xing + 8 > len(frame):
+        return 0
+    flags = int.from_bytes(frame[xing + 4:xing + 8], "big")
+    tag = xing + 8
+    for flag, size in ((0x1, 4), (0x2, 4), (0x4, 100), (0x8, 4)):
+        if flags & flag:
+            tag += size
+    if tag + 24 > len(frame) or frame[tag:tag + 4] not in (b"LAME", b"Lavc", b"Lavf"):
+        return 0
+    delay = (frame[tag + 21] << 4) | (frame[tag + 22] >> 4)
+    padding = ((frame[tag + 22] & 0x0F) << 8) | frame[tag + 23]
+    return delay + padding
+
+
+def mp3_duration_ms(path):
+    """Decoded duration of an MP3 in milliseconds, rounded to the nearest ms"""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    end = len(data)
+    if end >= 128 and data[end - 128:end - 125] == b"TAG":
+        end -= 128  # ID3v1 tag
+
+    pos = skip_id3v2(data)
+    total_samples = 0
+    trim_samples = 0
+    sample_rate = None
+    first = True
+
+    while pos < end:
+        header = parse_frame_header(data, pos)
+        # A frame only counts if it fits and is followed by another frame (or the end)
+        if header is not None:
+            length, samples, rate = header
+            next_pos = pos + length
+            if next_pos <= end and (next_pos == end or parse_frame_header(data, next_pos) is not None):
+                if first and is_info_frame(data, pos, length):
+                    trim_samples = gapless_trim_samples(data, pos, length)
+                else:
+                    if sample_rate is None:
+                        sample_rate = rate
+                    elif rate != sample_rate:
+                        raise ValueError(f"{path}: sample rate changes mid-stream")
+                    total_samples += samples
+                first = False
+                pos = next_pos
+                continue
+        pos += 1  # Resync - skip junk between frames
+
+    if sample_rate is None:
+        raise ValueError(f"{path}: no MPEG audio frames found")
+    if trim_samples >= total_samples:
+        raise ValueError(f"{path}: LAME tag trims more samples than the file has")
+    total_samples -= trim_samples
+
+    return (total_samples * 1000 + sample_rate // 2) // sample_rate
+
+
+def loudness_lufs_x10(path):
+    """EBU R128 integrated loudness in tenths of LUFS, via ffmpeg"""
+    result = subprocess.run(
+        ["ffmpeg", "-hide_banner", "-nostats", "-i", path, "-af", "ebur128=framelog=quiet", "-f", "null", "-"],
+        capture_output=True, text=True, check=True)
+    matches = re.findall(r"I:\s+(-?[\d.]+|-inf) LUFS", result.stderr)
+    if not matches or matches[-1] == "-inf":
+        return LOUDNESS_UNKNOWN  # Silence
+    return int(round(float(matches[-1]) * 10))
+
+
+def c_identifier(name):
+    return re.sub(r"[^A-Za-z0-9]", "_", os.path.splitext(name)[0]).upper()
+
+
+def header_loudness(path):
+    """Loudness per file name from an existing header - empty if there is none"""
+    try:
+        with open(path, newline="") as f:
+            text = f.read()
+    except FileNotFoundError:
+        return {}
+    loudness = {}
+    for value, name in re.findall(r"\{ \d+, (-?\d+|TRACK_LOUDNESS_UNKNOWN) \},\s+// \d{4}_(.+)", text):
+        loudness[name] = LOUDNESS_UNKNOWN if value == "TRACK_LOUDNESS_UNKNOWN" else int(value)
+    return loudness
+
+
+def build_manifest(source_dir, measure_loudness, known_loudness):
+    # Same order as prepare_sd_card.ps1: Sort-Object Name (case-insensitive)
+    files = sorted((f for f in os.listdir(source_dir) if f.lower().endswith(".mp3")), key=str.lower)
+    if not files:
+        raise ValueError(f"No .mp3 files in {source_dir}")
+    if len(files) > 255:
+        raise ValueError("DFPlayer track numbers are 8-bit - at most 255 files")
+
+    tracks = []
+    for number, name in enumerate(files, start=1):
+        path = os.path.join(source_dir, name)
+        if measure_loudness:
+            loudness = loudness_lufs_x10(path)
+        else:
+            loudness = known_loudness.get(name, LOUDNESS_UNKNOWN)
+        tracks.append((number, name, mp3_duration_ms(path), loudness))
+    return tracks
+
+
+def render_header(tracks, source_dir):
+    lines = [
+        "#ifndef TRACK_MANIFEST_H",
+        "#define TRACK_MANIFEST_H",
+        "",
+        "// Generated by tools/generate_track_manifest.py from " + source_dir.replace(os.sep, "/") + " - do not edit",
+        "// Regenerate whenever the SD card files change",
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define TRACK_MANIFEST_COUNT %d" % len(tracks),
+        "#define TRACK_LOUDNESS_UNKNOWN INT16_MIN",
+        "",
+        "struct TrackManifestEntry {",
+        "  uint32_t duration_ms;   // Decoded length",
+        "  int16_t loudness_x10;   // Integrated loudness in 0.1 LUFS (TRACK_LOUDNESS_UNKNOWN if not measured) -",
+        "                          // for leveling the files, not used by the firmware",
+        "};",
+        "",
+        "// Indexed by track number - entry 0 is unused (tracks start at 0001.mp3)",
+        "static const TrackManifestEntry TRACK_MANIFEST[TRACK_MANIFEST_COUNT + 1] = {",
+        "  { 0, TRACK_LOUDNESS_UNKNOWN },",
+    ]
+    for number, name, duration, loudness in tracks:
+        loudness_text = "TRACK_LOUDNESS_UNKNOWN" if loudness == LOUDNESS_UNKNOWN else str(loudness)
+        lines.append("  { %d, %s },  // %04d_%s" % (duration, loudness_text, number, name))
+    lines += [
+        "};",
+        "",
+    ]
+    for number, name, _, _ in tracks:
+        lines.append("#define TRACK_MANIFEST_%s %d" % (c_identifier(name), number))
+    lines += [
+        "",
+        "#endif // TRACK_MANIFEST_H",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate the DFPlayer track manifest header")
+    parser.add_argument("--source", default=DEFAULT_SOURCE_DIR, help="Directory of SD card MP3 files")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="Header to write")
+    parser.add_argument("--no-loudness", action="store_true",
+                        help="Skip the ffmpeg loudness measurement and keep the loudness already in the header")
+    parser.add_argument("--check", action="store_true", help="Exit 1 if the header doesn't match the files")
+    args = parser.parse_args()
+
+    with_loudness = not args.no_loudness
+    if with_loudness and shutil.which("ffmpeg") is None:
+        if not args.check:
+            # Writing unknown would silently erase loudness measured on another machine
+            print("ffmpeg not found - install it, or pass --no-loudness to keep the loudness already "
+                  "in the header", file=sys.stderr)
+            return 2
+        print("ffmpeg not found - checking numbering and durations only", file=sys.stderr)
+        with_loudness = False
+
+    tracks = build_manifest(args.source, with_loudness, header_loudness(args.output))
+    header = render_header(tracks, args.source)
+
+    for number, name, duration, loudness in tracks:
+        loudness_text = "?" if loudness == LOUDNESS_UNKNOWN else "%.1f LUFS" % (loudness / 10)
+        print("%04d_%-24s %7d ms  %s" % (number, name, duration, loudness_text))
+
+    if args.check:
+        try:
+            with open(args.output, newline="") as f:
+                current = f.read()
+        except FileNotFoundError:
+            current = ""
+        # Without ffmpeg only the durations and numbering can be compared
+        if not with_loudness:
+            current = re.sub(r"\{ (\d+), [^}]+\}", r"{ \1 }", current)
+            header = re.sub(r"\{ (\d+), [^}]+\}", r"{ \1 }", header)
+        if current != header:
+            print(f"{args.output} is out of date - run tools/generate_track_manifest.py", file=sys.stderr)
+            return 1
+        print(f"{args.output} is up to date")
+        return 0
+
+    with open(args.output, "w", newline="\n") as f:
+        f.write(header)
+    print(f"Wrote {args.output} ({len(tracks)} tracks)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,313 @@
+/**
+ * JsonWriter vs ArduinoJson - host benchmark
+ *
+ * Builds the MQTT payloads published by HomeAssistantControl both ways and reports, per
+ * payload, the time per serialization (and TSC cycles on x86) and the stack each path uses:
+ *
+ *   ArduinoJson: StaticJsonDocument + serializeJson() into a stack buffer, sprintf for 64-bit
+ *                IDs, then the copy into the outgoing queue (the old publish path)
+ *   JsonWriter:  written straight into the queue record (the current publish path)
+ *
+ * Both outputs are compared byte for byte so the writer can't drift from the old schema.
+ *
+ * Build and run on the host (ArduinoJson 6 sources - PlatformIO puts them in .pio/libdeps):
+ *   g++ -std=gnu++17 -O2 -Ilib/HomeAssistantControl -I.pio/libdeps/esp32dev/ArduinoJson/src \
+ *       tools/json_writer_benchmark.cpp -o json_writer_benchmark && ./json_writer_benchmark
+ * or: pio run -e json-benchmark && .pio/build/json-benchmark/program
+ *
+ * Without ArduinoJson on the include path only the JsonWriter column is measured.
+ *
+ * Stack use is measured by painting a region below the caller's frame and counting the bytes
+ * the serializer overwrote - approximate, but it's the same method for both paths.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include "JsonWriter.h"
+
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+#define HAVE_ARDUINOJSON 1
+#else
+#define HAVE_ARDUINOJSON 0
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#define NOINLINE __attribute__((noinline))
+
+// Same topics and sizes as HomeAssistantControl.h
+#define MQTT_STATE_TOPIC "magicband/state"
+#define MQTT_WAND_TOPIC "magicband/wand"
+#define MQTT_STATS_TOPIC "magicband/stats"
+#define MQTT_COMMAND_TOPIC "magicband/command"
+#define MQTT_DISCOVERY_PAYLOAD_MAX 512
+#define MQTT_STATE_PAYLOAD_MAX 96
+#define MQTT_STATS_PAYLOAD_MAX 512
+#define MQTT_WAND_PAYLOAD_MAX 160
+
+#define ITERATIONS 200000
+#define STACK_PAINT_SIZE 16384
+#define STACK_PAINT_BYTE 0xA5
+
+// Stand-in for the outgoing queue record the payload ends up in
+static char queue_record[512];
+static size_t queue_length;
+
+// Sample values - a real band ID with all 64 bits in use
+static const uint64_t band_id = 18446744073709551557ULL;
+static const uint32_t activations = 1234;
+static const uint32_t uptime = 987654;
+static const uint32_t timestamp_ms = 4000000000UL;
+static volatile bool sink;  // Keeps the optimizer from dropping the loop bodies
+
+// JsonWriter paths - mirror HomeAssistantControl.cpp
+
+NOINLINE static void writer_state() {
+  JsonWriter json(queue_record, MQTT_STATE_PAYLOAD_MAX + 1);
+  json.begin_object();
+  json.field("enabled", "ON");
+  json.field("brightness", (uint8_t)200);
+  json.field("cooldown", (unsigned long)10000);
+  json.field("auto_close", true);
+  json.end_object();
+  queue_length = json.length();
+}
+
+NOINLINE static void writer_wand() {
+  JsonWriter json(queue_record, MQTT_WAND_PAYLOAD_MAX + 1);
+  json.begin_object();
+  json.field_id("wand_id", band_id);
+  json.field("timestamp", timestamp_ms);
+  json.field("age_ms", (uint32_t)15);
+  json.field("name", "Elle's Band");
+  json.end_object();
+  queue_length = json.length();
+}
+
+NOINLINE static void writer_stats() {
+  JsonWriter json(queue_record, MQTT_STATS_PAYLOAD_MAX + 1);
+  json.begin_object();
+  json.field("activations", activations);
+  json.field("uptime", uptime);
+  json.field("lid_open", false);
+  json.field("time_until_ready", (uint32_t)0);
+  json.field("boot_ready_ms", (uint32_t)1850);
+  json.field("wifi_connect_ms", (uint32_t)4200);
+  json.field("activations_pending", 0);
+  json.field("activations_dropped", (uint32_t)0);
+  json.field_id("last_wand", band_id);
+  json.end_object();
+  queue_length = json.length();
+}
+
+NOINLINE static void writer_discovery() {
+  JsonWriter json(queue_record, MQTT_DISCOVERY_PAYLOAD_MAX + 1);
+  json.begin_object();
+  json.field("name", "MagicBand System");
+  json.field("unique_id", "magicband_system");
+  json.field("state_topic", MQTT_STATE_TOPIC);
+  json.field("command_topic", MQTT_COMMAND_TOPIC);
+  json.field("payload_on", "ON");
+  json.field("payload_off", "OFF");
+  json.field("value_template", "{{ value_json.enabled }}");
+  json.begin_object("device");
+  json.begin_array("identifiers").element("magicband").end_array();
+  json.field("name", "MagicBand");
+  json.field("manufacturer", "Custom");
+  json.field("model", "ESP32");
+  json.end_object();
+  json.end_object();
+  queue_length = json.length();
+}
+
+#if HAVE_ARDUINOJSON
+// ArduinoJson paths - the publish code as it was before JsonWriter
+
+static void queue_copy(const char* buffer) {
+  queue_length = strlen(buffer);
+  memcpy(queue_record, buffer, queue_length + 1);
+}
+
+NOINLINE static void arduinojson_state() {
+  StaticJsonDocument<256> doc;
+  char buffer[256];
+  doc["enabled"] = "ON";
+  doc["brightness"] = (uint8_t)200;
+  doc["cooldown"] = (unsigned long)10000;
+  doc["auto_close"] = true;
+  serializeJson(doc, buffer);
+  queue_copy(buffer);
+}
+
+NOINLINE static void arduinojson_wand() {
+  StaticJsonDocument<192> doc;
+  char buffer[192];
+  char wand_id_str[21];
+  sprintf(wand_id_str, "%llu", (unsigned long long)band_id);
+  doc["wand_id"] = wand_id_str;
+  doc["timestamp"] = timestamp_ms;
+  doc["age_ms"] = (uint32_t)15;
+  doc["name"] = "Elle's Band";
+  serializeJson(doc, buffer);
+  queue_copy(buffer);
+}
+
+NOINLINE static void arduinojson_stats() {
+  StaticJsonDocument<256> doc;
+  char buffer[320];
+  doc["activations"] = activations;
+  doc["uptime"] = uptime;
+  doc["lid_open"] = false;
+  doc["time_until_ready"] = (uint32_t)0;
+  doc["boot_ready_ms"] = (uint32_t)1850;
+  doc["wifi_connect_ms"] = (uint32_t)4200;
+  doc["activations_pending"] = 0;
+  doc["activations_dropped"] = (uint32_t)0;
+  char wand_id_str[21];
+  sprintf(wand_id_str, "%llu", (unsigned long long)band_id);
+  doc["last_wand"] = wand_id_str;
+  serializeJson(doc, buffer);
+  queue_copy(buffer);
+}
+
+NOINLINE static void arduinojson_discovery() {
+  StaticJsonDocument<512> doc;
+  char buffer[512];
+  doc["name"] = "MagicBand System";
+  doc["unique_id"] = "magicband_system";
+  doc["state_topic"] = MQTT_STATE_TOPIC;
+  doc["command_topic"] = MQTT_COMMAND_TOPIC;
+  doc["payload_on"] = "ON";
+  doc["payload_off"] = "OFF";
+  doc["value_template"] = "{{ value_json.enabled }}";
+  doc["device"]["identifiers"][0] = "magicband";
+  doc["device"]["name"] = "MagicBand";
+  doc["device"]["manufacturer"] = "Custom";
+  doc["device"]["model"] = "ESP32";
+  serializeJson(doc, buffer);
+  queue_copy(buffer);
+}
+#endif
+
+// Stack measurement - paint, run, then count what was overwritten at the same depth
+
+NOINLINE static void stack_paint() {
+  volatile uint8_t area[STACK_PAINT_SIZE];
+  for (size_t i = 0; i < sizeof(area); i++) {
+    area[i] = STACK_PAINT_BYTE;
+  }
+}
+
+// Reading the uninitialized array is the point - it holds what the serializer left behind
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+NOINLINE static size_t stack_scan() {
+  volatile uint8_t area[STACK_PAINT_SIZE];
+  // The stack grows down - the serializer's deepest write is the lowest changed byte
+  size_t untouched = 0;
+  while (untouched < sizeof(area) && area[untouched] == STACK_PAINT_BYTE) {
+    untouched++;
+  }
+  return sizeof(area) - untouched;
+}
+#pragma GCC diagnostic pop
+
+static size_t measure_stack(void (*serialize)()) {
+  stack_paint();
+  serialize();
+  return stack_scan();
+}
+
+struct Timing {
+  double ns;
+  double cycles;  // 0 without a TSC
+};
+
+static Timing measure_time(void (*serialize)()) {
+  for (int i = 0; i < 1000; i++) {
+    serialize();  // Warm up caches and branch predictors
+  }
+#if HAVE_TSC
+  uint64_t start_cycles = __rdtsc();
+#endif
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    serialize();
+    sink = queue_length != 0;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  Timing timing;
+  timing.ns = std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+#if HAVE_TSC
+  timing.cycles = (double)(__rdtsc() - start_cycles) / ITERATIONS;
+#else
+  timing.cycles = 0;
+#endif
+  return timing;
+}
+
+struct Payload {
+  const char* name;
+  void (*writer)();
+  void (*arduinojson)();
+};
+
+static const Payload payloads[] = {
+#if HAVE_ARDUINOJSON
+  {"state", writer_state, arduinojson_state},
+  {"wand", writer_wand, arduinojson_wand},
+  {"stats", writer_stats, arduinojson_stats},
+  {"discovery", writer_discovery, arduinojson_discovery},
+#else
+  {"state", writer_state, nullptr},
+  {"wand", writer_wand, nullptr},
+  {"stats", writer_stats, nullptr},
+  {"discovery", writer_discovery, nullptr},
+#endif
+};
+
+static void print_row(const char* path, const Timing& timing, size_t stack) {
+  if (HAVE_TSC) {
+    printf("  %-12s %8.1f ns %8.0f cycles %6zu bytes stack\n", path, timing.ns, timing.cycles, stack);
+  } else {
+    printf("  %-12s %8.1f ns %6zu bytes stack\n", path, timing.ns, stack);
+  }
+}
+
+int main() {
+  int mismatches = 0;
+
+  if (!HAVE_ARDUINOJSON) {
+    printf("ArduinoJson not on the include path - measuring JsonWriter only\n\n");
+  }
+
+  for (const Payload& payload : payloads) {
+    payload.writer();
+    char written[sizeof(queue_record)];
+    memcpy(written, queue_record, queue_length + 1);
+    printf("%s (%zu bytes): %s\n", payload.name, queue_length, written);
+
+    print_row("JsonWriter", measure_time(payload.writer), measure_stack(payload.writer));
+
+    if (payload.arduinojson != nullptr) {
+      payload.arduinojson();
+      if (strcmp(written, queue_record) != 0) {
+        printf("  MISMATCH - ArduinoJson wrote: %s\n", queue_record);
+        mismatches++;
+      }
+      print_row("ArduinoJson", measure_time(payload.arduinojson), measure_stack(payload.arduinojson));
+    }
+    printf("\n");
+  }
+
+  return mismatches == 0 ? 0 : 1;
+}
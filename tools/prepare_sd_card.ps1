@@ -47,5 +47,17 @@ foreach ($file in $files) {
     $i++
 }
 
+# Regenerate the firmware's track manifest from the same files - the firmware uses the durations,
+# loudness is only measured (with ffmpeg) as a reference for leveling the files
+$manifestArgs = @("--source", $SourceDir)
+if (-not (Get-Command ffmpeg -ErrorAction SilentlyContinue)) {
+    Write-Warning "ffmpeg not found - keeping the loudness already in the track manifest."
+    $manifestArgs += "--no-loudness"
+}
+python tools/generate_track_manifest.py @manifestArgs
+if ($LASTEXITCODE -ne 0) {
+    Write-Warning "Track manifest generation failed - lib/AudioControlDFPlayer/TrackManifest.h may be out of date."
+}
+
 Write-Host "SD card preparation complete. Copied $($files.Count) files to the root of ${DriveLetter}:."
 Write-Host "Please safely eject the SD card."
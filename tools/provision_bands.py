@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""
+Bulk-load band definitions into the MagicBand box over MQTT
+
+Reads bands from a CSV file (uid,name,color,sounds) and publishes them to the
+provisioning topic in chunks, waiting for each chunk's acknowledgement before
+sending the next one. Works against the box or any mosquitto broker.
+
+CSV format (header row required, sounds separated by spaces):
+    uid,name,color,sounds
+    27CB1805,August,#0000FF,9 5
+    045C92F2876880,Candice,#800080,11 10 12
+
+Usage:
+    pip install paho-mqtt
+    python tools/provision_bands.py bands.csv --host homeassistant.local --user USER --password PASS
+"""
+
+import argparse
+import csv
+import json
+import queue
+import sys
+import time
+
+import paho.mqtt.client as mqtt
+
+BASE_TOPIC = "homeassistant/magicband"
+PROVISION_TOPIC = BASE_TOPIC + "/bands/provision"
+STATUS_TOPIC = BASE_TOPIC + "/bands/status"
+
+# Must stay below MQTT_BUFFER_SIZE in HomeAssistantControl.h (minus topic and header)
+MAX_CHUNK_BYTES = 3800
+MAX_CHUNK_BANDS = 64   # MQTT_PROVISION_MAX_BANDS
+
+
+def load_bands(path):
+    bands = []
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            bands.append({
+                "uid": row["uid"].strip(),
+                "name": row["name"].strip(),
+                "color": row["color"].strip(),
+                "sounds": [int(s) for s in row["sounds"].split()],
+            })
+    return bands
+
+
+def make_chunks(bands, batch):
+    """Split bands into chunks that each fit one MQTT message"""
+    chunks = []
+    current = []
+    for band in bands:
+        candidate = current + [band]
+        size = len(json.dumps({"batch": batch, "chunk": 9999, "chunks": 9999, "bands": candidate}))
+        if current and (size > MAX_CHUNK_BYTES or len(candidate) > MAX_CHUNK_BANDS):
+            chunks.append(current)
+            current = [band]
+        else:
+            current = candidate
+    if current:
+        chunks.append(current)
+    return chunks
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Provision MagicBand bands over MQTT")
+    parser.add_argument("csv_file", help="CSV file with uid,name,color,sounds columns")
+    parser.add_argument("--host", default="localhost", help="MQTT broker host")
+    parser.add_argument("--port", type=int, default=1883, help="MQTT broker port")
+    parser.add_argument("--user", help="MQTT username")
+    parser.add_argument("--password", help="MQTT password")
+    parser.add_argument("--batch", default=time.strftime("batch-%Y%m%d-%H%M%S"), help="Batch name")
+    parser.add_argument("--timeout", type=float, default=5.0, help="Seconds to wait for each ack")
+    args = parser.parse_args()
+
+    bands = load_bands(args.csv_file)
+    chunks = make_chunks(bands, args.batch)
+    print(f"Loaded {len(bands)} bands from {args.csv_file} -> {len(chunks)} chunks")
+
+    acks = queue.Queue()
+    client = mqtt.Client()
+    if args.user:
+        client.username_pw_set(args.user, args.password)
+    client.on_message = lambda c, u, msg: acks.put(json.loads(msg.payload))
+    client.connect(args.host, args.port)
+    client.subscribe(STATUS_TOPIC)
+    client.loop_start()
+
+    start = time.time()
+    applied = 0
+    for index, chunk in enumerate(chunks):
+        payload = {"batch": args.batch, "chunk": index, "chunks": len(chunks), "bands": chunk}
+        client.publish(PROVISION_TOPIC, json.dumps(payload, separators=(",", ":")))
+
+        # Wait for this chunk's ack (ignore acks from other senders)
+        deadline = time.time() + args.timeout
+        while True:
+            try:
+                ack = acks.get(timeout=max(0.0, deadline - time.time()))
+            except queue.Empty:
+                print(f"Chunk {index + 1}/{len(chunks)}: no acknowledgement - aborting")
+                return 1
+            if ack.get("batch") == args.batch and ack.get("chunk") == index:
+                break
+
+        if ack.get("status") != "ok":
+            bad = ack.get("index")
+            detail = f" (band {chunk[bad]['uid']})" if isinstance(bad, int) and bad < len(chunk) else ""
+            print(f"Chunk {index + 1}/{len(chunks)} rejected: {ack.get('error')}{detail}")
+            return 1
+
+        applied += ack.get("applied", 0)
+        if not ack.get("persisted", True):
+            print(f"Chunk {index + 1}/{len(chunks)}: applied but not saved to flash")
+        print(f"Chunk {index + 1}/{len(chunks)}: {ack.get('applied')} bands, {ack.get('bands')} on device")
+
+    client.loop_stop()
+    print(f"Provisioned {applied} bands in {time.time() - start:.1f}s")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,268 @@
+/**
+ * Tap-to-greeting latency benchmark - native build
+ *
+ * Runs the firmware (src/main.cpp and lib/) against the simulated hardware in native/ and
+ * replays scripted taps. Each tap is timed from the moment the card enters the field:
+ *
+ *   detect          card answered the armed reader (PN532 IRQ low)
+ *   uid_read        firmware read the UID back
+ *   first_led_frame first frame that differs from what the strip showed before the tap
+ *   first_audio     first play command the DFPlayer received
+ *   mqtt_publish    activation published on the wand topic
+ *
+ * These run on virtual time, so they are repeatable and include the modelled bus, UART and
+ * LED wire times. Registry lookup does no I/O and takes no simulated time - it is measured
+ * on the host clock instead (band_registry_lookup() for the tapped UID, ns per call).
+ *
+ * Taps land at a random point of the loop's delay, like a guest would, so the percentiles
+ * show the spread from loop timing. The seed makes runs repeatable. One tap must give exactly
+ * one activation: if a tap starts a second one (a response the card left waiting when the
+ * reader re-armed), the run stops there and exits 1 - its timings would be measuring the
+ * wrong greeting. A tap that never publishes fails the run the same way.
+ *
+ * Build and run:
+ *   pio run -e tap-benchmark && .pio/build/tap-benchmark/program > tap_latency.json
+ * Options:
+ *   --taps N   Taps per scenario (default 50)
+ *   --seed S   Tap timing seed (default 1)
+ *
+ * Results go to stdout as JSON; progress and failures go to stderr. Firmware Serial output
+ * is muted.
+ */
+
+#include <Arduino.h>
+#include <HostHardware.h>
+#include <HostPN532.h>
+#include <HostLEDStrip.h>
+#include <HostBroker.h>
+#include <BandRegistry.h>
+#include <HomeAssistantControl.h>
+#include <AudioControlDFPlayer.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#define DEFAULT_TAPS 50
+#define WARMUP_MS 15000            // Boot, WiFi, MQTT and the startup sound
+#define TAP_HOLD_MS 500            // Card held in the field
+#define TAP_OFFSET_MAX_US 250000   // Tap lands up to this long into the next wait
+#define TAP_GAP_MAX_MS 2000        // Extra idle time between taps
+#define TAP_COOLDOWN_MS 5500       // Past the firmware's default 5s cooldown, which ends after the sounds
+#define TAP_TIMEOUT_MS 60000       // Give up on a tap that never publishes
+#define LOOKUP_ITERATIONS 1000     // band_registry_lookup() calls per lookup sample
+
+struct Scenario {
+  const char* name;
+  uint64_t uid;
+  uint8_t uid_length;
+};
+
+// Bands from BAND_CONFIGS in src/main.cpp plus one the registry doesn't know
+static const Scenario SCENARIOS[] = {
+  { "known_4byte_uid", 0x27CB1805, 4 },
+  { "known_7byte_uid", 0x045C92F2876880ULL, 7 },
+  { "unknown_band", 0xDEADBEEF, 4 },
+};
+
+enum Phase {
+  PHASE_DETECT,
+  PHASE_UID_READ,
+  PHASE_FIRST_LED_FRAME,
+  PHASE_FIRST_AUDIO,
+  PHASE_MQTT_PUBLISH,
+  PHASE_COUNT
+};
+
+static const char* PHASE_NAMES[PHASE_COUNT] = {
+  "detect", "uid_read", "first_led_frame", "first_audio", "mqtt_publish"
+};
+
+// Timeline of the tap in flight - 0 means not seen yet
+// Everything but the publish is written on the main thread (hardware events and loop())
+struct TapTimeline {
+  uint64_t tap_us;
+  uint64_t phase_us[PHASE_COUNT];
+};
+
+static TapTimeline tap = {};
+static uint32_t activation_starts = 0;        // Tap beeps - every activation starts with one
+static std::atomic<uint64_t> publish_us(0);  // Written on the MQTT task thread
+static std::vector<CRGB> shown;               // Last frame on the strip
+static uint8_t shown_brightness = 0;
+
+static uint32_t rng_state = 1;
+
+static uint32_t next_random(uint32_t limit) {
+  rng_state ^= rng_state << 13;  // xorshift32
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state % limit;
+}
+
+static void mark(Phase phase) {
+  if (tap.tap_us != 0 && tap.phase_us[phase] == 0) {
+    tap.phase_us[phase] = host_micros64();
+  }
+}
+
+static void on_led_frame(const CRGB* pixels, int count, uint8_t brightness) {
+  bool changed = brightness != shown_brightness || (int)shown.size() != count ||
+                 !std::equal(shown.begin(), shown.end(), pixels);
+  shown.assign(pixels, pixels + count);
+  shown_brightness = brightness;
+  if (changed && tap.phase_us[PHASE_UID_READ] != 0) {
+    mark(PHASE_FIRST_LED_FRAME);
+  }
+}
+
+static void on_dfplayer_command(uint8_t command, uint16_t param) {
+  if (command == 0x03 || command == 0x0F) {  // Play track / play folder track
+    mark(PHASE_FIRST_AUDIO);
+  }
+  if (command == 0x03 && param == SOUND_TAP_START) {
+    activation_starts++;
+  }
+}
+
+static void on_publish(const char* topic, const uint8_t* payload, size_t length, bool retain) {
+  if (strcmp(topic, MQTT_WAND_TOPIC) == 0) {
+    uint64_t expected = 0;
+    publish_us.compare_exchange_strong(expected, host_micros64());
+  }
+}
+
+static void run_until(uint64_t until_us) {
+  while (host_micros64() < until_us) {
+    host_loop_tick();
+  }
+}
+
+// Run until the next activation is published - false on timeout
+static bool wait_for_publish() {
+  uint64_t deadline = host_micros64() + (uint64_t)TAP_TIMEOUT_MS * 1000;
+  while (publish_us.load() == 0 && host_micros64() < deadline) {
+    host_loop_tick();
+  }
+  return publish_us.load() != 0;
+}
+
+// Host time for one registry lookup of this UID - averaged over a batch of calls
+static uint64_t measure_lookup_ns(uint64_t uid) {
+  volatile uintptr_t sink = 0;
+  BandConfig band;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < LOOKUP_ITERATIONS; i++) {
+    sink = sink + band_registry_lookup(uid, &band);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / LOOKUP_ITERATIONS;
+}
+
+// Nearest-rank percentile of sorted samples
+static uint64_t percentile(const std::vector<uint64_t>& sorted, int pct) {
+  size_t rank = (sorted.size() * pct + 99) / 100;
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void print_stats(const char* name, const char* unit, std::vector<uint64_t> samples, bool last) {
+  std::sort(samples.begin(), samples.end());
+  printf("        \"%s\": {\"samples\": %zu", name, samples.size());
+  if (!samples.empty()) {
+    printf(", \"p50_%s\": %llu, \"p99_%s\": %llu, \"max_%s\": %llu", unit,
+           (unsigned long long)percentile(samples, 50), unit, (unsigned long long)percentile(samples, 99),
+           unit, (unsigned long long)samples.back());
+  }
+  printf("}%s\n", last ? "" : ",");
+}
+
+int main(int argc, char** argv) {
+  int taps = DEFAULT_TAPS;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--taps") == 0 && i + 1 < argc) {
+      taps = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      rng_state = strtoul(argv[++i], nullptr, 10);
+      if (rng_state == 0) rng_state = 1;  // xorshift never leaves 0
+    } else {
+      fprintf(stderr, "usage: %s [--taps N] [--seed S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  host_set_virtual_time(true);
+  host_set_serial_output(false);
+  host_pn532_on_detect([]() { mark(PHASE_DETECT); });
+  host_pn532_on_read([](const uint8_t* uid, uint8_t uid_length) { mark(PHASE_UID_READ); });
+  host_led_on_frame(on_led_frame);
+  host_dfplayer_on_command(on_dfplayer_command);
+  host_broker_on_publish(on_publish);
+
+  setup();
+  run_until((uint64_t)WARMUP_MS * 1000);
+
+  const int scenario_count = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+  printf("{\n  \"benchmark\": \"tap_latency\",\n  \"clock\": \"virtual\",\n");
+  printf("  \"taps_per_scenario\": %d,\n  \"scenarios\": [\n", taps);
+
+  for (int s = 0; s < scenario_count; s++) {
+    const Scenario& scenario = SCENARIOS[s];
+    std::vector<uint64_t> phase_samples[PHASE_COUNT];
+    std::vector<uint64_t> lookup_samples;
+
+    for (int t = 0; t < taps; t++) {
+      tap = {};
+      publish_us.store(0);
+      uint32_t starts_before = activation_starts;
+
+      // The card arrives partway through whatever the loop is doing
+      host_schedule_us(next_random(TAP_OFFSET_MAX_US), [&scenario]() {
+        tap.tap_us = host_micros64();
+        host_pn532_tap(scenario.uid, scenario.uid_length, TAP_HOLD_MS);
+      });
+
+      if (!wait_for_publish()) {
+        fprintf(stderr, "FAIL %s: tap %d was never published\n", scenario.name, t + 1);
+        fflush(stdout);
+        quick_exit(1);
+      }
+      tap.phase_us[PHASE_MQTT_PUBLISH] = publish_us.load();
+      TapTimeline timeline = tap;
+      tap.tap_us = 0;  // Stop marking
+
+      // Let the cooldown run out before the next guest - a second activation from this tap
+      // would start in here
+      uint64_t next_tap = timeline.phase_us[PHASE_MQTT_PUBLISH] + (uint64_t)TAP_COOLDOWN_MS * 1000;
+      run_until(next_tap + (uint64_t)next_random(TAP_GAP_MAX_MS) * 1000);
+      if (activation_starts - starts_before != 1) {
+        fprintf(stderr, "FAIL %s: tap %d started %u activations\n", scenario.name, t + 1,
+                activation_starts - starts_before);
+        fflush(stdout);
+        quick_exit(1);
+      }
+
+      for (int p = 0; p < PHASE_COUNT; p++) {
+        if (timeline.tap_us != 0 && timeline.phase_us[p] >= timeline.tap_us) {
+          phase_samples[p].push_back(timeline.phase_us[p] - timeline.tap_us);
+        }
+      }
+      lookup_samples.push_back(measure_lookup_ns(scenario.uid));
+    }
+
+    fprintf(stderr, "%s: %d taps\n", scenario.name, taps);
+    printf("    {\n      \"name\": \"%s\",\n      \"taps\": %d,\n", scenario.name, taps);
+    printf("      \"phases\": {\n");
+    print_stats("registry_lookup", "ns", lookup_samples, false);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+      print_stats(PHASE_NAMES[p], "us", phase_samples[p], p == PHASE_COUNT - 1);
+    }
+    printf("      }\n    }%s\n", s < scenario_count - 1 ? "," : "");
+  }
+  printf("  ]\n}\n");
+
+  // The MQTT task thread is still parked in delay() - leave without running destructors
+  fflush(stdout);
+  quick_exit(0);
+}